@@ -11,8 +11,6 @@
 #pragma import_defines ( CAST_SHADOWS )
 #pragma import_defines ( ENABLE_ATMOSPHERE )
 
-in vec4 osg_Vertex;
-in vec4 osg_MultiTexCoord0;
 out vec2 texCoord;
 out vec2 normalViewSpaceXY;
 out vec3 emissionColor;
@@ -31,6 +29,9 @@ uniform vec3 lightDirection;
 
 uniform sampler2D cloudSampler;
 
+// Two texels per particle instance: (position.xyz, radius), (alpha, rotation seed, temperature, unused)
+uniform samplerBuffer particleSampler;
+
 vec2 rotate(vec2 v, float a)
 {
 	float s = sin(a);
@@ -39,6 +40,11 @@ vec2 rotate(vec2 v, float a)
 	return m * v;
 }
 
+float randomFast(float n)
+{
+	return fract(sin(n) * 43758.5453123);
+}
+
 vec3 colorAtTemperatureDegreesCelcius(float temperature)
 {
 	// This function is not physically based, but looks plausible
@@ -53,6 +59,9 @@ vec3 colorAtTemperatureDegreesCelcius(float temperature)
 
 void main()
 {
+	vec4 positionAndRadius = texelFetch(particleSampler, gl_InstanceID * 2);
+	vec4 params = texelFetch(particleSampler, gl_InstanceID * 2 + 1);
+
 	float x = ((gl_VertexID + 1) % 4) > 1 ? 1.0f : 0.0f;
 	float y = (gl_VertexID % 4) / 2;
 	
@@ -61,19 +70,19 @@ void main()
 	vec2 offset = texCoord * 2.0 - vec2(1.0);
 	
 	// Rotation
-	float rotationAngle = osg_MultiTexCoord0.z;
+	float rotationAngle = randomFast(params.y) * 2.0 * M_PI;
 	offset = rotate(offset, rotationAngle);
 
 	normalViewSpaceXY = offset * 0.8;
 	
 	// Scale
-	offset *= osg_MultiTexCoord0.xx;
+	offset *= positionAndRadius.w;
 	
-	vec4 pos = osg_Vertex;
+	vec4 pos = vec4(positionAndRadius.xyz, 1.0);
 	pos.xyz += offset.x * cameraRightDirection + offset.y * cameraUpDirection;
 	
-	emissionColor = colorAtTemperatureDegreesCelcius(osg_MultiTexCoord0.w);
-	alpha = osg_MultiTexCoord0.y;
+	emissionColor = colorAtTemperatureDegreesCelcius(params.z);
+	alpha = params.x;
 
 	gl_Position = osg_ModelViewProjectionMatrix * pos;
 	
@@ -83,7 +92,7 @@ void main()
 	gl_Position.z = logarithmicZ_vertexShader(gl_Position.z, gl_Position.w, logZ);
 	
 
-	vec3 positionWS = osg_Vertex.xyz; // assume particles are in world coordinates
+	vec3 positionWS = positionAndRadius.xyz; // assume particles are in world coordinates
 	positionRelCamera = positionWS.xyz - cameraPosition;
 
 	lightDirectionViewSpace = mat3(viewMatrix) * lightDirection;
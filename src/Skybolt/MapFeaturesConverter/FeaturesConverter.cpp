@@ -5,15 +5,22 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "FeaturesConverter.h"
+#include "NodeLocationIndex.h"
 #include <SkyboltSim/Spatial/GreatCircle.h>
 #include <SkyboltVis/Renderable/Planet/Features/PlanetFeaturesHelpers.h>
 #include <SkyboltCommon/Exception.h>
+#include <SkyboltCommon/ParallelFor.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <readosm.h>
+#include <chrono>
+#include <deque>
+#include <exception>
 #include <sstream>
 #include <map>
 #include <set>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
 #include <boost/algorithm/string.hpp>  
 #include <boost/lexical_cast.hpp>
 
@@ -33,14 +40,22 @@ static float calcBuildingHeightFromLevelCount(int levelCount)
 	return buildingGroundLevelHeight * (levelCount - 1) + buildingLevelHeight;
 }
 
+//! Looks up the altitudes of all points in one batch, which is much faster than looking up each point separately
+static std::vector<sim::PlanetAltitudeProvider::AltitudeResult> getAltitudes(const LatLonPoints& points, const sim::PlanetAltitudeProvider& provider)
+{
+	std::vector<sim::PlanetAltitudeProvider::AltitudeResult> altitudes(points.size());
+	provider.getAltitudes(points.data(), altitudes.data(), points.size());
+	return altitudes;
+}
+
 static LatLonAltPoints toLatLonAlt(const LatLonPoints& points, const sim::PlanetAltitudeProvider& provider)
 {
+	std::vector<sim::PlanetAltitudeProvider::AltitudeResult> altitudes = getAltitudes(points, provider);
+
 	LatLonAltPoints result(points.size());
-	int i = 0;
-	for (const LatLon& point : points)
+	for (size_t i = 0; i < points.size(); ++i)
 	{
-		result[i] = toLatLonAlt(point, provider.getAltitude(point).altitude);
-		++i;
+		result[i] = toLatLonAlt(points[i], altitudes[i].altitude);
 	}
 	return result;
 }
@@ -49,9 +64,9 @@ static LatLonAltPoints toLatLonWithMinAlt(const LatLonPoints& points, const sim:
 {
 	LatLonAltPoints result(points.size());
 	double alt = math::posInfinity();
-	for (const LatLon& point : points)
+	for (const sim::PlanetAltitudeProvider::AltitudeResult& altitude : getAltitudes(points, provider))
 	{
-		alt = std::min(alt, provider.getAltitude(point).altitude);
+		alt = std::min(alt, altitude.altitude);
 	}
 
 	int i = 0;
@@ -63,31 +78,128 @@ static LatLonAltPoints toLatLonWithMinAlt(const LatLonPoints& points, const sim:
 	return result;
 }
 
-struct ParserData
+//! Periodically prints the number of items processed and the rate of processing
+class ThroughputReporter
 {
-	struct Way
+public:
+	ThroughputReporter(const std::string& name, std::size_t reportInterval) :
+		mName(name),
+		mReportInterval(reportInterval),
+		mStartTime(std::chrono::steady_clock::now())
 	{
-		std::vector<long long> nodes;
-	};
+	}
+
+	void add(std::size_t count = 1)
+	{
+		std::size_t previousCount = mCount;
+		mCount += count;
+		if (mCount / mReportInterval != previousCount / mReportInterval)
+		{
+			printf("%s: %zu (%.0f per second)\n", mName.c_str(), mCount, double(mCount) / getElapsedSeconds());
+		}
+	}
 
-	std::map<long long, LatLon> nodes;
-	std::map<long long, Way> ways;
+	void finish() const
+	{
+		double seconds = getElapsedSeconds();
+		printf("%s: %zu in %.1f seconds (%.0f per second)\n", mName.c_str(), mCount, seconds, double(mCount) / std::max(seconds, 1e-3));
+	}
 
-	struct ParserAirport
+private:
+	double getElapsedSeconds() const
 	{
-		std::string name;
-		LatLonBounds bounds;
-		std::vector<LatLonPoints> areaPolygons;
-	};
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count();
+	}
+
+private:
+	const std::string mName;
+	const std::size_t mReportInterval;
+	const std::chrono::steady_clock::time_point mStartTime;
+	std::size_t mCount = 0;
+};
+
+//! OSM objects are copied out of readosm callbacks so that they can be processed on other threads
+struct OsmTag
+{
+	std::string key;
+	std::string value;
+};
+
+using OsmTags = std::vector<OsmTag>;
+
+template <class T>
+OsmTags copyTags(const T& object)
+{
+	OsmTags tags(object.tag_count);
+	for (int i = 0; i < object.tag_count; i++)
+	{
+		tags[i] = {object.tags[i].key, object.tags[i].value};
+	}
+	return tags;
+}
+
+struct OsmWay
+{
+	long long id;
+	OsmTags tags;
+	std::vector<long long> nodes;
+};
+
+struct OsmRelationMember
+{
+	int type;
+	long long id;
+	std::string role;
+};
+
+struct OsmRelation
+{
+	long long id;
+	OsmTags tags;
+	std::vector<OsmRelationMember> members;
+};
+
+struct ParserAirport
+{
+	std::string name;
+	LatLonBounds bounds;
+	std::vector<LatLonPoints> areaPolygons;
+};
+
+//! Result of processing a block of OSM objects.
+//! Block results are merged in file order so that the output does not depend on thread timing.
+struct BlockResult
+{
 	std::vector<ParserAirport> airports;
 	std::vector<Airport::Runway> runways;
 
 	std::vector<FeaturePtr> features;
 	std::map<long long, RoadJunction> nodeRoadJunctions;
+};
 
+//! Read-only data used to process OSM objects
+//! @ThreadSafe
+struct ParserContext
+{
+	const NodeLocationIndex* nodes;
 	const sim::PlanetAltitudeProvider* altitudeProvider;
 };
 
+struct ParserData : BlockResult
+{
+	ParserContext context;
+	std::unique_ptr<NodeLocationIndex> nodes;
+
+	std::vector<OsmRelation> relations; //!< Relations which produce features
+	std::unordered_set<long long> relationWayIds; //!< IDs of ways which are members of relations
+	std::unordered_map<long long, std::vector<long long>> relationWays; //!< Node IDs of ways which are members of relations
+
+	std::vector<OsmWay> pendingWays; //!< Ways waiting to be processed as a block
+	std::size_t wayBlockSize;
+	std::unique_ptr<class WayBlockProcessor> wayBlockProcessor;
+	std::unique_ptr<ThroughputReporter> throughputReporter;
+};
+
 float getHighwayRoadWidth(int laneCount) {return 3.7f * laneCount;}
 float getResidentialRoadWidth(int laneCount) {return 3.5f * laneCount;}
 
@@ -99,23 +211,20 @@ static int parseNode(const void* user_data, const readosm_node* node)
 		throw skybolt::Exception("Undefined longitude");
 
 	ParserData& data = *(ParserData*)user_data;
-	data.nodes[node->id] = LatLon(node->latitude * degToRadD(), node->longitude * degToRadD());
-
-	if (data.nodes.size() % 1000000 == 0)
-		printf("Loaded %zu nodes\n", data.nodes.size());
+	data.nodes->add(node->id, node->latitude, node->longitude);
+	data.throughputReporter->add();
 
 	return READOSM_OK;
 }
 
 template <class T>
-const readosm_tag* getTag(const T& object, const char* key)
+const OsmTag* getTag(const T& object, const char* key)
 {
-	for (int i = 0; i < object.tag_count; i++)
+	for (const OsmTag& tag : object.tags)
 	{
-		const readosm_tag* tag = object.tags + i;
-		if (strcmp(tag->key, key) == 0)
+		if (tag.key == key)
 		{
-			return tag;
+			return &tag;
 		}
 	}
 	return nullptr;
@@ -124,10 +233,10 @@ const readosm_tag* getTag(const T& object, const char* key)
 template <class T>
 const char* getTagValue(const T& object, const char* key)
 {
-	const readosm_tag* tag = getTag(object, key);
+	const OsmTag* tag = getTag(object, key);
 	if (tag)
 	{
-		return tag->value;
+		return tag->value.c_str();
 	}
 	return nullptr;
 }
@@ -199,46 +308,20 @@ V getTagValueOrDefault(const T& object, const char* key, Units units, const V& d
 	return defaultValue;
 }
 
-static void printTags(const readosm_way& way)
-{
-	for (int i = 0; i < way.tag_count; i++)
-	{
-		const readosm_tag* tag = way.tags + i;
-		std::cout << tag->key << ": " << tag->value << std::endl;
-	}
-}
-
-static void readPoints(const readosm_way& way, const ParserData& data, std::vector<LatLon>& points)
+static void printTags(const OsmWay& way)
 {
-	for (int i = 0; i < way.node_ref_count; ++i)
+	for (const OsmTag& tag : way.tags)
 	{
-		long long nodeId = way.node_refs[i];
-
-		std::map<long long, LatLon>::const_iterator it = data.nodes.find(nodeId);
-		if (it == data.nodes.end())
-		{
-			std::stringstream ss;
-			ss << nodeId;
-			throw skybolt::Exception("Invalid node ID " + ss.str());
-		}
-		points.push_back(it->second);
+		std::cout << tag.key << ": " << tag.value << std::endl;
 	}
 }
 
-static void readPoints(const ParserData::Way& way, const ParserData& data, std::vector<LatLon>& points)
+static void readPoints(const std::vector<long long>& nodes, const ParserContext& context, std::vector<LatLon>& points)
 {
-	for (size_t i = 0; i < way.nodes.size(); ++i)
+	points.reserve(points.size() + nodes.size());
+	for (long long nodeId : nodes)
 	{
-		long long nodeId = way.nodes[i];
-
-		std::map<long long, LatLon>::const_iterator it = data.nodes.find(nodeId);
-		if (it == data.nodes.end())
-		{
-			std::stringstream ss;
-			ss << nodeId;
-			throw skybolt::Exception("Invalid node ID " + ss.str());
-		}
-		points.push_back(it->second);
+		points.push_back(context.nodes->get(nodeId));
 	}
 }
 
@@ -291,60 +374,52 @@ bool isClosed(const std::vector<LatLon>& points)
 	return (points.size() >= 2 && points.back() == points.front());
 }
 
-static int parseWay(const void* user_data, const readosm_way* way)
+static void processWay(const OsmWay& way, const ParserContext& context, BlockResult& data)
 {
-	ParserData& data = *(ParserData*)user_data;
 	std::vector<FeaturePtr>& features = data.features;
 
-	ParserData::Way parsedWay;
-	for (int i = 0; i < way->node_ref_count; ++i)
-	{
-		parsedWay.nodes.push_back(way->node_refs[i]);
-	}
-	data.ways[way->id] = parsedWay;
-
-	const readosm_tag* tag = getTag(*way, "highway");
+	const OsmTag* tag = getTag(way, "highway");
 	if (tag)
 	{
-		if (strcmp(tag->value, "motorway") == 0
-			|| strcmp(tag->value, "motorway_link") == 0
-			|| strcmp(tag->value, "trunk") == 0
-			|| strcmp(tag->value, "primary") == 0
-			|| strcmp(tag->value, "secondary") == 0
-			|| strcmp(tag->value, "tertiary") == 0
-			|| strcmp(tag->value, "residential") == 0
+		if (tag->value == "motorway"
+			|| tag->value == "motorway_link"
+			|| tag->value == "trunk"
+			|| tag->value == "primary"
+			|| tag->value == "secondary"
+			|| tag->value == "tertiary"
+			|| tag->value == "residential"
 			)
 		{
-			if (getTag(*way, "tunnel")) // ignore tunnels
+			if (getTag(way, "tunnel")) // ignore tunnels
 			{
-				return READOSM_OK;
+				return;
 			}
 
 			std::shared_ptr<Road> roadPtr = std::make_shared<Road>();
 			Road& road = *roadPtr;
 			road.laneCount = 2; // by default, assume road has one lane going one way, and another going the opposite way, e.g typical residential street.
 
-			const readosm_tag* lanesTag = getTag(*way, "lanes");
+			const OsmTag* lanesTag = getTag(way, "lanes");
 			if (lanesTag)
 			{
-				road.laneCount = atoi(lanesTag->value);
+				road.laneCount = atoi(lanesTag->value.c_str());
 			}
 
-			bool isResidential = (strcmp(tag->value, "residential") == 0);
+			bool isResidential = (tag->value == "residential");
 			road.width = isResidential ? getResidentialRoadWidth(road.laneCount) : getHighwayRoadWidth(road.laneCount);
 
 			if (road.width > 0.0f)
 			{
 				LatLonPoints latLonPoints;
-				readPoints(*way, data, latLonPoints);
+				readPoints(way.nodes, context, latLonPoints);
 
 				if (latLonPoints.size() >= 2)
 				{
-					road.points = toLatLonAlt(latLonPoints, *data.altitudeProvider);
+					road.points = toLatLonAlt(latLonPoints, *context.altitudeProvider);
 					features.push_back(roadPtr);
 
-					long long startNode = way->node_refs[0];
-					long long endNode = way->node_refs[way->node_ref_count - 1];
+					long long startNode = way.nodes.front();
+					long long endNode = way.nodes.back();
 					data.nodeRoadJunctions[startNode].roads.push_back({roadPtr, RoadJunction::StartOrEnd::Start});
 					data.nodeRoadJunctions[endNode].roads.push_back({roadPtr, RoadJunction::StartOrEnd::End});
 				}
@@ -352,15 +427,15 @@ static int parseWay(const void* user_data, const readosm_way* way)
 		}
 	}
 
-	tag = getTag(*way, "building");
+	tag = getTag(way, "building");
 	if (!tag)
 	{
-		tag = getTag(*way, "building:part");
+		tag = getTag(way, "building:part");
 	}
 	if (tag)
 	{
 		float height = 0.0f;
-		const readosm_tag* heightTag = getTag(*way, "height");
+		const OsmTag* heightTag = getTag(way, "height");
 		if (heightTag)
 		{
 			try
@@ -376,7 +451,7 @@ static int parseWay(const void* user_data, const readosm_way* way)
 		}
 		else
 		{
-			const readosm_tag* levelsTag = getTag(*way, "building:levels");
+			const OsmTag* levelsTag = getTag(way, "building:levels");
 			if (levelsTag)
 			{
 				int levels = 1;
@@ -398,7 +473,7 @@ static int parseWay(const void* user_data, const readosm_way* way)
 		std::shared_ptr<Building> buildingPtr = std::make_shared<Building>();
 		Building& building = *buildingPtr;
 		LatLonPoints points;
-		readPoints(*way, data, points);
+		readPoints(way.nodes, context, points);
 
 		if (!isClockwise(points))
 		{
@@ -421,89 +496,89 @@ static int parseWay(const void* user_data, const readosm_way* way)
 
 		if (points.size() >= 2)
 		{
-			building.points = toLatLonWithMinAlt(points, *data.altitudeProvider);
+			building.points = toLatLonWithMinAlt(points, *context.altitudeProvider);
 			features.push_back(buildingPtr);
 		}
 	}
 
-	tag = getTag(*way, "natural");
+	tag = getTag(way, "natural");
 	if (tag)
 	{
-		if (strcmp(tag->value, "water") == 0)
+		if (tag->value == "water")
 		{
 			LatLonPoints points;
-			readPoints(*way, data, points);
+			readPoints(way.nodes, context, points);
 			preparePoly(points);
 
 			if (points.size() >= 2)
 			{
 				std::shared_ptr<Water> waterPtr = std::make_shared<Water>();
 				Water& water = *waterPtr;
-				water.points = toLatLonAlt(points, *data.altitudeProvider);
+				water.points = toLatLonAlt(points, *context.altitudeProvider);
 				features.push_back(waterPtr);
 			}
 		}
 	}
 
-	tag = getTag(*way, "aeroway");
+	tag = getTag(way, "aeroway");
 	if (tag)
 	{
-		if (strcmp(tag->value, "aerodrome") == 0)
+		if (tag->value == "aerodrome")
 		{
-			const char* name = getTagValue(*way, "name");
+			const char* name = getTagValue(way, "name");
 			if (name)
 			{
 				std::vector<sim::LatLon> points;
-				readPoints(*way, data, points);
+				readPoints(way.nodes, context, points);
 				
-				ParserData::ParserAirport airport;
+				ParserAirport airport;
 				airport.name = name;
 				airport.bounds = calcPointBounds(points);
 				airport.areaPolygons = { points };
 				data.airports.emplace_back(airport);
 			}
-		} else  if (strcmp(tag->value, "runway") == 0)
+		} else  if (tag->value == "runway")
 		{
-			const char* name = getTagValue(*way, "ref");
+			const char* name = getTagValue(way, "ref");
 			if (name)
 			{
 				std::vector<sim::LatLon> points;
-				readPoints(*way, data, points);
+				readPoints(way.nodes, context, points);
 				if (!points.empty())
 				{
 					Airport::Runway runway;
 					runway.name = name;
 					runway.start = points.front();
 					runway.end = points.back();
-					runway.width = getTagValueOrDefault(*way, "width", Units::Meters, 45.0);
+					runway.width = getTagValueOrDefault(way, "width", Units::Meters, 45.0);
 
 					data.runways.emplace_back(runway);
 				}
 			}
 		}
 	}
+}
 
-	if (data.features.size() % 100000 == 0)
-		printf("Loaded %zu features\n", data.features.size());
-
-	return READOSM_OK;
+static bool isMultiPolygonOuterWay(const OsmRelationMember& member)
+{
+	return member.type == READOSM_MEMBER_WAY && member.role == "outer";
 }
 
-std::vector<LatLonPoints> readMultiPolygonRelation(const readosm_relation& relation, const ParserData& data)
+std::vector<LatLonPoints> readMultiPolygonRelation(const OsmRelation& relation, const ParserData& data)
 {
 	std::vector<LatLonPoints> polygons;
 	std::vector<std::vector<sim::LatLon>> parts;
 
-	for (int i = 0; i < relation.member_count; ++i)
+	for (const OsmRelationMember& member : relation.members)
 	{
-		const readosm_member& member = relation.members[i];
-		if (member.member_type == READOSM_MEMBER_WAY)
+		if (isMultiPolygonOuterWay(member))
 		{
-			if (strcmp(member.role, "outer") == 0)
+			// Member ways may be missing if the relation crosses the boundary of an extract
+			auto it = data.relationWays.find(member.id);
+			if (it != data.relationWays.end())
 			{
-				const ParserData::Way& way = data.ways.find(member.id)->second;
 				LatLonPoints points;
-				readPoints(way, data, points);
+				readPoints(it->second, data.context, points);
 				if (points.size() >= 2)
 				{
 					parts.emplace_back(points);
@@ -563,39 +638,223 @@ std::vector<LatLonPoints> readMultiPolygonRelation(const readosm_relation& relat
 	return polygons;
 }
 
-int parseRelation(const void* user_data, const readosm_relation* relation)
+static bool isRelationOfInterest(const OsmRelation& relation)
+{
+	return getTagValueString(relation, "natural") == "water"
+		|| (getTagValueString(relation, "aeroway") == "aerodrome" && getTag(relation, "name"));
+}
+
+//! Keeps relations which produce features, and records their member ways so that they can be kept when ways are parsed
+static int parseRelation(const void* user_data, const readosm_relation* relation)
 {
 	ParserData& data = *(ParserData*)user_data;
 
-	if (getTagValueString(*relation, "natural") == "water")
+	OsmRelation parsedRelation;
+	parsedRelation.id = relation->id;
+	parsedRelation.tags = copyTags(*relation);
+	if (!isRelationOfInterest(parsedRelation))
 	{
-		std::vector<LatLonPoints> polygons = readMultiPolygonRelation(*relation, data);
+		return READOSM_OK;
+	}
 
-		std::vector<FeaturePtr>& features = data.features;
+	for (int i = 0; i < relation->member_count; ++i)
+	{
+		const readosm_member& member = relation->members[i];
+		parsedRelation.members.push_back({member.member_type, member.id, member.role ? member.role : ""});
+		if (isMultiPolygonOuterWay(parsedRelation.members.back()))
+		{
+			data.relationWayIds.insert(member.id);
+		}
+	}
+	data.relations.push_back(std::move(parsedRelation));
+
+	return READOSM_OK;
+}
+
+//! Must be called after all ways have been parsed
+static void processRelation(const OsmRelation& relation, const ParserData& data, BlockResult& result)
+{
+	if (getTagValueString(relation, "natural") == "water")
+	{
+		std::vector<LatLonPoints> polygons = readMultiPolygonRelation(relation, data);
+
+		std::vector<FeaturePtr>& features = result.features;
 		for (const LatLonPoints& polygon : polygons)
 		{
 			auto water = std::make_shared<Water>();
-			water->points = toLatLonAlt(polygon, *data.altitudeProvider);
+			water->points = toLatLonAlt(polygon, *data.context.altitudeProvider);
 			features.push_back(water);
 		}
 	}
-	else if (getTagValueString(*relation, "aeroway") == "aerodrome")
+	else if (getTagValueString(relation, "aeroway") == "aerodrome")
 	{
-		const char* name = getTagValue(*relation, "name");
+		const char* name = getTagValue(relation, "name");
 		if (name)
 		{
-			std::vector<LatLonPoints> polygons = readMultiPolygonRelation(*relation, data);
+			std::vector<LatLonPoints> polygons = readMultiPolygonRelation(relation, data);
 			if (!polygons.empty())
 			{
-				ParserData::ParserAirport airport;
+				ParserAirport airport;
 				airport.name = name;
 				airport.bounds = calcPointBounds(polygons.front());
 				airport.areaPolygons = polygons;
-				data.airports.emplace_back(airport);
+				result.airports.emplace_back(airport);
 			}
 		}
 	}
+}
+
+static void mergeBlockResult(BlockResult& result, BlockResult& data)
+{
+	data.features.insert(data.features.end(), result.features.begin(), result.features.end());
+	data.airports.insert(data.airports.end(), result.airports.begin(), result.airports.end());
+	data.runways.insert(data.runways.end(), result.runways.begin(), result.runways.end());
+	for (auto& [node, junction] : result.nodeRoadJunctions)
+	{
+		std::vector<RoadJunction::Item>& roads = data.nodeRoadJunctions[node].roads;
+		roads.insert(roads.end(), junction.roads.begin(), junction.roads.end());
+	}
+	result = BlockResult();
+}
+
+//! Processes blocks of ways on the scheduler's threads while the parser reads further blocks.
+//! The number of blocks held in memory is bounded, with the parser waiting for the oldest block to finish when the limit is reached.
+class WayBlockProcessor
+{
+public:
+	WayBlockProcessor(px_sched::Scheduler* scheduler, const ParserContext& context, BlockResult& output, int maxBlocksInFlight) :
+		mScheduler(scheduler),
+		mContext(context),
+		mOutput(output),
+		mMaxBlocksInFlight(std::max(1, maxBlocksInFlight)),
+		mThroughputReporter("Created features", 100000)
+	{
+	}
+
+	~WayBlockProcessor()
+	{
+		if (mScheduler)
+		{
+			for (const auto& block : mBlocks)
+			{
+				mScheduler->waitFor(block->sync);
+			}
+		}
+	}
+
+	void process(std::vector<OsmWay> ways)
+	{
+		auto block = std::make_unique<Block>();
+		block->ways = std::move(ways);
+
+		if (mScheduler)
+		{
+			mScheduler->run([this, block = block.get()] {
+				processBlock(*block);
+			}, &block->sync);
+			mBlocks.push_back(std::move(block));
 
+			while (mBlocks.size() > std::size_t(mMaxBlocksInFlight))
+			{
+				mergeOldestBlock();
+			}
+		}
+		else
+		{
+			processBlock(*block);
+			mBlocks.push_back(std::move(block));
+			mergeOldestBlock();
+		}
+	}
+
+	//! Waits for all blocks to be processed and merges their results
+	void finish()
+	{
+		while (!mBlocks.empty())
+		{
+			mergeOldestBlock();
+		}
+		mThroughputReporter.finish();
+	}
+
+private:
+	struct Block
+	{
+		std::vector<OsmWay> ways;
+		BlockResult result;
+		std::exception_ptr error;
+		px_sched::Sync sync;
+	};
+
+	// @ThreadSafe
+	void processBlock(Block& block) const
+	{
+		try
+		{
+			for (const OsmWay& way : block.ways)
+			{
+				processWay(way, mContext, block.result);
+			}
+		}
+		catch (...)
+		{
+			block.error = std::current_exception();
+		}
+		block.ways.clear();
+	}
+
+	void mergeOldestBlock()
+	{
+		std::unique_ptr<Block> block = std::move(mBlocks.front());
+		mBlocks.pop_front();
+		if (mScheduler)
+		{
+			mScheduler->waitFor(block->sync);
+		}
+
+		if (block->error)
+		{
+			std::rethrow_exception(block->error);
+		}
+
+		mThroughputReporter.add(block->result.features.size());
+		mergeBlockResult(block->result, mOutput);
+	}
+
+private:
+	px_sched::Scheduler* mScheduler;
+	const ParserContext mContext;
+	BlockResult& mOutput;
+	const int mMaxBlocksInFlight;
+	std::deque<std::unique_ptr<Block>> mBlocks; //!< In file order
+	ThroughputReporter mThroughputReporter;
+};
+
+static int parseWay(const void* user_data, const readosm_way* way)
+{
+	ParserData& data = *(ParserData*)user_data;
+
+	OsmWay parsedWay;
+	parsedWay.id = way->id;
+	parsedWay.tags = copyTags(*way);
+	parsedWay.nodes.assign(way->node_refs, way->node_refs + way->node_ref_count);
+
+	if (data.relationWayIds.find(way->id) != data.relationWayIds.end())
+	{
+		data.relationWays[way->id] = parsedWay.nodes;
+	}
+
+	if (!parsedWay.tags.empty())
+	{
+		data.pendingWays.push_back(std::move(parsedWay));
+		if (data.pendingWays.size() >= data.wayBlockSize)
+		{
+			data.wayBlockProcessor->process(std::move(data.pendingWays));
+			data.pendingWays.clear();
+		}
+	}
+
+	data.throughputReporter->add();
 	return READOSM_OK;
 }
 
@@ -611,12 +870,12 @@ sim::LatLon approxAverage(const sim::LatLon& a, const sim::LatLon& b)
 	return sim::LatLon((a.lat + b.lat) / 2.0, (a.lon + b.lon) / 2.0);
 }
 
-const ParserData::ParserAirport* findClosestAirport(const ParserData& data, const sim::LatLon& position)
+const ParserAirport* findClosestAirport(const ParserData& data, const sim::LatLon& position)
 {
-	const ParserData::ParserAirport* result = nullptr;
+	const ParserAirport* result = nullptr;
 	double resultDistance = 0.0;
 	
-	for (const ParserData::ParserAirport& airport : data.airports)
+	for (const ParserAirport& airport : data.airports)
 	{
 		LatLon boundsSize = airport.bounds.size();
 		double airportRadius = std::max(boundsSize.lat, boundsSize.lon); // only accept airports within this radius
@@ -632,7 +891,7 @@ const ParserData::ParserAirport* findClosestAirport(const ParserData& data, cons
 
 std::map<std::string, AirportPtr> createAirports(const ParserData& data, const sim::PlanetAltitudeProvider& provider)
 {
-	std::map<const ParserData::ParserAirport*, AirportPtr> airports;
+	std::map<const ParserAirport*, AirportPtr> airports;
 	for (const auto& v : data.airports)
 	{
 		auto airport = std::make_shared<Airport>();
@@ -645,7 +904,7 @@ std::map<std::string, AirportPtr> createAirports(const ParserData& data, const s
 	for (const auto& runway : data.runways)
 	{
 		// Add to closest airport
-		const ParserData::ParserAirport* airport = findClosestAirport(data, approxAverage(runway.start, runway.end));
+		const ParserAirport* airport = findClosestAirport(data, approxAverage(runway.start, runway.end));
 		if (airport)
 		{
 			airports[airport]->runways.push_back(runway);
@@ -672,10 +931,9 @@ static void joinRoadsAtJunctions(const ParserData& data)
 	}
 }
 
-ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider)
+//! Parses the file, calling the callbacks for each OSM object. Objects with null callbacks are skipped.
+static void parseFile(const std::string& filename, ParserData& data, readosm_node_callback nodeCallback, readosm_way_callback wayCallback, readosm_relation_callback relationCallback)
 {
-	ParserData data;
-	data.altitudeProvider = &provider;
 	const void *osm_handle;
 	try
 	{
@@ -687,7 +945,7 @@ ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProv
 		}
 
 		const void *userData = &data;
-		ret = readosm_parse(osm_handle, userData, parseNode, parseWay, parseRelation);
+		ret = readosm_parse(osm_handle, userData, nodeCallback, wayCallback, relationCallback);
 		if (ret != READOSM_OK)
 		{
 			std::stringstream ss;
@@ -701,6 +959,71 @@ ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProv
 		throw skybolt::Exception("Error converting " + filename + ". Reason: " + e.what());
 	}
 	readosm_close(osm_handle);
+}
+
+static void processRelations(ParserData& data, px_sched::Scheduler* scheduler)
+{
+	std::vector<BlockResult> results(data.relations.size());
+	std::vector<std::exception_ptr> errors(data.relations.size());
+
+	parallelFor(scheduler, data.relations.size(), /* minBatchSize */ 16, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			try
+			{
+				processRelation(data.relations[i], data, results[i]);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		}
+	});
+
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		if (errors[i])
+		{
+			std::rethrow_exception(errors[i]);
+		}
+		mergeBlockResult(results[i], data);
+	}
+}
+
+ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider, const ReadPbfOptions& options)
+{
+	ParserData data;
+	data.nodes = std::make_unique<NodeLocationIndex>(options.nodeIndexFilename.empty() ? (filename + ".nodes") : options.nodeIndexFilename);
+	data.context.nodes = data.nodes.get();
+	data.context.altitudeProvider = &provider;
+	data.wayBlockSize = std::max(std::size_t(1), options.wayBlockSize);
+
+	// Pass 1. Index node locations and keep relations of interest.
+	// Relations are read before ways so that only ways which are members of relations need to be kept.
+	printf("Indexing nodes and reading relations\n");
+	data.throughputReporter = std::make_unique<ThroughputReporter>("Indexed nodes", 1000000);
+	parseFile(filename, data, parseNode, nullptr, parseRelation);
+	data.nodes->finishAdding();
+	data.throughputReporter->finish();
+	printf("Found %zu relations with %zu member ways\n", data.relations.size(), data.relationWayIds.size());
+
+	// Pass 2. Create features from ways.
+	printf("Creating features from ways\n");
+	int maxBlocksInFlight = options.maxBlocksInFlight;
+	if (maxBlocksInFlight <= 0)
+	{
+		maxBlocksInFlight = options.scheduler ? 2 * (int(options.scheduler->params().num_threads) + 1) : 1;
+	}
+	data.throughputReporter = std::make_unique<ThroughputReporter>("Parsed ways", 1000000);
+	data.wayBlockProcessor = std::make_unique<WayBlockProcessor>(options.scheduler, data.context, data, maxBlocksInFlight);
+	parseFile(filename, data, nullptr, parseWay, nullptr);
+	data.wayBlockProcessor->process(std::move(data.pendingWays));
+	data.wayBlockProcessor->finish();
+	data.throughputReporter->finish();
+
+	// Create features from relations, now that all member ways are known
+	printf("Creating features from %zu relations\n", data.relations.size());
+	processRelations(data, options.scheduler);
 
 	printf("Connecting roads at %zu connection points\n", data.nodeRoadJunctions.size());
 	joinRoadsAtJunctions(data);
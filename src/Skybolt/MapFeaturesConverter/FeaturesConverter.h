@@ -9,6 +9,8 @@
 #include <SkyboltSim/PlanetAltitudeProvider.h>
 #include <SkyboltVis/Renderable/Planet/Features/PlanetFeaturesSource.h>
 
+namespace px_sched { class Scheduler; }
+
 namespace skybolt {
 namespace mapfeatures {
 
@@ -17,7 +19,20 @@ struct ReadPbfResult
 	std::vector<FeaturePtr> features; //!< All the features
 	std::map<std::string, AirportPtr> airports; //!< Map of names to airport features
 };
-ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider);
+
+struct ReadPbfOptions
+{
+	px_sched::Scheduler* scheduler = nullptr; //!< If set, ways and relations are processed in parallel. May be null.
+	std::string nodeIndexFilename; //!< Temporary file for the node location index. If empty, the input filename with a '.nodes' suffix is used.
+	std::size_t wayBlockSize = 10000; //!< Number of ways processed together in one task
+	int maxBlocksInFlight = 0; //!< Maximum number of way blocks held in memory at once. If 0, a value based on the thread count is used.
+};
+
+//! Reads features from an OSM PBF file in two passes. The first pass writes node locations to a memory mapped index file,
+//! so memory use does not grow with the number of nodes. The second pass processes ways in parallel blocks.
+//! Nodes in the file must be sorted by ID.
+//! @param provider must be thread safe if options.scheduler is set
+ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider, const ReadPbfOptions& options = {});
 
 } // namespace mapfeatures
 } // namespace skybolt
\ No newline at end of file
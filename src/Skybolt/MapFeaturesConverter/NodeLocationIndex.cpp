@@ -0,0 +1,128 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "NodeLocationIndex.h"
+#include <SkyboltCommon/Exception.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <tuple>
+
+namespace bip = boost::interprocess;
+
+namespace skybolt {
+namespace mapfeatures {
+
+//! OSM stores coordinates as integer multiples of 1e-7 degrees
+constexpr double fixedPointDegreesScale = 1e7;
+
+struct NodeLocationRecord
+{
+	std::int64_t id;
+	std::int32_t latitude; //!< Fixed point degrees
+	std::int32_t longitude; //!< Fixed point degrees
+};
+
+static_assert(sizeof(NodeLocationRecord) == 16, "NodeLocationRecord must be tightly packed");
+
+//! @returns true if node ID a comes before b in sorted OSM files.
+//! Non-positive IDs come first, in increasing order of magnitude, followed by positive IDs.
+static bool isBeforeInSortOrder(std::int64_t a, std::int64_t b)
+{
+	// Magnitudes are computed with unsigned arithmetic so that the most negative ID does not overflow
+	auto getMagnitude = [] (std::int64_t id) { return (id < 0) ? std::uint64_t(0) - std::uint64_t(id) : std::uint64_t(id); };
+	return std::make_tuple(a > 0, getMagnitude(a)) < std::make_tuple(b > 0, getMagnitude(b));
+}
+
+NodeLocationIndex::NodeLocationIndex(const std::string& filename) :
+	mFilename(filename),
+	mWriter(filename, std::ios::out | std::ios::binary | std::ios::trunc)
+{
+	if (!mWriter)
+	{
+		throw skybolt::Exception("Could not create node location index file '" + filename + "'");
+	}
+}
+
+NodeLocationIndex::~NodeLocationIndex()
+{
+	mMapping.reset();
+	mWriter.close();
+
+	std::error_code error;
+	std::filesystem::remove(mFilename, error);
+}
+
+void NodeLocationIndex::add(std::int64_t id, double latitudeDegrees, double longitudeDegrees)
+{
+	assert(!mMapping);
+	if (mLastAddedId && !isBeforeInSortOrder(*mLastAddedId, id))
+	{
+		throw skybolt::Exception("Nodes are not sorted by ID. Sort the input file, e.g with 'osmium sort', before converting.");
+	}
+	mLastAddedId = id;
+
+	NodeLocationRecord record;
+	record.id = id;
+	record.latitude = std::int32_t(std::llround(latitudeDegrees * fixedPointDegreesScale));
+	record.longitude = std::int32_t(std::llround(longitudeDegrees * fixedPointDegreesScale));
+	mWriter.write((const char*)&record, sizeof(record));
+	++mSize;
+}
+
+void NodeLocationIndex::finishAdding()
+{
+	mWriter.close();
+	if (!mWriter)
+	{
+		throw skybolt::Exception("Could not write node location index file '" + mFilename + "'");
+	}
+
+	if (mSize == 0)
+	{
+		return;
+	}
+
+	bip::file_mapping fileMapping(mFilename.c_str(), bip::read_only);
+	mMapping = std::make_unique<bip::mapped_region>(fileMapping, bip::read_only, 0, mSize * sizeof(NodeLocationRecord));
+	mRecords = static_cast<const NodeLocationRecord*>(mMapping->get_address());
+}
+
+std::optional<sim::LatLon> NodeLocationIndex::find(std::int64_t id) const
+{
+	const NodeLocationRecord* end = mRecords + mSize;
+	const NodeLocationRecord* i = std::lower_bound(mRecords, end, id, [] (const NodeLocationRecord& record, std::int64_t id) {
+		return isBeforeInSortOrder(record.id, id);
+	});
+
+	if (i == end || i->id != id)
+	{
+		return std::nullopt;
+	}
+
+	const double scale = math::degToRadD() / fixedPointDegreesScale;
+	return sim::LatLon(double(i->latitude) * scale, double(i->longitude) * scale);
+}
+
+sim::LatLon NodeLocationIndex::get(std::int64_t id) const
+{
+	std::optional<sim::LatLon> location = find(id);
+	if (!location)
+	{
+		throw skybolt::Exception("Invalid node ID " + std::to_string(id));
+	}
+	return *location;
+}
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -0,0 +1,67 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltSim/Spatial/LatLon.h>
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace boost::interprocess {
+class mapped_region;
+}
+
+namespace skybolt {
+namespace mapfeatures {
+
+struct NodeLocationRecord;
+
+//! Index of OSM node locations stored in a flat file which is memory mapped for lookups,
+//! so that the nodes of a large region do not need to fit in RAM.
+//! Nodes must be added in the order of sorted OSM files, as produced by 'osmium sort'. This is non-positive IDs
+//! (e.g. negative IDs from JOSM exports) in increasing order of magnitude, followed by positive IDs in increasing order.
+//! Locations are stored in the OSM fixed point format, so are exactly preserved.
+class NodeLocationIndex
+{
+public:
+	//! @param filename is the file to store the index in. The file is deleted when the index is destroyed.
+	NodeLocationIndex(const std::string& filename);
+	~NodeLocationIndex();
+
+	//! Must not be called after finishAdding()
+	void add(std::int64_t id, double latitudeDegrees, double longitudeDegrees);
+
+	//! Finishes writing the index and maps it for lookups
+	void finishAdding();
+
+	//! Must only be called after finishAdding()
+	//! @returns the node location, or empty if the node is not in the index
+	//! @ThreadSafe
+	std::optional<sim::LatLon> find(std::int64_t id) const;
+
+	//! Must only be called after finishAdding()
+	//! @throws skybolt::Exception if the node is not in the index
+	//! @ThreadSafe
+	sim::LatLon get(std::int64_t id) const;
+
+	std::size_t size() const { return mSize; }
+
+private:
+	const std::string mFilename;
+	std::ofstream mWriter;
+	std::optional<std::int64_t> mLastAddedId;
+	std::size_t mSize = 0;
+
+	std::unique_ptr<boost::interprocess::mapped_region> mMapping; //!< Null if the index is empty
+	const NodeLocationRecord* mRecords = nullptr;
+};
+
+} // namespace mapfeatures
+} // namespace skybolt
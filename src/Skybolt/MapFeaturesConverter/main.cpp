@@ -12,12 +12,17 @@
 #include "HeightmapLeveler.h"
 #endif
 
+//! If defined, existing tiles in the output directory are converted to the packed format instead of being regenerated
+//#define CONVERT_LEGACY_FEATURE_TILES
+
 #define PX_SCHED_IMPLEMENTATION 1
 #include <px_sched/px_sched.h>
 
 #include <SkyboltVis/ElevationProvider/TilePlanetAltitudeProvider.h>
+#include <SkyboltVis/Renderable/Planet/Features/PackedFeatureTile.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/CachedTileSource.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/MapboxElevationTileSource.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/PackedTileCache.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/SphericalMercatorToPlateCarreeTileSource.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/XyzTileSource.h>
 #include <SkyboltEngine/EngineCommandLineParser.h>
@@ -41,6 +46,12 @@ int main(int argc, char *argv[])
 {
 	try
 	{
+#ifdef CONVERT_LEGACY_FEATURE_TILES
+		std::size_t convertedTileCount = mapfeatures::convertTilesToPackedFormat(outputDirectory);
+		printf("Converted %zu feature tiles to packed format\n", convertedTileCount);
+		return 0;
+#endif
+
 		auto params = EngineCommandLineParser::parse(argc, argv);
 		nlohmann::json settings = readEngineSettings(params);
 		auto tileApiKeys = readNameMap<std::string>(settings, "tileApiKeys");
@@ -66,10 +77,18 @@ int main(int argc, char *argv[])
 
 		auto uncachedTileSource = std::make_shared<SphericalMercatorToPlateCarreeTileSource>(std::make_shared<MapboxElevationTileSource>(config));
 		std::string tileSourceCacheDirectory = tileCacheDirectory  + "/" + calcSha1(config.urlTemplate);
-		auto tileSource = std::make_shared<CachedTileSource>(uncachedTileSource, tileSourceCacheDirectory);
+		PackedTileCacheConfig cacheConfig;
+		cacheConfig.directory = tileSourceCacheDirectory;
+		auto tileSource = std::make_shared<CachedTileSource>(uncachedTileSource, std::make_shared<PackedTileCache>(cacheConfig));
 #endif
+		px_sched::Scheduler scheduler;
+		scheduler.init();
+
 		BlockingTilePlanetAltitudeProvider altitudeProvider(tileSource, maxHeightmapTileLod);
-		ReadPbfResult result = mapfeatures::readPbf("washington-latest.osm.pbf", altitudeProvider);
+
+		ReadPbfOptions readOptions;
+		readOptions.scheduler = &scheduler;
+		ReadPbfResult result = mapfeatures::readPbf("washington-latest.osm.pbf", altitudeProvider, readOptions);
 		{
 			printf("Feature Conversion Stats:\n%s\n", mapfeatures::statsToString(result.features).c_str());
 
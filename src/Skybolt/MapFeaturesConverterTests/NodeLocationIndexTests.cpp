@@ -0,0 +1,180 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <MapFeaturesConverter/NodeLocationIndex.h>
+#include <SkyboltCommon/Exception.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <filesystem>
+#include <limits>
+
+using namespace skybolt;
+using namespace skybolt::mapfeatures;
+
+namespace fs = std::filesystem;
+
+static fs::path createEmptyTemporaryDirectory(const std::string& name)
+{
+	fs::path path = fs::temp_directory_path() / "SkyboltTests" / "NodeLocationIndex" / name;
+	fs::remove_all(path);
+	fs::create_directories(path);
+	return path;
+}
+
+//! @returns the location which the index returns for a location stored in OSM fixed point degrees
+static sim::LatLon fixedPointToLatLon(std::int32_t latitude, std::int32_t longitude)
+{
+	const double scale = math::degToRadD() / 1e7;
+	return sim::LatLon(double(latitude) * scale, double(longitude) * scale);
+}
+
+TEST_CASE("NodeLocationIndex round trips locations at coordinate extremes")
+{
+	fs::path directory = createEmptyTemporaryDirectory("Extremes");
+	NodeLocationIndex index((directory / "index.nodes").string());
+	index.add(1, 90.0, 180.0);
+	index.add(2, -90.0, -180.0);
+	index.add(3, 90.0, -180.0);
+	index.add(4, -90.0, 180.0);
+	index.add(1000000000000, 0.0, 0.0);
+	index.finishAdding();
+
+	CHECK(index.size() == 5);
+	CHECK(index.get(1) == fixedPointToLatLon(900000000, 1800000000));
+	CHECK(index.get(2) == fixedPointToLatLon(-900000000, -1800000000));
+	CHECK(index.get(3) == fixedPointToLatLon(900000000, -1800000000));
+	CHECK(index.get(4) == fixedPointToLatLon(-900000000, 1800000000));
+	CHECK(index.get(1000000000000) == fixedPointToLatLon(0, 0));
+
+	CHECK(index.get(1).lat == Approx(math::halfPiD()));
+	CHECK(index.get(1).lon == Approx(math::piD()));
+	CHECK(index.get(2).lat == Approx(-math::halfPiD()));
+	CHECK(index.get(2).lon == Approx(-math::piD()));
+}
+
+TEST_CASE("NodeLocationIndex rounds locations to the nearest OSM fixed point value")
+{
+	fs::path directory = createEmptyTemporaryDirectory("Rounding");
+	NodeLocationIndex index((directory / "index.nodes").string());
+	index.add(10, 51.5074456, -0.1277653); // exactly representable in the fixed point format
+	index.add(11, 51.50744564, -0.12776534); // rounds down in magnitude
+	index.add(12, 51.50744556, -0.12776526); // rounds up in magnitude
+	index.add(13, 1e-8, -1e-8); // rounds to zero
+	index.add(14, 6e-8, -6e-8); // rounds away from zero
+	index.finishAdding();
+
+	CHECK(index.get(10) == fixedPointToLatLon(515074456, -1277653));
+	CHECK(index.get(11) == fixedPointToLatLon(515074456, -1277653));
+	CHECK(index.get(12) == fixedPointToLatLon(515074456, -1277653));
+	CHECK(index.get(13) == fixedPointToLatLon(0, 0));
+	CHECK(index.get(14) == fixedPointToLatLon(1, -1));
+}
+
+TEST_CASE("NodeLocationIndex reports nodes which are not in the index")
+{
+	fs::path directory = createEmptyTemporaryDirectory("Missing");
+
+	SECTION("Populated index")
+	{
+		NodeLocationIndex index((directory / "index.nodes").string());
+		index.add(2, 1.0, 2.0);
+		index.add(4, 3.0, 4.0);
+		index.finishAdding();
+
+		for (std::int64_t id : {std::int64_t(1), std::int64_t(3), std::int64_t(5), std::int64_t(-1)})
+		{
+			CHECK(!index.find(id));
+			CHECK_THROWS_WITH(index.get(id), "Invalid node ID " + std::to_string(id));
+		}
+		CHECK(index.find(4));
+	}
+
+	SECTION("Empty index")
+	{
+		NodeLocationIndex index((directory / "index.nodes").string());
+		index.finishAdding();
+
+		CHECK(index.size() == 0);
+		CHECK(!index.find(1));
+		CHECK_THROWS_AS(index.get(1), skybolt::Exception);
+	}
+}
+
+TEST_CASE("NodeLocationIndex round trips negative node IDs in osmium sort order")
+{
+	fs::path directory = createEmptyTemporaryDirectory("NegativeIds");
+	NodeLocationIndex index((directory / "index.nodes").string());
+	index.add(std::numeric_limits<std::int64_t>::min() + 1, 0.0, 0.0);
+	index.add(std::numeric_limits<std::int64_t>::min(), 0.0, 1.0);
+	index.finishAdding();
+	CHECK(index.get(std::numeric_limits<std::int64_t>::min() + 1) == fixedPointToLatLon(0, 0));
+	CHECK(index.get(std::numeric_limits<std::int64_t>::min()) == fixedPointToLatLon(0, 10000000));
+}
+
+TEST_CASE("NodeLocationIndex accepts negative, zero and positive node IDs")
+{
+	fs::path directory = createEmptyTemporaryDirectory("MixedIds");
+	NodeLocationIndex index((directory / "index.nodes").string());
+
+	// Order produced by 'osmium sort'
+	index.add(0, 0.5, -0.5);
+	index.add(-1, 1.0, -1.0);
+	index.add(-2, 2.0, -2.0);
+	index.add(-10, 10.0, -10.0);
+	index.add(1, 3.0, -3.0);
+	index.add(7, 7.0, -7.0);
+	index.finishAdding();
+
+	CHECK(index.size() == 6);
+	CHECK(index.get(-1) == fixedPointToLatLon(10000000, -10000000));
+	CHECK(index.get(-2) == fixedPointToLatLon(20000000, -20000000));
+	CHECK(index.get(-10) == fixedPointToLatLon(100000000, -100000000));
+	CHECK(index.get(0) == fixedPointToLatLon(5000000, -5000000));
+	CHECK(index.get(1) == fixedPointToLatLon(30000000, -30000000));
+	CHECK(index.get(7) == fixedPointToLatLon(70000000, -70000000));
+
+	for (std::int64_t id : {std::int64_t(-3), std::int64_t(-11), std::int64_t(2), std::int64_t(8)})
+	{
+		CHECK(!index.find(id));
+	}
+}
+
+TEST_CASE("NodeLocationIndex rejects nodes which are not sorted by ID")
+{
+	fs::path directory = createEmptyTemporaryDirectory("Unsorted");
+
+	SECTION("Positive IDs")
+	{
+		NodeLocationIndex index((directory / "index.nodes").string());
+		index.add(5, 1.0, 2.0);
+		CHECK_THROWS_AS(index.add(5, 1.0, 2.0), skybolt::Exception);
+		CHECK_THROWS_AS(index.add(4, 1.0, 2.0), skybolt::Exception);
+		CHECK_THROWS_AS(index.add(-1, 1.0, 2.0), skybolt::Exception);
+	}
+
+	SECTION("Negative IDs")
+	{
+		NodeLocationIndex index((directory / "index.nodes").string());
+		index.add(-5, 1.0, 2.0);
+		CHECK_THROWS_AS(index.add(-5, 1.0, 2.0), skybolt::Exception);
+		CHECK_THROWS_AS(index.add(-4, 1.0, 2.0), skybolt::Exception);
+	}
+}
+
+TEST_CASE("NodeLocationIndex deletes its file when destroyed")
+{
+	fs::path directory = createEmptyTemporaryDirectory("Cleanup");
+	fs::path filename = directory / "index.nodes";
+	{
+		NodeLocationIndex index(filename.string());
+		index.add(1, 1.0, 2.0);
+		index.finishAdding();
+		CHECK(fs::exists(filename));
+	}
+	CHECK(!fs::exists(filename));
+}
@@ -0,0 +1,92 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace skybolt {
+
+//! Holds an object which can be read concurrently without locking while it is being modified.
+//! Two copies of the object are kept. Readers use one copy while a writer modifies the other,
+//! then the copies are swapped and the writer waits for readers of the old copy to finish before applying the same modification to it.
+//! Reads are wait-free. Writes are serialized and may wait for in-progress reads, so are best suited to read-mostly data.
+//! See "Left-Right: A Concurrency Control Technique with Wait-Free Population Oblivious Reads", Ramalhete and Correia.
+//! @ThreadSafe
+template <typename T>
+class LeftRight
+{
+public:
+	template <typename... Args>
+	explicit LeftRight(const Args&... args) :
+		mInstances{T(args...), T(args...)}
+	{
+	}
+
+	LeftRight(const LeftRight&) = delete;
+	LeftRight& operator=(const LeftRight&) = delete;
+
+	//! Calls reader with a const reference to the object, and returns the reader's result.
+	//! The reference must not be used after the reader returns.
+	template <typename Reader>
+	auto read(Reader&& reader) const
+	{
+		ReadGuard guard(mReaderCounts[mVersionIndex.load()]);
+		return reader(static_cast<const T&>(mInstances[mReadIndex.load()]));
+	}
+
+	//! Calls writer twice, once with each copy of the object, so writer must make the same modification each time it is called.
+	template <typename Writer>
+	void modify(Writer&& writer)
+	{
+		std::scoped_lock<std::mutex> lock(mWriterMutex);
+
+		int readIndex = mReadIndex.load();
+		writer(mInstances[1 - readIndex]);
+		mReadIndex.store(1 - readIndex);
+
+		// Wait for readers which may still be using the old read instance
+		int versionIndex = mVersionIndex.load();
+		waitForReaders(mReaderCounts[1 - versionIndex]);
+		mVersionIndex.store(1 - versionIndex);
+		waitForReaders(mReaderCounts[versionIndex]);
+
+		writer(mInstances[readIndex]);
+	}
+
+private:
+	struct alignas(64) ReaderCount
+	{
+		std::atomic<std::int64_t> count = 0;
+	};
+
+	struct ReadGuard
+	{
+		ReadGuard(ReaderCount& readerCount) : readerCount(readerCount) { ++readerCount.count; }
+		~ReadGuard() { --readerCount.count; }
+		ReaderCount& readerCount;
+	};
+
+	static void waitForReaders(const ReaderCount& readerCount)
+	{
+		while (readerCount.count.load() != 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	T mInstances[2];
+	std::atomic<int> mReadIndex = 0; //!< Index of instance to read from
+	std::atomic<int> mVersionIndex = 0; //!< Index of reader count that new readers increment
+	mutable ReaderCount mReaderCounts[2];
+	std::mutex mWriterMutex;
+};
+
+} // namespace skybolt
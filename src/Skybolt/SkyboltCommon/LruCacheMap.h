@@ -57,6 +57,19 @@ struct LruCacheMap
 		return false;
 	}
 
+	//! @returns true if the item was found and removed
+	bool erase(const KeyT& key)
+	{
+		auto it = mEntries.find(key);
+		if (it == mEntries.end())
+		{
+			return false;
+		}
+		mQueue.erase(it->second);
+		mEntries.erase(it);
+		return true;
+	}
+
 	size_t size() const
 	{
 		return mEntries.size();
@@ -7,6 +7,8 @@
 #include "InterpolateTableLinear.h"
 #include "MathUtility.h"
 
+#include <algorithm>
+
 namespace skybolt {
 namespace math {
 
@@ -27,17 +29,15 @@ std::optional<InterpolationPoint> findInterpolationPoint(const std::vector<doubl
 	}
 
 	// Find left bound
-	int i = 0;                                                                  
+	int i = 0;
 	if (x >= xData[size - 2]) // Make sure we're not past the right bound
 	{
 		i = size - 2;
 	}
 	else
 	{
-		while (x > xData[i + 1])
-		{
-			i++;
-		}
+		// Binary search for the first right bound not less than x
+		i = int(std::lower_bound(xData.begin() + 1, xData.begin() + size - 1, x) - xData.begin()) - 1;
 	}
 	double xL = xData[i];
 	double xR = xData[i + 1];
@@ -0,0 +1,53 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <px_sched/px_sched.h>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace skybolt {
+
+/*! Splits the range [0, count) into contiguous batches and calls func(begin, end) for each batch.
+	Batches are distributed across the scheduler's worker threads, with the calling thread processing the first batch.
+	Blocks until all batches have been processed.
+	@param scheduler if null, the whole range is processed on the calling thread.
+	@param minBatchSize minimum number of items per batch. Ranges smaller than this are processed on the calling thread.
+*/
+template <typename FuncT>
+void parallelFor(px_sched::Scheduler* scheduler, std::size_t count, std::size_t minBatchSize, const FuncT& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (!scheduler || count <= minBatchSize)
+	{
+		func(std::size_t(0), count);
+		return;
+	}
+
+	// Use one batch per worker thread plus one for the calling thread
+	std::size_t batchCount = std::size_t(scheduler->params().num_threads) + 1;
+	std::size_t batchSize = std::max(std::max(minBatchSize, std::size_t(1)), (count + batchCount - 1) / batchCount);
+
+	px_sched::Sync sync;
+	for (std::size_t begin = batchSize; begin < count; begin += batchSize)
+	{
+		std::size_t end = std::min(count, begin + batchSize);
+		scheduler->run([&func, begin, end] {
+			func(begin, end);
+		}, &sync);
+	}
+
+	func(std::size_t(0), std::min(batchSize, count));
+	scheduler->waitFor(sync);
+}
+
+} // namespace skybolt
@@ -0,0 +1,72 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace skybolt {
+
+//! First-in first-out queue which items can be pushed to from any thread, and which is processed
+//! on one thread within a time budget, e.g. to add the results of background loads to the scene each frame.
+//! @ThreadSafe
+template <typename T>
+class TimeBudgetedQueue
+{
+public:
+	void push(T item)
+	{
+		std::scoped_lock<std::mutex> lock(mMutex);
+		mItems.push_back(std::move(item));
+	}
+
+	//! Pops items in the order they were pushed and passes each to process(item), until the queue is empty or the time budget is spent.
+	//! process() returns true if it processed the item, or false if it skipped it.
+	//! At least one item is processed regardless of the budget, if there are any items which are not skipped.
+	//! @returns the number of items processed
+	template <typename ProcessT>
+	std::size_t process(double timeBudgetMilliseconds, const ProcessT& process)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		auto budget = std::chrono::duration<double, std::milli>(timeBudgetMilliseconds);
+		std::size_t processedCount = 0;
+
+		while (processedCount == 0 || std::chrono::steady_clock::now() - startTime <= budget)
+		{
+			T item;
+			{
+				std::scoped_lock<std::mutex> lock(mMutex);
+				if (mItems.empty())
+				{
+					break;
+				}
+				item = std::move(mItems.front());
+				mItems.pop_front();
+			}
+
+			// Items are processed without holding the lock, so that pushes are not blocked
+			if (process(item))
+			{
+				++processedCount;
+			}
+		}
+		return processedCount;
+	}
+
+	std::size_t size() const
+	{
+		std::scoped_lock<std::mutex> lock(mMutex);
+		return mItems.size();
+	}
+
+private:
+	mutable std::mutex mMutex;
+	std::deque<T> mItems;
+};
+
+} // namespace skybolt
@@ -44,6 +44,18 @@ inline std::vector<std::type_index> getExposedTypes(const T& type)
 	return { typeid(type) };
 }
 
+//! @returns hash of type T, computed once per type
+template <class T>
+std::size_t getTypeHash()
+{
+	static const std::size_t hash = typeid(T).hash_code();
+	return hash;
+}
+
+/*! Stores items which can be looked up by any of their exposed types.
+	Items are grouped by exposed type in a small flat array, which is scanned by precomputed type hash.
+	This is faster than a tree lookup for the small number of types (typically 5-20) stored in a container.
+*/
 template <typename BaseT>
 class TypedItemContainer
 {
@@ -52,7 +64,8 @@ class TypedItemContainer
 public:
 	virtual ~TypedItemContainer()
 	{
-		mComponentMap.clear();
+		mTypeHashes.clear();
+		mTypeEntries.clear();
 		// Delete components in reverse order
 		for (int i = (int)mComponents.size() - 1; i >= 0; --i)
 		{
@@ -66,7 +79,16 @@ public:
 
 		for (const auto& type : getExposedTypes(*c))
 		{
-			mComponentMap.insert(typename ComponentMap::value_type(type, c));
+			std::size_t hash = type.hash_code();
+			if (TypeEntry* entry = findTypeEntry(hash, type); entry)
+			{
+				entry->items.push_back(c);
+			}
+			else
+			{
+				mTypeHashes.push_back(hash);
+				mTypeEntries.push_back(TypeEntry{type, {c}});
+			}
 		}
 	}
 
@@ -80,16 +102,10 @@ public:
 			}
 		}
 
-		for (auto it = mComponentMap.begin(); it != mComponentMap.end();)
+		// Empty type entries are retained because the same types are likely to be added again
+		for (TypeEntry& entry : mTypeEntries)
 		{
-			if (it->second == c)
-			{
-				it = mComponentMap.erase(it);
-			}
-			else
-			{
-				++it;
-			}
+			entry.items.erase(std::remove(entry.items.begin(), entry.items.end(), c), entry.items.end());
 		}
 	}
 
@@ -99,17 +115,16 @@ public:
 	{
 		std::vector<std::shared_ptr<DerivedT> > result;
 
-		std::type_index index = typeid(DerivedT);
-		typename ComponentMap::const_iterator it = mComponentMap.lower_bound(index);
-		typename ComponentMap::const_iterator it2 = mComponentMap.upper_bound(index);
-
-		while (it != it2)
+		if (const TypeEntry* entry = findTypeEntry(getTypeHash<DerivedT>(), typeid(DerivedT)); entry)
 		{
-			if (const auto& p = detail::static_or_dynamic_pointer_cast<BaseT, DerivedT>(it->second); p)
+			result.reserve(entry->items.size());
+			for (const BaseTPtr& item : entry->items)
 			{
-				result.push_back(p);
+				if (const auto& p = detail::static_or_dynamic_pointer_cast<BaseT, DerivedT>(item); p)
+				{
+					result.push_back(p);
+				}
 			}
-			++it;
 		}
 
 		return result;
@@ -124,10 +139,9 @@ public:
 	template <class DerivedT>
 	std::shared_ptr<DerivedT> getFirstItemOfType() const
 	{
-		typename ComponentMap::const_iterator i = mComponentMap.find(typeid(DerivedT));
-		if (i != mComponentMap.end())
+		if (const TypeEntry* entry = findTypeEntry(getTypeHash<DerivedT>(), typeid(DerivedT)); entry && !entry->items.empty())
 		{
-			return detail::static_or_dynamic_pointer_cast<BaseT, DerivedT>(i->second);
+			return detail::static_or_dynamic_pointer_cast<BaseT, DerivedT>(entry->items.front());
 		}
 
 		return nullptr;
@@ -137,9 +151,33 @@ protected:
 	std::vector<BaseTPtr> mComponents;
 
 private:
-	typedef std::multimap<std::type_index, BaseTPtr> ComponentMap;
-	ComponentMap mComponentMap;
+	struct TypeEntry
+	{
+		std::type_index type;
+		std::vector<BaseTPtr> items; //!< Items exposing this type, in order of addition
+	};
+
+	const TypeEntry* findTypeEntry(std::size_t hash, const std::type_index& type) const
+	{
+		for (std::size_t i = 0; i < mTypeHashes.size(); ++i)
+		{
+			if (mTypeHashes[i] == hash && mTypeEntries[i].type == type)
+			{
+				return &mTypeEntries[i];
+			}
+		}
+		return nullptr;
+	}
 
+	TypeEntry* findTypeEntry(std::size_t hash, const std::type_index& type)
+	{
+		return const_cast<TypeEntry*>(static_cast<const TypedItemContainer*>(this)->findTypeEntry(hash, type));
+	}
+
+private:
+	// Type hashes are stored separately from entries so that lookups scan a small contiguous array
+	std::vector<std::size_t> mTypeHashes;
+	std::vector<TypeEntry> mTypeEntries; //!< Parallel to mTypeHashes
 };
 
 } // namespace skybolt
\ No newline at end of file
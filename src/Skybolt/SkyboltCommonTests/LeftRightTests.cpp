@@ -0,0 +1,69 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltCommon/LeftRight.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace skybolt;
+
+TEST_CASE("LeftRight modifications are visible to readers")
+{
+	LeftRight<std::map<int, int>> leftRight;
+	leftRight.modify([] (std::map<int, int>& m) { m[1] = 2; });
+	CHECK(leftRight.read([] (const std::map<int, int>& m) { return m.at(1); }) == 2);
+
+	leftRight.modify([] (std::map<int, int>& m) { m[1] = 3; });
+	CHECK(leftRight.read([] (const std::map<int, int>& m) { return m.at(1); }) == 3);
+}
+
+TEST_CASE("LeftRight readers see consistent state during concurrent modification")
+{
+	// Writer keeps both values equal. Readers should never see different values.
+	struct Pair
+	{
+		int a = 0;
+		int b = 0;
+	};
+	LeftRight<Pair> leftRight;
+
+	std::atomic<bool> stop = false;
+	std::atomic<int> inconsistentReadCount = 0;
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 4; ++i)
+	{
+		readers.emplace_back([&] {
+			while (!stop)
+			{
+				if (!leftRight.read([] (const Pair& p) { return p.a == p.b; }))
+				{
+					++inconsistentReadCount;
+				}
+			}
+		});
+	}
+
+	for (int i = 0; i < 10000; ++i)
+	{
+		leftRight.modify([i] (Pair& p) {
+			p.a = i;
+			p.b = i;
+		});
+	}
+	stop = true;
+
+	for (std::thread& reader : readers)
+	{
+		reader.join();
+	}
+
+	CHECK(inconsistentReadCount == 0);
+	CHECK(leftRight.read([] (const Pair& p) { return p.a; }) == 9999);
+}
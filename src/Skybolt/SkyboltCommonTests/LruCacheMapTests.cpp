@@ -69,3 +69,21 @@ TEST_CASE("LruCacheMap least recently used item is pruned when cache capacity ex
 
 	CHECK(!cache.exists("2"));
 }
+
+TEST_CASE("LruCacheMap erase item")
+{
+	int capacity = 2;
+	LruCacheMap<std::string, int> cache(capacity);
+	cache.put("a", 1);
+	cache.put("b", 2);
+
+	CHECK(cache.erase("a"));
+	CHECK(!cache.exists("a"));
+	CHECK(cache.size() == 1);
+	CHECK(!cache.erase("a"));
+
+	// Erased items no longer count towards capacity
+	cache.put("c", 3);
+	CHECK(cache.exists("b"));
+	CHECK(cache.exists("c"));
+}
@@ -0,0 +1,141 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltCommon/TimeBudgetedQueue.h>
+
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace skybolt;
+
+constexpr double infiniteBudget = std::numeric_limits<double>::infinity();
+
+TEST_CASE("TimeBudgetedQueue processes items in the order they were pushed")
+{
+	TimeBudgetedQueue<int> queue;
+	for (int i = 0; i < 5; ++i)
+	{
+		queue.push(i);
+	}
+
+	std::vector<int> processed;
+	CHECK(queue.process(infiniteBudget, [&] (int item) {
+		processed.push_back(item);
+		return true;
+	}) == 5);
+
+	CHECK(processed == std::vector<int>({0, 1, 2, 3, 4}));
+	CHECK(queue.size() == 0);
+}
+
+TEST_CASE("TimeBudgetedQueue stops processing when the time budget is spent")
+{
+	TimeBudgetedQueue<int> queue;
+	for (int i = 0; i < 5; ++i)
+	{
+		queue.push(i);
+	}
+
+	auto slowProcess = [] (std::vector<int>& processed) {
+		return [&processed] (int item) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			processed.push_back(item);
+			return true;
+		};
+	};
+
+	// The budget is spent by the first item, so remaining items are left for the next call
+	std::vector<int> processed;
+	CHECK(queue.process(10.0, slowProcess(processed)) == 1);
+	CHECK(processed == std::vector<int>({0}));
+	CHECK(queue.size() == 4);
+
+	processed.clear();
+	CHECK(queue.process(10.0, slowProcess(processed)) == 1);
+	CHECK(processed == std::vector<int>({1}));
+	CHECK(queue.size() == 3);
+}
+
+TEST_CASE("TimeBudgetedQueue processes at least one item regardless of budget")
+{
+	TimeBudgetedQueue<int> queue;
+	queue.push(1);
+	queue.push(2);
+
+	std::vector<int> processed;
+	CHECK(queue.process(0.0, [&] (int item) {
+		processed.push_back(item);
+		return true;
+	}) == 1);
+	CHECK(processed == std::vector<int>({1}));
+	CHECK(queue.size() == 1);
+}
+
+TEST_CASE("TimeBudgetedQueue skipped items do not count towards the minimum processed item")
+{
+	TimeBudgetedQueue<int> queue;
+	for (int i = 0; i < 4; ++i)
+	{
+		queue.push(i);
+	}
+
+	// Skip even items. The first odd item is processed even though the budget is zero.
+	std::vector<int> processed;
+	CHECK(queue.process(0.0, [&] (int item) {
+		if (item % 2 == 0)
+		{
+			return false;
+		}
+		processed.push_back(item);
+		return true;
+	}) == 1);
+	CHECK(processed == std::vector<int>({1}));
+	CHECK(queue.size() == 2);
+}
+
+TEST_CASE("TimeBudgetedQueue accepts items pushed from other threads")
+{
+	TimeBudgetedQueue<int> queue;
+	constexpr int threadCount = 4;
+	constexpr int itemsPerThread = 1000;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < itemsPerThread; ++i)
+			{
+				queue.push(t * itemsPerThread + i);
+			}
+		});
+	}
+
+	// Items from each thread are processed in the order that thread pushed them
+	std::vector<int> lastItemFromThread(threadCount, -1);
+	std::size_t processedCount = 0;
+	bool ordered = true;
+	auto process = [&] (int item) {
+		int& last = lastItemFromThread[item / itemsPerThread];
+		ordered &= (item > last);
+		last = item;
+		return true;
+	};
+
+	while (processedCount < threadCount * itemsPerThread)
+	{
+		processedCount += queue.process(1.0, process);
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(ordered);
+	CHECK(queue.size() == 0);
+}
@@ -8,6 +8,10 @@
 #include <catch2/catch.hpp>
 #include <SkyboltCommon/TypedItemContainer.h>
 
+#include <map>
+#include <string>
+#include <utility>
+
 using namespace skybolt;
 
 struct Base
@@ -111,3 +115,85 @@ TEST_CASE("TypedItemContainer add and remove item with multiple exposed types")
 	CHECK(c.getFirstItemOfType<MultiTypeBase>() == nullptr);
 	CHECK(c.getAllItems().empty());
 }
+
+
+namespace {
+
+//! Reference implementation of the previous std::multimap based container, used for benchmark comparison
+template <typename BaseT>
+class MultimapTypedItemContainer
+{
+	typedef std::shared_ptr<BaseT> BaseTPtr;
+
+public:
+	void addItem(const BaseTPtr& c)
+	{
+		mComponents.push_back(c);
+		for (const auto& type : getExposedTypes(*c))
+		{
+			mComponentMap.insert(typename ComponentMap::value_type(type, c));
+		}
+	}
+
+	template <class DerivedT>
+	std::shared_ptr<DerivedT> getFirstItemOfType() const
+	{
+		typename ComponentMap::const_iterator i = mComponentMap.find(typeid(DerivedT));
+		if (i != mComponentMap.end())
+		{
+			return detail::static_or_dynamic_pointer_cast<BaseT, DerivedT>(i->second);
+		}
+		return nullptr;
+	}
+
+private:
+	std::vector<BaseTPtr> mComponents;
+	typedef std::multimap<std::type_index, BaseTPtr> ComponentMap;
+	ComponentMap mComponentMap;
+};
+
+template <int N>
+struct BenchmarkItem : Base {};
+
+template <typename ContainerT, int... Indices>
+void addBenchmarkItems(ContainerT& container, std::integer_sequence<int, Indices...>)
+{
+	(container.addItem(std::make_shared<BenchmarkItem<Indices>>()), ...);
+}
+
+template <typename ContainerT, int... Indices>
+std::size_t lookupBenchmarkItems(const ContainerT& container, std::integer_sequence<int, Indices...>)
+{
+	return (std::size_t(container.template getFirstItemOfType<BenchmarkItem<Indices>>() != nullptr) + ...);
+}
+
+template <int ItemCount>
+void benchmarkContainers()
+{
+	using Sequence = std::make_integer_sequence<int, ItemCount>;
+
+	TypedItemContainer<Base> container;
+	addBenchmarkItems(container, Sequence());
+
+	MultimapTypedItemContainer<Base> referenceContainer;
+	addBenchmarkItems(referenceContainer, Sequence());
+
+	BENCHMARK("TypedItemContainer lookup all of " + std::to_string(ItemCount) + " items")
+	{
+		return lookupBenchmarkItems(container, Sequence());
+	};
+
+	BENCHMARK("Multimap container lookup all of " + std::to_string(ItemCount) + " items")
+	{
+		return lookupBenchmarkItems(referenceContainer, Sequence());
+	};
+}
+
+} // namespace
+
+TEST_CASE("Benchmark TypedItemContainer getFirstItemOfType", "[.benchmark]")
+{
+	benchmarkContainers<5>();
+	benchmarkContainers<10>();
+	benchmarkContainers<20>();
+}
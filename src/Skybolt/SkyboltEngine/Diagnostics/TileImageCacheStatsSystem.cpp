@@ -0,0 +1,34 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "TileImageCacheStatsSystem.h"
+#include "SkyboltEngine/EngineStats.h"
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/TileImageCache.h>
+
+#include <assert.h>
+
+namespace skybolt {
+
+TileImageCacheStatsSystem::TileImageCacheStatsSystem(const vis::TileImageCachePtr& cache, EngineStats* stats) :
+	mCache(cache),
+	mStats(stats)
+{
+	assert(mCache);
+	assert(mStats);
+}
+
+TileImageCacheStatsSystem::~TileImageCacheStatsSystem() = default;
+
+void TileImageCacheStatsSystem::updateStats()
+{
+	vis::TileImageCacheStats stats = mCache->getStats();
+	mStats->tileImageCacheHits = stats.hits;
+	mStats->tileImageCacheMisses = stats.misses;
+	mStats->tileImageCacheEvictions = stats.evictions;
+	mStats->tileImageCacheSizeBytes = stats.sizeBytes;
+}
+
+} // namespace skybolt
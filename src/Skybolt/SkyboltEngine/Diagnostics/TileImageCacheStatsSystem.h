@@ -0,0 +1,33 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltEngine/SkyboltEngineFwd.h"
+#include <SkyboltSim/System/System.h>
+#include <SkyboltVis/SkyboltVisFwd.h>
+
+namespace skybolt {
+
+//! Copies TileImageCache statistics into EngineStats each update
+class TileImageCacheStatsSystem : public sim::System
+{
+public:
+	TileImageCacheStatsSystem(const vis::TileImageCachePtr& cache, EngineStats* stats);
+	~TileImageCacheStatsSystem() override;
+
+	SKYBOLT_BEGIN_REGISTER_UPDATE_HANDLERS
+		SKYBOLT_REGISTER_UPDATE_HANDLER(sim::UpdateStage::Output, updateStats)
+	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
+
+	void updateStats();
+
+private:
+	vis::TileImageCachePtr mCache;
+	EngineStats* mStats;
+};
+
+} // namespace skybolt
@@ -6,8 +6,11 @@
 
 #include "EngineRoot.h"
 #include "ComponentFactory.h"
+#include "Diagnostics/TileImageCacheStatsSystem.h"
 #include "SimVisBinding/SimVisSystem.h"
+#include <SkyboltSim/System/EntitySpatialIndexSystem.h>
 #include <SkyboltSim/System/EntitySystem.h>
+#include <SkyboltSim/System/TerrainPrefetchSystem.h>
 #include <SkyboltSim/World.h>
 #include <SkyboltVis/OsgStateSetHelpers.h>
 #include <SkyboltVis/Scene.h>
@@ -46,12 +49,14 @@ Expected<file::Path> locateFile(const std::string& filename)
 
 static std::vector<std::string> transparentMaterialNames() { return { "transparentExt", "transparent" }; }
 
-static vis::ModelFactoryPtr createModelFactory(const vis::ShaderPrograms& programs)
+static vis::ModelFactoryPtr createModelFactory(const vis::ShaderPrograms& programs, px_sched::Scheduler* scheduler, const file::Path& cacheDir)
 {
 	osg::ref_ptr<osg::Program> glassProgram = programs.getRequiredProgram("glass");
 
 	vis::ModelFactoryConfig config;
 	config.defaultProgram = programs.getRequiredProgram("model");
+	config.scheduler = scheduler;
+	config.cacheDirectory = cacheDir.string();
 	for (const std::string& name : transparentMaterialNames())
 	{
 		config.stateSetModifiers[name] = [=](osg::StateSet& stateSet, const osg::Material& material) {
@@ -188,12 +193,17 @@ EngineRoot::EngineRoot(const EngineRootConfig& config) :
 	vis::addDefaultFactories(*visFactoryRegistry);
 	factoryRegistries->addItem(visFactoryRegistry);
 
+	file::Path cacheDir = getCacheDir();
+	BOOST_LOG_TRIVIAL(info) << "Using cache directory '" << cacheDir.string() << "'.";
+
 	tileSourceFactoryRegistry = std::make_shared<vis::JsonTileSourceFactoryRegistry>([&] {
-		file::Path cacheDir = getCacheDir();
-		BOOST_LOG_TRIVIAL(info) << "Using cache directory '" << cacheDir.string() << "'.";
 		vis::JsonTileSourceFactoryRegistryConfig c;
 		c.apiKeys = readNameMap<std::string>(config.engineSettings, "tileApiKeys");
 		c.cacheDirectory = cacheDir.string();
+		if (const auto& it = config.engineSettings.find("tiles"); it != config.engineSettings.end())
+		{
+			c.tileImageCacheSizeBytes = readOptionalOrDefault<std::size_t>(it.value(), "imageCacheSizeMB", c.tileImageCacheSizeBytes / (1024 * 1024)) * 1024 * 1024;
+		}
 		return c;
 	}());
 	vis::addDefaultFactories(*tileSourceFactoryRegistry);
@@ -217,8 +227,9 @@ EngineRoot::EngineRoot(const EngineRootConfig& config) :
 			c.scene = scene.get();
 			c.programs = &programs;
 			c.visFactoryRegistry = visFactoryRegistry;
-			c.modelFactory = createModelFactory(programs);
+			c.modelFactory = createModelFactory(programs, scheduler.get(), cacheDir);
 			c.textureCache = std::make_shared<vis::TextureCache>();
+			c.cacheDirectory = cacheDir.string();
 			return c;
 		}();
 	}
@@ -228,9 +239,16 @@ EngineRoot::EngineRoot(const EngineRootConfig& config) :
 
 	// Create default systems
 	systemRegistry = std::make_shared<sim::SystemRegistry>(sim::SystemRegistry({
-		std::make_shared<sim::EntitySystem>(&scenario->world),
+		std::make_shared<sim::EntitySystem>(&scenario->world, scheduler.get()),
+		std::make_shared<sim::EntitySpatialIndexSystem>(&scenario->world),
+		std::make_shared<sim::TerrainPrefetchSystem>(&scenario->world),
 		std::make_shared<SimVisSystem>(&scenario->world, scene)
 	}));
+
+	if (const vis::TileImageCachePtr& tileImageCache = tileSourceFactoryRegistry->getTileImageCache(); tileImageCache)
+	{
+		systemRegistry->push_back(std::make_shared<TileImageCacheStatsSystem>(tileImageCache, &stats));
+	}
 }
 
 EngineRoot::~EngineRoot()
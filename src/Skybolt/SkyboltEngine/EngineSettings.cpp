@@ -34,6 +34,9 @@ nlohmann::json createDefaultEngineSettings()
 	},
 	"clouds": {
 		"enableTemporalUpscaling": true
+	},
+	"tiles": {
+		"imageCacheSizeMB": 512
 	}
 })"_json;
 }
@@ -13,6 +13,30 @@ struct EngineStats
 {
 	size_t terrainTileLoadQueueSize = 0;
 	size_t featureTileLoadQueueSize = 0;
+
+	size_t terrainTileLoadsQueued = 0; //!< Terrain tile loads waiting to start
+	size_t terrainTileLoadsActive = 0; //!< Terrain tile loads in progress on worker threads
+	size_t terrainTileLoadsCanceledBeforeStart = 0; //!< Total terrain tile loads canceled before a worker started them
+	double terrainTileLoaderUpdateMilliseconds = 0; //!< Main thread time spent updating terrain tile loaders in the last frame
+
+	size_t featureTileLoadsAwaitingIntegration = 0; //!< Feature tile loads finished on worker threads, waiting to be added to the scene
+	double featureTileIntegrationMilliseconds = 0; //!< Main thread time spent adding loaded feature tiles to the scene in the last frame
+
+	// Time from requesting a feature tile until it is added to the scene, for recently added tiles of all planets
+	double featureTileLoadLatencyTotalMilliseconds = 0;
+	size_t featureTileLoadLatencySampleCount = 0;
+
+	//! @returns mean time from requesting a feature tile until it is added to the scene, for recently added tiles of all planets
+	double getFeatureTileLoadLatencyMilliseconds() const
+	{
+		return featureTileLoadLatencySampleCount ? featureTileLoadLatencyTotalMilliseconds / double(featureTileLoadLatencySampleCount) : 0.0;
+	}
+
+	// Decoded tile images cached in memory, shared by all tile sources
+	size_t tileImageCacheHits = 0; //!< Total since startup
+	size_t tileImageCacheMisses = 0; //!< Total since startup
+	size_t tileImageCacheEvictions = 0; //!< Total since startup
+	size_t tileImageCacheSizeBytes = 0;
 };
 
 } // namespace skybolt
\ No newline at end of file
@@ -232,7 +232,7 @@ static vis::ModelPtr createVisualModel(const nlohmann::json& json, vis::ModelFac
 	std::string filename = json.at("model").get<std::string>();
 	std::vector<vis::ModelFactory::TextureRole> textureRoles = readTextureRoles(json);
 	vis::ModelConfig config;
-	config.node = factory.createModel(filename, textureRoles);
+	config.pendingNode = factory.createModelAsync(filename, textureRoles); // model is empty until loaded
 
 	registerAssetSearchDirectory(getParentDirectory(filename));
 
@@ -359,6 +359,13 @@ struct PlanetStatsUpdater : vis::PlanetFeaturesListener, vis::QuadTreeTileLoader
 
 		mStats->terrainTileLoadQueueSize -= mOwnTilesLoading;
 		mStats->featureTileLoadQueueSize -= mOwnFeaturesLoading;
+		mStats->terrainTileLoadsQueued -= mOwnLoaderStats.queuedLoads;
+		mStats->terrainTileLoadsActive -= mOwnLoaderStats.activeLoads;
+		mStats->terrainTileLoaderUpdateMilliseconds -= mOwnLoaderStats.updateMilliseconds;
+		mStats->featureTileLoadsAwaitingIntegration -= mOwnFeaturesStats.completedLoadsAwaitingIntegration;
+		mStats->featureTileIntegrationMilliseconds -= mOwnFeaturesStats.integrationMilliseconds;
+		mStats->featureTileLoadLatencyTotalMilliseconds -= mOwnFeaturesStats.totalLoadLatencyMilliseconds;
+		mStats->featureTileLoadLatencySampleCount -= mOwnFeaturesStats.loadLatencySampleCount;
 	}
 
 	void tileLoadRequested() override
@@ -379,6 +386,16 @@ struct PlanetStatsUpdater : vis::PlanetFeaturesListener, vis::QuadTreeTileLoader
 		--mOwnTilesLoading;
 	}
 
+	void tileLoaderStatsUpdated(const vis::AsyncTileLoaderStats& stats) override
+	{
+		// Stats are shared between planets, so replace this planet's previous contribution
+		mStats->terrainTileLoadsQueued += stats.queuedLoads - mOwnLoaderStats.queuedLoads;
+		mStats->terrainTileLoadsActive += stats.activeLoads - mOwnLoaderStats.activeLoads;
+		mStats->terrainTileLoadsCanceledBeforeStart += stats.loadsCanceledBeforeStart - mOwnLoaderStats.loadsCanceledBeforeStart;
+		mStats->terrainTileLoaderUpdateMilliseconds += stats.updateMilliseconds - mOwnLoaderStats.updateMilliseconds;
+		mOwnLoaderStats = stats;
+	}
+
 	void featureLoadEnqueued() override
 	{
 		++mStats->featureTileLoadQueueSize;
@@ -391,11 +408,23 @@ struct PlanetStatsUpdater : vis::PlanetFeaturesListener, vis::QuadTreeTileLoader
 		--mOwnFeaturesLoading;
 	}
 
+	void featureLoaderStatsUpdated(const vis::PlanetFeaturesStats& stats) override
+	{
+		// Stats are shared between planets, so replace this planet's previous contribution
+		mStats->featureTileLoadsAwaitingIntegration += stats.completedLoadsAwaitingIntegration - mOwnFeaturesStats.completedLoadsAwaitingIntegration;
+		mStats->featureTileIntegrationMilliseconds += stats.integrationMilliseconds - mOwnFeaturesStats.integrationMilliseconds;
+		mStats->featureTileLoadLatencyTotalMilliseconds += stats.totalLoadLatencyMilliseconds - mOwnFeaturesStats.totalLoadLatencyMilliseconds;
+		mStats->featureTileLoadLatencySampleCount += stats.loadLatencySampleCount - mOwnFeaturesStats.loadLatencySampleCount;
+		mOwnFeaturesStats = stats;
+	}
+
 private:
 	EngineStats* mStats;
 	vis::Planet* mPlanet;
 	size_t mOwnTilesLoading = 0;
 	size_t mOwnFeaturesLoading = 0;
+	vis::AsyncTileLoaderStats mOwnLoaderStats;
+	vis::PlanetFeaturesStats mOwnFeaturesStats;
 };
 
 static osg::ref_ptr<osg::Texture2D> createCloudTexture(const std::string& filepath)
@@ -424,6 +453,7 @@ static void loadVisualPlanet(Entity* entity, const EntityFactory::Context& conte
 
 	vis::PlanetConfig config;
 	config.scheduler = context.scheduler;
+	config.cacheDirectory = visContext.cacheDirectory;
 	config.programs = visContext.programs;
 	config.scene = visContext.scene;
 	config.innerRadius = planetComponent->radius;
@@ -541,6 +571,7 @@ static void loadVisualPlanet(Entity* entity, const EntityFactory::Context& conte
 			}
 		}
 		config.planetTileSources = planetTileSources;
+		config.tileImageCache = context.tileSourceFactoryRegistry->getTileImageCache();
 	}
 
 	{
@@ -35,6 +35,7 @@ public:
 		const vis::ShaderPrograms* programs;
 		vis::ModelFactoryPtr modelFactory;
 		vis::TextureCachePtr textureCache;
+		std::string cacheDirectory; //!< Skybolt cache directory
 	};
 
 	struct Context
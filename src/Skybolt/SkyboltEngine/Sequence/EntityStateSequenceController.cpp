@@ -5,48 +5,12 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "EntityStateSequenceController.h"
-#include "SkyboltEngine/Sequence/Interpolator/CubicBSplineInterpolator.h"
-#include "SkyboltEngine/Sequence/Interpolator/LinearInterpolator.h"
 #include <SkyboltSim/World.h>
 #include <SkyboltSim/Components/DynamicBodyComponent.h>
 #include <assert.h>
 
 namespace skybolt {
 
-constexpr bool linear = false;
-
-std::shared_ptr<InterpolatorD> createPositionComponentInterpolator(const std::shared_ptr<EntityStateSequence>& sequence, int componentIndex)
-{
-	if (linear)
-	{
-		return std::make_shared<LinearInterpolatorD>(
-			[sequence, componentIndex](int i) { return sequence->values[i].position[componentIndex]; });
-	}
-	else
-	{
-		return std::make_shared<CubicBSplineInterpolatorD>(
-			[sequence, componentIndex] { return int(sequence->values.size()); },
-			[sequence, componentIndex](int i) { return sequence->values[i].position[componentIndex]; },
-			[sequence, componentIndex](int i) { return sequence->times[i]; });
-	}
-}
-
-std::shared_ptr<InterpolatorD> createOrientationComponentInterpolator(const std::shared_ptr<EntityStateSequence>& sequence, int componentIndex)
-{
-	if (linear)
-	{
-		return std::make_shared<LinearInterpolatorD>(
-			[sequence, componentIndex](int i) { return sequence->values[i].orientation[componentIndex]; });
-	}
-	else
-	{
-		return std::make_shared<CubicBSplineInterpolatorD>(
-			[sequence, componentIndex] { return int(sequence->values.size()); },
-			[sequence, componentIndex](int i) { return sequence->values[i].orientation[componentIndex]; },
-			[sequence, componentIndex](int i) { return sequence->times[i]; });
-	}
-}
-
 static glm::dquat toSameSign(const glm::dquat& self, const glm::dquat& reference)
 {
 	double dot = glm::dot(self, reference);
@@ -72,19 +36,6 @@ EntityStateSequenceController::EntityStateSequenceController(const std::shared_p
 {
 	makeQuaternionSignConsistent(*sequence);
 
-	mPositionInterpolators = {
-		createPositionComponentInterpolator(sequence, 0),
-		createPositionComponentInterpolator(sequence, 1),
-		createPositionComponentInterpolator(sequence, 2)
-	};
-
-	mOrientationInterpolators = {
-		createOrientationComponentInterpolator(sequence, 0),
-		createOrientationComponentInterpolator(sequence, 1),
-		createOrientationComponentInterpolator(sequence, 2),
-		createOrientationComponentInterpolator(sequence, 3)
-	};
-
 	auto sanitizeOrientation = [sequence](size_t index) {
 		glm::dquat& ori = sequence->values[index].orientation;
 		ori = toSameSign(ori, sequence->values.front().orientation);
@@ -92,10 +43,27 @@ EntityStateSequenceController::EntityStateSequenceController(const std::shared_p
 
 	mConnections.push_back(sequence->itemAdded.connect(sanitizeOrientation));
 	mConnections.push_back(sequence->valueChanged.connect(sanitizeOrientation));
+
+	mConnections.push_back(sequence->itemAdded.connect([this](size_t index) {
+		std::scoped_lock<std::mutex> lock(mSplineMutex);
+		mSpline.keyAdded(index);
+	}));
+	mConnections.push_back(sequence->valueChanged.connect([this](size_t index) {
+		std::scoped_lock<std::mutex> lock(mSplineMutex);
+		mSpline.keyChanged(index);
+	}));
+	mConnections.push_back(sequence->itemRemoved.connect([this](size_t index) {
+		std::scoped_lock<std::mutex> lock(mSplineMutex);
+		mSpline.keyRemoved(index);
+	}));
 }
 
 EntityStateSequenceController::~EntityStateSequenceController()
 {
+	for (auto& connection : mConnections)
+	{
+		connection.disconnect();
+	}
 	setEntity(nullptr);
 }
 
@@ -158,26 +126,98 @@ void EntityStateSequenceController::setStateT(const EntitySequenceState& state)
 	}
 }
 
-SequenceStatePtr EntityStateSequenceController::getStateAtInterpolationPoint(const math::InterpolationPoint& point) const
+void EntityStateSequenceController::updateSpline() const
 {
-	glm::dvec3 position;
-	for (int i = 0; i < (int)mPositionInterpolators.size(); ++i)
+	// Once updated, the spline is not modified again until the sequence changes,
+	// so concurrent readers may evaluate it without holding the lock.
+	std::scoped_lock<std::mutex> lock(mSplineMutex);
+	mSpline.update(mSequence->times, [this](size_t index, Spline::Values& result) {
+		const EntitySequenceState& state = mSequence->values[index];
+		for (int i = 0; i < 3; ++i)
+		{
+			result[i] = state.position[i];
+		}
+		for (int i = 0; i < 4; ++i)
+		{
+			result[3 + i] = state.orientation[i];
+		}
+	});
+}
+
+void EntityStateSequenceController::evaluateSpline(size_t segmentIndex, double u, sim::Vector3& position, sim::Quaternion& orientation) const
+{
+	Spline::Values values;
+	mSpline.evaluate(segmentIndex, u, values);
+
+	for (int i = 0; i < 3; ++i)
 	{
-		position[i] = mPositionInterpolators[i]->interpolate(point.bounds.first, point.bounds.last, point.weight);
+		position[i] = values[i];
 	}
-
-	glm::dquat orientation;
-	for (int i = 0; i < (int)mOrientationInterpolators.size(); ++i)
+	for (int i = 0; i < 4; ++i)
 	{
-		orientation[i] = mOrientationInterpolators[i]->interpolate(point.bounds.first, point.bounds.last, point.weight);
+		orientation[i] = values[3 + i];
 	}
+	orientation = glm::normalize(orientation);
+}
 
+SequenceStatePtr EntityStateSequenceController::getStateAtInterpolationPoint(const math::InterpolationPoint& point) const
+{
 	auto state = std::make_shared<EntitySequenceState>();
-	state->position = position;
-	state->orientation = glm::normalize(orientation);
+	if (point.bounds.first == point.bounds.last)
+	{
+		const EntitySequenceState& key = mSequence->values[point.bounds.first];
+		state->position = key.position;
+		state->orientation = glm::normalize(key.orientation);
+		return state;
+	}
+
+	updateSpline();
+	evaluateSpline(point.bounds.first, point.weight, state->position, state->orientation);
 	return state;
 }
 
+bool EntityStateSequenceController::sampleRange(double startTime, double endTime, int count, sim::Vector3* positions, sim::Quaternion* orientations) const
+{
+	const std::vector<double>& times = mSequence->times;
+	if (times.empty())
+	{
+		return false;
+	}
+
+	if (times.size() == 1)
+	{
+		const EntitySequenceState& key = mSequence->values.front();
+		std::fill(positions, positions + count, key.position);
+		std::fill(orientations, orientations + count, glm::normalize(key.orientation));
+		return true;
+	}
+
+	updateSpline();
+
+	const size_t lastSegment = mSpline.getSegmentCount() - 1;
+	double timeStep = (count > 1) ? (endTime - startTime) / double(count - 1) : 0.0;
+	size_t segment = 0;
+
+	for (int i = 0; i < count; ++i)
+	{
+		double t = startTime + timeStep * i;
+
+		// Find the first segment ending at or after t. Samples are usually in increasing order, so search forward from the previous segment.
+		if (t < times[segment])
+		{
+			segment = std::lower_bound(times.begin() + 1, times.begin() + lastSegment + 1, t) - times.begin() - 1;
+		}
+		while (segment < lastSegment && t > times[segment + 1])
+		{
+			++segment;
+		}
+
+		double u = math::clamp((t - times[segment]) / (times[segment + 1] - times[segment]), 0.0, 1.0);
+		evaluateSpline(segment, u, positions[i], orientations[i]);
+	}
+	return true;
+}
+
 SequenceStatePtr EntityStateSequenceController::getStateAtTime(double t) const
 {
 #ifdef SMOOTHING_TEST
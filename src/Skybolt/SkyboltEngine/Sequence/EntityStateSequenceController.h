@@ -7,11 +7,13 @@
 #pragma once
 
 #include "SequenceController.h"
-#include "SkyboltEngine/Sequence/Interpolator/Interpolator.h"
+#include "SkyboltEngine/Sequence/Interpolator/CachedCubicBSpline.h"
 #include <SkyboltSim/Entity.h>
 #include <SkyboltSim/SimMath.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 
+#include <mutex>
+
 namespace skybolt {
 
 struct EntitySequenceState : public SequenceState
@@ -44,17 +46,32 @@ public:
 	void setStateT(const EntitySequenceState& state) override;
 	SequenceStatePtr getStateAtInterpolationPoint(const math::InterpolationPoint& point) const override;
 
+	//! @ThreadSafe with other const methods, but not while the sequence is being modified
 	SequenceStatePtr getStateAtTime(double t) const override;
 
+	//! Samples the sequence at count evenly spaced times from startTime to endTime inclusive, writing into caller owned buffers without allocating.
+	//! Times outside the sequence's time range are clamped to the range.
+	//! @param positions and orientations must each have space for count elements
+	//! @returns false if the sequence is empty, in which case nothing is written
+	//! @ThreadSafe with other const methods, but not while the sequence is being modified
+	bool sampleRange(double startTime, double endTime, int count, sim::Vector3* positions, sim::Quaternion* orientations) const;
+
 	boost::signals2::signal<void(sim::Entity* entity)> entityChanged;
 
 private:
 	void onDestroy(sim::Entity* entity) override;
 
+	//! Position xyz followed by orientation quaternion components
+	using Spline = CachedCubicBSpline<7>;
+
+	//! Updates segments of mSpline affected by sequence changes. Safe to call concurrently from const methods.
+	void updateSpline() const;
+	void evaluateSpline(size_t segmentIndex, double u, sim::Vector3& position, sim::Quaternion& orientation) const;
+
 private:
 	sim::Entity* mEntity = nullptr;
-	std::vector<std::shared_ptr<InterpolatorD>> mPositionInterpolators;
-	std::vector<std::shared_ptr<InterpolatorD>> mOrientationInterpolators;
+	mutable Spline mSpline; //!< Lazily updated when evaluated
+	mutable std::mutex mSplineMutex; //!< Guards updates of mSpline, which may happen in concurrent calls to const methods
 	std::vector<boost::signals2::connection> mConnections;
 };
 
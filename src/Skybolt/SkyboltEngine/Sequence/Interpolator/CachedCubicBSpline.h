@@ -0,0 +1,188 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "CubicBSplineInterpolator.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace skybolt {
+
+//! Cubic B-spline with multiple channels through a sequence of keys. Evaluates the same curve as CubicBSplineInterpolator.
+//! Polynomial coefficients are cached for each segment between two keys, so evaluating all channels is a single pass with no allocation.
+//! The keys are owned by the caller, which must notify the spline when keys are added, removed or changed.
+//! Coefficients of affected segments are recalculated on the next call to update().
+template <int ChannelCount>
+class CachedCubicBSpline
+{
+public:
+	using Values = std::array<double, ChannelCount>;
+
+	//! Must be called after a key is inserted at index
+	void keyAdded(size_t index)
+	{
+		++mKeyCount;
+		if (mKeyCount >= 2)
+		{
+			size_t insertIndex = std::min(index, mSegments.size());
+			mSegments.insert(mSegments.begin() + insertIndex, Segment());
+			mDirty.insert(mDirty.begin() + insertIndex, 1);
+		}
+		markKeyNeighborhoodDirty(index);
+	}
+
+	//! Must be called after the key at index is removed
+	void keyRemoved(size_t index)
+	{
+		if (mKeyCount == 0)
+		{
+			return;
+		}
+		--mKeyCount;
+		if (!mSegments.empty())
+		{
+			size_t eraseIndex = std::min(index, mSegments.size() - 1);
+			mSegments.erase(mSegments.begin() + eraseIndex);
+			mDirty.erase(mDirty.begin() + eraseIndex);
+		}
+
+		// Keys either side of the removed key are now neighbors. Their control points change, affecting segments [index-2, index].
+		markSegmentsDirty(int(index) - 2, int(index));
+	}
+
+	//! Must be called after the key at index changes time or value
+	void keyChanged(size_t index)
+	{
+		markKeyNeighborhoodDirty(index);
+	}
+
+	//! Recalculates coefficients of segments affected by key changes since the last update.
+	//! If the number of keys does not match the number of keys the spline was notified of, all segments are recalculated.
+	//! @param times are the key times, which must be monotonically increasing
+	//! @param valuesGetter is called as valuesGetter(size_t index, Values& result) to get the channel values of a key
+	template <typename ValuesGetter>
+	void update(const std::vector<double>& times, const ValuesGetter& valuesGetter)
+	{
+		if (times.size() != mKeyCount || mSegments.size() != getSegmentCountForKeys(mKeyCount))
+		{
+			reset(times.size());
+		}
+
+		if (!mHasDirty)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < mSegments.size(); ++i)
+		{
+			if (mDirty[i])
+			{
+				calcSegment(times, valuesGetter, i, mSegments[i]);
+				mDirty[i] = 0;
+			}
+		}
+		mHasDirty = false;
+	}
+
+	size_t getSegmentCount() const { return mSegments.size(); }
+
+	//! Evaluates all channels of a segment. Segment i spans keys i and i+1.
+	//! update() must have been called since the keys last changed.
+	//! @param u is the parameteric interpolation coordinate in range [0, 1]
+	void evaluate(size_t segmentIndex, double u, Values& result) const
+	{
+		const Segment& segment = mSegments[segmentIndex];
+		for (int c = 0; c < ChannelCount; ++c)
+		{
+			result[c] = ((segment.coefficients[3][c] * u + segment.coefficients[2][c]) * u + segment.coefficients[1][c]) * u + segment.coefficients[0][c];
+		}
+	}
+
+private:
+	//! Polynomial coefficients in increasing order of power, i.e value = c0 + c1*u + c2*u^2 + c3*u^3
+	struct Segment
+	{
+		double coefficients[4][ChannelCount];
+	};
+
+	static size_t getSegmentCountForKeys(size_t keyCount)
+	{
+		return keyCount >= 2 ? keyCount - 1 : 0;
+	}
+
+	void reset(size_t keyCount)
+	{
+		mKeyCount = keyCount;
+		mSegments.assign(getSegmentCountForKeys(keyCount), Segment());
+		mDirty.assign(mSegments.size(), 1);
+		mHasDirty = true;
+	}
+
+	void markKeyNeighborhoodDirty(size_t keyIndex)
+	{
+		// A key affects the control points of itself and its neighbors, which are used by segments [index-2, index+1]
+		markSegmentsDirty(int(keyIndex) - 2, int(keyIndex) + 1);
+	}
+
+	//! Marks segments in closed range [first, last] as dirty, clamped to the valid range
+	void markSegmentsDirty(int first, int last)
+	{
+		first = std::max(0, first);
+		last = std::min(int(mSegments.size()) - 1, last);
+		for (int i = first; i <= last; ++i)
+		{
+			mDirty[i] = 1;
+			mHasDirty = true;
+		}
+	}
+
+	template <typename ValuesGetter>
+	static void calcSegment(const std::vector<double>& times, const ValuesGetter& valuesGetter, size_t i, Segment& segment)
+	{
+		size_t lastKey = times.size() - 1;
+		size_t k0 = (i > 0) ? i - 1 : 0;
+		size_t k1 = i;
+		size_t k2 = i + 1;
+		size_t k3 = std::min(lastKey, i + 2);
+
+		Values v0, v1, v2, v3;
+		valuesGetter(k0, v0);
+		valuesGetter(k1, v1);
+		valuesGetter(k2, v2);
+		valuesGetter(k3, v3);
+
+		for (int c = 0; c < ChannelCount; ++c)
+		{
+			glm::dvec2 q0(times[k0], v0[c]);
+			glm::dvec2 q1(times[k1], v1[c]);
+			glm::dvec2 q2(times[k2], v2[c]);
+			glm::dvec2 q3(times[k3], v3[c]);
+
+			// Bezier control points
+			double p0 = q1.y;
+			double p1 = calcCubicBSplineControlPoint(q0, q1, q2, /* rightSide */ true);
+			double p2 = calcCubicBSplineControlPoint(q1, q2, q3, /* rightSide */ false);
+			double p3 = q2.y;
+
+			// Convert from Bernstein to power basis
+			segment.coefficients[0][c] = p0;
+			segment.coefficients[1][c] = 3.0 * (p1 - p0);
+			segment.coefficients[2][c] = 3.0 * (p0 - 2.0 * p1 + p2);
+			segment.coefficients[3][c] = p3 - p0 + 3.0 * (p1 - p2);
+		}
+	}
+
+private:
+	size_t mKeyCount = 0;
+	std::vector<Segment> mSegments;
+	std::vector<std::uint8_t> mDirty; //!< One per segment. Non-zero if the segment needs recalculating.
+	bool mHasDirty = false;
+};
+
+} // namespace skybolt
@@ -12,6 +12,24 @@
 
 namespace skybolt {
 
+//! Calculates a Bezier control point to the left or right of point p1, such that the curve passes through p1 with a tangent
+//! that bisects the directions to the neighboring points p0 and p2.
+//! Points are (time, value) pairs. p0 and p2 may equal p1 at the ends of the spline, in which case the tangent is flat.
+template <typename T>
+T calcCubicBSplineControlPoint(const glm::tvec2<T>& p0, const glm::tvec2<T>& p1, const glm::tvec2<T>& p2, bool rightSide)
+{
+	using vec = glm::tvec2<T>;
+	vec v0 = glm::normalize(p1 - p0);
+	vec v1 = glm::normalize(p2 - p1);
+
+	vec v = glm::normalize(v0 + v1);
+	T grad = (v.x > T(0)) ? (v.y / v.x) : T(0);
+
+	// Calculate control point offset along tangent by distance of 1/3 to next point
+	T timeOffset = T(1.0/3.0) * (rightSide ? (p2.x - p1.x) : (p0.x - p1.x));
+	return p1.y + grad * timeOffset;
+}
+
 template <typename T>
 class CubicBSplineInterpolator : public Interpolator<T>
 {
@@ -74,15 +92,7 @@ private:
 		vec p1(mTimeGetter(index), mValueGetter(index));
 		vec p2(mTimeGetter(indexNext), mValueGetter(indexNext));
 
-		vec v0 = glm::normalize(p1 - p0);
-		vec v1 = glm::normalize(p2 - p1);
-
-		vec v = glm::normalize(v0 + v1);
-		T grad = (v.x > T(0)) ? (v.y / v.x) : T(0);
-
-		// Calculate control point offset along tangent by distance of 1/3 to next point
-		T timeOffset = T(1.0/3.0) * (rightSide ? (p2.x - p1.x) : (p0.x - p1.x));
-		return p1.y + grad * timeOffset;
+		return calcCubicBSplineControlPoint(p0, p1, p2, rightSide);
 	}
 
 private:
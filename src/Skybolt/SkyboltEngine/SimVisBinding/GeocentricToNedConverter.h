@@ -38,6 +38,9 @@ public:
 	osg::Quat convert(const sim::Quaternion &ori) const;
 	sim::Quaternion convert(const osg::Quat &ori) const;
 
+	//! @returns the transform applied by convertPosition()
+	const sim::Matrix4& getGeocentricToNedTransform() const { return mNedBasisInverse; }
+
 private:
 	sim::Matrix4 mNedBasis;
 	sim::Matrix4 mNedBasisInverse;
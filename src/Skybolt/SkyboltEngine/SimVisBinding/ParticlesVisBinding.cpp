@@ -16,8 +16,7 @@ constexpr double forceScaleMetersPerNewton = 0.0001;
 
 ParticlesVisBinding::ParticlesVisBinding(const sim::ParticleSystemPtr& particleSystem, const vis::ParticlesPtr& particles) :
 	mParticleSystem(particleSystem),
-	mParticles(particles),
-	mParticlePositions(new osg::Vec3Array())
+	mParticles(particles)
 {
 	assert(mParticleSystem);
 	assert(mParticles);
@@ -25,17 +24,7 @@ ParticlesVisBinding::ParticlesVisBinding(const sim::ParticleSystemPtr& particleS
 
 void ParticlesVisBinding::syncVis(const GeocentricToNedConverter& converter)
 {
-	auto simParticles = mParticleSystem->getParticles();
-	mParticlePositions->resize(simParticles.size());
-
-	int i = 0;
-	for (const auto& simParticle : simParticles)
-	{
-		(*mParticlePositions)[i] = converter.convertPosition(simParticle.position);
-		++i;
-	}
-
-	mParticles->setParticles(simParticles, mParticlePositions);
+	mParticles->setParticles(mParticleSystem->getParticles(), converter.getGeocentricToNedTransform());
 }
 
 } // namespace skybolt
@@ -25,7 +25,6 @@ public:
 private:
 	sim::ParticleSystemPtr mParticleSystem;
 	vis::ParticlesPtr mParticles;
-	osg::ref_ptr<osg::Vec3Array> mParticlePositions;
 };
 
 } // namespace skybolt
\ No newline at end of file
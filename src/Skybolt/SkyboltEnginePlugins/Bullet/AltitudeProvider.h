@@ -7,6 +7,7 @@
 #pragma once
 
 #include <SkyboltSim/Spatial/LatLon.h>
+#include <cstddef>
 
 namespace skybolt {
 namespace sim {
@@ -18,6 +19,16 @@ public:
 
 	//! @return altitude above sea level. Positive is up.
 	virtual double get(const LatLon& position) const = 0;
+
+	//! Gets the altitudes of multiple positions
+	//! @param altitudes must have space for count altitudes
+	virtual void get(const LatLon* positions, double* altitudes, std::size_t count) const
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			altitudes[i] = get(positions[i]);
+		}
+	}
 };
 
 } // namespace sim
@@ -29,6 +29,7 @@
 
 #include <boost/config.hpp>
 #include <boost/dll/alias.hpp>
+#include <algorithm>
 #include <assert.h>
 
 namespace skybolt {
@@ -48,6 +49,22 @@ public:
 		return mProvider->getAltitude(position).altitude;
 	}
 
+	void get(const sim::LatLon* positions, double* altitudes, std::size_t count) const override
+	{
+		// Process in fixed size chunks to avoid allocating a results buffer
+		constexpr std::size_t chunkSize = 16;
+		PlanetAltitudeProvider::AltitudeResult results[chunkSize];
+		for (std::size_t begin = 0; begin < count; begin += chunkSize)
+		{
+			std::size_t chunkCount = std::min(chunkSize, count - begin);
+			mProvider->getAltitudes(positions + begin, results, chunkCount);
+			for (std::size_t i = 0; i < chunkCount; ++i)
+			{
+				altitudes[begin + i] = results[i].altitude;
+			}
+		}
+	}
+
 	std::shared_ptr<PlanetAltitudeProvider> mProvider;
 };
 
@@ -51,10 +51,15 @@ void TerrainCollisionShape::processAllTriangles(btTriangleCallback *callback, co
 	Vector3 p01 = planetCenter + (-tangent + bitangent) * radius;
 	Vector3 p11 = planetCenter + (tangent + bitangent) * radius;
 
-	p00 += getAltitude(p00) * normal;
-	p10 += getAltitude(p10) * normal;
-	p01 += getAltitude(p01) * normal;
-	p11 += getAltitude(p11) * normal;
+	// Query all corners in one batch so the altitude provider only needs to access its tile index once
+	sim::LatLon latLons[4] = {geocentricToLatLon(p00), geocentricToLatLon(p10), geocentricToLatLon(p01), geocentricToLatLon(p11)};
+	double altitudes[4];
+	mAltitudeProvider->get(latLons, altitudes, 4);
+
+	p00 += altitudes[0] * normal;
+	p10 += altitudes[1] * normal;
+	p01 += altitudes[2] * normal;
+	p11 += altitudes[3] * normal;
 
 	btVector3 t0[3];
 	t0[0] = toBtVector3(p00);
@@ -83,11 +88,5 @@ void TerrainCollisionShape::calculateLocalInertia(btScalar mass, btVector3 &iner
 	inertia.setValue(btScalar(0.), btScalar(0.), btScalar(0.));
 }
 
-double TerrainCollisionShape::getAltitude(const Vector3& position) const
-{
-	sim::LatLon latLon = geocentricToLatLon(position);
-	return mAltitudeProvider->get(latLon);
-}
-
 } // namespace sim
 } // namespace skybolt
\ No newline at end of file
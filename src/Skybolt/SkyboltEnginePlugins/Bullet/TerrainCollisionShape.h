@@ -34,9 +34,6 @@ public:
 
 	const char *getName() const override { return "TerrainCollisionShape"; }
 
-private:
-	double getAltitude(const Vector3& position) const;
-
 private:
 	std::shared_ptr<AltitudeProvider> mAltitudeProvider;
 	double mPlanetRadius; //!< Reference radius for altitude = 0
@@ -5,6 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "FftOceanGenerator.h"
+#include <SkyboltCommon/ParallelFor.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <cxxtimer/cxxtimer.hpp>
 
@@ -312,15 +313,11 @@ static float filterNan(float v, float valueIfNan)
 	return std::isnan(v) ? valueIfNan : v;
 }
 
-void FftOceanGenerator::calculate(float t, std::vector<glm::vec3>& result)
+void FftOceanGenerator::calcFftInputRows(float t, int beginRow, int endRow)
 {
-	cxxtimer::Timer timer(true);
-
-	result.resize(mTextureSizePixels * mTextureSizePixels);
 	complex_type_simd4 htVertical, htHorizontalX, htHorizontalZ;
 
-	// Prepare fft input
-	for (int m = 0; m < mTextureSizePixels; ++m)
+	for (int m = beginRow; m < endRow; ++m)
 	{
 		Simd4 kz = fromScalar(math::piF() * (2.0f * m - mTextureSizePixels) * mOneOnTextureWorldSize);
 		for (int ns = 0; ns < mTextureSizePixels; ns+=4) // advance in blocks of 4 which are processed concurrently with simd4
@@ -354,18 +351,14 @@ void FftOceanGenerator::calculate(float t, std::vector<glm::vec3>& result)
 			}
 		}
 	}
+}
 
-	// Run FFT
-	mufft_execute_plan_2d(mFftGeneratorData->verticalPlan, mFftOutputVertical.get(), mFftInputVertical.get());
-	mufft_execute_plan_2d(mFftGeneratorData->horizontalPlan[0], mFftOutputHorizontal[0].get(), mFftInputHorizontal[0].get());
-	mufft_execute_plan_2d(mFftGeneratorData->horizontalPlan[1], mFftOutputHorizontal[1].get(), mFftInputHorizontal[1].get());
-	//std::cout << "time " << timer.count() << std::endl;
-
-	// Output results to vector displacement image
+void FftOceanGenerator::calcOutputRows(std::vector<glm::vec3>& result, int beginRow, int endRow) const
+{
 	float lambda = 8.f; // Controls wave peak steepness
 	float signs[] = { 1.0f, -1.0f };
 
-	for (int m = 0; m < mTextureSizePixels; ++m)
+	for (int m = beginRow; m < endRow; ++m)
 	{
 		for (int n = 0; n < mTextureSizePixels; ++n)
 		{
@@ -379,6 +372,48 @@ void FftOceanGenerator::calculate(float t, std::vector<glm::vec3>& result)
 	}
 }
 
+void FftOceanGenerator::calculate(float t, std::vector<glm::vec3>& result, px_sched::Scheduler* scheduler)
+{
+	cxxtimer::Timer timer(true);
+
+	result.resize(mTextureSizePixels * mTextureSizePixels);
+
+	// Rows are independent, so split them into batches across threads
+	constexpr std::size_t minRowsPerBatch = 16;
+
+	// Prepare fft input
+	parallelFor(scheduler, mTextureSizePixels, minRowsPerBatch, [&] (std::size_t begin, std::size_t end) {
+		calcFftInputRows(t, int(begin), int(end));
+	});
+
+	// Run FFTs. Each FFT has its own plan and buffers, so the three FFTs can run concurrently.
+	struct FftJob
+	{
+		mufft_plan_2d* plan;
+		aligned_complex_type* output;
+		const aligned_complex_type* input;
+	};
+
+	const FftJob fftJobs[] = {
+		{mFftGeneratorData->verticalPlan, mFftOutputVertical.get(), mFftInputVertical.get()},
+		{mFftGeneratorData->horizontalPlan[0], mFftOutputHorizontal[0].get(), mFftInputHorizontal[0].get()},
+		{mFftGeneratorData->horizontalPlan[1], mFftOutputHorizontal[1].get(), mFftInputHorizontal[1].get()}
+	};
+
+	parallelFor(scheduler, std::size(fftJobs), 1, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			mufft_execute_plan_2d(fftJobs[i].plan, fftJobs[i].output, fftJobs[i].input);
+		}
+	});
+	//std::cout << "time " << timer.count() << std::endl;
+
+	// Output results to vector displacement image
+	parallelFor(scheduler, mTextureSizePixels, minRowsPerBatch, [&] (std::size_t begin, std::size_t end) {
+		calcOutputRows(result, int(begin), int(end));
+	});
+}
+
 void FftOceanGenerator::setWindSpeed(float windSpeed)
 {
 	mWindVelocity.x = windSpeed;
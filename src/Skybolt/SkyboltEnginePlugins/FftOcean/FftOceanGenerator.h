@@ -16,6 +16,8 @@
 
 #include <xsimd/xsimd.hpp>
 
+namespace px_sched { class Scheduler; }
+
 namespace skybolt {
 namespace vis {
 
@@ -66,7 +68,11 @@ public:
 	}
 
 	//! Generates a vector displacement image of the wave field at given time
-	void calculate(float time, std::vector<glm::vec3>& result);
+	//! @param scheduler if not null, the spectrum evaluation, FFTs and output repacking are split across the scheduler's worker threads
+	void calculate(float time, std::vector<glm::vec3>& result, px_sched::Scheduler* scheduler = nullptr);
+
+	int getTextureSizePixels() const { return mTextureSizePixels; }
+	float getTextureWorldSize() const { return mTextureWorldSize; }
 
 	void setWindSpeed(float windSpeed);
 
@@ -74,6 +80,8 @@ public:
 
 private:
 	Simd4 calcDispersion(Simd4 kx, Simd4 kz) const;
+	void calcFftInputRows(float time, int beginRow, int endRow);
+	void calcOutputRows(std::vector<glm::vec3>& result, int beginRow, int endRow) const;
 	float calcPhillips(int n, int m) const;
 	float calcBruenton(int n, int m) const;
 	void calcHt0();
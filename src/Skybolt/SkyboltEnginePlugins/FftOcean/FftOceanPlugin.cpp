@@ -19,17 +19,26 @@ namespace skybolt {
 class FftOceanWaveHeightTextureGeneratorFactory : public vis::WaveHeightTextureGeneratorFactory
 {
 public:
+	FftOceanWaveHeightTextureGeneratorFactory(px_sched::Scheduler* scheduler) :
+		mScheduler(scheduler)
+	{
+		assert(mScheduler);
+	}
+
 	std::unique_ptr<vis::WaveHeightTextureGenerator> create(float textureWorldSize, const glm::vec2& normalizedFrequencyRange) const override
 	{
-		return std::make_unique<vis::FftOceanWaveHeightTextureGenerator>(textureWorldSize, normalizedFrequencyRange);
+		return std::make_unique<vis::FftOceanWaveHeightTextureGenerator>(mScheduler, textureWorldSize, normalizedFrequencyRange);
 	}
+
+private:
+	px_sched::Scheduler* mScheduler;
 };
 
 FftOceanPlugin::FftOceanPlugin(const PluginConfig& config)
 {
 	mVisFactoryRegistry = valueOrThrowException(getExpectedRegistry<vis::VisFactoryRegistry>(*config.engineRoot->factoryRegistries));
 
-	(*mVisFactoryRegistry)[vis::VisFactoryType::WaveHeightTextureGenerator] = std::make_shared<FftOceanWaveHeightTextureGeneratorFactory>();
+	(*mVisFactoryRegistry)[vis::VisFactoryType::WaveHeightTextureGenerator] = std::make_shared<FftOceanWaveHeightTextureGeneratorFactory>(config.engineRoot->scheduler.get());
 }
 
 FftOceanPlugin::~FftOceanPlugin()
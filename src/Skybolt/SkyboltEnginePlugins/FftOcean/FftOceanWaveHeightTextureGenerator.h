@@ -7,32 +7,43 @@
 #include <SkyboltVis/Renderable/Water/WaveHeightTextureGenerator.h>
 #include "FftOceanGenerator.h"
 
+#include <px_sched/px_sched.h>
+
+#include <assert.h>
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <thread>
+#include <limits>
 
 namespace skybolt {
 namespace vis {
 
+//! Generates a wave displacement texture for one ocean cascade.
+//! Generation runs as a task on the scheduler, so multiple cascades at different texture world sizes are generated concurrently
+//! on the scheduler's workers, and each generation is itself split across the workers.
+//! Results are double buffered. While the render thread uploads the latest result, the next result is generated into the other buffer,
+//! so the render thread never waits for generation to finish.
 class FftOceanWaveHeightTextureGenerator : public WaveHeightTextureGenerator
 {
 public:
-	FftOceanWaveHeightTextureGenerator(float textureWorldSize, const glm::vec2& normalizedFrequencyRange) :
+	FftOceanWaveHeightTextureGenerator(px_sched::Scheduler* scheduler, float textureWorldSize, const glm::vec2& normalizedFrequencyRange, int textureSizePixels = 512) :
+		mScheduler(scheduler),
 		mWorldSize(textureWorldSize),
 		mWaveHeight(0.5)
 	{
+		assert(mScheduler);
 		mWindSpeed = FftOceanGenerator::calcWindSpeedFromMaxWaveHeight(mWaveHeight, mGravity);
 
 		FftOceanGeneratorConfig config;
 		config.gravity = mGravity;
 		config.seed = 0;
-		config.textureSizePixels = 512;
+		config.textureSizePixels = textureSizePixels;
 		config.textureWorldSize = textureWorldSize;
 		config.windVelocity = glm::vec2(mWindSpeed.load(), 0);
 		config.normalizedFrequencyRange = normalizedFrequencyRange;
 
-		mGeneratorResult = std::vector<glm::vec3>(config.textureSizePixels * config.textureSizePixels, glm::vec3(0,0,0));
+		for (auto& result : mGeneratorResults)
+		{
+			result = std::vector<glm::vec3>(config.textureSizePixels * config.textureSizePixels, glm::vec3(0,0,0));
+		}
 
 		mGenerator.reset(new FftOceanGenerator(config));
 
@@ -45,21 +56,12 @@ public:
 		mTexture->setFilter(osg::Texture2D::FilterParameter::MIN_FILTER, osg::Texture2D::FilterMode::LINEAR_MIPMAP_LINEAR);
 		mTexture->setFilter(osg::Texture2D::FilterParameter::MAG_FILTER, osg::Texture2D::FilterMode::LINEAR);
 
-		mGeneratorThread = std::thread([this] {runGeneratorThread(); });
-		{
-			std::lock_guard<std::mutex> lock(mGeneratorRequestMutex);
-			mGeneratorRequest = true;
-		}
-		mGeneratorRequestCV.notify_one();
-
-		generate(0);
+		requestGeneration(0);
 	}
 
 	~FftOceanWaveHeightTextureGenerator()
 	{
-		mTerminateGeneratorThread = true;
-		mGeneratorRequestCV.notify_one();
-		mGeneratorThread.join();
+		mScheduler->waitFor(mGeneratorSync);
 	}
 
 	bool generate(double time) override
@@ -69,55 +71,23 @@ public:
 			return false;
 		}
 
-		if (mGeneratorHasResult)
+		if (!mGeneratorHasResult.load(std::memory_order_acquire))
 		{
-			osg::Image* image = mTexture->getImage();
-			{
-				// Copy image from generator thread to texture
-				std::lock_guard<std::mutex> lock(mGeneratorResultMutex);
-				memcpy(image->data(), mGeneratorResult.data(), mGeneratorResult.size() * sizeof(float) * 3);
-				mResultTime = mRequestTime;
-
-				// Request a new image to be generated
-				mGeneratorRequest = true;
-				mRequestTime = time;
-			}
-			mGeneratorRequestCV.notify_one();
-			image->dirty();
-			return true;
-		}
-		return false;
-	}
-
-	void runGeneratorThread()
-	{
-		while (!mTerminateGeneratorThread)
-		{
-			// Wait for generation request
-			{
-				std::unique_lock<std::mutex> lock(mGeneratorRequestMutex);
-				mGeneratorRequestCV.wait(lock, [this] {return mGeneratorRequest || mTerminateGeneratorThread; });
-			}
-
-			if (mTerminateGeneratorThread)
-			{
-				return;
-			}
-
-			{
-				std::lock_guard<std::mutex> lock(mGeneratorResultMutex);
-
-				if (mWindSpeedChanged)
-				{
-					mGenerator->setWindSpeed(mWindSpeed);
-					mWindSpeedChanged = false;
-				}
-
-				mGenerator->calculate(mRequestTime, mGeneratorResult);
-				mGeneratorHasResult = true;
-				mGeneratorRequest = false;
-			}
+			return false;
 		}
+		mGeneratorHasResult = false;
+
+		// The generator task has finished, so its result becomes the front buffer
+		// and the next result can be generated into the back buffer while the front buffer is uploaded.
+		mFrontResultIndex = 1 - mFrontResultIndex;
+		mResultTime = mRequestTime;
+		requestGeneration(time);
+
+		const std::vector<glm::vec3>& result = mGeneratorResults[mFrontResultIndex];
+		osg::Image* image = mTexture->getImage();
+		memcpy(image->data(), result.data(), result.size() * sizeof(float) * 3);
+		image->dirty();
+		return true;
 	}
 
 	float getWorldSize() const
@@ -142,25 +112,39 @@ public:
 		return mTexture;
 	}
 
+private:
+	//! Starts generating a result for the given time into the back buffer.
+	//! Must only be called when no generator task is running.
+	void requestGeneration(double time)
+	{
+		mRequestTime = time;
+		std::vector<glm::vec3>* backResult = &mGeneratorResults[1 - mFrontResultIndex];
+
+		mScheduler->run([this, time, backResult] {
+			if (mWindSpeedChanged.exchange(false))
+			{
+				mGenerator->setWindSpeed(mWindSpeed);
+			}
+
+			mGenerator->calculate(float(time), *backResult, mScheduler);
+			mGeneratorHasResult.store(true, std::memory_order_release);
+		}, &mGeneratorSync);
+	}
+
 private:
 	const float mGravity = 9.8f;
+	px_sched::Scheduler* mScheduler;
 	std::unique_ptr<FftOceanGenerator> mGenerator;
 	osg::ref_ptr<osg::Texture2D> mTexture;
 	float mWorldSize;
 	float mWaveHeight;
 
-	std::thread mGeneratorThread;
-	std::atomic_bool mTerminateGeneratorThread = false;
-
-	std::vector<glm::vec3> mGeneratorResult;
-	std::mutex mGeneratorResultMutex;
+	px_sched::Sync mGeneratorSync;
+	std::vector<glm::vec3> mGeneratorResults[2];
+	int mFrontResultIndex = 0; //!< Index of result being displayed. The other result is written by the generator task.
 	std::atomic_bool mGeneratorHasResult = false;
 	double mResultTime = std::numeric_limits<double>::infinity();
-
-	std::mutex mGeneratorRequestMutex;
-	std::condition_variable mGeneratorRequestCV;
 	double mRequestTime = 0;
-	bool mGeneratorRequest = false;
 
 	std::atomic<float> mWindSpeed;
 	std::atomic_bool mWindSpeedChanged = false;
@@ -9,18 +9,28 @@
 #include <FftOcean/FftOceanGenerator.h>
 
 #include <osgDB/WriteFile>
+#include <px_sched/px_sched.h>
+
+#include <memory>
+#include <string>
 
 using namespace skybolt::vis;
 
-TEST_CASE("Generate FFT ocean texture")
+static FftOceanGeneratorConfig createTestConfig(int textureSizePixels = 256, float textureWorldSize = 1000)
 {
 	FftOceanGeneratorConfig config;
 	config.seed = 0;
-	config.textureSizePixels = 256;
-	config.textureWorldSize = 1000;
+	config.textureSizePixels = textureSizePixels;
+	config.textureWorldSize = textureWorldSize;
 	config.windVelocity = glm::vec2(10, 0);
 	config.gravity = 9.8;
 	config.normalizedFrequencyRange = glm::vec2(0, 1);
+	return config;
+}
+
+TEST_CASE("Generate FFT ocean texture")
+{
+	FftOceanGeneratorConfig config = createTestConfig();
 	FftOceanGenerator generator(config);
 
 	float maxHeight = generator.calcMaxWaveHeight(glm::length(config.windVelocity), config.gravity);
@@ -51,3 +61,67 @@ TEST_CASE("Generate FFT ocean texture")
 		osgDB::writeImageFile(*image, "C:/Users/Public/test.tga");
 	}
 }
+
+TEST_CASE("Parallel FFT ocean generation matches serial generation")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	FftOceanGenerator serialGenerator(createTestConfig());
+	FftOceanGenerator parallelGenerator(createTestConfig());
+
+	for (float time : {0.0f, 1.5f})
+	{
+		std::vector<glm::vec3> serialResult;
+		serialGenerator.calculate(time, serialResult);
+
+		std::vector<glm::vec3> parallelResult;
+		parallelGenerator.calculate(time, parallelResult, &scheduler);
+
+		REQUIRE(serialResult.size() == parallelResult.size());
+		CHECK(serialResult == parallelResult);
+	}
+}
+
+TEST_CASE("Benchmark FFT ocean generation", "[.benchmark]")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	for (int textureSizePixels : {256, 512, 1024})
+	{
+		FftOceanGenerator generator(createTestConfig(textureSizePixels));
+		std::vector<glm::vec3> result;
+
+		BENCHMARK("Serial " + std::to_string(textureSizePixels))
+		{
+			generator.calculate(1.0f, result);
+			return result.size();
+		};
+
+		BENCHMARK("Parallel " + std::to_string(textureSizePixels))
+		{
+			generator.calculate(1.0f, result, &scheduler);
+			return result.size();
+		};
+	}
+
+	// Cascades at different world sizes, each with its own generator, as created by FftOceanWaveHeightTextureGenerator
+	std::vector<std::unique_ptr<FftOceanGenerator>> cascades;
+	std::vector<std::vector<glm::vec3>> cascadeResults(2);
+	cascades.push_back(std::make_unique<FftOceanGenerator>(createTestConfig(512, 1000)));
+	cascades.push_back(std::make_unique<FftOceanGenerator>(createTestConfig(512, 5000)));
+
+	BENCHMARK("Parallel 2 cascades 512")
+	{
+		px_sched::Sync sync;
+		for (size_t i = 0; i < cascades.size(); ++i)
+		{
+			scheduler.run([&, i] {
+				cascades[i]->calculate(1.0f, cascadeResults[i], &scheduler);
+			}, &sync);
+		}
+		scheduler.waitFor(sync);
+		return cascadeResults[0].size();
+	};
+}
@@ -0,0 +1,222 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltEngine/Sequence/EntityStateSequenceController.h>
+#include <SkyboltEngine/Sequence/Interpolator/CubicBSplineInterpolator.h>
+
+#include <random>
+#include <thread>
+
+using namespace skybolt;
+
+static EntitySequenceState createTestState(std::mt19937& generator)
+{
+	std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+	EntitySequenceState state;
+	state.position = sim::Vector3(distribution(generator), distribution(generator), distribution(generator)) * 100.0;
+	state.orientation = glm::normalize(sim::Quaternion(2.0, distribution(generator), distribution(generator), distribution(generator)));
+	return state;
+}
+
+static std::shared_ptr<EntityStateSequence> createTestSequence(int keyCount)
+{
+	std::mt19937 generator(0);
+	auto sequence = std::make_shared<EntityStateSequence>();
+	for (int i = 0; i < keyCount; ++i)
+	{
+		sequence->addItemAtIndex(createTestState(generator), i * 1.5 + (i % 3) * 0.2, i);
+	}
+	return sequence;
+}
+
+//! Interpolates with one CubicBSplineInterpolator per component, as a reference for the cached spline
+static EntitySequenceState interpolateReference(const EntityStateSequence& sequence, double t)
+{
+	std::optional<math::InterpolationPoint> point = math::findInterpolationPoint(sequence.times, t, /* extrapolate */ false);
+	REQUIRE(point);
+
+	auto sizeGetter = [&] { return int(sequence.values.size()); };
+	auto timeGetter = [&] (int i) { return sequence.times[i]; };
+
+	EntitySequenceState state;
+	for (int c = 0; c < 3; ++c)
+	{
+		CubicBSplineInterpolatorD interpolator(sizeGetter, [&] (int i) { return sequence.values[i].position[c]; }, timeGetter);
+		state.position[c] = interpolator.interpolate(point->bounds.first, point->bounds.last, point->weight);
+	}
+	for (int c = 0; c < 4; ++c)
+	{
+		CubicBSplineInterpolatorD interpolator(sizeGetter, [&] (int i) { return sequence.values[i].orientation[c]; }, timeGetter);
+		state.orientation[c] = interpolator.interpolate(point->bounds.first, point->bounds.last, point->weight);
+	}
+	state.orientation = glm::normalize(state.orientation);
+	return state;
+}
+
+static void checkStatesEqual(const sim::Vector3& position, const sim::Quaternion& orientation, const EntitySequenceState& expected)
+{
+	constexpr double epsilon = 1e-9;
+	for (int c = 0; c < 3; ++c)
+	{
+		CHECK(position[c] == Approx(expected.position[c]).margin(epsilon));
+	}
+	for (int c = 0; c < 4; ++c)
+	{
+		CHECK(orientation[c] == Approx(expected.orientation[c]).margin(epsilon));
+	}
+}
+
+static void checkControllerMatchesReference(const EntityStateSequenceController& controller, const EntityStateSequence& sequence)
+{
+	double startTime = sequence.times.front() - 1.0;
+	double endTime = sequence.times.back() + 1.0;
+	for (double t = startTime; t <= endTime; t += 0.1)
+	{
+		SequenceStatePtr state = controller.getStateAtTime(t);
+		REQUIRE(state);
+		const auto& entityState = static_cast<const EntitySequenceState&>(*state);
+		checkStatesEqual(entityState.position, entityState.orientation, interpolateReference(sequence, t));
+	}
+}
+
+TEST_CASE("EntityStateSequenceController interpolates keys with cubic B-spline")
+{
+	auto sequence = createTestSequence(10);
+	EntityStateSequenceController controller(sequence);
+	checkControllerMatchesReference(controller, *sequence);
+
+	std::mt19937 generator(1);
+
+	SECTION("Spline is updated when a key is added")
+	{
+		sequence->addItemAtTime(createTestState(generator), 4.0);
+		checkControllerMatchesReference(controller, *sequence);
+
+		sequence->addItemAtTime(createTestState(generator), -3.0);
+		checkControllerMatchesReference(controller, *sequence);
+	}
+
+	SECTION("Spline is updated when a key is changed")
+	{
+		sequence->setValueAtIndex(createTestState(generator), 5);
+		checkControllerMatchesReference(controller, *sequence);
+	}
+
+	SECTION("Spline is updated when a key is removed")
+	{
+		sequence->removeItemAtIndex(3);
+		checkControllerMatchesReference(controller, *sequence);
+
+		sequence->removeItemAtIndex(0);
+		checkControllerMatchesReference(controller, *sequence);
+
+		sequence->removeItemAtIndex(sequence->times.size() - 1);
+		checkControllerMatchesReference(controller, *sequence);
+	}
+}
+
+TEST_CASE("EntityStateSequenceController can be evaluated from multiple threads")
+{
+	auto sequence = createTestSequence(200);
+	EntityStateSequenceController controller(sequence);
+
+	// Change keys so that the first evaluations on each thread race to update the spline
+	std::mt19937 generator(2);
+	for (size_t i = 0; i < sequence->times.size(); i += 3)
+	{
+		sequence->setValueAtIndex(createTestState(generator), i);
+	}
+
+	constexpr int threadCount = 4;
+	constexpr int sampleCount = 1000;
+	std::vector<std::vector<sim::Vector3>> positions(threadCount, std::vector<sim::Vector3>(sampleCount));
+	std::vector<std::vector<sim::Quaternion>> orientations(threadCount, std::vector<sim::Quaternion>(sampleCount));
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t] {
+			controller.sampleRange(sequence->times.front(), sequence->times.back(), sampleCount, positions[t].data(), orientations[t].data());
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (int t = 0; t < threadCount; ++t)
+	{
+		for (int i = 0; i < sampleCount; i += 97)
+		{
+			double time = sequence->times.front() + (sequence->times.back() - sequence->times.front()) * double(i) / double(sampleCount - 1);
+			checkStatesEqual(positions[t][i], orientations[t][i], interpolateReference(*sequence, time));
+		}
+	}
+}
+
+TEST_CASE("EntityStateSequenceController samples range into caller buffers")
+{
+	auto sequence = createTestSequence(20);
+	EntityStateSequenceController controller(sequence);
+
+	constexpr int sampleCount = 50;
+	std::vector<sim::Vector3> positions(sampleCount);
+	std::vector<sim::Quaternion> orientations(sampleCount);
+
+	// Sample beyond both ends of the sequence, forwards and backwards
+	double firstTime = sequence->times.front() - 2.0;
+	double lastTime = sequence->times.back() + 2.0;
+	for (auto [startTime, endTime] : {std::make_pair(firstTime, lastTime), std::make_pair(lastTime, firstTime)})
+	{
+		REQUIRE(controller.sampleRange(startTime, endTime, sampleCount, positions.data(), orientations.data()));
+
+		for (int i = 0; i < sampleCount; ++i)
+		{
+			double t = startTime + (endTime - startTime) * double(i) / double(sampleCount - 1);
+			checkStatesEqual(positions[i], orientations[i], interpolateReference(*sequence, t));
+		}
+	}
+
+	SECTION("Empty sequence is not sampled")
+	{
+		sequence->clear();
+		CHECK(!controller.sampleRange(0, 1, sampleCount, positions.data(), orientations.data()));
+	}
+}
+
+TEST_CASE("Benchmark EntityStateSequenceController sampling", "[.benchmark]")
+{
+	auto sequence = createTestSequence(20000);
+	EntityStateSequenceController controller(sequence);
+
+	constexpr int sampleCount = 1000;
+	std::vector<sim::Vector3> positions(sampleCount);
+	std::vector<sim::Quaternion> orientations(sampleCount);
+	double startTime = sequence->times.front();
+	double endTime = sequence->times.back();
+
+	BENCHMARK("getStateAtTime 1000 samples")
+	{
+		SequenceStatePtr state;
+		for (int i = 0; i < sampleCount; ++i)
+		{
+			state = controller.getStateAtTime(startTime + (endTime - startTime) * double(i) / double(sampleCount - 1));
+		}
+		return state;
+	};
+
+	BENCHMARK("sampleRange 1000 samples")
+	{
+		return controller.sampleRange(startTime, endTime, sampleCount, positions.data(), orientations.data());
+	};
+
+	BENCHMARK("Change key and resample")
+	{
+		sequence->setValueAtIndex(sequence->values[100], 100);
+		return controller.sampleRange(startTime, endTime, sampleCount, positions.data(), orientations.data());
+	};
+}
@@ -5,9 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PyComponent.h"
-#include "PythonBindings.h"
-
-#include <SkyboltEngine/EngineRoot.h>
+#include "PyComponentSystem.h"
 
 namespace py = pybind11;
 
@@ -24,26 +22,43 @@ static py::detail::str_attr_accessor getRequiredAttr(const py::handle& obj, cons
 	return obj.attr(name);
 }
 
-PyComponent::PyComponent(py::object pythonComponent) :
-	mPythonComponent(std::move(pythonComponent))
+//! @returns the attribute, or null if the object does not have the attribute
+static py::object getOptionalAttr(const py::handle& obj, const char* name)
 {
-	EngineRoot* engine = getGlobalEngineRoot();
-	if (!engine)
-	{
-		throw std::runtime_error("Global EngineRoot not instantiated");
-	}
-
-	refl::TypeRegistry* typeRegistry = engine->typeRegistry.get();
+	return py::hasattr(obj, name) ? py::object(obj.attr(name)) : py::object();
+}
 
+PyComponent::PyComponent(py::object pythonComponent, refl::TypeRegistry& typeRegistry, const std::shared_ptr<PyComponentSystem>& system) :
+	mPythonComponent(std::move(pythonComponent)),
+	mSystem(system)
+{
 	auto properties = getRequiredAttr(mPythonComponent, "properties");
 	mPropertiesDict = properties.attr("__dict__");
 	for (const auto& [name, property] : mPropertiesDict)
 	{
-		addProperty(*typeRegistry, py::cast<std::string>(name), property);
+		addProperty(typeRegistry, py::cast<std::string>(name), property);
 	}
+
+	mSetSimTimeFunc = getOptionalAttr(mPythonComponent, "set_sim_time");
+	mAdvanceSimTimeFunc = getOptionalAttr(mPythonComponent, "advance_sim_time");
+	mPropertyChangedFunc = getOptionalAttr(mPythonComponent, "property_changed");
 }
 
-PyComponent::~PyComponent() = default;
+PyComponent::~PyComponent()
+{
+	if (auto system = mSystem.lock(); system)
+	{
+		system->removeQueuedCalls(this);
+	}
+
+	// Release Python objects while holding the GIL, because the caller may have released it, e.g during stepSim
+	py::gil_scoped_acquire acquire;
+	mSetSimTimeFunc.release().dec_ref();
+	mAdvanceSimTimeFunc.release().dec_ref();
+	mPropertyChangedFunc.release().dec_ref();
+	mPropertiesDict.release().dec_ref();
+	mPythonComponent.release().dec_ref();
+}
 
 refl::Type::PropertyMap PyComponent::getProperties() const
 {
@@ -52,17 +67,53 @@ refl::Type::PropertyMap PyComponent::getProperties() const
 
 void PyComponent::setSimTime(SecondsD newTime)
 {
-	if (pybind11::hasattr(mPythonComponent, "set_sim_time"))
+	if (!mSetSimTimeFunc)
+	{
+		return;
+	}
+
+	if (auto system = mSystem.lock(); system)
+	{
+		system->queueSetSimTime(this, newTime);
+	}
+	else
 	{
-		mPythonComponent.attr("set_sim_time")(newTime);
+		py::gil_scoped_acquire acquire;
+		callSetSimTime(newTime);
 	}
 }
 
 void PyComponent::advanceSimTime(SecondsD newTime, SecondsD dt)
 {
-	if (pybind11::hasattr(mPythonComponent, "advance_sim_time"))
+	if (!mAdvanceSimTimeFunc)
+	{
+		return;
+	}
+
+	if (auto system = mSystem.lock(); system)
+	{
+		system->queueAdvanceSimTime(this, newTime, dt);
+	}
+	else
+	{
+		py::gil_scoped_acquire acquire;
+		callAdvanceSimTime(newTime, dt);
+	}
+}
+
+void PyComponent::callSetSimTime(SecondsD newTime)
+{
+	if (mSetSimTimeFunc)
+	{
+		mSetSimTimeFunc(newTime);
+	}
+}
+
+void PyComponent::callAdvanceSimTime(SecondsD newTime, SecondsD dt)
+{
+	if (mAdvanceSimTimeFunc)
 	{
-		mPythonComponent.attr("advance_sim_time")(newTime, dt);
+		mAdvanceSimTimeFunc(newTime, dt);
 	}
 }
 
@@ -10,20 +10,33 @@
 
 #include <pybind11/pybind11.h>
 
+#include <memory>
+
 namespace skybolt {
 
-//! Wrapper allowing Python scripts define Component functionality
+class PyComponentSystem;
+
+//! Wrapper allowing Python scripts define Component functionality.
+//! The Python component's hooks are looked up once on construction.
 class PyComponent : public sim::Component, public refl::DynamicPropertySource
 {
 public:
-	PyComponent(pybind11::object pythonComponent);
+	//! @param system is optional. If provided, calls to the Python component's time update hooks are queued
+	//! and made in a batch by the system. Otherwise the hooks are called immediately.
+	PyComponent(pybind11::object pythonComponent, refl::TypeRegistry& typeRegistry, const std::shared_ptr<PyComponentSystem>& system = nullptr);
 	~PyComponent() override;
 
 	refl::Type::PropertyMap getProperties() const override;
 
-    void setSimTime(sim::SecondsD newTime) override;
+	void setSimTime(sim::SecondsD newTime) override;
 	void advanceSimTime(sim::SecondsD newTime, sim::SecondsD dt) override;
 
+	//! Calls the Python component's set_sim_time hook, if it has one. Caller must hold the GIL.
+	void callSetSimTime(sim::SecondsD newTime);
+
+	//! Calls the Python component's advance_sim_time hook, if it has one. Caller must hold the GIL.
+	void callAdvanceSimTime(sim::SecondsD newTime, sim::SecondsD dt);
+
 private:
 	void addProperty(refl::TypeRegistry& typeRegistry, const std::string& name, const pybind11::handle& value);
 
@@ -31,17 +44,19 @@ private:
 	void addPropertyOfType(refl::TypeRegistry& typeRegistry, const std::string& name, const T& value)
 	{
 		auto getter = [name] (const PyComponent& c) -> T {
+			pybind11::gil_scoped_acquire acquire;
 			return pybind11::cast<T>(c.mPropertiesDict[name.c_str()]);
 		};
 
-		auto setter = [name, this] (PyComponent& c, const T& value) {
+		auto setter = [name] (PyComponent& c, const T& value) {
+			pybind11::gil_scoped_acquire acquire;
 			auto oldValue = c.mPropertiesDict[name.c_str()];
 			if (pybind11::cast<T>(oldValue) != value)
 			{
 				c.mPropertiesDict[name.c_str()] = value;
-				if (pybind11::hasattr(mPythonComponent, "property_changed"))
+				if (c.mPropertyChangedFunc)
 				{
-					mPythonComponent.attr("property_changed")(name, value);
+					c.mPropertyChangedFunc(name, value);
 				}
 			}
 		};
@@ -53,6 +68,12 @@ private:
 	pybind11::object mPythonComponent;
 	pybind11::dict mPropertiesDict;
 	refl::Type::PropertyMap mProperties;
+	std::weak_ptr<PyComponentSystem> mSystem;
+
+	// Bound methods of the Python component, or null if the Python component does not define them
+	pybind11::object mSetSimTimeFunc;
+	pybind11::object mAdvanceSimTimeFunc;
+	pybind11::object mPropertyChangedFunc;
 };
 
 SKYBOLT_REFLECT_BEGIN(PyComponent)
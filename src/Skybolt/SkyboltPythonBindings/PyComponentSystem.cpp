@@ -0,0 +1,104 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "PyComponentSystem.h"
+#include "PyComponent.h"
+#include <SkyboltSim/System/EntitySystem.h>
+
+#include <algorithm>
+
+namespace py = pybind11;
+
+namespace skybolt {
+
+using namespace skybolt::sim;
+
+PyComponentSystem::PyComponentSystem() = default;
+
+PyComponentSystem::~PyComponentSystem() = default;
+
+void PyComponentSystem::setSimTime(SecondsD newTime)
+{
+	processQueue();
+}
+
+void PyComponentSystem::advanceSimTime(SecondsD newTime, SecondsD dt)
+{
+	processQueue();
+}
+
+void PyComponentSystem::queueSetSimTime(PyComponent* component, SecondsD newTime)
+{
+	mQueue.push_back({component, false, newTime, 0});
+}
+
+void PyComponentSystem::queueAdvanceSimTime(PyComponent* component, SecondsD newTime, SecondsD dt)
+{
+	mQueue.push_back({component, true, newTime, dt});
+}
+
+void PyComponentSystem::removeQueuedCalls(const PyComponent* component)
+{
+	auto isComponent = [component] (const QueuedCall& call) { return call.component == component; };
+	mQueue.erase(std::remove_if(mQueue.begin(), mQueue.end(), isComponent), mQueue.end());
+
+	// The component may be destroyed by a call made by processQueue(), so skip its remaining calls
+	for (QueuedCall& call : mProcessingQueue)
+	{
+		if (call.component == component)
+		{
+			call.component = nullptr;
+		}
+	}
+}
+
+void PyComponentSystem::processQueue()
+{
+	if (mQueue.empty())
+	{
+		return;
+	}
+
+	// Move calls to a separate queue, because Python may queue more calls while processing
+	mProcessingQueue.clear();
+	std::swap(mQueue, mProcessingQueue);
+
+	py::gil_scoped_acquire acquire;
+	for (size_t i = 0; i < mProcessingQueue.size(); ++i)
+	{
+		const QueuedCall& call = mProcessingQueue[i];
+		if (!call.component)
+		{
+			continue;
+		}
+
+		if (call.advance)
+		{
+			call.component->callAdvanceSimTime(call.newTime, call.dt);
+		}
+		else
+		{
+			call.component->callSetSimTime(call.newTime);
+		}
+	}
+	mProcessingQueue.clear();
+}
+
+std::shared_ptr<PyComponentSystem> addPyComponentSystem(SystemRegistry& registry)
+{
+	if (auto system = findSystem<PyComponentSystem>(registry); system)
+	{
+		return system;
+	}
+
+	auto system = std::make_shared<PyComponentSystem>();
+	auto isEntitySystem = [] (const SystemPtr& s) { return dynamic_cast<EntitySystem*>(s.get()) != nullptr; };
+	auto i = std::find_if(registry.begin(), registry.end(), isEntitySystem);
+	registry.insert(i == registry.end() ? i : std::next(i), system);
+	return system;
+}
+
+} // namespace skybolt
@@ -0,0 +1,64 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltSim/System/System.h>
+#include <SkyboltSim/System/SystemRegistry.h>
+
+#include <vector>
+
+namespace skybolt {
+
+class PyComponent;
+
+//! Calls the Python time update hooks of all PyComponents in one batch per update, acquiring the GIL once per batch
+//! rather than once per component. PyComponents queue their calls when the EntitySystem updates them,
+//! so this system must be registered after the EntitySystem. @see addPyComponentSystem()
+//! Because calls are deferred until the end of the EntitySystem update, a component's Python hook now runs after
+//! the C++ components of all entities have been updated, rather than in order with the components of its entity.
+class PyComponentSystem : public sim::System
+{
+public:
+	PyComponentSystem();
+	~PyComponentSystem() override;
+
+	void setSimTime(sim::SecondsD newTime) override;
+	void advanceSimTime(sim::SecondsD newTime, sim::SecondsD dt) override;
+
+	//! Queues a call to the component's set_sim_time hook
+	void queueSetSimTime(PyComponent* component, sim::SecondsD newTime);
+
+	//! Queues a call to the component's advance_sim_time hook
+	void queueAdvanceSimTime(PyComponent* component, sim::SecondsD newTime, sim::SecondsD dt);
+
+	//! Removes queued calls to a component which is being destroyed
+	void removeQueuedCalls(const PyComponent* component);
+
+private:
+	//! Makes all queued calls in order
+	void processQueue();
+
+private:
+	struct QueuedCall
+	{
+		PyComponent* component;
+		bool advance; //!< If true, calls advance_sim_time, otherwise calls set_sim_time
+		sim::SecondsD newTime;
+		sim::SecondsD dt;
+	};
+
+	std::vector<QueuedCall> mQueue;
+	std::vector<QueuedCall> mProcessingQueue; //!< Calls being made by processQueue(), kept to reuse allocation
+};
+
+//! Adds a PyComponentSystem to the registry directly after the EntitySystem, so that Python component hooks
+//! are called before the systems which follow the EntitySystem, as they were when the EntitySystem called them.
+//! If the registry has no EntitySystem, the PyComponentSystem is added to the end.
+//! @returns the registry's PyComponentSystem, which is only added if the registry does not already have one
+std::shared_ptr<PyComponentSystem> addPyComponentSystem(sim::SystemRegistry& registry);
+
+} // namespace skybolt
@@ -0,0 +1,91 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "PyStateArrays.h"
+
+#include <algorithm>
+#include <optional>
+
+namespace py = pybind11;
+
+namespace skybolt {
+
+template <typename T>
+static py::array_t<T> copyToArray(const std::vector<T>& values)
+{
+	return py::array_t<T>(py::ssize_t(values.size()), values.data());
+}
+
+//! Calls visitor(name, values) for each particle attribute array in the store
+template <typename StoreT, typename VisitorT>
+static void forEachParticleArray(StoreT& particles, const VisitorT& visitor)
+{
+	visitor("guid", particles.guid);
+	visitor("positionX", particles.positionX);
+	visitor("positionY", particles.positionY);
+	visitor("positionZ", particles.positionZ);
+	visitor("velocityX", particles.velocityX);
+	visitor("velocityY", particles.velocityY);
+	visitor("velocityZ", particles.velocityZ);
+	visitor("radius", particles.radius);
+	visitor("age", particles.age);
+	visitor("initialAlpha", particles.initialAlpha);
+	visitor("alpha", particles.alpha);
+	visitor("temperatureDegreesCelcius", particles.temperatureDegreesCelcius);
+}
+
+py::dict getParticleArrays(const sim::ParticleStore& particles)
+{
+	py::dict result;
+	forEachParticleArray(particles, [&] (const char* name, const auto& values) {
+		result[name] = copyToArray(values);
+	});
+	return result;
+}
+
+void setParticleArrays(sim::ParticleStore& particles, const py::dict& arrays)
+{
+	// Convert and validate every array before writing any, so that invalid input leaves the particles unchanged
+	std::vector<std::optional<py::array>> convertedArrays;
+	std::vector<std::string> names;
+	forEachParticleArray(particles, [&] (const char* name, const auto& values) {
+		using ValueT = typename std::decay_t<decltype(values)>::value_type;
+		names.push_back(name);
+		if (!arrays.contains(name))
+		{
+			convertedArrays.push_back(std::nullopt);
+			return;
+		}
+
+		auto array = py::array_t<ValueT, py::array::c_style | py::array::forcecast>::ensure(arrays[name]);
+		if (!array || array.ndim() != 1 || array.shape(0) != py::ssize_t(values.size()))
+		{
+			throw std::runtime_error("Expected particle attribute '" + std::string(name) + "' to be an array of shape (" + std::to_string(values.size()) + ",)");
+		}
+		convertedArrays.push_back(std::move(array));
+	});
+
+	for (const auto& item : arrays)
+	{
+		std::string name = py::str(item.first);
+		if (std::find(names.begin(), names.end(), name) == names.end())
+		{
+			throw std::runtime_error("Unknown particle attribute '" + name + "'");
+		}
+	}
+
+	size_t i = 0;
+	forEachParticleArray(particles, [&] (const char* name, auto& values) {
+		using ValueT = typename std::decay_t<decltype(values)>::value_type;
+		if (const std::optional<py::array>& array = convertedArrays[i++]; array)
+		{
+			const ValueT* data = static_cast<const ValueT*>(array->data());
+			std::copy(data, data + values.size(), values.begin());
+		}
+	});
+}
+
+} // namespace skybolt
@@ -0,0 +1,81 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/Particles/ParticleSystem.h>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace skybolt {
+
+//! Copies a vector of state from each entity into a row of a contiguous (entityCount, ComponentCount) array.
+//! Rows for entities which do not have the state are filled with NaN.
+template <int ComponentCount, typename GetterT>
+pybind11::array_t<double> getEntityStates(const std::vector<sim::EntityPtr>& entities, const GetterT& getter)
+{
+	pybind11::array_t<double> result({pybind11::ssize_t(entities.size()), pybind11::ssize_t(ComponentCount)});
+	auto r = result.template mutable_unchecked<2>();
+	for (pybind11::ssize_t i = 0; i < r.shape(0); ++i)
+	{
+		if (auto value = getter(*entities[i]); value)
+		{
+			for (int c = 0; c < ComponentCount; ++c)
+			{
+				r(i, c) = (*value)[c];
+			}
+		}
+		else
+		{
+			for (int c = 0; c < ComponentCount; ++c)
+			{
+				r(i, c) = std::numeric_limits<double>::quiet_NaN();
+			}
+		}
+	}
+	return result;
+}
+
+//! Sets state of each entity from the corresponding row of a (entityCount, ComponentCount) array
+//! @throws std::runtime_error if the array has the wrong shape
+template <typename ValueT, int ComponentCount, typename SetterT>
+void setEntityStates(const std::vector<sim::EntityPtr>& entities, const pybind11::array_t<double, pybind11::array::c_style | pybind11::array::forcecast>& values, const SetterT& setter)
+{
+	if (values.ndim() != 2 || values.shape(0) != pybind11::ssize_t(entities.size()) || values.shape(1) != ComponentCount)
+	{
+		throw std::runtime_error("Expected array of shape (" + std::to_string(entities.size()) + ", " + std::to_string(ComponentCount) + ")");
+	}
+
+	auto r = values.template unchecked<2>();
+	for (pybind11::ssize_t i = 0; i < r.shape(0); ++i)
+	{
+		ValueT value;
+		for (int c = 0; c < ComponentCount; ++c)
+		{
+			value[c] = r(i, c);
+		}
+		setter(*entities[i], value);
+	}
+}
+
+//! @returns a dict of arrays, one per particle attribute, each containing a copy of the attribute's values.
+//! The arrays own their data, so they remain valid after the particles are updated.
+pybind11::dict getParticleArrays(const sim::ParticleStore& particles);
+
+//! Sets particle attributes from a dict of arrays in the format returned by getParticleArrays().
+//! The dict may contain a subset of the attributes. Attributes which are not in the dict are unchanged.
+//! The particle count is not changed, so each array must contain one value per particle.
+//! @throws std::runtime_error if an array has the wrong shape or an attribute name is unknown.
+//! Arrays are validated before any are written, so the particles are unchanged if an error is thrown.
+void setParticleArrays(sim::ParticleStore& particles, const pybind11::dict& arrays);
+
+} // namespace skybolt
@@ -5,6 +5,8 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PyComponent.h"
+#include "PyComponentSystem.h"
+#include "PyStateArrays.h"
 #include "PythonBindings.h"
 
 #include <SkyboltCommon/Math/Box3.h>
@@ -26,11 +28,16 @@
 #include <SkyboltSim/Components/CameraControllerComponent.h>
 #include <SkyboltSim/Components/MainRotorComponent.h>
 #include <SkyboltSim/Components/NameComponent.h>
+#include <SkyboltSim/Components/ParticleSystemComponent.h>
+#include <SkyboltSim/Particles/ParticleSystem.h>
+#include <SkyboltSim/Spatial/EntitySpatialIndex.h>
 #include <SkyboltSim/Spatial/Frustum.h>
 #include <SkyboltSim/Spatial/GreatCircle.h>
 #include <SkyboltSim/Spatial/Orientation.h>
 #include <SkyboltSim/Spatial/Position.h>
+#include <SkyboltSim/System/EntitySpatialIndexSystem.h>
 #include <SkyboltSim/System/SimStepper.h>
+#include <SkyboltSim/System/SystemRegistry.h>
 
 #include <SkyboltVis/Rect.h>
 #include <SkyboltVis/VisRoot.h>
@@ -63,6 +70,8 @@ static void setGlobalEngineRoot(EngineRoot* root) { gEngineRoot = root;
 	// FIXME: There's currently an issue where if this plugin is linked statically, calling this addStaticallyRegisteredTypes
 	// will re-register previously registered types, creating duplicate types because there is only one `globalHandlers` list across statically-linked objects.
 	addStaticallyRegisteredTypes(*root->typeRegistry);
+
+	addPyComponentSystem(*root->systemRegistry);
 }
 
 static std::unique_ptr<EngineRoot> createEngineRootWithDefaults() {
@@ -179,12 +188,18 @@ static void registerComponent(EngineRoot& engineRoot, const py::handle& pyClass)
 {
 	auto mComponentFactoryRegistry = valueOrThrowException(getExpectedRegistry<ComponentFactoryRegistry>(*engineRoot.factoryRegistries));
 
-	auto factory = std::make_shared<ComponentFactoryFunctionAdapter>([pyClass](Entity* entity, const ComponentFactoryContext& context, const nlohmann::json& json) {
-        // Instantiate the Python class
-        py::object object = pyClass(entity);
+	std::shared_ptr<PyComponentSystem> system = sim::findSystem<PyComponentSystem>(*engineRoot.systemRegistry);
+	refl::TypeRegistry* typeRegistry = engineRoot.typeRegistry.get();
+
+	auto factory = std::make_shared<ComponentFactoryFunctionAdapter>([pyClass, system, typeRegistry](Entity* entity, const ComponentFactoryContext& context, const nlohmann::json& json) {
+		// Entities may be created while the GIL is released, e.g during stepSim
+		py::gil_scoped_acquire acquire;
+
+		// Instantiate the Python class
+		py::object object = pyClass(entity);
 
 		// Create the C++ component to wrap the python object
-        return std::make_shared<PyComponent>(object);
+		return std::make_shared<PyComponent>(object, *typeRegistry, system);
 	});
 
 	std::string componentClassName = py::str(pyClass.attr("__name__"));
@@ -309,6 +324,16 @@ PYBIND11_MODULE(skybolt, m) {
 			[](CameraComponent& c, const CameraState& state) { CameraState& s = c.getState(); s = state; },
 			py::return_value_policy::reference_internal);
 
+	py::class_<ParticleSystem, std::shared_ptr<ParticleSystem>>(m, "ParticleSystem")
+		.def("getParticleCount", [](const ParticleSystem& s) { return s.getParticles().size(); })
+		.def("getParticleArrays", [](const ParticleSystem& s) { return getParticleArrays(s.getParticles()); },
+			"Returns a dict of NumPy arrays, one per particle attribute, containing a copy of the particle state")
+		.def("setParticleArrays", [](ParticleSystem& s, const py::dict& arrays) { setParticleArrays(s.getParticles(), arrays); },
+			"Sets particle attributes from a dict of NumPy arrays in the format returned by getParticleArrays(). Attributes missing from the dict are unchanged.");
+
+	py::class_<ParticleSystemComponent, std::shared_ptr<ParticleSystemComponent>, Component>(m, "ParticleSystemComponent")
+		.def_property_readonly("particleSystem", &ParticleSystemComponent::getParticleSystem);
+
 	py::class_<CameraControllerSelector, std::shared_ptr<CameraControllerSelector>>(m, "CameraControllerSelector")
 		.def("selectController", &CameraControllerSelector::selectController)
 		.def("getSelectedControllerName", &CameraControllerSelector::getSelectedControllerName)
@@ -350,6 +375,23 @@ PYBIND11_MODULE(skybolt, m) {
 		.def("removeAllEntities", &World::removeAllEntities)
 		.def("findObjectByName", &World::findObjectByName);
 
+	py::class_<EntitySpatialIndex>(m, "EntitySpatialIndex", "Spatial index of entity geocentric positions, updated once per simulation step")
+		.def("findEntitiesInRadius", [](const EntitySpatialIndex& index, const Vector3& center, double radius) {
+			std::vector<EntityPtr> result;
+			index.findEntitiesInRadius(center, radius, result);
+			return result;
+		})
+		.def("findEntitiesInBox", [](const EntitySpatialIndex& index, const Box3d& box) {
+			std::vector<EntityPtr> result;
+			index.findEntitiesInBox(box, result);
+			return result;
+		})
+		.def("findEntitiesInFrustum", [](const EntitySpatialIndex& index, const Frustum& frustum) {
+			std::vector<EntityPtr> result;
+			index.findEntitiesInFrustum(frustum, result);
+			return result;
+		});
+
 	py::class_<EntityFactory>(m, "EntityFactory", "Class responsible for creating `Entity` instances based on a template name")
 		.def("createEntity", &EntityFactory::createEntity, py::return_value_policy::reference,
 			py::arg("templateName"), py::arg("name") = "", py::arg("position") = math::dvec3Zero(), py::arg("orientation") = math::dquatIdentity(), py::arg("id") = sim::nullEntityId());
@@ -363,6 +405,7 @@ PYBIND11_MODULE(skybolt, m) {
 		.def_property_readonly("world", [](const EngineRoot& r) {return &r.scenario->world; }, py::return_value_policy::reference_internal)
 		.def_property_readonly("entityFactory", [](const EngineRoot& r) {return r.entityFactory.get(); }, py::return_value_policy::reference_internal)
 		.def_property_readonly("scenario", [](const EngineRoot& r) {return r.scenario.get(); }, py::return_value_policy::reference_internal)
+		.def_property_readonly("spatialIndex", [](const EngineRoot& r) {return &findRequiredSystem<EntitySpatialIndexSystem>(*r.systemRegistry)->getIndex(); }, py::return_value_policy::reference_internal)
 		.def("locateFile", [](const EngineRoot& r, const std::string& filename) { return value(r.fileLocator(filename)).value_or("").string(); });
 
 	py::class_<vis::Window, std::shared_ptr<vis::Window>>(m, "Window");
@@ -389,8 +432,10 @@ PYBIND11_MODULE(skybolt, m) {
 	m.def("createEngineRootWithDefaults", &createEngineRootWithDefaults, "Create an EngineRoot with default values");
 	m.def("attachCameraToWindowWithEngine", &attachCameraToWindowWithEngine);
 	m.def("registerComponent", &registerComponent);
-	m.def("stepSim", &stepSim);
-	m.def("render", &render, py::arg("engineRoot"), py::arg("window"));
+	// Release the GIL while stepping and rendering so that other Python threads can run.
+	// Python components are called back in batches which reacquire the GIL.
+	m.def("stepSim", &stepSim, py::call_guard<py::gil_scoped_release>());
+	m.def("render", &render, py::arg("engineRoot"), py::arg("window"), py::call_guard<py::gil_scoped_release>());
 	m.def("toGeocentricPosition", [](const PositionPtr& position) { return std::make_shared<GeocentricPosition>(toGeocentric(*position)); });
 	m.def("toGeocentricOrientation", [](const OrientationPtr& orientation, const LatLon& latLon) { return std::make_shared<GeocentricOrientation>(toGeocentric(*orientation, latLon)); });
 	m.def("toLatLonAlt", [](const PositionPtr& position) { return std::make_shared<LatLonAltPosition>(toLatLonAlt(*position)); });
@@ -406,4 +451,24 @@ PYBIND11_MODULE(skybolt, m) {
 	m.def("transformToScreenSpace", &transformToScreenSpace);
 	m.def("setWaveHeight", &setWaveHeight);
 	m.def("calcSmallestAngleFromTo", &math::calcSmallestAngleFromTo<double>);
+
+	// Bulk access to the state of many entities in a single call, using NumPy arrays with one row per entity
+	m.def("getPositions", [](const std::vector<EntityPtr>& entities) {
+		return getEntityStates<3>(entities, [](const Entity& e) { return getPosition(e); });
+	}, "Returns an (N, 3) array of entity geocentric positions. Rows are NaN for entities without a position.");
+	m.def("setPositions", [](const std::vector<EntityPtr>& entities, const py::array_t<double, py::array::c_style | py::array::forcecast>& positions) {
+		setEntityStates<Vector3, 3>(entities, positions, [](Entity& e, const Vector3& v) { setPosition(e, v); });
+	}, "Sets entity geocentric positions from an (N, 3) array");
+	m.def("getOrientations", [](const std::vector<EntityPtr>& entities) {
+		return getEntityStates<4>(entities, [](const Entity& e) { return getOrientation(e); });
+	}, "Returns an (N, 4) array of entity geocentric orientation quaternions as [x, y, z, w]. Rows are NaN for entities without an orientation.");
+	m.def("setOrientations", [](const std::vector<EntityPtr>& entities, const py::array_t<double, py::array::c_style | py::array::forcecast>& orientations) {
+		setEntityStates<Quaternion, 4>(entities, orientations, [](Entity& e, const Quaternion& q) { setOrientation(e, q); });
+	}, "Sets entity geocentric orientations from an (N, 4) array of quaternions as [x, y, z, w]");
+	m.def("getVelocities", [](const std::vector<EntityPtr>& entities) {
+		return getEntityStates<3>(entities, [](const Entity& e) { return getVelocity(e); });
+	}, "Returns an (N, 3) array of entity linear velocities. Rows are NaN for entities without a velocity.");
+	m.def("setVelocities", [](const std::vector<EntityPtr>& entities, const py::array_t<double, py::array::c_style | py::array::forcecast>& velocities) {
+		setEntityStates<Vector3, 3>(entities, velocities, [](Entity& e, const Vector3& v) { setVelocity(e, v); });
+	}, "Sets entity linear velocities from an (N, 3) array");
 }
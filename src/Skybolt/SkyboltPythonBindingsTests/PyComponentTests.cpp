@@ -0,0 +1,215 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include "PythonTestInterpreter.h"
+#include <SkyboltPythonBindings/PyComponent.h>
+#include <SkyboltPythonBindings/PyComponentSystem.h>
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/System/EntitySystem.h>
+#include <SkyboltSim/System/SimStepper.h>
+
+namespace py = pybind11;
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+//! @returns the namespace defining Python component classes used by the tests
+static py::dict getTestScope()
+{
+	initPythonInterpreter();
+	static py::dict scope = [] {
+		py::dict d;
+		py::exec(R"(
+class Properties:
+	pass
+
+class TimedComponent:
+	def __init__(self):
+		self.properties = Properties()
+		self.properties.speed = 1.0
+		self.set_time_count = 0
+		self.time = 0.0
+		self.elapsed = 0.0
+
+	def set_sim_time(self, new_time):
+		self.set_time_count += 1
+		self.time = new_time
+
+	def advance_sim_time(self, new_time, dt):
+		self.time = new_time
+		self.elapsed += dt
+
+class PassiveComponent:
+	def __init__(self):
+		self.properties = Properties()
+)", d);
+		return d;
+	}();
+	return scope;
+}
+
+static std::shared_ptr<PyComponent> createComponent(const char* className, refl::TypeRegistry& typeRegistry, const std::shared_ptr<PyComponentSystem>& system)
+{
+	py::object object = getTestScope()[className]();
+	return std::make_shared<PyComponent>(object, typeRegistry, system);
+}
+
+TEST_CASE("PyComponent calls Python hooks immediately without a PyComponentSystem")
+{
+	refl::TypeRegistry typeRegistry;
+	py::object object = getTestScope()["TimedComponent"]();
+	PyComponent component(object, typeRegistry);
+
+	component.setSimTime(5.0);
+	CHECK(object.attr("time").cast<double>() == 5.0);
+
+	component.advanceSimTime(6.0, 1.0);
+	CHECK(object.attr("time").cast<double>() == 6.0);
+	CHECK(object.attr("elapsed").cast<double>() == 1.0);
+}
+
+TEST_CASE("PyComponentSystem calls Python hooks of queued components in a batch")
+{
+	refl::TypeRegistry typeRegistry;
+	auto system = std::make_shared<PyComponentSystem>();
+
+	std::vector<py::object> objects;
+	std::vector<std::shared_ptr<PyComponent>> components;
+	for (int i = 0; i < 3; ++i)
+	{
+		objects.push_back(getTestScope()["TimedComponent"]());
+		components.push_back(std::make_shared<PyComponent>(objects.back(), typeRegistry, system));
+	}
+
+	// Components without hooks are not queued
+	auto passive = createComponent("PassiveComponent", typeRegistry, system);
+	passive->advanceSimTime(1.0, 1.0);
+
+	for (const auto& component : components)
+	{
+		component->setSimTime(2.0);
+	}
+	CHECK(objects[0].attr("set_time_count").cast<int>() == 0);
+
+	system->setSimTime(2.0);
+	for (const py::object& object : objects)
+	{
+		CHECK(object.attr("set_time_count").cast<int>() == 1);
+		CHECK(object.attr("time").cast<double>() == 2.0);
+	}
+
+	for (const auto& component : components)
+	{
+		component->advanceSimTime(3.0, 1.0);
+	}
+
+	SECTION("Calls to destroyed components are discarded")
+	{
+		components[1].reset();
+		system->advanceSimTime(3.0, 1.0);
+		CHECK(objects[0].attr("elapsed").cast<double>() == 1.0);
+		CHECK(objects[1].attr("elapsed").cast<double>() == 0.0);
+		CHECK(objects[2].attr("elapsed").cast<double>() == 1.0);
+	}
+}
+
+TEST_CASE("Queued PyComponent calls are made with GIL released by caller")
+{
+	refl::TypeRegistry typeRegistry;
+	auto system = std::make_shared<PyComponentSystem>();
+	py::object object = getTestScope()["TimedComponent"]();
+	auto component = std::make_shared<PyComponent>(object, typeRegistry, system);
+
+	{
+		py::gil_scoped_release release;
+		component->advanceSimTime(1.0, 0.5);
+		system->advanceSimTime(1.0, 0.5);
+	}
+	CHECK(object.attr("elapsed").cast<double>() == 0.5);
+}
+
+//! Records the time of a Python component when advanced
+class PythonTimeRecordingSystem : public System
+{
+public:
+	PythonTimeRecordingSystem(py::object object) : mObject(std::move(object)) {}
+
+	void advanceSimTime(SecondsD newTime, SecondsD dt) override
+	{
+		recordedTime = mObject.attr("time").cast<double>();
+	}
+
+	double recordedTime = 0;
+
+private:
+	py::object mObject;
+};
+
+TEST_CASE("PyComponentSystem calls Python hooks before systems which follow the EntitySystem")
+{
+	refl::TypeRegistry typeRegistry;
+	World world;
+	py::object object = getTestScope()["TimedComponent"]();
+	auto recordingSystem = std::make_shared<PythonTimeRecordingSystem>(object);
+
+	auto registry = std::make_shared<SystemRegistry>(SystemRegistry({
+		std::make_shared<EntitySystem>(&world),
+		recordingSystem
+	}));
+	std::shared_ptr<PyComponentSystem> system = addPyComponentSystem(*registry);
+	REQUIRE(registry->size() == 3);
+	CHECK((*registry)[1] == system);
+	CHECK(addPyComponentSystem(*registry) == system);
+
+	auto entity = std::make_shared<Entity>(EntityId({1, 1}));
+	entity->addComponent(std::make_shared<PyComponent>(object, typeRegistry, system));
+	world.addEntity(entity);
+
+	SimStepper stepper(registry);
+	stepper.setDynamicsStepSize(0.5);
+	stepper.update(0.5);
+
+	CHECK(object.attr("time").cast<double>() == 0.5);
+	CHECK(recordingSystem->recordedTime == 0.5);
+}
+
+TEST_CASE("Benchmark PyComponent time updates with 1000 components", "[.benchmark]")
+{
+	constexpr int componentCount = 1000;
+	refl::TypeRegistry typeRegistry;
+	auto system = std::make_shared<PyComponentSystem>();
+
+	std::vector<std::shared_ptr<PyComponent>> immediateComponents;
+	std::vector<std::shared_ptr<PyComponent>> batchedComponents;
+	for (int i = 0; i < componentCount; ++i)
+	{
+		immediateComponents.push_back(createComponent("TimedComponent", typeRegistry, nullptr));
+		batchedComponents.push_back(createComponent("TimedComponent", typeRegistry, system));
+	}
+
+	// Measure with the GIL released, as it is during stepSim
+	py::gil_scoped_release release;
+
+	BENCHMARK("Immediate")
+	{
+		for (const auto& component : immediateComponents)
+		{
+			component->advanceSimTime(1.0, 1.0 / 60.0);
+		}
+	};
+
+	BENCHMARK("Batched")
+	{
+		for (const auto& component : batchedComponents)
+		{
+			component->advanceSimTime(1.0, 1.0 / 60.0);
+		}
+		system->advanceSimTime(1.0, 1.0 / 60.0);
+	};
+}
@@ -0,0 +1,209 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include "PythonTestInterpreter.h"
+#include <SkyboltPythonBindings/PyStateArrays.h>
+#include <SkyboltSim/Components/Node.h>
+
+#include <cmath>
+
+namespace py = pybind11;
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+static EntityPtr createEntity(int id, const std::optional<Vector3>& position)
+{
+	auto entity = std::make_shared<Entity>(EntityId({1, id}));
+	if (position)
+	{
+		entity->addComponent(std::make_shared<Node>(*position));
+	}
+	return entity;
+}
+
+using StateArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+static auto getEntityPosition = [](const Entity& e) { return getPosition(e); };
+static auto setEntityPosition = [](Entity& e, const Vector3& v) { setPosition(e, v); };
+
+TEST_CASE("getEntityStates copies entity state into rows of an array")
+{
+	initPythonInterpreter();
+	std::vector<EntityPtr> entities = {
+		createEntity(1, Vector3(1, 2, 3)),
+		createEntity(2, std::nullopt),
+		createEntity(3, Vector3(4, 5, 6))
+	};
+
+	py::array_t<double> states = getEntityStates<3>(entities, getEntityPosition);
+	REQUIRE(states.ndim() == 2);
+	REQUIRE(states.shape(0) == 3);
+	REQUIRE(states.shape(1) == 3);
+
+	auto r = states.unchecked<2>();
+	CHECK(r(0, 0) == 1);
+	CHECK(r(0, 1) == 2);
+	CHECK(r(0, 2) == 3);
+	CHECK(r(2, 0) == 4);
+	CHECK(r(2, 2) == 6);
+
+	// Entities without the state have NaN rows
+	for (int c = 0; c < 3; ++c)
+	{
+		CHECK(std::isnan(r(1, c)));
+	}
+}
+
+TEST_CASE("getEntityStates returns an empty array for no entities")
+{
+	initPythonInterpreter();
+	py::array_t<double> states = getEntityStates<3>({}, getEntityPosition);
+	CHECK(states.shape(0) == 0);
+	CHECK(states.shape(1) == 3);
+}
+
+TEST_CASE("setEntityStates sets entity state from rows of an array")
+{
+	initPythonInterpreter();
+	std::vector<EntityPtr> entities = {
+		createEntity(1, Vector3(0, 0, 0)),
+		createEntity(2, Vector3(0, 0, 0))
+	};
+
+	StateArray values({py::ssize_t(2), py::ssize_t(3)});
+	auto w = values.mutable_unchecked<2>();
+	for (py::ssize_t i = 0; i < 2; ++i)
+	{
+		for (py::ssize_t c = 0; c < 3; ++c)
+		{
+			w(i, c) = double(i * 10 + c);
+		}
+	}
+
+	setEntityStates<Vector3, 3>(entities, values, setEntityPosition);
+	CHECK(*getPosition(*entities[0]) == Vector3(0, 1, 2));
+	CHECK(*getPosition(*entities[1]) == Vector3(10, 11, 12));
+
+	SECTION("Arrays of the wrong shape are rejected")
+	{
+		StateArray wrongRowCount({py::ssize_t(3), py::ssize_t(3)});
+		CHECK_THROWS_AS((setEntityStates<Vector3, 3>(entities, wrongRowCount, setEntityPosition)), std::runtime_error);
+
+		StateArray wrongColumnCount({py::ssize_t(2), py::ssize_t(4)});
+		CHECK_THROWS_AS((setEntityStates<Vector3, 3>(entities, wrongColumnCount, setEntityPosition)), std::runtime_error);
+
+		// Entities are unchanged
+		CHECK(*getPosition(*entities[0]) == Vector3(0, 1, 2));
+	}
+}
+
+static Particle createParticle(int guid)
+{
+	Particle particle;
+	particle.guid = guid;
+	particle.position = Vector3(guid, guid + 1, guid + 2);
+	particle.velocity = Vector3(-guid, 0, 0);
+	particle.radius = 1.5f;
+	particle.age = 0.25f * guid;
+	particle.initialAlpha = 1.0f;
+	particle.alpha = 0.5f;
+	particle.temperatureDegreesCelcius = 20.0f;
+	return particle;
+}
+
+TEST_CASE("getParticleArrays returns copies which remain valid after particles change")
+{
+	initPythonInterpreter();
+	ParticleStore particles;
+	particles.push_back(createParticle(1));
+	particles.push_back(createParticle(2));
+
+	py::dict arrays = getParticleArrays(particles);
+	CHECK(arrays.size() == 12);
+
+	auto guid = arrays["guid"].cast<py::array_t<int>>();
+	auto positionY = arrays["positionY"].cast<py::array_t<double>>();
+	auto age = arrays["age"].cast<py::array_t<float>>();
+	REQUIRE(guid.size() == 2);
+	CHECK(guid.owndata());
+
+	// Reallocate and overwrite the particle storage
+	particles.clear();
+	for (int i = 0; i < 1000; ++i)
+	{
+		particles.push_back(createParticle(100 + i));
+	}
+
+	CHECK(guid.at(0) == 1);
+	CHECK(guid.at(1) == 2);
+	CHECK(positionY.at(1) == 3.0);
+	CHECK(age.at(1) == 0.5f);
+}
+
+TEST_CASE("setParticleArrays writes back arrays returned by getParticleArrays")
+{
+	initPythonInterpreter();
+	ParticleStore particles;
+	particles.push_back(createParticle(1));
+	particles.push_back(createParticle(2));
+
+	// Read, modify and write back a subset of the attributes
+	py::dict arrays = getParticleArrays(particles);
+	auto positionX = arrays["positionX"].cast<py::array_t<double>>();
+	auto alpha = arrays["alpha"].cast<py::array_t<float>>();
+	positionX.mutable_at(1) = 42.0;
+	alpha.mutable_at(0) = 0.125f;
+
+	py::dict modified;
+	modified["positionX"] = positionX;
+	modified["alpha"] = alpha;
+	setParticleArrays(particles, modified);
+
+	// Read again
+	py::dict result = getParticleArrays(particles);
+	CHECK(result["positionX"].cast<py::array_t<double>>().at(1) == 42.0);
+	CHECK(result["alpha"].cast<py::array_t<float>>().at(0) == 0.125f);
+
+	// Attributes which were not written are unchanged
+	CHECK(particles.positionX[0] == 1.0);
+	CHECK(particles.positionY[1] == 3.0);
+	CHECK(particles.alpha[1] == 0.5f);
+
+	SECTION("Writing back all attributes unchanged leaves the particles unchanged")
+	{
+		setParticleArrays(particles, result);
+		CHECK(particles.guid[1] == 2);
+		CHECK(particles.positionX[1] == 42.0);
+		CHECK(particles.age[1] == 0.5f);
+	}
+
+	SECTION("Arrays of other numeric types are converted")
+	{
+		py::dict values;
+		values["radius"] = py::array_t<double>(py::ssize_t(2), std::vector<double>({3.0, 4.0}).data());
+		setParticleArrays(particles, values);
+		CHECK(particles.radius[0] == 3.0f);
+		CHECK(particles.radius[1] == 4.0f);
+	}
+
+	SECTION("Invalid arrays are rejected without modifying the particles")
+	{
+		py::dict wrongCount;
+		wrongCount["alpha"] = alpha;
+		wrongCount["age"] = py::array_t<float>(py::ssize_t(3));
+		CHECK_THROWS_AS(setParticleArrays(particles, wrongCount), std::runtime_error);
+
+		py::dict unknownAttribute;
+		unknownAttribute["alpha"] = py::array_t<float>(py::ssize_t(2), std::vector<float>({0.0f, 0.0f}).data());
+		unknownAttribute["mass"] = py::array_t<float>(py::ssize_t(2));
+		CHECK_THROWS_AS(setParticleArrays(particles, unknownAttribute), std::runtime_error);
+
+		CHECK(particles.alpha[0] == 0.125f);
+		CHECK(particles.alpha[1] == 0.5f);
+	}
+}
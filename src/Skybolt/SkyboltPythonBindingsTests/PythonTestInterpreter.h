@@ -0,0 +1,15 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <pybind11/embed.h>
+
+//! Starts the embedded Python interpreter on first use. The interpreter lives until the tests exit.
+inline void initPythonInterpreter()
+{
+	static pybind11::scoped_interpreter interpreter;
+}
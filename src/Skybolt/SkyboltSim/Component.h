@@ -24,6 +24,11 @@ public:
 
 	//! @returns types this component will be registered as in the type system, used by TypedItemContainer
 	virtual std::vector<std::type_index> getExposedTypes() const { return { typeid(*this) }; }
+
+	//! @returns true if the component's update handlers for entity-local stages (PreDynamicsSubStep, DynamicsSubStep and PostDynamicsSubStep)
+	//! only access state owned by the component's own entity. Entities whose components are all thread safe may be updated
+	//! concurrently on worker threads during those stages. Defaults to false, meaning the entity is always updated on the main thread.
+	virtual bool isThreadSafe() const { return false; }
 };
 
 } // namespace sim
@@ -32,6 +32,8 @@ public:
 
 	const AssetDescription& getDescription() const {return *mDescription;}
 
+	bool isThreadSafe() const override { return true; }
+
 private:
 	std::shared_ptr<AssetDescription> mDescription;
 };
@@ -58,6 +58,8 @@ class ControlInputsComponent : public Component
 public:
 	std::map<std::string, ControlInputPtr> controls;
 
+	bool isThreadSafe() const override { return true; }
+
 	template <typename T>
 	inline std::shared_ptr<ControlInputT<T>> get(const std::string& name) const
 	{
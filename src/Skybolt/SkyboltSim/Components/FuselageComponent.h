@@ -63,6 +63,8 @@ public:
 	float getAngleOfAttack() const { return mAngleOfAttack; }
 	float getSideSlipAngle() const { return mSideSlipAngle; }
 
+	bool isThreadSafe() const override { return true; }
+
 public: // SimUpdatable interface
 	void advanceSimTime(SecondsD newTime, SecondsD dt) override;
 
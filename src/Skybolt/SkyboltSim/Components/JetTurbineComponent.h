@@ -26,6 +26,8 @@ public:
 
 	float getRpm() const {return mEngineRpm;}
 
+	bool isThreadSafe() const override { return true; }
+
 public: // SimUpdatable interface
 	void advanceSimTime(SecondsD newTime, SecondsD dt) override;
 
@@ -68,6 +68,8 @@ public:
 
 	float getTppPitchOffset() const { return mParams->tppPitchOffset; }
 
+	bool isThreadSafe() const override { return true; }
+
 public: // SimUpdatable interface
 	void advanceSimTime(SecondsD newTime, SecondsD dt) override;
 
@@ -17,6 +17,8 @@ class Motion : public Component
 public:
 	Vector3 linearVelocity = math::dvec3Zero();
 	Vector3 angularVelocity = math::dvec3Zero(); //!< angular velocity in world axes, not body axes
+
+	bool isThreadSafe() const override { return true; }
 };
 
 SKYBOLT_REFLECT_EXTERN(Motion)
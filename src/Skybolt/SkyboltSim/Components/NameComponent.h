@@ -24,6 +24,8 @@ public:
 
 	const std::string& getName() const {return mName;}
 
+	bool isThreadSafe() const override { return true; }
+
 private:
 	std::string mName;
 };
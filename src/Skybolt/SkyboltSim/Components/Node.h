@@ -28,6 +28,8 @@ public:
 	Vector3 getPosition() const override {return mPosition;}
 	Quaternion getOrientation() const override {return mOrientation;}
 
+	bool isThreadSafe() const override { return true; }
+
 private:
 	Vector3 mPosition;
 	Quaternion mOrientation;
@@ -23,6 +23,10 @@ void ParticleSystemComponent::advanceSimTime(SecondsD newTime, SecondsD dt)
 
 void ParticleSystemComponent::updateState()
 {
+	if (mSimTimeDt <= 0)
+	{
+		return;
+	}
 	mParticleSystem->update(mSimTimeDt);
 	mSimTimeDt = 0;
 }
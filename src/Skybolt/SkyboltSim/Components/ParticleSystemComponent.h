@@ -22,8 +22,13 @@ public:
 	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
 
 	void advanceSimTime(SecondsD newTime, SecondsD dt) override;
+
+	//! Advances the particle system by the sim time elapsed since the last update.
+	//! Does nothing if no sim time has elapsed, so may be called early by a system which updates particle systems in parallel.
 	void updateState();
 
+	bool isThreadSafe() const override { return true; }
+
 	const ParticleSystemPtr& getParticleSystem() const { return mParticleSystem; }
 
 private:
@@ -48,6 +48,8 @@ public:
 	const Vector3& getPositionRelBody() const {return mPositionRelBody;}
 	const Quaternion& getOrientationRelBody() const {return mOrientationRelBody;}
 
+	bool isThreadSafe() const override { return true; }
+
 public: // SimUpdatable interface
 	void advanceSimTime(SecondsD newTime, SecondsD dt) override;
 
@@ -32,6 +32,8 @@ class ReactionControlSystemComponent : public Component
 public:
 	ReactionControlSystemComponent(const ReactionControlSystemComponentConfig& config);
 
+	bool isThreadSafe() const override { return true; }
+
 	SKYBOLT_BEGIN_REGISTER_UPDATE_HANDLERS
 		SKYBOLT_REGISTER_UPDATE_HANDLER(UpdateStage::PreDynamicsSubStep, updatePreDynamicsSubstep)
 	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
@@ -23,6 +23,8 @@ class RocketMotorComponent : public Component
 public:
 	RocketMotorComponent(const RocketMotorComponentParams& params, Node* node, DynamicBodyComponent* body, const ControlInputFloatPtr& input);
 
+	bool isThreadSafe() const override { return true; }
+
 	SKYBOLT_BEGIN_REGISTER_UPDATE_HANDLERS
 		SKYBOLT_REGISTER_UPDATE_HANDLER(UpdateStage::PreDynamicsSubStep, updatePreDynamicsSubstep)
 	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
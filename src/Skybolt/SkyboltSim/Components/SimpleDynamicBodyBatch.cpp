@@ -0,0 +1,163 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "SimpleDynamicBodyBatch.h"
+#include "SimpleDynamicBodyComponent.h"
+#include "Motion.h"
+#include "Node.h"
+#include "SkyboltSim/World.h"
+#include <SkyboltCommon/ParallelFor.h>
+
+#include <assert.h>
+#include <cmath>
+
+namespace skybolt {
+namespace sim {
+
+//! Minimum number of bodies processed by each worker task
+constexpr std::size_t minBodiesPerTask = 256;
+
+void SimpleDynamicBodyBatch::clear()
+{
+	mBodies.clear();
+}
+
+void SimpleDynamicBodyBatch::addBody(SimpleDynamicBodyComponent* body)
+{
+	assert(body);
+	mBodies.push_back(body);
+}
+
+void SimpleDynamicBodyBatch::resizeBuffers()
+{
+	std::size_t count = mBodies.size();
+	for (auto* buffer : {&mPositionX, &mPositionY, &mPositionZ, &mVelocityX, &mVelocityY, &mVelocityZ, &mForceX, &mForceY, &mForceZ, &mMass, &mDt})
+	{
+		buffer->resize(count);
+	}
+}
+
+void SimpleDynamicBodyBatch::applyGravity(px_sched::Scheduler* scheduler)
+{
+	resizeBuffers();
+	parallelFor(scheduler, mBodies.size(), minBodiesPerTask, [this] (std::size_t begin, std::size_t end) {
+		applyGravity(begin, end);
+	});
+}
+
+void SimpleDynamicBodyBatch::integrate(px_sched::Scheduler* scheduler)
+{
+	resizeBuffers();
+	parallelFor(scheduler, mBodies.size(), minBodiesPerTask, [this] (std::size_t begin, std::size_t end) {
+		integrate(begin, end);
+	});
+}
+
+void SimpleDynamicBodyBatch::applyGravity(std::size_t begin, std::size_t end)
+{
+	// Gather
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		const SimpleDynamicBodyComponent& body = *mBodies[i];
+		Vector3 position = body.mNode->getPosition();
+		mPositionX[i] = position.x;
+		mPositionY[i] = position.y;
+		mPositionZ[i] = position.z;
+		mMass[i] = body.mMass;
+	}
+
+	// Calculate gravity towards world origin. Operations are performed in the same order as World::calcGravity()
+	// so that results are identical.
+	double* px = mPositionX.data();
+	double* py = mPositionY.data();
+	double* pz = mPositionZ.data();
+	double* fx = mForceX.data();
+	double* fy = mForceY.data();
+	double* fz = mForceZ.data();
+	const double* mass = mMass.data();
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		double magnitude = mass[i] * -World::gravitationalAcceleration;
+		double r = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+		bool valid = r > 1e-8;
+		fx[i] = valid ? px[i] / r * magnitude : 0.0;
+		fy[i] = valid ? py[i] / r * magnitude : 0.0;
+		fz[i] = valid ? pz[i] / r * magnitude : 0.0;
+	}
+
+	// Scatter
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		mBodies[i]->applyCentralForce(Vector3(fx[i], fy[i], fz[i]));
+	}
+}
+
+void SimpleDynamicBodyBatch::integrate(std::size_t begin, std::size_t end)
+{
+	// Gather
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		const SimpleDynamicBodyComponent& body = *mBodies[i];
+		Vector3 position = body.mNode->getPosition();
+		mPositionX[i] = position.x;
+		mPositionY[i] = position.y;
+		mPositionZ[i] = position.z;
+
+		const Vector3& velocity = body.mMotion->linearVelocity;
+		mVelocityX[i] = velocity.x;
+		mVelocityY[i] = velocity.y;
+		mVelocityZ[i] = velocity.z;
+
+		mForceX[i] = body.mTotalForce.x;
+		mForceY[i] = body.mTotalForce.y;
+		mForceZ[i] = body.mTotalForce.z;
+
+		mMass[i] = body.mMass;
+		mDt[i] = body.mElapsedDt;
+	}
+
+	// Integrate using velocity-verlet. Operations are performed in the same order as
+	// SimpleDynamicBodyComponent::integrateTimeStep() so that results are identical.
+	double* px = mPositionX.data();
+	double* py = mPositionY.data();
+	double* pz = mPositionZ.data();
+	double* vx = mVelocityX.data();
+	double* vy = mVelocityY.data();
+	double* vz = mVelocityZ.data();
+	const double* fx = mForceX.data();
+	const double* fy = mForceY.data();
+	const double* fz = mForceZ.data();
+	const double* mass = mMass.data();
+	const double* dt = mDt.data();
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		double halfDt2 = dt[i] * dt[i] * 0.5;
+		double ax = fx[i] / mass[i];
+		double ay = fy[i] / mass[i];
+		double az = fz[i] / mass[i];
+		px[i] = px[i] + vx[i] * dt[i] + ax * halfDt2;
+		py[i] = py[i] + vy[i] * dt[i] + ay * halfDt2;
+		pz[i] = pz[i] + vz[i] * dt[i] + az * halfDt2;
+		vx[i] += ax * dt[i];
+		vy[i] += ay * dt[i];
+		vz[i] += az * dt[i];
+	}
+
+	// Scatter. Bodies without positive mass are skipped, as they are in SimpleDynamicBodyComponent::integrateTimeStep().
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		SimpleDynamicBodyComponent& body = *mBodies[i];
+		if (mass[i] > 0)
+		{
+			body.mNode->setPosition(Vector3(px[i], py[i], pz[i]));
+			body.mMotion->linearVelocity = Vector3(vx[i], vy[i], vz[i]);
+		}
+		body.mLinearDynamicsIntegrated = true;
+	}
+}
+
+} // namespace sim
+} // namespace skybolt
@@ -0,0 +1,60 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltSim/SkyboltSimFwd.h"
+#include <vector>
+
+namespace px_sched {
+class Scheduler;
+} // namespace px_sched
+
+namespace skybolt {
+namespace sim {
+
+class SimpleDynamicBodyComponent;
+
+/*! Applies gravity and integrates linear dynamics for many SimpleDynamicBodyComponents at once.
+	Body state is gathered into structure-of-arrays buffers, processed in tight loops, and scattered back to the bodies.
+	Results are identical to those produced by World::calcGravity() and SimpleDynamicBodyComponent::integrateTimeStep().
+*/
+class SimpleDynamicBodyBatch
+{
+public:
+	void clear();
+	void addBody(SimpleDynamicBodyComponent* body);
+	std::size_t getBodyCount() const { return mBodies.size(); }
+
+	//! Applies gravitational force to all bodies. Should be called in UpdateStage::PreDynamicsSubStep
+	//! before any other forces are applied, to match the order in which EntitySystem applies gravity.
+	//! @param scheduler is optional. If provided, the work is split across the scheduler's worker threads.
+	void applyGravity(px_sched::Scheduler* scheduler = nullptr);
+
+	//! Integrates linear dynamics of all bodies over their elapsed substep time.
+	//! Should be called in UpdateStage::DynamicsSubStep before the bodies are updated.
+	//! The bodies will then only integrate their angular dynamics when updated.
+	//! @param scheduler is optional. If provided, the work is split across the scheduler's worker threads.
+	void integrate(px_sched::Scheduler* scheduler = nullptr);
+
+private:
+	void resizeBuffers();
+	void applyGravity(std::size_t begin, std::size_t end);
+	void integrate(std::size_t begin, std::size_t end);
+
+private:
+	std::vector<SimpleDynamicBodyComponent*> mBodies;
+
+	// Structure-of-arrays buffers, parallel to mBodies
+	std::vector<double> mPositionX, mPositionY, mPositionZ;
+	std::vector<double> mVelocityX, mVelocityY, mVelocityZ;
+	std::vector<double> mForceX, mForceY, mForceZ;
+	std::vector<double> mMass;
+	std::vector<double> mDt;
+};
+
+} // namespace sim
+} // namespace skybolt
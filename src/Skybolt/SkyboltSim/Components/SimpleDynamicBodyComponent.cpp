@@ -73,7 +73,12 @@ void SimpleDynamicBodyComponent::integrateTimeStep()
 	double halfDt2 = dt * dt * 0.5;
 
 	// Integrate linear dynamics using velocity-verlet https://en.wikipedia.org/wiki/Verlet_integration
-	if (mMass > 0)
+	// Note: SimpleDynamicBodyBatch::integrate() performs the same calculation and must be kept consistent with this one.
+	if (mLinearDynamicsIntegrated)
+	{
+		mLinearDynamicsIntegrated = false;
+	}
+	else if (mMass > 0)
 	{
 		Vector3 acceleration = mTotalForce / (double)mMass;
 		mNode->setPosition(mNode->getPosition() + mMotion->linearVelocity * dt + acceleration * halfDt2);
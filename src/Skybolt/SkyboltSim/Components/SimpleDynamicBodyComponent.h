@@ -32,6 +32,8 @@ public:
 
 	virtual void setCollisionsEnabled(bool enabled) override {}
 
+	bool isThreadSafe() const override { return true; }
+
 	std::vector<std::type_index> getExposedTypes() const override
 	{
 		return {typeid(DynamicBodyComponent), typeid(SimpleDynamicBodyComponent)};
@@ -59,6 +61,11 @@ private:
 	Vector3 mTotalTorque = math::dvec3Zero(); //!< World space
 
 	std::vector<AppliedForce> mCurrentForces; //!< For visualization purposes. Used to populate mForcesAppliedInLastSubstep in base class.
+
+	//! True if linear dynamics have already been integrated for the current substep by SimpleDynamicBodyBatch
+	bool mLinearDynamicsIntegrated = false;
+
+	friend class SimpleDynamicBodyBatch;
 };
 
 SKYBOLT_REFLECT_EXTERN(SimpleDynamicBodyComponent);
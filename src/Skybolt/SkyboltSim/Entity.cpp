@@ -28,12 +28,20 @@ Entity::~Entity()
 void Entity::addComponent(const ComponentPtr& c)
 {
 	mComponents.addItem(c);
+	if (!c->isThreadSafe())
+	{
+		++mMainThreadOnlyComponentCount;
+	}
 	CALL_LISTENERS(onComponentAdded(this, c.get()));
 }
 
 void Entity::removeComponent(const ComponentPtr& c)
 {
 	CALL_LISTENERS(onComponentRemove(this, c.get()));
+	if (!c->isThreadSafe())
+	{
+		--mMainThreadOnlyComponentCount;
+	}
 	mComponents.removeItem(c);
 }
 
@@ -40,6 +40,10 @@ public:
 	void addComponent(const ComponentPtr& c);
 	void removeComponent(const ComponentPtr& c);
 
+	//! @returns true if all components are thread safe, allowing the entity to be updated
+	//! on a worker thread during entity-local update stages. @see Component::isThreadSafe()
+	bool isThreadSafe() const { return mMainThreadOnlyComponentCount == 0; }
+
 	template <class DerivedT>
 	std::vector<std::shared_ptr<DerivedT>> getComponentsOfType() const
 	{
@@ -80,6 +84,7 @@ private:
 	const EntityId mId; //!< Globally unique ID of entity
 	TypedItemContainer<Component> mComponents;
 	bool mDynamicsEnabled = true;
+	int mMainThreadOnlyComponentCount = 0;
 };
 
 std::optional<Vector3> getPosition(const Entity& entity);
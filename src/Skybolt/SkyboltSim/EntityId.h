@@ -7,6 +7,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <tuple>
 
 namespace skybolt {
@@ -42,4 +43,17 @@ inline bool operator != (const EntityId& a, const EntityId& b)
 constexpr EntityId nullEntityId() { return {}; }
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
+
+namespace std {
+
+template <>
+struct hash<skybolt::sim::EntityId>
+{
+	std::size_t operator()(const skybolt::sim::EntityId& id) const noexcept
+	{
+		return std::hash<std::uint64_t>()((std::uint64_t(id.applicationId) << 32) | std::uint64_t(id.entityId));
+	}
+};
+
+} // namespace std
\ No newline at end of file
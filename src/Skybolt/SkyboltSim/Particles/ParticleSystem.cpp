@@ -13,15 +13,125 @@
 #include <SkyboltCommon/Random.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 
+#include <algorithm>
+#include <atomic>
+
 namespace skybolt {
 namespace sim {
 
+static std::atomic<int> nextParticleId = 0;
+
+int allocateParticleIds(int count)
+{
+	return nextParticleId.fetch_add(count, std::memory_order_relaxed);
+}
+
+void ParticleStore::reserve(size_t count)
+{
+	guid.reserve(count);
+	positionX.reserve(count);
+	positionY.reserve(count);
+	positionZ.reserve(count);
+	velocityX.reserve(count);
+	velocityY.reserve(count);
+	velocityZ.reserve(count);
+	radius.reserve(count);
+	age.reserve(count);
+	initialAlpha.reserve(count);
+	alpha.reserve(count);
+	temperatureDegreesCelcius.reserve(count);
+}
+
+void ParticleStore::resize(size_t count)
+{
+	guid.resize(count);
+	positionX.resize(count);
+	positionY.resize(count);
+	positionZ.resize(count);
+	velocityX.resize(count);
+	velocityY.resize(count);
+	velocityZ.resize(count);
+	radius.resize(count);
+	age.resize(count);
+	initialAlpha.resize(count);
+	alpha.resize(count);
+	temperatureDegreesCelcius.resize(count);
+}
+
+void ParticleStore::push_back(const Particle& particle)
+{
+	resize(size() + 1);
+	set(size() - 1, particle);
+}
+
+void ParticleStore::set(size_t i, const Particle& particle)
+{
+	guid[i] = particle.guid;
+	positionX[i] = particle.position.x;
+	positionY[i] = particle.position.y;
+	positionZ[i] = particle.position.z;
+	velocityX[i] = particle.velocity.x;
+	velocityY[i] = particle.velocity.y;
+	velocityZ[i] = particle.velocity.z;
+	radius[i] = particle.radius;
+	age[i] = particle.age;
+	initialAlpha[i] = particle.initialAlpha;
+	alpha[i] = particle.alpha;
+	temperatureDegreesCelcius[i] = particle.temperatureDegreesCelcius;
+}
+
+Particle ParticleStore::get(size_t i) const
+{
+	Particle particle;
+	particle.guid = guid[i];
+	particle.position = getPosition(i);
+	particle.velocity = getVelocity(i);
+	particle.radius = radius[i];
+	particle.age = age[i];
+	particle.initialAlpha = initialAlpha[i];
+	particle.alpha = alpha[i];
+	particle.temperatureDegreesCelcius = temperatureDegreesCelcius[i];
+	return particle;
+}
+
+template <typename T>
+static void compactArray(std::vector<T>& values, const std::vector<std::uint8_t>& removed, size_t first)
+{
+	size_t count = values.size();
+	size_t w = first;
+	for (size_t i = first; i < count; ++i)
+	{
+		if (!removed[i])
+		{
+			values[w++] = values[i];
+		}
+	}
+	values.resize(w);
+}
+
+void ParticleStore::compactFrom(size_t first)
+{
+	// Compact each array separately so that each pass reads and writes contiguous memory
+	compactArray(guid, mRemoved, first);
+	compactArray(positionX, mRemoved, first);
+	compactArray(positionY, mRemoved, first);
+	compactArray(positionZ, mRemoved, first);
+	compactArray(velocityX, mRemoved, first);
+	compactArray(velocityY, mRemoved, first);
+	compactArray(velocityZ, mRemoved, first);
+	compactArray(radius, mRemoved, first);
+	compactArray(age, mRemoved, first);
+	compactArray(initialAlpha, mRemoved, first);
+	compactArray(alpha, mRemoved, first);
+	compactArray(temperatureDegreesCelcius, mRemoved, first);
+}
+
 ParticleEmitter::ParticleEmitter(const Params& params) : mParams(params)
 {
 	mOrientation = getOrientationFromDirection(mParams.upDirection);
 }
 
-void ParticleEmitter::update(float dt, std::vector<Particle>& particles)
+void ParticleEmitter::update(float dt, ParticleStore& particles)
 {
 	// Calculate emitter velocity
 	Vector3 position = mParams.positionable->getPosition();
@@ -33,41 +143,48 @@ void ParticleEmitter::update(float dt, std::vector<Particle>& particles)
 	// Create particles
 	mParticlesToEmit += mParams.emissionRate * mEmissionRateMultiplier * dt;
 	int particleCount = int(mParticlesToEmit);
-	if (particleCount > 0)
+	if (particleCount <= 0)
 	{
-		mParticlesToEmit -= particleCount;
-		float dtSubstep = dt / particleCount;
-		float timeOffset = 0;
-
-		for (int i = 0; i < particleCount; ++i)
-		{
-			particles.push_back(createParticle(emitterVelocity, timeOffset));
-			timeOffset += dtSubstep;
-		}
+		return;
 	}
-}
-
-int ParticleEmitter::mNextParticleId = 0;
+	mParticlesToEmit -= particleCount;
 
-Particle ParticleEmitter::createParticle(const Vector3& emitterVelocity, float timeOffset) const
-{
+	// Calculate state shared by all particles emitted this step
 	float density = getAtmosphericDensity();
 	float alpha = glm::mix(mParams.zeroAtmosphericDensityAlpha, mParams.earthSeaLevelAtmosphericDensityAlpha, density / 1.225);
+	float initialAlpha = alpha * mEmissionAlphaMultiplier;
+	Matrix3 orientation = glm::mat3_cast(mParams.positionable->getOrientation()) * mOrientation;
+	int firstId = allocateParticleIds(particleCount);
 
-	Vector3 velocityRelEmitter = calculateParticleVelocityRelEmitter();
-	Particle particle;
-	particle.guid = mNextParticleId++;
-	particle.position = mParams.positionable->getPosition() + velocityRelEmitter * double(timeOffset);
-	particle.velocity = emitterVelocity + velocityRelEmitter;
-	particle.age = 0;
-	particle.radius = mParams.radius;
-	particle.initialAlpha = alpha * mEmissionAlphaMultiplier;
-	particle.alpha = particle.initialAlpha;
-	particle.temperatureDegreesCelcius = mParams.temperatureDegreesCelcius;
-	return particle;
+	size_t first = particles.size();
+	particles.resize(first + particleCount);
+
+	double dtSubstep = double(dt) / particleCount;
+	for (int i = 0; i < particleCount; ++i)
+	{
+		size_t p = first + i;
+		double timeOffset = dtSubstep * i;
+		Vector3 velocityRelEmitter = calculateParticleVelocityRelEmitter(orientation);
+		Vector3 particlePosition = position + velocityRelEmitter * timeOffset;
+		Vector3 particleVelocity = emitterVelocity + velocityRelEmitter;
+
+		particles.guid[p] = firstId + i;
+		particles.positionX[p] = particlePosition.x;
+		particles.positionY[p] = particlePosition.y;
+		particles.positionZ[p] = particlePosition.z;
+		particles.velocityX[p] = particleVelocity.x;
+		particles.velocityY[p] = particleVelocity.y;
+		particles.velocityZ[p] = particleVelocity.z;
+	}
+
+	std::fill(particles.radius.begin() + first, particles.radius.end(), mParams.radius);
+	std::fill(particles.age.begin() + first, particles.age.end(), 0.0f);
+	std::fill(particles.initialAlpha.begin() + first, particles.initialAlpha.end(), initialAlpha);
+	std::fill(particles.alpha.begin() + first, particles.alpha.end(), initialAlpha);
+	std::fill(particles.temperatureDegreesCelcius.begin() + first, particles.temperatureDegreesCelcius.end(), mParams.temperatureDegreesCelcius);
 }
 
-Vector3 ParticleEmitter::calculateParticleVelocityRelEmitter() const
+Vector3 ParticleEmitter::calculateParticleVelocityRelEmitter(const Matrix3& orientation) const
 {
 	float azimuth = mParams.random->unitRand() * math::twoPiF();
 	float elevation = mParams.random->rangedRand(float(mParams.elevationAngle.first), float(mParams.elevationAngle.last));
@@ -81,7 +198,7 @@ Vector3 ParticleEmitter::calculateParticleVelocityRelEmitter() const
 		speed * glm::cos(azimuth) * cosElevation
 	);
 	
-	return mParams.positionable->getOrientation() * (mOrientation * velocity);
+	return orientation * velocity;
 }
 
 sim::Entity* ParticleEmitter::getNearestPlanet() const
@@ -117,21 +234,19 @@ float ParticleEmitter::getAtmosphericDensity() const
 	return planet ? float(sim::getAtmosphericDensity(*planet, position)) : 0.0f;
 }
 
-void ParticleKiller::update(float dt, std::vector<Particle>& particles)
+void ParticleKiller::update(float dt, ParticleStore& particles)
 {
-	for (size_t i = 0; i < particles.size();)
+	float* age = particles.age.data();
+	size_t count = particles.size();
+	for (size_t i = 0; i < count; ++i)
 	{
-		particles[i].age += dt;
-		if (particles[i].age > mLifetime)
-		{
-			std::swap(particles[i], particles[particles.size() - 1]);
-			particles.pop_back();
-		}
-		else
-		{
-			++i;
-		}
+		age[i] += dt;
 	}
+
+	// Particles are stored oldest first, so expired particles are usually a prefix of the store
+	particles.removeIf([age, lifetime = mLifetime] (size_t i) {
+		return age[i] > lifetime;
+	});
 }
 
 ParticleIntegrator::ParticleIntegrator(const Params& params) :
@@ -140,7 +255,29 @@ ParticleIntegrator::ParticleIntegrator(const Params& params) :
 	assert(mParams.nearestPlanetProvider);
 }
 
-void ParticleIntegrator::update(float dt, std::vector<Particle>& particles)
+//! Applies damping of velocity relative to the wind, and integrates position, for one axis
+static void integrateAxis(double* position, double* velocity, size_t count, double dt, const std::optional<double>& windVelocity, double velocityDamping)
+{
+	if (windVelocity)
+	{
+		double wind = *windVelocity;
+		for (size_t i = 0; i < count; ++i)
+		{
+			double v = wind + (velocity[i] - wind) * velocityDamping;
+			velocity[i] = v;
+			position[i] += v * dt;
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			position[i] += velocity[i] * dt;
+		}
+	}
+}
+
+void ParticleIntegrator::update(float dt, ParticleStore& particles)
 {
 	if (particles.empty())
 	{
@@ -154,13 +291,13 @@ void ParticleIntegrator::update(float dt, std::vector<Particle>& particles)
 	std::optional<sim::Vector3> windVelocity;
 	double velocityDamping = 0;
 	{
-		sim::Vector3 position = particles.front().position;
+		sim::Vector3 position = particles.getPosition(0);
 		sim::Entity* planet = mParams.nearestPlanetProvider(position);
 		if (planet)
 		{
 			glm::dmat4 planetTransform = getTransform(*planet).value_or(math::dmat4Identity());
 			glm::dmat4 invPlanetTransform = glm::inverse(planetTransform);
-			sim::Vector3 firstParticlePosition = particles.front().position;
+			sim::Vector3 firstParticlePosition = position;
 
 			sim::Vector3 particlePositionPlanetSpace = invPlanetTransform * glm::dvec4(firstParticlePosition, 1.0);
 			if (mPrevPlanetTransform)
@@ -177,22 +314,36 @@ void ParticleIntegrator::update(float dt, std::vector<Particle>& particles)
 		}
 	}
 
-	// Integrate particle state
-	for (auto& particle : particles)
+	// Integrate particle state.
+	// Each attribute array is processed with its own loop so that the loops vectorize.
+	size_t count = particles.size();
+	integrateAxis(particles.positionX.data(), particles.velocityX.data(), count, dtD, windVelocity ? std::optional<double>(windVelocity->x) : std::nullopt, velocityDamping);
+	integrateAxis(particles.positionY.data(), particles.velocityY.data(), count, dtD, windVelocity ? std::optional<double>(windVelocity->y) : std::nullopt, velocityDamping);
+	integrateAxis(particles.positionZ.data(), particles.velocityZ.data(), count, dtD, windVelocity ? std::optional<double>(windVelocity->z) : std::nullopt, velocityDamping);
+
+	float radiusGrowth = mParams.radiusLinearGrowthPerSecond * dt;
+	float* radius = particles.radius.data();
+	for (size_t i = 0; i < count; ++i)
 	{
-		if (windVelocity)
-		{
-			sim::Vector3 velocityRelWind = particle.velocity - *windVelocity;
-			particle.velocity = *windVelocity + velocityRelWind * velocityDamping;
-		}
+		radius[i] += radiusGrowth;
+	}
 
-		particle.position += particle.velocity * dtD;
-		particle.radius += mParams.radiusLinearGrowthPerSecond * dt;
-		particle.alpha = glm::mix(particle.initialAlpha, 0.0f, particle.age / mParams.lifetime);
+	float invLifetime = 1.0f / mParams.lifetime;
+	float* alpha = particles.alpha.data();
+	const float* initialAlpha = particles.initialAlpha.data();
+	const float* age = particles.age.data();
+	for (size_t i = 0; i < count; ++i)
+	{
+		alpha[i] = initialAlpha[i] * (1.0f - age[i] * invLifetime);
+	}
 
-		if (mParams.heatTransferCoefficent)
+	if (mParams.heatTransferCoefficent)
+	{
+		float temperatureDecay = std::exp(-dt * mParams.heatTransferCoefficent.value());
+		float* temperature = particles.temperatureDegreesCelcius.data();
+		for (size_t i = 0; i < count; ++i)
 		{
-			particle.temperatureDegreesCelcius *= std::exp(-dt * mParams.heatTransferCoefficent.value());
+			temperature[i] *= temperatureDecay;
 		}
 	}
 }
@@ -10,6 +10,7 @@
 #include "SkyboltSim/SkyboltSimFwd.h"
 #include <SkyboltCommon/Range.h>
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -33,11 +34,77 @@ struct Particle
 	float temperatureDegreesCelcius;
 };
 
+//! @returns the first of count consecutive particle IDs. IDs are shared by all particle systems.
+//! @ThreadSafe
+int allocateParticleIds(int count);
+
+//! Stores particles as a structure of arrays, with one array per particle attribute,
+//! so that operations can process each attribute with tight loops that the compiler can vectorize.
+//! Particles are stored in the order they were added. Removal preserves the order of the remaining particles.
+class ParticleStore
+{
+public:
+	std::vector<int> guid;
+	std::vector<double> positionX;
+	std::vector<double> positionY;
+	std::vector<double> positionZ;
+	std::vector<double> velocityX;
+	std::vector<double> velocityY;
+	std::vector<double> velocityZ;
+	std::vector<float> radius;
+	std::vector<float> age;
+	std::vector<float> initialAlpha;
+	std::vector<float> alpha;
+	std::vector<float> temperatureDegreesCelcius;
+
+	size_t size() const { return guid.size(); }
+	bool empty() const { return guid.empty(); }
+
+	void reserve(size_t count);
+	void resize(size_t count);
+	void clear() { resize(0); }
+
+	void push_back(const Particle& particle);
+	void set(size_t i, const Particle& particle);
+	Particle get(size_t i) const;
+
+	Vector3 getPosition(size_t i) const { return Vector3(positionX[i], positionY[i], positionZ[i]); }
+	Vector3 getVelocity(size_t i) const { return Vector3(velocityX[i], velocityY[i], velocityZ[i]); }
+
+	//! Removes particles for which shouldRemove(index) returns true
+	template <typename PredicateT>
+	void removeIf(const PredicateT& shouldRemove)
+	{
+		size_t count = size();
+		size_t first = 0;
+		while (first < count && !shouldRemove(first))
+		{
+			++first;
+		}
+		if (first == count)
+		{
+			return;
+		}
+
+		mRemoved.assign(count, 0);
+		for (size_t i = first; i < count; ++i)
+		{
+			mRemoved[i] = shouldRemove(i) ? 1 : 0;
+		}
+		compactFrom(first);
+	}
+
+private:
+	void compactFrom(size_t first);
+
+	std::vector<std::uint8_t> mRemoved; //!< Scratch buffer used by removeIf
+};
+
 class ParticleSystemOperation
 {
 public:
 	virtual ~ParticleSystemOperation() {}
-	virtual void update(float dt, std::vector<Particle>& particles) = 0;
+	virtual void update(float dt, ParticleStore& particles) = 0;
 };
 
 using NearestPlanetProvider = std::function<sim::Entity*(const sim::Vector3& position)>;
@@ -57,14 +124,14 @@ public:
 		float zeroAtmosphericDensityAlpha;
 		float earthSeaLevelAtmosphericDensityAlpha;
 
-		std::shared_ptr<Random> random;
+		std::shared_ptr<Random> random; //!< Must not be shared with other emitters if particle systems are updated concurrently
 		NearestPlanetProvider nearestPlanetProvider;
 	};
 
 	ParticleEmitter(const Params& params);
 	~ParticleEmitter() override = default;
 
-	void update(float dt, std::vector<Particle>& particles) override;
+	void update(float dt, ParticleStore& particles) override;
 
 	void setEmissionRateMultiplier(float emissionRateMultiplier)
 	{
@@ -76,13 +143,12 @@ public:
 		mEmissionAlphaMultiplier = emissionAlphaMultiplier;
 	}
 
-	virtual Particle createParticle(const Vector3& emitterVelocity, float timeOffset) const;
-
 private:
 	sim::Entity* getNearestPlanet() const;
 	float getAtmosphericDensity() const; // kg / m^3
 
-	Vector3 calculateParticleVelocityRelEmitter() const;
+	//! @param orientation is the orientation of the emitter's up direction in world space
+	Vector3 calculateParticleVelocityRelEmitter(const Matrix3& orientation) const;
 
 private:
 	const Params mParams;
@@ -91,7 +157,6 @@ private:
 	float mEmissionRateMultiplier = 1.0;
 	float mEmissionAlphaMultiplier = 1.0;
 	std::optional<Vector3> mPrevPosition;
-	static int mNextParticleId;
 };
 
 class ParticleKiller : public ParticleSystemOperation
@@ -100,7 +165,7 @@ public:
 	ParticleKiller(float lifetime) : mLifetime(lifetime) {}
 	~ParticleKiller() override = default;
 
-	void update(float dt, std::vector<Particle>& particles) override;
+	void update(float dt, ParticleStore& particles) override;
 
 private:
 	const float mLifetime;
@@ -119,13 +184,14 @@ public:
 	};
 
 	ParticleIntegrator(const Params& params);
-	void update(float dt, std::vector<Particle>& particles) override;
+	void update(float dt, ParticleStore& particles) override;
 
 private:
 	Params mParams;
 	std::optional<glm::dmat4> mPrevPlanetTransform;
 };
 
+//! Independent particle systems may be updated concurrently on different threads.
 class ParticleSystem
 {
 public:
@@ -135,7 +201,8 @@ public:
 
 	void update(float dt);
 
-	const std::vector<Particle>& getParticles() const { return mParticles; }
+	const ParticleStore& getParticles() const { return mParticles; }
+	ParticleStore& getParticles() { return mParticles; }
 
 	template <class T>
 	std::shared_ptr<T> getOperationOfType()
@@ -152,7 +219,7 @@ public:
 
 private:
 	Operations mOperations;
-	std::vector<Particle> mParticles;
+	ParticleStore mParticles;
 };
 
 } // namespace sim
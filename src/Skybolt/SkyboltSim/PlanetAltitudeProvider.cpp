@@ -0,0 +1,19 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "SkyboltSim/PlanetAltitudeProvider.h"
+#include "SkyboltSim/Spatial/Geocentric.h"
+
+namespace skybolt {
+namespace sim {
+
+void prefetchAltitudesAlongTrack(const PlanetAltitudeProvider& provider, const Vector3& position, const Vector3& velocity, double lookaheadSeconds)
+{
+	provider.prefetchAltitudes(geocentricToLatLon(position), geocentricToLatLon(position + velocity * lookaheadSeconds));
+}
+
+} // namespace sim
+} // namespace skybolt
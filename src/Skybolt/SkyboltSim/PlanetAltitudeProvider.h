@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <SkyboltSim/SimMath.h>
 #include <SkyboltSim/Spatial/LatLon.h>
+#include <cstddef>
 #include <optional>
 #include <tuple>
 
@@ -16,6 +18,8 @@ namespace sim {
 class PlanetAltitudeProvider
 {
 public:
+	virtual ~PlanetAltitudeProvider() = default;
+
 	struct AltitudeResult
 	{
 		double altitude; //!< Altitude above sea level, positive is up.
@@ -47,7 +51,26 @@ public:
 	};
 
 	virtual AltitudeResult getAltitude(const sim::LatLon& position) const = 0;
+
+	//! Gets the altitudes of multiple positions. Implementations may override this to be faster than calling getAltitude() for each position.
+	//! @param results must have space for count results
+	virtual void getAltitudes(const sim::LatLon* positions, AltitudeResult* results, std::size_t count) const
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			results[i] = getAltitude(positions[i]);
+		}
+	}
+
+	//! Hints that altitudes along the track from start to end will be requested soon,
+	//! allowing implementations with asynchronously loaded data to start loading it in advance.
+	//! Data nearest to start is loaded first.
+	virtual void prefetchAltitudes(const sim::LatLon& start, const sim::LatLon& end) const {}
 };
 
+//! Prefetches altitudes along the track that a body moving at constant velocity will follow over the lookahead time.
+//! @param position and velocity are in geocentric coordinates
+void prefetchAltitudesAlongTrack(const PlanetAltitudeProvider& provider, const Vector3& position, const Vector3& velocity, double lookaheadSeconds);
+
 } // namespace sim
 } // namespace skybolt
\ No newline at end of file
@@ -33,7 +33,9 @@ class Node;
 struct Orientation;
 struct Particle;
 class ParticleEmitter;
+class ParticleStore;
 class ParticleSystem;
+class ParticleSystemComponent;
 struct PlanetComponent;
 struct Position;
 class Positionable;
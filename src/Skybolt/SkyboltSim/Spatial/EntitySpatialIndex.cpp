@@ -0,0 +1,347 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "EntitySpatialIndex.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace skybolt {
+namespace sim {
+
+EntitySpatialIndex::EntitySpatialIndex(double cellSize) :
+	mCellSize(cellSize)
+{
+	assert(mCellSize > 0);
+	clear();
+}
+
+void EntitySpatialIndex::update(const EntityPtr& entity, const Vector3& position)
+{
+	assert(entity);
+	CellKey key = toCellKey(position);
+
+	if (auto i = mLocations.find(entity.get()); i != mLocations.end())
+	{
+		Location& location = i->second;
+		if (location.key == key)
+		{
+			mCells[key][location.itemIndex].position = position;
+			return;
+		}
+		removeFromCell(location);
+
+		Cell& cell = addToCell(key);
+		location = Location{key, cell.size()};
+		cell.push_back(Item{entity, position});
+	}
+	else
+	{
+		Cell& cell = addToCell(key);
+		mLocations[entity.get()] = Location{key, cell.size()};
+		cell.push_back(Item{entity, position});
+	}
+}
+
+void EntitySpatialIndex::remove(const Entity* entity)
+{
+	if (auto i = mLocations.find(entity); i != mLocations.end())
+	{
+		removeFromCell(i->second);
+		mLocations.erase(i);
+	}
+}
+
+void EntitySpatialIndex::clear()
+{
+	mCells.clear();
+	mLocations.clear();
+
+	// Set an empty range
+	constexpr std::int32_t maxValue = std::numeric_limits<std::int32_t>::max();
+	constexpr std::int32_t minValue = std::numeric_limits<std::int32_t>::lowest();
+	mOccupiedMinKey = CellKey{maxValue, maxValue, maxValue};
+	mOccupiedMaxKey = CellKey{minValue, minValue, minValue};
+}
+
+bool EntitySpatialIndex::contains(const Entity* entity) const
+{
+	return mLocations.find(entity) != mLocations.end();
+}
+
+EntitySpatialIndex::Cell& EntitySpatialIndex::addToCell(const CellKey& key)
+{
+	mOccupiedMinKey = CellKey{std::min(mOccupiedMinKey.x, key.x), std::min(mOccupiedMinKey.y, key.y), std::min(mOccupiedMinKey.z, key.z)};
+	mOccupiedMaxKey = CellKey{std::max(mOccupiedMaxKey.x, key.x), std::max(mOccupiedMaxKey.y, key.y), std::max(mOccupiedMaxKey.z, key.z)};
+	return mCells[key];
+}
+
+void EntitySpatialIndex::removeFromCell(const Location& location)
+{
+	auto cellIt = mCells.find(location.key);
+	assert(cellIt != mCells.end());
+	Cell& cell = cellIt->second;
+
+	// Swap with last item and pop
+	if (location.itemIndex != cell.size() - 1)
+	{
+		cell[location.itemIndex] = std::move(cell.back());
+		mLocations[cell[location.itemIndex].entity.get()].itemIndex = location.itemIndex;
+	}
+	cell.pop_back();
+
+	if (cell.empty())
+	{
+		mCells.erase(cellIt);
+	}
+}
+
+static std::int32_t toCellCoordinate(double value)
+{
+	// Clamp so that conversion is defined for distant and non-finite positions.
+	// The int32 limits are excluded so that loops over a range of cell coordinates cannot overflow.
+	constexpr double maxCoordinate = double(std::numeric_limits<std::int32_t>::max() - 1);
+	if (std::isnan(value))
+	{
+		return 0;
+	}
+	return std::int32_t(std::clamp(std::floor(value), -maxCoordinate, maxCoordinate));
+}
+
+EntitySpatialIndex::CellKey EntitySpatialIndex::toCellKey(const Vector3& position) const
+{
+	return CellKey{
+		toCellCoordinate(position.x / mCellSize),
+		toCellCoordinate(position.y / mCellSize),
+		toCellCoordinate(position.z / mCellSize)
+	};
+}
+
+Box3d EntitySpatialIndex::getCellBounds(const CellKey& key) const
+{
+	Vector3 minimum(double(key.x) * mCellSize, double(key.y) * mCellSize, double(key.z) * mCellSize);
+	return Box3d(minimum, minimum + Vector3(mCellSize));
+}
+
+template <typename VisitorT>
+void EntitySpatialIndex::visitCellsOverlappingBox(const Box3d& box, const VisitorT& visitor) const
+{
+	CellKey minKey = toCellKey(box.minimum);
+	CellKey maxKey = toCellKey(box.maximum);
+
+	// Calculate in double precision because the range may not fit in an int32
+	double rangeCellCount = (double(maxKey.x) - double(minKey.x) + 1) * (double(maxKey.y) - double(minKey.y) + 1) * (double(maxKey.z) - double(minKey.z) + 1);
+	if (rangeCellCount <= double(mCells.size()))
+	{
+		// Look up each cell in range
+		for (std::int32_t z = minKey.z; z <= maxKey.z; ++z)
+		{
+			for (std::int32_t y = minKey.y; y <= maxKey.y; ++y)
+			{
+				for (std::int32_t x = minKey.x; x <= maxKey.x; ++x)
+				{
+					if (auto i = mCells.find(CellKey{x, y, z}); i != mCells.end())
+					{
+						visitor(i->first, i->second);
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		// Query volume spans more cells than are occupied, so visit occupied cells instead
+		for (const auto& [key, cell] : mCells)
+		{
+			if (key.x >= minKey.x && key.x <= maxKey.x
+				&& key.y >= minKey.y && key.y <= maxKey.y
+				&& key.z >= minKey.z && key.z <= maxKey.z)
+			{
+				visitor(key, cell);
+			}
+		}
+	}
+}
+
+template <typename VisitorT>
+void EntitySpatialIndex::visitItemsInCellsOverlappingBox(const Box3d& box, const VisitorT& visitor) const
+{
+	visitCellsOverlappingBox(box, [&] (const CellKey& key, const Cell& cell) {
+		for (const Item& item : cell)
+		{
+			visitor(item);
+		}
+	});
+}
+
+void EntitySpatialIndex::findEntitiesInRadius(const Vector3& center, double radius, std::vector<EntityPtr>& result) const
+{
+	double radiusSquared = radius * radius;
+	visitItemsInCellsOverlappingBox(Box3d(center - Vector3(radius), center + Vector3(radius)), [&] (const Item& item) {
+		Vector3 d = item.position - center;
+		if (glm::dot(d, d) <= radiusSquared)
+		{
+			result.push_back(item.entity);
+		}
+	});
+}
+
+void EntitySpatialIndex::findEntitiesInBox(const Box3d& box, std::vector<EntityPtr>& result) const
+{
+	visitItemsInCellsOverlappingBox(box, [&] (const Item& item) {
+		const Vector3& p = item.position;
+		if (p.x >= box.minimum.x && p.x <= box.maximum.x
+			&& p.y >= box.minimum.y && p.y <= box.maximum.y
+			&& p.z >= box.minimum.z && p.z <= box.maximum.z)
+		{
+			result.push_back(item.entity);
+		}
+	});
+}
+
+//! Calculates the bounds of the intersection of a box and a cone formed by planes which pass through the cone's apex.
+//! The intersection is a convex polytope, and each of its vertices lies on a face of the box except for the apex.
+//! The bounds are therefore the bounds of the box faces clipped by the planes, and the apex if it is inside the box.
+//! @param planeNormals point outwards from the cone
+//! @returns empty if the box and cone do not intersect
+static std::optional<Box3d> calcBoundsOfConeInBox(const Vector3& apex, const std::array<Vector3, 4>& planeNormals, const Box3d& box)
+{
+	// A quad clipped by four planes has at most eight vertices
+	constexpr int maxVertexCount = 8;
+	using Polygon = std::array<Vector3, maxVertexCount>;
+
+	Box3d bounds;
+	bool empty = true;
+
+	if (apex.x >= box.minimum.x && apex.x <= box.maximum.x
+		&& apex.y >= box.minimum.y && apex.y <= box.maximum.y
+		&& apex.z >= box.minimum.z && apex.z <= box.maximum.z)
+	{
+		bounds.merge(apex);
+		empty = false;
+	}
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		int u = (axis + 1) % 3;
+		int v = (axis + 2) % 3;
+		for (double faceCoordinate : {box.minimum[axis], box.maximum[axis]})
+		{
+			Polygon polygon;
+			int vertexCount = 4;
+			for (int i = 0; i < vertexCount; ++i)
+			{
+				polygon[i][axis] = faceCoordinate;
+				polygon[i][u] = (i == 1 || i == 2) ? box.maximum[u] : box.minimum[u];
+				polygon[i][v] = (i >= 2) ? box.maximum[v] : box.minimum[v];
+			}
+
+			// Clip the face against each plane, keeping the inside
+			for (const Vector3& normal : planeNormals)
+			{
+				Polygon clipped;
+				int clippedVertexCount = 0;
+				for (int i = 0; i < vertexCount; ++i)
+				{
+					const Vector3& current = polygon[i];
+					const Vector3& next = polygon[(i + 1) % vertexCount];
+					double currentDistance = glm::dot(normal, current - apex);
+					double nextDistance = glm::dot(normal, next - apex);
+					if (currentDistance <= 0)
+					{
+						clipped[clippedVertexCount++] = current;
+					}
+					if ((currentDistance <= 0) != (nextDistance <= 0))
+					{
+						clipped[clippedVertexCount++] = current + (next - current) * (currentDistance / (currentDistance - nextDistance));
+					}
+				}
+				polygon = clipped;
+				vertexCount = clippedVertexCount;
+			}
+
+			for (int i = 0; i < vertexCount; ++i)
+			{
+				bounds.merge(polygon[i]);
+				empty = false;
+			}
+		}
+	}
+
+	if (empty)
+	{
+		return std::nullopt;
+	}
+	return bounds;
+}
+
+void EntitySpatialIndex::findEntitiesInFrustum(const Frustum& frustum, std::vector<EntityPtr>& result) const
+{
+	if (mCells.empty())
+	{
+		return;
+	}
+
+	// Calculate side planes of the frustum, which pass through the frustum origin.
+	// Frustum axes are x forward, y right and z down. Normals point outwards.
+	double tanHalfHorizontal = std::tan(frustum.fieldOfViewHorizontal * 0.5);
+	double tanHalfVertical = std::tan(frustum.fieldOfViewVertical * 0.5);
+	const std::array<Vector3, 4> planeNormals = {
+		frustum.orientation * glm::normalize(Vector3(-tanHalfHorizontal, 1, 0)),
+		frustum.orientation * glm::normalize(Vector3(-tanHalfHorizontal, -1, 0)),
+		frustum.orientation * glm::normalize(Vector3(-tanHalfVertical, 0, 1)),
+		frustum.orientation * glm::normalize(Vector3(-tanHalfVertical, 0, -1))
+	};
+
+	auto isSphereOutside = [&] (const Vector3& center, double radius) {
+		Vector3 p = center - frustum.origin;
+		for (const Vector3& normal : planeNormals)
+		{
+			if (glm::dot(normal, p) > radius)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	// The frustum has no far plane, so bound it by the occupied cells
+	Box3d occupiedBounds(getCellBounds(mOccupiedMinKey).minimum, getCellBounds(mOccupiedMaxKey).maximum);
+	std::optional<Box3d> bounds = calcBoundsOfConeInBox(frustum.origin, planeNormals, occupiedBounds);
+	if (!bounds)
+	{
+		return;
+	}
+
+	// Pad the bounds so that rounding cannot exclude cells containing positions which lie on the frustum boundary
+	Vector3 padding(mCellSize * 1e-6);
+	bounds->minimum -= padding;
+	bounds->maximum += padding;
+
+	const double cellBoundingRadius = mCellSize * std::sqrt(3.0) * 0.5;
+	visitCellsOverlappingBox(*bounds, [&] (const CellKey& key, const Cell& cell) {
+		if (isSphereOutside(getCellBounds(key).center(), cellBoundingRadius))
+		{
+			return;
+		}
+
+		for (const Item& item : cell)
+		{
+			if (!isSphereOutside(item.position, 0.0))
+			{
+				result.push_back(item.entity);
+			}
+		}
+	});
+}
+
+} // namespace sim
+} // namespace skybolt
@@ -0,0 +1,112 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltSim/SimMath.h"
+#include "SkyboltSim/SkyboltSimFwd.h"
+#include <SkyboltCommon/Math/Box3.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace skybolt {
+namespace sim {
+
+struct Frustum;
+
+/*! Spatial index of entity positions in geocentric (ECEF) coordinates.
+	Entities are stored in a sparse uniform grid of cubic cells, so updating an entity's position
+	only moves it between containers when it crosses a cell boundary.
+	Queries return entities whose last indexed position is within the query volume.
+	Cell coordinates are clamped to the int32 range, so positions beyond roughly 2^31 cell sizes from
+	the origin share the outermost cells.
+*/
+class EntitySpatialIndex
+{
+public:
+	//! @param cellSize is the edge length of grid cells in meters
+	explicit EntitySpatialIndex(double cellSize = 10000.0);
+
+	//! Inserts the entity, or updates its position if it is already indexed
+	void update(const EntityPtr& entity, const Vector3& position);
+	void remove(const Entity* entity);
+	void clear();
+
+	bool contains(const Entity* entity) const;
+	std::size_t size() const { return mLocations.size(); }
+
+	//! Appends entities within radius of center to result
+	void findEntitiesInRadius(const Vector3& center, double radius, std::vector<EntityPtr>& result) const;
+
+	//! Appends entities within the box to result
+	void findEntitiesInBox(const Box3d& box, std::vector<EntityPtr>& result) const;
+
+	//! Appends entities within the frustum to result.
+	//! Only cells overlapping the part of the frustum within the occupied cells are visited.
+	void findEntitiesInFrustum(const Frustum& frustum, std::vector<EntityPtr>& result) const;
+
+private:
+	struct CellKey
+	{
+		std::int32_t x;
+		std::int32_t y;
+		std::int32_t z;
+
+		bool operator == (const CellKey& other) const { return x == other.x && y == other.y && z == other.z; }
+		bool operator != (const CellKey& other) const { return !(*this == other); }
+	};
+
+	struct CellKeyHash
+	{
+		std::size_t operator()(const CellKey& key) const
+		{
+			// Large primes from "Optimized Spatial Hashing for Collision Detection of Deformable Objects", Teschner et al.
+			return std::size_t((std::int64_t(key.x) * 73856093) ^ (std::int64_t(key.y) * 19349663) ^ (std::int64_t(key.z) * 83492791));
+		}
+	};
+
+	struct Item
+	{
+		EntityPtr entity;
+		Vector3 position;
+	};
+
+	using Cell = std::vector<Item>;
+
+	struct Location
+	{
+		CellKey key;
+		std::size_t itemIndex;
+	};
+
+	CellKey toCellKey(const Vector3& position) const;
+	Box3d getCellBounds(const CellKey& key) const;
+	Cell& addToCell(const CellKey& key);
+	void removeFromCell(const Location& location);
+
+	//! Calls visitor(key, cell) for all cells which overlap the box
+	template <typename VisitorT>
+	void visitCellsOverlappingBox(const Box3d& box, const VisitorT& visitor) const;
+
+	//! Calls visitor(item) for all items in cells which overlap the box
+	template <typename VisitorT>
+	void visitItemsInCellsOverlappingBox(const Box3d& box, const VisitorT& visitor) const;
+
+private:
+	const double mCellSize;
+	std::unordered_map<CellKey, Cell, CellKeyHash> mCells;
+	std::unordered_map<const Entity*, Location> mLocations;
+
+	//! Range of keys of cells which have been occupied since the index was last cleared.
+	//! Not shrunk when cells are vacated, so may be larger than the range of currently occupied cells.
+	CellKey mOccupiedMinKey;
+	CellKey mOccupiedMaxKey;
+};
+
+} // namespace sim
+} // namespace skybolt
@@ -0,0 +1,49 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "EntitySpatialIndexSystem.h"
+#include "SkyboltSim/Entity.h"
+
+#include <assert.h>
+
+namespace skybolt {
+namespace sim {
+
+EntitySpatialIndexSystem::EntitySpatialIndexSystem(World* world, double cellSize) :
+	mWorld(world),
+	mIndex(cellSize)
+{
+	assert(mWorld);
+	mWorld->addListener(this);
+}
+
+EntitySpatialIndexSystem::~EntitySpatialIndexSystem()
+{
+	mWorld->removeListener(this);
+}
+
+void EntitySpatialIndexSystem::updateIndex()
+{
+	for (const EntityPtr& entity : mWorld->getEntities())
+	{
+		if (std::optional<Vector3> position = getPosition(*entity); position)
+		{
+			mIndex.update(entity, *position);
+		}
+		else
+		{
+			mIndex.remove(entity.get());
+		}
+	}
+}
+
+void EntitySpatialIndexSystem::entityAboutToBeRemoved(const EntityPtr& entity)
+{
+	mIndex.remove(entity.get());
+}
+
+} // namespace sim
+} // namespace skybolt
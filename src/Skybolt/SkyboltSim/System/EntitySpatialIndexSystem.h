@@ -0,0 +1,44 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltSim/SkyboltSimFwd.h"
+#include "SkyboltSim/World.h"
+#include "SkyboltSim/Spatial/EntitySpatialIndex.h"
+#include "System.h"
+
+namespace skybolt {
+namespace sim {
+
+//! Maintains an EntitySpatialIndex of the positions of all entities in the world.
+//! The index is updated in UpdateStage::EndStateUpdate, once entity positions have been updated for the frame.
+class EntitySpatialIndexSystem : public System, public WorldListener
+{
+public:
+	//! @param cellSize is the edge length of spatial index grid cells in meters
+	EntitySpatialIndexSystem(World* world, double cellSize = 10000.0);
+	~EntitySpatialIndexSystem() override;
+
+	const EntitySpatialIndex& getIndex() const { return mIndex; }
+
+	//! Updates the index with current entity positions
+	void updateIndex();
+
+	SKYBOLT_BEGIN_REGISTER_UPDATE_HANDLERS
+		SKYBOLT_REGISTER_UPDATE_HANDLER(UpdateStage::EndStateUpdate, updateIndex)
+	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
+
+private: // WorldListener interface
+	void entityAboutToBeRemoved(const EntityPtr& entity) override;
+
+private:
+	World* mWorld;
+	EntitySpatialIndex mIndex;
+};
+
+} // namespace sim
+} // namespace skybolt
@@ -8,14 +8,34 @@
 #include "SkyboltSim/Entity.h"
 #include "SkyboltSim/World.h"
 #include "SkyboltSim/Components/DynamicBodyComponent.h"
+#include "SkyboltSim/Components/ParticleSystemComponent.h"
+#include "SkyboltSim/Components/SimpleDynamicBodyComponent.h"
+#include <SkyboltCommon/ParallelFor.h>
 
 namespace skybolt {
 namespace sim {
 
-EntitySystem::EntitySystem(World* world) :
-	mWorld(world)
+//! Minimum number of entities processed by each worker task.
+//! Smaller batches cost more in scheduling overhead than they gain from parallelism.
+constexpr std::size_t minEntitiesPerTask = 64;
+
+static bool isEntityLocalStage(UpdateStage stage)
+{
+	return stage == UpdateStage::PreDynamicsSubStep || stage == UpdateStage::DynamicsSubStep || stage == UpdateStage::PostDynamicsSubStep;
+}
+
+EntitySystem::EntitySystem(World* world, px_sched::Scheduler* scheduler) :
+	mWorld(world),
+	mScheduler(scheduler),
+	mParallelUpdateEnabled(scheduler != nullptr)
 {
 	assert(mWorld);
+	mWorld->addListener(this);
+}
+
+EntitySystem::~EntitySystem()
+{
+	mWorld->removeListener(this);
 }
 
 void EntitySystem::setSimTime(SecondsD newTime)
@@ -44,33 +64,190 @@ void EntitySystem::advanceSimTime(SecondsD newTime, SecondsD dt)
 
 void EntitySystem::update(UpdateStage stage)
 {
-	// Take a copy of the entities container so that the list doesn't change during timestep
-	// due to entities being added or removed from the world.
-	std::vector<EntityPtr> entities = mWorld->getEntities();
+	if (mEntitiesDirty)
+	{
+		mEntities = mWorld->getEntities();
+		mEntitiesDirty = false;
+	}
+
+	mUpdating = true;
+
+	bool applyGravityPerEntity = true;
+	if (mBatchedDynamicsEnabled)
+	{
+		if (stage == UpdateStage::PreDynamicsSubStep)
+		{
+			applyGravityBatched();
+			applyGravityPerEntity = false;
+		}
+		else if (stage == UpdateStage::DynamicsSubStep)
+		{
+			integrateBatched();
+		}
+	}
+
+	if (mScheduler && mParallelUpdateEnabled && mParallelParticleUpdateEnabled && stage == UpdateStage::EndStateUpdate)
+	{
+		// Particle systems are updated ahead of the entities' own EndStateUpdate handlers,
+		// which then have no elapsed time to process and do nothing.
+		updateParticleSystemsParallel();
+	}
+
+	if (mScheduler && mParallelUpdateEnabled && isEntityLocalStage(stage))
+	{
+		updateParallel(stage, applyGravityPerEntity);
+	}
+	else
+	{
+		for (const EntityPtr& entity : mEntities)
+		{
+			updateEntity(*entity, stage, applyGravityPerEntity);
+		}
+	}
+	mUpdating = false;
 
-	for (const EntityPtr& entity : entities)
+	// Release references to entities removed from the world during the update
+	if (mEntitiesDirty)
 	{
-		if (!entity->isDynamicsEnabled() &&
-			(stage == UpdateStage::PreDynamicsSubStep || stage == UpdateStage::DynamicsSubStep || stage == UpdateStage::PostDynamicsSubStep))
+		mEntities.clear();
+	}
+}
+
+void EntitySystem::applyGravityBatched()
+{
+	mBodyBatch.clear();
+	for (const EntityPtr& entity : mEntities)
+	{
+		if (entity->isDynamicsEnabled())
 		{
-			continue;
+			if (auto body = entity->getFirstComponent<DynamicBodyComponent>(); body)
+			{
+				if (auto simpleBody = dynamic_cast<SimpleDynamicBodyComponent*>(body.get()); simpleBody)
+				{
+					mBodyBatch.addBody(simpleBody);
+				}
+				else
+				{
+					applyGravity(*entity, *body);
+				}
+			}
 		}
+	}
+
+	mBodyBatch.applyGravity(getBatchScheduler());
+}
 
-		if (entity->isDynamicsEnabled() && stage == UpdateStage::PreDynamicsSubStep)
+void EntitySystem::integrateBatched()
+{
+	mBodyBatch.clear();
+	for (const EntityPtr& entity : mEntities)
+	{
+		if (entity->isDynamicsEnabled())
 		{
-			// Apply gravity
-			auto position = getPosition(*entity);
-			auto body = entity->getFirstComponent<DynamicBodyComponent>();
-			if (body)
+			if (auto body = entity->getFirstComponent<DynamicBodyComponent>(); body)
 			{
-				Vector3 force = mWorld->calcGravity(*position, body->getMass());
-				body->applyCentralForce(force);
+				if (auto simpleBody = dynamic_cast<SimpleDynamicBodyComponent*>(body.get()); simpleBody)
+				{
+					mBodyBatch.addBody(simpleBody);
+				}
 			}
 		}
+	}
+
+	mBodyBatch.integrate(getBatchScheduler());
+}
+
+void EntitySystem::updateParticleSystemsParallel()
+{
+	mParticleSystemComponents.clear();
+	for (const EntityPtr& entity : mEntities)
+	{
+		for (const auto& component : entity->getComponentsOfType<ParticleSystemComponent>())
+		{
+			mParticleSystemComponents.push_back(component.get());
+		}
+	}
+
+	// Each particle system is substantial work, so process one per task
+	parallelFor(mScheduler, mParticleSystemComponents.size(), /* minBatchSize */ 1, [this] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			mParticleSystemComponents[i]->updateState();
+		}
+	});
+}
+
+px_sched::Scheduler* EntitySystem::getBatchScheduler() const
+{
+	return mParallelUpdateEnabled ? mScheduler : nullptr;
+}
+
+void EntitySystem::updateParallel(UpdateStage stage, bool applyGravityPerEntity)
+{
+	mThreadSafeEntities.clear();
+	mMainThreadEntities.clear();
+	for (const EntityPtr& entity : mEntities)
+	{
+		if (entity->isDynamicsEnabled())
+		{
+			(entity->isThreadSafe() ? mThreadSafeEntities : mMainThreadEntities).push_back(entity.get());
+		}
+	}
+
+	parallelFor(mScheduler, mThreadSafeEntities.size(), minEntitiesPerTask, [this, stage, applyGravityPerEntity] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			updateEntity(*mThreadSafeEntities[i], stage, applyGravityPerEntity);
+		}
+	});
+
+	for (Entity* entity : mMainThreadEntities)
+	{
+		updateEntity(*entity, stage, applyGravityPerEntity);
+	}
+}
+
+void EntitySystem::updateEntity(Entity& entity, UpdateStage stage, bool applyGravityPerEntity) const
+{
+	if (!entity.isDynamicsEnabled() && isEntityLocalStage(stage))
+	{
+		return;
+	}
+
+	if (applyGravityPerEntity && entity.isDynamicsEnabled() && stage == UpdateStage::PreDynamicsSubStep)
+	{
+		auto body = entity.getFirstComponent<DynamicBodyComponent>();
+		if (body)
+		{
+			applyGravity(entity, *body);
+		}
+	}
 
-		entity->update(stage);
+	entity.update(stage);
+}
+
+void EntitySystem::applyGravity(const Entity& entity, DynamicBodyComponent& body) const
+{
+	auto position = getPosition(entity);
+	Vector3 force = mWorld->calcGravity(*position, body.getMass());
+	body.applyCentralForce(force);
+}
+
+void EntitySystem::entityAdded(const EntityPtr& entity)
+{
+	mEntitiesDirty = true;
+}
+
+void EntitySystem::entityRemoved(const EntityPtr& entity)
+{
+	mEntitiesDirty = true;
+
+	// Release our reference to the removed entity now, unless we are part way through iterating over the snapshot
+	if (!mUpdating)
+	{
+		mEntities.clear();
 	}
 }
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
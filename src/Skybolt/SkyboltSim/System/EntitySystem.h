@@ -7,25 +7,79 @@
 #pragma once
 
 #include "SkyboltSim/SkyboltSimFwd.h"
+#include "SkyboltSim/World.h"
+#include "SkyboltSim/Components/SimpleDynamicBodyBatch.h"
 #include "System.h"
 #include <vector>
 
+namespace px_sched {
+class Scheduler;
+} // namespace px_sched
+
 namespace skybolt {
 namespace sim {
 
-class EntitySystem : public System
+class EntitySystem : public System, public WorldListener
 {
 public:
-	EntitySystem(World* world);
+	//! @param scheduler is optional. If provided, entity-local update stages of thread safe entities
+	//! are distributed across the scheduler's worker threads. @see Component::isThreadSafe()
+	EntitySystem(World* world, px_sched::Scheduler* scheduler = nullptr);
+	~EntitySystem() override;
+
+	//! Parallel update is enabled by default if a scheduler was provided
+	void setParallelUpdateEnabled(bool enabled) { mParallelUpdateEnabled = enabled; }
+	bool isParallelUpdateEnabled() const { return mParallelUpdateEnabled; }
+
+	//! If enabled, gravity and linear dynamics of SimpleDynamicBodyComponents are processed in batches
+	//! rather than per entity. Results are identical to the unbatched path. Disabled by default.
+	//! @see SimpleDynamicBodyBatch
+	void setBatchedDynamicsEnabled(bool enabled) { mBatchedDynamicsEnabled = enabled; }
+	bool isBatchedDynamicsEnabled() const { return mBatchedDynamicsEnabled; }
+
+	//! If enabled, and parallel update is enabled, ParticleSystemComponents of all entities are updated
+	//! concurrently across the scheduler's worker threads at the start of the EndStateUpdate stage. Enabled by default.
+	void setParallelParticleUpdateEnabled(bool enabled) { mParallelParticleUpdateEnabled = enabled; }
+	bool isParallelParticleUpdateEnabled() const { return mParallelParticleUpdateEnabled; }
 
 	void setSimTime(SecondsD newTime) override;
 	void advanceWallTime(SecondsD newTime, SecondsD dt) override;
 	void advanceSimTime(SecondsD newTime, SecondsD dt) override;
 	void update(UpdateStage stage) override;
 
+private: // WorldListener interface
+	void entityAdded(const EntityPtr& entity) override;
+	void entityRemoved(const EntityPtr& entity) override;
+
+private:
+	void updateParallel(UpdateStage stage, bool applyGravityPerEntity);
+	void updateEntity(Entity& entity, UpdateStage stage, bool applyGravityPerEntity) const;
+	void applyGravity(const Entity& entity, DynamicBodyComponent& body) const;
+
+	void applyGravityBatched();
+	void integrateBatched();
+	void updateParticleSystemsParallel();
+	px_sched::Scheduler* getBatchScheduler() const;
+
 private:
 	World* mWorld;
+	px_sched::Scheduler* mScheduler;
+	bool mParallelUpdateEnabled;
+	bool mBatchedDynamicsEnabled = false;
+	bool mParallelParticleUpdateEnabled = true;
+
+	//! Snapshot of the world's entities so that the list doesn't change during a timestep
+	//! due to entities being added or removed from the world. Only refreshed when the world's entities change.
+	std::vector<EntityPtr> mEntities;
+	bool mEntitiesDirty = true;
+	bool mUpdating = false;
+
+	// Scratch buffers reused between updates to avoid allocation
+	std::vector<Entity*> mThreadSafeEntities;
+	std::vector<Entity*> mMainThreadEntities;
+	std::vector<ParticleSystemComponent*> mParticleSystemComponents;
+	SimpleDynamicBodyBatch mBodyBatch;
 };
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
@@ -0,0 +1,58 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "TerrainPrefetchSystem.h"
+#include "SkyboltSim/Entity.h"
+#include "SkyboltSim/World.h"
+#include "SkyboltSim/WorldUtil.h"
+#include "SkyboltSim/Components/PlanetComponent.h"
+
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <assert.h>
+
+namespace skybolt {
+namespace sim {
+
+TerrainPrefetchSystem::TerrainPrefetchSystem(World* world, double lookaheadSeconds) :
+	mWorld(world),
+	mLookaheadSeconds(lookaheadSeconds)
+{
+	assert(mWorld);
+}
+
+void TerrainPrefetchSystem::prefetch()
+{
+	const World::Entities& entities = mWorld->getEntities();
+	for (const EntityPtr& entity : entities)
+	{
+		std::optional<Vector3> position = getPosition(*entity);
+		std::optional<Vector3> velocity = getVelocity(*entity);
+		if (!position || !velocity || glm::dot(*velocity, *velocity) == 0.0)
+		{
+			continue;
+		}
+
+		EntityPtr planet = findNearestEntityWithComponent<PlanetComponent>(entities, *position);
+		if (!planet || planet == entity)
+		{
+			continue;
+		}
+
+		const PlanetAltitudeProvider* provider = planet->getFirstComponent<PlanetComponent>()->altitudeProvider.get();
+		if (provider)
+		{
+			// Track is computed in planet space, in which the provider's latitudes and longitudes are defined
+			glm::dmat4 invPlanetTransform = glm::inverse(getTransform(*planet).value_or(math::dmat4Identity()));
+			Vector3 positionInPlanetSpace(invPlanetTransform * glm::dvec4(*position, 1.0));
+			Vector3 velocityInPlanetSpace(invPlanetTransform * glm::dvec4(*velocity, 0.0));
+			prefetchAltitudesAlongTrack(*provider, positionInPlanetSpace, velocityInPlanetSpace, mLookaheadSeconds);
+		}
+	}
+}
+
+} // namespace sim
+} // namespace skybolt
@@ -0,0 +1,37 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltSim/SkyboltSimFwd.h"
+#include "System.h"
+
+namespace skybolt {
+namespace sim {
+
+//! Prefetches terrain altitudes along the track of every moving entity, so that altitude tiles ahead of fast bodies
+//! are loaded before the bodies reach them. Each entity's track is extrapolated from its current velocity
+//! and prefetched from the altitude provider of the nearest planet.
+class TerrainPrefetchSystem : public System
+{
+public:
+	//! @param lookaheadSeconds is the time over which each entity's track is extrapolated
+	TerrainPrefetchSystem(World* world, double lookaheadSeconds = 10.0);
+	~TerrainPrefetchSystem() override = default;
+
+	void prefetch();
+
+	SKYBOLT_BEGIN_REGISTER_UPDATE_HANDLERS
+		SKYBOLT_REGISTER_UPDATE_HANDLER(UpdateStage::EndStateUpdate, prefetch)
+	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
+
+private:
+	World* mWorld;
+	double mLookaheadSeconds;
+};
+
+} // namespace sim
+} // namespace skybolt
@@ -7,7 +7,6 @@
 
 #include "SkyboltSim/World.h"
 #include "SkyboltSim/Components/NameComponent.h"
-#include <SkyboltCommon/MapUtility.h>
 
 namespace skybolt {
 namespace sim {
@@ -22,7 +21,17 @@ World::~World()
 	// This could happen if an entity removes its child from the world when it is destroyed.
 	// TODO: Investigate cleaner solutions.
 	mDestructing = true;
+
+	// Clear the lookup structures before releasing the entities, so that lookups made while entities
+	// are destroyed find nothing rather than indexing into released entities.
+	Entities entities = std::move(mEntities);
+	std::unordered_map<std::string, EntityPtr> nameToEntityMap = std::move(mNameToEntityMap);
 	mEntities.clear();
+	mNameToEntityMap.clear();
+	mEntitySlotIndices.clear();
+	mSlots.clear();
+	mFreeSlotIndices.clear();
+	mIdToSlotIndexMap.clear();
 }
 
 void World::addEntity(const EntityPtr& entity)
@@ -35,8 +44,22 @@ void World::addEntity(const EntityPtr& entity)
 		return;
 	}
 
+	std::uint32_t slotIndex;
+	if (mFreeSlotIndices.empty())
+	{
+		slotIndex = std::uint32_t(mSlots.size());
+		mSlots.emplace_back();
+	}
+	else
+	{
+		slotIndex = mFreeSlotIndices.back();
+		mFreeSlotIndices.pop_back();
+	}
+
+	mSlots[slotIndex].entityIndex = std::uint32_t(mEntities.size());
 	mEntities.push_back(entity);
-	mIdToEntityMap[entity->getId()] = entity;
+	mEntitySlotIndices.push_back(slotIndex);
+	mIdToSlotIndexMap[entity->getId()] = slotIndex;
 
 	if (const std::string& name = getName(*entity); !name.empty())
 	{
@@ -55,47 +78,95 @@ void World::removeEntity(Entity* entity)
 		return;
 	}
 
-	auto it = std::find_if(mEntities.begin(), mEntities.end(), [entity](const EntityPtr& item) {
-		return item.get() == entity;
-	});
+	auto slotIt = mIdToSlotIndexMap.find(entity->getId());
+	if (slotIt == mIdToSlotIndexMap.end() || mEntities[mSlots[slotIt->second].entityIndex].get() != entity)
+	{
+		return;
+	}
+
+	EntityPtr objectPtr = mEntities[mSlots[slotIt->second].entityIndex];
+	CALL_LISTENERS(entityAboutToBeRemoved(objectPtr));
 
-	if (it != mEntities.end())
+	// Look up the slot again because listeners may have added or removed other entities
+	slotIt = mIdToSlotIndexMap.find(entity->getId());
+	if (slotIt == mIdToSlotIndexMap.end())
 	{
-		EntityPtr objectPtr = *it;
-		CALL_LISTENERS(entityAboutToBeRemoved(objectPtr));
-		mEntities.erase(it);
-		mIdToEntityMap.erase(entity->getId());
+		return;
+	}
+	std::uint32_t slotIndex = slotIt->second;
+	mIdToSlotIndexMap.erase(slotIt);
+
+	// Swap entity with the last entity and pop
+	std::uint32_t entityIndex = mSlots[slotIndex].entityIndex;
+	std::uint32_t lastEntityIndex = std::uint32_t(mEntities.size() - 1);
+	if (entityIndex != lastEntityIndex)
+	{
+		mEntities[entityIndex] = std::move(mEntities[lastEntityIndex]);
+		mEntitySlotIndices[entityIndex] = mEntitySlotIndices[lastEntityIndex];
+		mSlots[mEntitySlotIndices[entityIndex]].entityIndex = entityIndex;
+	}
+	mEntities.pop_back();
+	mEntitySlotIndices.pop_back();
 
-		if (const std::string& name = getName(*entity); !name.empty())
+	++mSlots[slotIndex].generation;
+	mFreeSlotIndices.push_back(slotIndex);
+
+	if (const std::string& name = getName(*entity); !name.empty())
+	{
+		if (auto i = mNameToEntityMap.find(name); i != mNameToEntityMap.end() && i->second.get() == entity)
 		{
-			mNameToEntityMap.erase(name);
+			mNameToEntityMap.erase(i);
 		}
-
-		CALL_LISTENERS(entityRemoved(objectPtr));
 	}
+
+	CALL_LISTENERS(entityRemoved(objectPtr));
 }
 
 void World::removeAllEntities()
 {
+	// Remove from the back so that each removal is constant time
 	while (!mEntities.empty())
 	{
-		removeEntity(mEntities.front().get());
+		removeEntity(mEntities.back().get());
 	}
 }
 
 EntityPtr World::getEntityById(EntityId id) const
 {
-	if (auto i = mIdToEntityMap.find(id); i != mIdToEntityMap.end())
+	if (auto i = mIdToSlotIndexMap.find(id); i != mIdToSlotIndexMap.end())
 	{
-		return i->second;
+		return mEntities[mSlots[i->second].entityIndex];
+	}
+	return nullptr;
+}
+
+EntityHandle World::getEntityHandle(EntityId id) const
+{
+	if (auto i = mIdToSlotIndexMap.find(id); i != mIdToSlotIndexMap.end())
+	{
+		return EntityHandle{i->second, mSlots[i->second].generation};
+	}
+	return EntityHandle();
+}
+
+EntityPtr World::getEntityByHandle(const EntityHandle& handle) const
+{
+	if (handle.slot < mSlots.size())
+	{
+		const EntitySlot& slot = mSlots[handle.slot];
+		if (slot.generation == handle.generation && slot.entityIndex < mEntitySlotIndices.size() && mEntitySlotIndices[slot.entityIndex] == handle.slot)
+		{
+			return mEntities[slot.entityIndex];
+		}
 	}
 	return nullptr;
 }
 
 Vector3 World::calcGravity(const Vector3& position, double mass) const
 {
-	// Apply gravity towards world origin, which is assumed to be centre of planet
-	double magnitude = mass * -9.81f;
+	// Apply gravity towards world origin, which is assumed to be centre of planet.
+	// Note: SimpleDynamicBodyBatch::applyGravity() performs the same calculation and must be kept consistent with this one.
+	double magnitude = mass * -gravitationalAcceleration;
 	double r = glm::length(position);
 	if (r > 1e-8)
 	{
@@ -107,7 +178,11 @@ Vector3 World::calcGravity(const Vector3& position, double mass) const
 
 EntityPtr World::findObjectByName(const std::string& name) const
 {
-	return findOptional(mNameToEntityMap, name).value_or(nullptr);
+	if (auto i = mNameToEntityMap.find(name); i != mNameToEntityMap.end())
+	{
+		return i->second;
+	}
+	return nullptr;
 }
 
 } // namespace sim
@@ -11,6 +11,10 @@
 #include <SkyboltCommon/Event.h>
 #include <SkyboltCommon/Listenable.h>
 
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
 namespace skybolt {
 namespace sim {
 
@@ -24,15 +28,38 @@ public:
 	virtual void entityRemoved(const sim::EntityPtr& entity) {}
 };
 
+//! Lightweight reference to an entity in a World, which can be resolved in constant time.
+//! The handle becomes stale when the entity is removed from the world, even if its storage slot is reused.
+struct EntityHandle
+{
+	std::uint32_t slot = ~std::uint32_t(0);
+	std::uint32_t generation = 0;
+};
+
+inline bool operator == (const EntityHandle& a, const EntityHandle& b)
+{
+	return a.slot == b.slot && a.generation == b.generation;
+}
+
+inline bool operator != (const EntityHandle& a, const EntityHandle& b)
+{
+	return !(a == b);
+}
+
 class World : public EventEmitter, public skybolt::Listenable<WorldListener>
 {
 public:
 	World();
 	~World();
 
+	//! Magnitude of gravitational acceleration, in m/s^2, applied towards the world origin
+	static constexpr float gravitationalAcceleration = 9.81f;
+
 	Vector3 calcGravity(const Vector3& position, double mass) const;
 
 	void addEntity(const EntityPtr& entity);
+
+	//! Removal is constant time. The order of the remaining entities returned by getEntities() may change.
 	void removeEntity(Entity* entity);
 	void removeAllEntities();
 
@@ -45,10 +72,26 @@ public:
 	//! @return null if entity not found
 	EntityPtr findObjectByName(const std::string& name) const;
 
+	//! @return handle to the entity, or a null handle if the entity is not in the world
+	EntityHandle getEntityHandle(EntityId id) const;
+
+	//! @return null if the handle is stale or null
+	EntityPtr getEntityByHandle(const EntityHandle& handle) const;
+
 private:
+	struct EntitySlot
+	{
+		std::uint32_t generation = 0; //!< Incremented each time the slot is vacated
+		std::uint32_t entityIndex = 0; //!< Index of the entity in mEntities
+	};
+
 	Entities mEntities;
-	std::map<EntityId, EntityPtr> mIdToEntityMap;
-	std::map<std::string, EntityPtr> mNameToEntityMap;
+	std::vector<std::uint32_t> mEntitySlotIndices; //!< Slot index of each entity, parallel to mEntities
+	std::vector<EntitySlot> mSlots;
+	std::vector<std::uint32_t> mFreeSlotIndices;
+
+	std::unordered_map<EntityId, std::uint32_t> mIdToSlotIndexMap;
+	std::unordered_map<std::string, EntityPtr> mNameToEntityMap;
 
 	bool mDestructing = false;
 };
@@ -0,0 +1,272 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/Node.h>
+#include <SkyboltSim/Spatial/EntitySpatialIndex.h>
+#include <SkyboltSim/Spatial/Frustum.h>
+#include <SkyboltSim/System/EntitySpatialIndexSystem.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+constexpr double earthRadius = 6371000;
+
+static EntityPtr createEntityAtPosition(std::uint32_t id, const Vector3& position)
+{
+	auto entity = std::make_shared<Entity>(EntityId({1, id}));
+	entity->addComponent(std::make_shared<Node>(position));
+	return entity;
+}
+
+static std::vector<EntityPtr> createRandomEntitiesNearSurface(int count, double spread)
+{
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> distribution(-spread, spread);
+
+	std::vector<EntityPtr> entities;
+	for (int i = 0; i < count; ++i)
+	{
+		Vector3 position(earthRadius + distribution(generator), distribution(generator), distribution(generator));
+		entities.push_back(createEntityAtPosition(std::uint32_t(i + 1), position));
+	}
+	return entities;
+}
+
+static std::set<EntityPtr> toSet(const std::vector<EntityPtr>& entities)
+{
+	return std::set<EntityPtr>(entities.begin(), entities.end());
+}
+
+template <typename PredicateT>
+static std::set<EntityPtr> findBruteForce(const std::vector<EntityPtr>& entities, const PredicateT& predicate)
+{
+	std::set<EntityPtr> result;
+	for (const EntityPtr& entity : entities)
+	{
+		if (predicate(*getPosition(*entity)))
+		{
+			result.insert(entity);
+		}
+	}
+	return result;
+}
+
+TEST_CASE("EntitySpatialIndex radius and box queries match brute force search")
+{
+	auto entities = createRandomEntitiesNearSurface(1000, 50000);
+
+	EntitySpatialIndex index(5000);
+	for (const EntityPtr& entity : entities)
+	{
+		index.update(entity, *getPosition(*entity));
+	}
+	CHECK(index.size() == entities.size());
+
+	Vector3 center(earthRadius + 1000, 2000, -3000);
+	for (double radius : {100.0, 10000.0, 1e7})
+	{
+		std::vector<EntityPtr> result;
+		index.findEntitiesInRadius(center, radius, result);
+		CHECK(toSet(result) == findBruteForce(entities, [&] (const Vector3& p) { return glm::distance(p, center) <= radius; }));
+	}
+
+	Box3d box(Vector3(earthRadius - 20000, -5000, -30000), Vector3(earthRadius + 7000, 12000, 1000));
+	std::vector<EntityPtr> result;
+	index.findEntitiesInBox(box, result);
+	CHECK(!result.empty());
+	CHECK(toSet(result) == findBruteForce(entities, [&] (const Vector3& p) {
+		return p.x >= box.minimum.x && p.x <= box.maximum.x
+			&& p.y >= box.minimum.y && p.y <= box.maximum.y
+			&& p.z >= box.minimum.z && p.z <= box.maximum.z;
+	}));
+}
+
+TEST_CASE("EntitySpatialIndex frustum query matches screen space test")
+{
+	auto entities = createRandomEntitiesNearSurface(1000, 50000);
+
+	EntitySpatialIndex index(5000);
+	for (const EntityPtr& entity : entities)
+	{
+		index.update(entity, *getPosition(*entity));
+	}
+
+	Frustum frustum;
+	frustum.origin = Vector3(earthRadius, -60000, 0);
+	frustum.orientation = glm::angleAxis(math::halfPiD(), Vector3(0, 0, 1)); // Look along +y axis
+	frustum.fieldOfViewHorizontal = 0.6;
+	frustum.fieldOfViewVertical = 0.4;
+
+	std::vector<EntityPtr> result;
+	index.findEntitiesInFrustum(frustum, result);
+	CHECK(!result.empty());
+	CHECK(toSet(result) == findBruteForce(entities, [&] (const Vector3& p) {
+		Vector3 s = transformToScreenSpace(frustum, p);
+		return s.z > 0 && std::abs(s.x) <= 1 && std::abs(s.y) <= 1;
+	}));
+}
+
+TEST_CASE("EntitySpatialIndex frustum query only finds entities in front of the frustum")
+{
+	EntitySpatialIndex index(1000);
+	auto inFront = createEntityAtPosition(1, Vector3(0, 50000, 0));
+	auto behind = createEntityAtPosition(2, Vector3(0, -50000, 0));
+	auto beside = createEntityAtPosition(3, Vector3(500000, 0, 0));
+	for (const EntityPtr& entity : {inFront, behind, beside})
+	{
+		index.update(entity, *getPosition(*entity));
+	}
+
+	Frustum frustum;
+	frustum.origin = Vector3(0, 0, 0);
+	frustum.orientation = glm::angleAxis(math::halfPiD(), Vector3(0, 0, 1)); // Look along +y axis
+	frustum.fieldOfViewHorizontal = 0.6;
+	frustum.fieldOfViewVertical = 0.4;
+
+	std::vector<EntityPtr> result;
+	index.findEntitiesInFrustum(frustum, result);
+	CHECK(result == std::vector<EntityPtr>({inFront}));
+
+	// Frustum origin outside of the occupied cells
+	frustum.origin = Vector3(0, -1e6, 0);
+	result.clear();
+	index.findEntitiesInFrustum(frustum, result);
+	CHECK(toSet(result) == std::set<EntityPtr>({inFront, behind}));
+
+	index.clear();
+	result.clear();
+	index.findEntitiesInFrustum(frustum, result);
+	CHECK(result.empty());
+}
+
+TEST_CASE("EntitySpatialIndex handles positions beyond the cell coordinate range")
+{
+	EntitySpatialIndex index(1);
+	double far = 1e20;
+	auto entityA = createEntityAtPosition(1, Vector3(far, -far, 0));
+	auto entityB = createEntityAtPosition(2, Vector3(-far, far, 0));
+	auto entityC = createEntityAtPosition(3, Vector3(0, 0, 0));
+	for (const EntityPtr& entity : {entityA, entityB, entityC})
+	{
+		index.update(entity, *getPosition(*entity));
+	}
+	CHECK(index.size() == 3);
+
+	std::vector<EntityPtr> result;
+	index.findEntitiesInRadius(Vector3(far, -far, 0), 10, result);
+	CHECK(result == std::vector<EntityPtr>({entityA}));
+
+	result.clear();
+	index.findEntitiesInBox(Box3d(Vector3(-2 * far), Vector3(2 * far)), result);
+	CHECK(toSet(result) == std::set<EntityPtr>({entityA, entityB, entityC}));
+
+	result.clear();
+	index.findEntitiesInRadius(Vector3(0, 0, 0), std::numeric_limits<double>::infinity(), result);
+	CHECK(result.size() == 3);
+
+	index.remove(entityA.get());
+	index.remove(entityB.get());
+	CHECK(index.size() == 1);
+}
+
+TEST_CASE("EntitySpatialIndex tracks moved and removed entities")
+{
+	EntitySpatialIndex index(1000);
+	auto entity = createEntityAtPosition(1, Vector3(0, 0, 0));
+	index.update(entity, Vector3(0, 0, 0));
+
+	std::vector<EntityPtr> result;
+	index.findEntitiesInRadius(Vector3(5000, 0, 0), 10, result);
+	CHECK(result.empty());
+
+	index.update(entity, Vector3(5000, 0, 0));
+	index.findEntitiesInRadius(Vector3(5000, 0, 0), 10, result);
+	CHECK(result.size() == 1);
+
+	index.remove(entity.get());
+	CHECK(!index.contains(entity.get()));
+	result.clear();
+	index.findEntitiesInRadius(Vector3(5000, 0, 0), 10, result);
+	CHECK(result.empty());
+}
+
+TEST_CASE("EntitySpatialIndexSystem indexes world entities at EndStateUpdate")
+{
+	World world;
+	EntitySpatialIndexSystem system(&world);
+
+	auto entity = createEntityAtPosition(1, Vector3(earthRadius, 0, 0));
+	world.addEntity(entity);
+	CHECK(!system.getIndex().contains(entity.get()));
+
+	system.updateIndex();
+	CHECK(system.getIndex().contains(entity.get()));
+
+	world.removeEntity(entity.get());
+	CHECK(!system.getIndex().contains(entity.get()));
+}
+
+TEST_CASE("Benchmark EntitySpatialIndex with 100k entities", "[.benchmark]")
+{
+	auto entities = createRandomEntitiesNearSurface(100000, 1000000);
+
+	EntitySpatialIndex index;
+	for (const EntityPtr& entity : entities)
+	{
+		index.update(entity, *getPosition(*entity));
+	}
+
+	BENCHMARK("Update all entity positions")
+	{
+		for (const EntityPtr& entity : entities)
+		{
+			index.update(entity, *getPosition(*entity) + Vector3(1, 0, 0));
+		}
+	};
+
+	BENCHMARK("Radius query 20km")
+	{
+		std::vector<EntityPtr> result;
+		index.findEntitiesInRadius(Vector3(earthRadius, 0, 0), 20000, result);
+		return result.size();
+	};
+
+	BENCHMARK("Brute force radius query 20km")
+	{
+		std::vector<EntityPtr> result;
+		Vector3 center(earthRadius, 0, 0);
+		for (const EntityPtr& entity : entities)
+		{
+			if (glm::distance(*getPosition(*entity), center) <= 20000)
+			{
+				result.push_back(entity);
+			}
+		}
+		return result.size();
+	};
+
+	Frustum frustum;
+	frustum.origin = Vector3(earthRadius, -1000000, 0);
+	frustum.orientation = glm::angleAxis(math::halfPiD(), Vector3(0, 0, 1));
+	frustum.fieldOfViewHorizontal = 0.5;
+	frustum.fieldOfViewVertical = 0.3;
+
+	BENCHMARK("Frustum query")
+	{
+		std::vector<EntityPtr> result;
+		index.findEntitiesInFrustum(frustum, result);
+		return result.size();
+	};
+}
@@ -0,0 +1,194 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#define PX_SCHED_IMPLEMENTATION 1
+#include <px_sched/px_sched.h>
+
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/Motion.h>
+#include <SkyboltSim/Components/Node.h>
+#include <SkyboltSim/Components/SimpleDynamicBodyComponent.h>
+#include <SkyboltSim/System/EntitySystem.h>
+#include <SkyboltSim/System/SimStepper.h>
+
+#include <cmath>
+#include <thread>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+constexpr double earthRadius = 6371000;
+
+static EntityPtr createSimpleBodyEntity(std::uint32_t id)
+{
+	auto entity = std::make_shared<Entity>(EntityId({1, id}));
+
+	// Spread entities around the planet with varying velocities
+	double angle = double(id) * 0.001;
+	auto node = std::make_shared<Node>(Vector3(std::cos(angle), std::sin(angle), 0) * (earthRadius + double(id)));
+	auto motion = std::make_shared<Motion>();
+	motion->linearVelocity = Vector3(-std::sin(angle), std::cos(angle), 0.1) * 200.0;
+
+	entity->addComponent(node);
+	entity->addComponent(motion);
+	entity->addComponent(std::make_shared<SimpleDynamicBodyComponent>(node.get(), motion.get(), 1000.0, Vector3(1, 2, 3)));
+	return entity;
+}
+
+static void populateWorld(World& world, int entityCount)
+{
+	for (int i = 1; i <= entityCount; ++i)
+	{
+		world.addEntity(createSimpleBodyEntity(std::uint32_t(i)));
+	}
+}
+
+class MainThreadOnlyComponent : public Component
+{
+public:
+	SKYBOLT_BEGIN_REGISTER_UPDATE_HANDLERS
+		SKYBOLT_REGISTER_UPDATE_HANDLER(UpdateStage::DynamicsSubStep, updateDynamicsSubStep)
+	SKYBOLT_END_REGISTER_UPDATE_HANDLERS
+
+	void updateDynamicsSubStep()
+	{
+		updateThreadId = std::this_thread::get_id();
+	}
+
+	std::thread::id updateThreadId;
+};
+
+TEST_CASE("Entity is thread safe only if all components are thread safe")
+{
+	auto entity = createSimpleBodyEntity(1);
+	CHECK(entity->isThreadSafe());
+
+	auto component = std::make_shared<MainThreadOnlyComponent>();
+	entity->addComponent(component);
+	CHECK(!entity->isThreadSafe());
+
+	entity->removeComponent(component);
+	CHECK(entity->isThreadSafe());
+}
+
+TEST_CASE("Parallel EntitySystem update produces same result as serial update")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	constexpr int entityCount = 1000;
+	World serialWorld;
+	populateWorld(serialWorld, entityCount);
+
+	World parallelWorld;
+	populateWorld(parallelWorld, entityCount);
+
+	auto serialSystem = std::make_shared<EntitySystem>(&serialWorld);
+	auto parallelSystem = std::make_shared<EntitySystem>(&parallelWorld, &scheduler);
+	CHECK(!serialSystem->isParallelUpdateEnabled());
+	CHECK(parallelSystem->isParallelUpdateEnabled());
+
+	SimStepper serialStepper(std::make_shared<SystemRegistry>(SystemRegistry({serialSystem})));
+	SimStepper parallelStepper(std::make_shared<SystemRegistry>(SystemRegistry({parallelSystem})));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		serialStepper.update(0.1);
+		parallelStepper.update(0.1);
+	}
+
+	for (int i = 0; i < entityCount; ++i)
+	{
+		REQUIRE(getPosition(*serialWorld.getEntities()[i]) == getPosition(*parallelWorld.getEntities()[i]));
+		REQUIRE(getVelocity(*serialWorld.getEntities()[i]) == getVelocity(*parallelWorld.getEntities()[i]));
+	}
+}
+
+TEST_CASE("Batched dynamics EntitySystem update produces same result as unbatched update")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	constexpr int entityCount = 1000;
+	World unbatchedWorld;
+	populateWorld(unbatchedWorld, entityCount);
+
+	World batchedWorld;
+	populateWorld(batchedWorld, entityCount);
+
+	auto unbatchedSystem = std::make_shared<EntitySystem>(&unbatchedWorld);
+	auto batchedSystem = std::make_shared<EntitySystem>(&batchedWorld, &scheduler);
+	batchedSystem->setBatchedDynamicsEnabled(true);
+
+	SimStepper unbatchedStepper(std::make_shared<SystemRegistry>(SystemRegistry({unbatchedSystem})));
+	SimStepper batchedStepper(std::make_shared<SystemRegistry>(SystemRegistry({batchedSystem})));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		unbatchedStepper.update(0.1);
+		batchedStepper.update(0.1);
+	}
+
+	for (int i = 0; i < entityCount; ++i)
+	{
+		REQUIRE(getPosition(*unbatchedWorld.getEntities()[i]) == getPosition(*batchedWorld.getEntities()[i]));
+		REQUIRE(getVelocity(*unbatchedWorld.getEntities()[i]) == getVelocity(*batchedWorld.getEntities()[i]));
+	}
+}
+
+TEST_CASE("Entities with main thread only components are updated on the main thread")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	World world;
+	populateWorld(world, 1000);
+
+	auto component = std::make_shared<MainThreadOnlyComponent>();
+	world.getEntities().back()->addComponent(component);
+
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({std::make_shared<EntitySystem>(&world, &scheduler)})));
+	stepper.update(0.1);
+
+	CHECK(component->updateThreadId == std::this_thread::get_id());
+}
+
+TEST_CASE("Benchmark SimStepper update with SimpleDynamicBodyComponent entities", "[.benchmark]")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	for (int entityCount : {1000, 10000})
+	{
+		World world;
+		populateWorld(world, entityCount);
+
+		auto system = std::make_shared<EntitySystem>(&world, &scheduler);
+		SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({system})));
+		constexpr SecondsD dt = 1.0 / 60.0;
+
+		system->setParallelUpdateEnabled(false);
+		BENCHMARK("Serial " + std::to_string(entityCount) + " entities")
+		{
+			stepper.update(dt);
+		};
+
+		system->setParallelUpdateEnabled(true);
+		BENCHMARK("Parallel " + std::to_string(entityCount) + " entities")
+		{
+			stepper.update(dt);
+		};
+
+		system->setBatchedDynamicsEnabled(true);
+		BENCHMARK("Parallel batched " + std::to_string(entityCount) + " entities")
+		{
+			stepper.update(dt);
+		};
+	}
+}
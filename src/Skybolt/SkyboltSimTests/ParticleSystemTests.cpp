@@ -0,0 +1,237 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#include <px_sched/px_sched.h>
+
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/Node.h>
+#include <SkyboltSim/Components/ParticleSystemComponent.h>
+#include <SkyboltSim/Particles/ParticleSystem.h>
+#include <SkyboltSim/System/EntitySystem.h>
+#include <SkyboltSim/System/SimStepper.h>
+#include <SkyboltCommon/Random.h>
+
+#include <set>
+#include <thread>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+static Particle createTestParticle(int guid, float age)
+{
+	Particle particle;
+	particle.guid = guid;
+	particle.position = Vector3(guid, 2 * guid, 3 * guid);
+	particle.velocity = Vector3(1, 0, 0);
+	particle.radius = 1;
+	particle.age = age;
+	particle.initialAlpha = 1;
+	particle.alpha = 1;
+	particle.temperatureDegreesCelcius = 0;
+	return particle;
+}
+
+static ParticleSystemPtr createTestParticleSystem(const PositionablePtr& positionable, float emissionRate, float lifetime)
+{
+	NearestPlanetProvider nearestPlanetProvider = [] (const Vector3& position) { return nullptr; };
+
+	ParticleEmitter::Params emitterParams;
+	emitterParams.positionable = positionable;
+	emitterParams.emissionRate = emissionRate;
+	emitterParams.radius = 1;
+	emitterParams.upDirection = Vector3(0, 0, -1);
+	emitterParams.speed = DoubleRangeInclusive(10, 20);
+	emitterParams.elevationAngle = DoubleRangeInclusive(1.0, 1.5);
+	emitterParams.temperatureDegreesCelcius = 1000;
+	emitterParams.zeroAtmosphericDensityAlpha = 1;
+	emitterParams.earthSeaLevelAtmosphericDensityAlpha = 1;
+	emitterParams.random = std::make_shared<Random>(/* seed */ 0);
+	emitterParams.nearestPlanetProvider = nearestPlanetProvider;
+
+	ParticleIntegrator::Params integratorParams;
+	integratorParams.radiusLinearGrowthPerSecond = 2;
+	integratorParams.lifetime = lifetime;
+	integratorParams.atmosphericSlowdownFactor = 1;
+	integratorParams.heatTransferCoefficent = 0.5f;
+	integratorParams.nearestPlanetProvider = nearestPlanetProvider;
+
+	return std::make_shared<ParticleSystem>(ParticleSystem::Operations({
+		std::make_shared<ParticleIntegrator>(integratorParams),
+		std::make_shared<ParticleEmitter>(emitterParams),
+		std::make_shared<ParticleKiller>(lifetime)
+	}));
+}
+
+TEST_CASE("ParticleStore removeIf preserves order of remaining particles")
+{
+	ParticleStore store;
+	for (int i = 0; i < 10; ++i)
+	{
+		store.push_back(createTestParticle(i, float(i)));
+	}
+
+	store.removeIf([&] (size_t i) { return store.guid[i] % 3 == 0; });
+
+	REQUIRE(store.size() == 6);
+	std::vector<int> expectedGuids = {1, 2, 4, 5, 7, 8};
+	for (size_t i = 0; i < store.size(); ++i)
+	{
+		CHECK(store.guid[i] == expectedGuids[i]);
+
+		Particle particle = store.get(i);
+		CHECK(particle.position == createTestParticle(expectedGuids[i], 0).position);
+		CHECK(particle.age == float(expectedGuids[i]));
+	}
+}
+
+TEST_CASE("ParticleSystem emits, integrates and kills particles")
+{
+	auto node = std::make_shared<Node>(Vector3(1, 2, 3));
+	constexpr float emissionRate = 100;
+	constexpr float lifetime = 1;
+	ParticleSystemPtr particleSystem = createTestParticleSystem(node, emissionRate, lifetime);
+
+	particleSystem->update(0.1f);
+	const ParticleStore& particles = particleSystem->getParticles();
+	REQUIRE(particles.size() == 10);
+
+	std::set<int> guids(particles.guid.begin(), particles.guid.end());
+	CHECK(guids.size() == particles.size());
+
+	particleSystem->update(0.1f);
+	REQUIRE(particles.size() == 20);
+	for (size_t i = 0; i < 10; ++i)
+	{
+		CHECK(particles.age[i] == Approx(0.2f));
+		CHECK(particles.radius[i] == Approx(1.2f));
+		CHECK(particles.temperatureDegreesCelcius[i] < 1000);
+		CHECK(particles.getPosition(i) != Vector3(1, 2, 3));
+	}
+
+	// Run until particles reach steady state between emission and expiry
+	for (int i = 0; i < 20; ++i)
+	{
+		particleSystem->update(0.1f);
+	}
+	CHECK(particles.size() == Approx(emissionRate * lifetime).margin(10));
+	for (float age : particles.age)
+	{
+		CHECK(age <= lifetime);
+	}
+}
+
+TEST_CASE("Particle IDs are unique when allocated concurrently")
+{
+	constexpr int threadCount = 4;
+	constexpr int allocationsPerThread = 1000;
+	std::vector<std::vector<int>> ids(threadCount);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&ids, t] {
+			for (int i = 0; i < allocationsPerThread; ++i)
+			{
+				ids[t].push_back(allocateParticleIds(2));
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::set<int> uniqueIds;
+	for (const auto& threadIds : ids)
+	{
+		for (int id : threadIds)
+		{
+			uniqueIds.insert(id);
+			uniqueIds.insert(id + 1);
+		}
+	}
+	CHECK(uniqueIds.size() == threadCount * allocationsPerThread * 2);
+}
+
+static void populateParticleWorld(World& world, int entityCount)
+{
+	for (int i = 0; i < entityCount; ++i)
+	{
+		auto entity = std::make_shared<Entity>(EntityId({1, std::uint32_t(i)}));
+		auto node = std::make_shared<Node>(Vector3(i, 0, 0));
+		entity->addComponent(node);
+		entity->addComponent(std::make_shared<ParticleSystemComponent>(createTestParticleSystem(node, 1000, 1)));
+		world.addEntity(entity);
+	}
+}
+
+static const ParticleStore& getParticles(const Entity& entity)
+{
+	return entity.getFirstComponentRequired<ParticleSystemComponent>()->getParticleSystem()->getParticles();
+}
+
+TEST_CASE("Parallel particle system update produces same result as serial update")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	constexpr int entityCount = 16;
+	World serialWorld;
+	populateParticleWorld(serialWorld, entityCount);
+
+	World parallelWorld;
+	populateParticleWorld(parallelWorld, entityCount);
+
+	auto serialSystem = std::make_shared<EntitySystem>(&serialWorld);
+	auto parallelSystem = std::make_shared<EntitySystem>(&parallelWorld, &scheduler);
+	CHECK(parallelSystem->isParallelParticleUpdateEnabled());
+
+	SimStepper serialStepper(std::make_shared<SystemRegistry>(SystemRegistry({serialSystem})));
+	SimStepper parallelStepper(std::make_shared<SystemRegistry>(SystemRegistry({parallelSystem})));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		serialStepper.update(0.1);
+		parallelStepper.update(0.1);
+	}
+
+	for (int i = 0; i < entityCount; ++i)
+	{
+		const ParticleStore& serialParticles = getParticles(*serialWorld.getEntities()[i]);
+		const ParticleStore& parallelParticles = getParticles(*parallelWorld.getEntities()[i]);
+		REQUIRE(serialParticles.size() > 0);
+		REQUIRE(serialParticles.size() == parallelParticles.size());
+		CHECK(serialParticles.positionX == parallelParticles.positionX);
+		CHECK(serialParticles.velocityZ == parallelParticles.velocityZ);
+		CHECK(serialParticles.alpha == parallelParticles.alpha);
+	}
+}
+
+TEST_CASE("Benchmark ParticleSystem update with 100k particles", "[.benchmark]")
+{
+	auto node = std::make_shared<Node>();
+	constexpr float lifetime = 10;
+	constexpr float particleCount = 100000;
+	constexpr float dt = 1.0f / 60.0f;
+	ParticleSystemPtr particleSystem = createTestParticleSystem(node, particleCount / lifetime, lifetime);
+
+	// Warm up to steady state
+	for (int i = 0; i < int(lifetime / dt) + 1; ++i)
+	{
+		particleSystem->update(dt);
+	}
+	REQUIRE(particleSystem->getParticles().size() == Approx(particleCount).epsilon(0.01));
+
+	BENCHMARK("Update 100k particles")
+	{
+		particleSystem->update(dt);
+		return particleSystem->getParticles().size();
+	};
+}
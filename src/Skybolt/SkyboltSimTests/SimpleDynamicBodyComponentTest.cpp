@@ -7,7 +7,9 @@
 
 #include <SkyboltSim/Components/Motion.h>
 #include <SkyboltSim/Components/Node.h>
+#include <SkyboltSim/Components/SimpleDynamicBodyBatch.h>
 #include <SkyboltSim/Components/SimpleDynamicBodyComponent.h>
+#include <SkyboltSim/World.h>
 #include <SkyboltSim/SimMath.h>
 #include <catch2/catch.hpp>
 
@@ -107,4 +109,75 @@ TEST_CASE("Force at distance produces torque")
 	CHECK(euler.x == Approx(theta).epsilon(0.01));
 	CHECK(euler.y == Approx(0).epsilon(1e-8f));
 	CHECK(euler.z == Approx(0).epsilon(1e-8f));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Batched gravity and integration produces identical results to per-body path")
+{
+	constexpr int bodyCount = 100;
+	constexpr SecondsD dt = 1.0 / 60.0;
+	World world;
+
+	struct Body
+	{
+		Body(double mass, const Vector3& position, const Vector3& velocity) :
+			node(position),
+			body(&node, &motion, mass, Vector3(2, 3, 4))
+		{
+			motion.linearVelocity = velocity;
+		}
+
+		Node node;
+		Motion motion;
+		SimpleDynamicBodyComponent body;
+	};
+
+	std::vector<std::unique_ptr<Body>> referenceBodies;
+	std::vector<std::unique_ptr<Body>> batchedBodies;
+	for (int i = 0; i < bodyCount; ++i)
+	{
+		double mass = (i == 0) ? 0.0 : 10.0 + i; // Include a massless body, which should not move
+		Vector3 position(6371000.0 + i * 1.1, i * 13.7, -i * 7.3);
+		Vector3 velocity(i * 0.3, 250.0 - i, i * 0.01);
+		referenceBodies.push_back(std::make_unique<Body>(mass, position, velocity));
+		batchedBodies.push_back(std::make_unique<Body>(mass, position, velocity));
+	}
+
+	SimpleDynamicBodyBatch batch;
+	for (const auto& b : batchedBodies)
+	{
+		batch.addBody(&b->body);
+	}
+
+	for (int step = 0; step < 100; ++step)
+	{
+		// Reference path, as performed by EntitySystem for each entity
+		for (const auto& b : referenceBodies)
+		{
+			b->body.applyCentralForce(world.calcGravity(b->node.getPosition(), b->body.getMass()));
+			b->body.applyForce(Vector3(1, 2, 3), Vector3(0.1, 0.2, 0.3));
+			b->body.advanceSimTime(0, dt);
+			b->body.update(UpdateStage::DynamicsSubStep);
+		}
+
+		// Batched path
+		batch.applyGravity();
+		for (const auto& b : batchedBodies)
+		{
+			b->body.applyForce(Vector3(1, 2, 3), Vector3(0.1, 0.2, 0.3));
+			b->body.advanceSimTime(0, dt);
+		}
+		batch.integrate();
+		for (const auto& b : batchedBodies)
+		{
+			b->body.update(UpdateStage::DynamicsSubStep);
+		}
+	}
+
+	for (int i = 0; i < bodyCount; ++i)
+	{
+		CHECK(referenceBodies[i]->node.getPosition() == batchedBodies[i]->node.getPosition());
+		CHECK(referenceBodies[i]->node.getOrientation() == batchedBodies[i]->node.getOrientation());
+		CHECK(referenceBodies[i]->motion.linearVelocity == batchedBodies[i]->motion.linearVelocity);
+		CHECK(referenceBodies[i]->motion.angularVelocity == batchedBodies[i]->motion.angularVelocity);
+	}
+}
@@ -0,0 +1,169 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/NameComponent.h>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+static EntityPtr createNamedEntity(std::uint32_t id, const std::string& name)
+{
+	auto entity = std::make_shared<Entity>(EntityId({1, id}));
+	entity->addComponent(std::make_shared<NameComponent>(name));
+	return entity;
+}
+
+TEST_CASE("World finds entities by id and name")
+{
+	World world;
+	auto a = createNamedEntity(1, "a");
+	auto b = createNamedEntity(2, "b");
+	world.addEntity(a);
+	world.addEntity(b);
+
+	CHECK(world.getEntityById(EntityId({1, 1})) == a);
+	CHECK(world.getEntityById(EntityId({1, 2})) == b);
+	CHECK(world.getEntityById(EntityId({1, 3})) == nullptr);
+	CHECK(world.findObjectByName("a") == a);
+	CHECK(world.findObjectByName("b") == b);
+	CHECK(world.findObjectByName("c") == nullptr);
+
+	world.removeEntity(a.get());
+	CHECK(world.getEntityById(EntityId({1, 1})) == nullptr);
+	CHECK(world.findObjectByName("a") == nullptr);
+	CHECK(world.getEntityById(EntityId({1, 2})) == b);
+	CHECK(world.findObjectByName("b") == b);
+	REQUIRE(world.getEntities().size() == 1);
+	CHECK(world.getEntities()[0] == b);
+}
+
+TEST_CASE("World entity handle becomes stale when entity is removed")
+{
+	World world;
+	auto a = createNamedEntity(1, "a");
+	world.addEntity(a);
+
+	EntityHandle handle = world.getEntityHandle(a->getId());
+	CHECK(world.getEntityByHandle(handle) == a);
+	CHECK(world.getEntityByHandle(EntityHandle()) == nullptr);
+
+	world.removeEntity(a.get());
+	CHECK(world.getEntityHandle(a->getId()) == EntityHandle());
+	CHECK(world.getEntityByHandle(handle) == nullptr);
+
+	// New entity reuses the slot but the old handle remains stale
+	auto b = createNamedEntity(2, "b");
+	world.addEntity(b);
+	EntityHandle handleB = world.getEntityHandle(b->getId());
+	CHECK(handleB.slot == handle.slot);
+	CHECK(world.getEntityByHandle(handle) == nullptr);
+	CHECK(world.getEntityByHandle(handleB) == b);
+}
+
+TEST_CASE("World handles remain valid after other entities are removed")
+{
+	World world;
+	std::vector<EntityPtr> entities;
+	for (std::uint32_t i = 1; i <= 10; ++i)
+	{
+		entities.push_back(createNamedEntity(i, std::to_string(i)));
+		world.addEntity(entities.back());
+	}
+
+	std::vector<EntityHandle> handles;
+	for (const EntityPtr& entity : entities)
+	{
+		handles.push_back(world.getEntityHandle(entity->getId()));
+	}
+
+	world.removeEntity(entities[0].get());
+	world.removeEntity(entities[5].get());
+
+	for (size_t i = 0; i < entities.size(); ++i)
+	{
+		bool removed = (i == 0 || i == 5);
+		CHECK(world.getEntityByHandle(handles[i]) == (removed ? nullptr : entities[i]));
+		CHECK(world.getEntityById(entities[i]->getId()) == (removed ? nullptr : entities[i]));
+	}
+	CHECK(world.getEntities().size() == 8);
+
+	world.removeAllEntities();
+	CHECK(world.getEntities().empty());
+}
+
+//! Looks up another entity in the world when destroyed
+class WorldLookupOnDestroyComponent : public Component
+{
+public:
+	WorldLookupOnDestroyComponent(const World* world, EntityId otherEntityId, int* lookupsWhichFoundEntity) :
+		mWorld(world), mOtherEntityId(otherEntityId), mLookupsWhichFoundEntity(lookupsWhichFoundEntity) {}
+
+	~WorldLookupOnDestroyComponent() override
+	{
+		*mLookupsWhichFoundEntity += (mWorld->getEntityById(mOtherEntityId) != nullptr);
+		*mLookupsWhichFoundEntity += (mWorld->getEntityByHandle(mWorld->getEntityHandle(mOtherEntityId)) != nullptr);
+		*mLookupsWhichFoundEntity += (mWorld->findObjectByName("a") != nullptr);
+	}
+
+private:
+	const World* mWorld;
+	EntityId mOtherEntityId;
+	int* mLookupsWhichFoundEntity;
+};
+
+TEST_CASE("World lookups from entities destroyed with the world find nothing")
+{
+	int lookupsWhichFoundEntity = 0;
+	{
+		World world;
+		for (std::uint32_t i = 1; i <= 10; ++i)
+		{
+			auto entity = createNamedEntity(i, i == 1 ? "a" : std::to_string(i));
+			EntityId otherEntityId{1, (i % 10) + 1};
+			entity->addComponent(std::make_shared<WorldLookupOnDestroyComponent>(&world, otherEntityId, &lookupsWhichFoundEntity));
+			world.addEntity(entity);
+		}
+	}
+	CHECK(lookupsWhichFoundEntity == 0);
+}
+
+TEST_CASE("Benchmark World spawn and despawn 50k entities", "[.benchmark]")
+{
+	constexpr std::uint32_t entityCount = 50000;
+
+	std::vector<EntityPtr> entities;
+	for (std::uint32_t i = 1; i <= entityCount; ++i)
+	{
+		entities.push_back(createNamedEntity(i, "entity" + std::to_string(i)));
+	}
+
+	BENCHMARK("Add then removeAllEntities")
+	{
+		World world;
+		for (const EntityPtr& entity : entities)
+		{
+			world.addEntity(entity);
+		}
+		world.removeAllEntities();
+	};
+
+	BENCHMARK("Add then remove in insertion order")
+	{
+		World world;
+		for (const EntityPtr& entity : entities)
+		{
+			world.addEntity(entity);
+		}
+		for (const EntityPtr& entity : entities)
+		{
+			world.removeEntity(entity.get());
+		}
+	};
+}
@@ -5,11 +5,13 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "TilePlanetAltitudeProvider.h"
-#include "HeightMapElevationProvider.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/TileSource.h"
 #include "SkyboltVis/OsgBox2.h"
 #include "SkyboltVis/GeoImageHelpers.h"
 #include <SkyboltSim/Spatial/GreatCircle.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <algorithm>
 
 namespace skybolt {
 namespace vis {
@@ -19,60 +21,106 @@ static vis::Box2f toBox2f(const BlockingTilePlanetAltitudeProvider::LatLonBounds
 	return vis::Box2f(osg::Vec2f(b.minimum.x(), b.minimum.y()), osg::Vec2f(b.maximum.x(), b.maximum.y()));
 }
 
+BlockingTilePlanetAltitudeProvider::TileIndexEntry::TileIndexEntry(const TileImage& tile) :
+	tile(tile),
+	elevationProvider(tile.image, getRequiredHeightMapElevationRerange(*tile.image), toBox2f(getKeyLatLonBounds<LatLonVec2Adapter>(tile.key))),
+	lastUsedTime(0)
+{
+}
+
+double BlockingTilePlanetAltitudeProvider::TileIndexEntry::getAltitude(const sim::LatLon& position) const
+{
+	return elevationProvider.get(position.lat, position.lon);
+}
+
 BlockingTilePlanetAltitudeProvider::BlockingTilePlanetAltitudeProvider(const TileSourcePtr& tileSource, int maxLod) :
 	mTileSource(tileSource),
-	mMaxLod(maxLod),
-	mTileImageCache(1024)
+	mMaxLod(maxLod)
 {
 	assert(mTileSource);
 }
 
 BlockingTilePlanetAltitudeProvider::AltitudeResult BlockingTilePlanetAltitudeProvider::getAltitude(const sim::LatLon& position) const
 {
-	std::optional<TileImage> tile;
 	QuadTreeTileKey highestLodKey = getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(position));
 
-	tile = findTile(highestLodKey);
+	std::optional<double> altitude = mTileIndex.read([&] (const TileIndex& index) -> std::optional<double> {
+		if (const TileIndexEntry* entry = findTile(index, highestLodKey); entry)
+		{
+			return entry->getAltitude(position);
+		}
+		return std::nullopt;
+	});
+
+	if (altitude)
+	{
+		return AltitudeResult::finalValue(*altitude);
+	}
+
+	std::optional<TileImage> tile = loadBestTileAndAddToIndex(highestLodKey);
 	if (!tile)
 	{
-		// Load tile at highest available LOD level
-		for (int lod = mMaxLod; lod >= 0; lod--)
+		return AltitudeResult::provisionalValue(0.0);
+	}
+
+	return AltitudeResult::finalValue(TileIndexEntry(*tile).getAltitude(position));
+}
+
+void BlockingTilePlanetAltitudeProvider::getAltitudes(const sim::LatLon* positions, AltitudeResult* results, std::size_t count) const
+{
+	// Results of positions with missing tiles are marked provisional, so that the results array
+	// records which positions are missing without allocating a separate list
+	bool anyMissing = false;
+	mTileIndex.read([&] (const TileIndex& index) {
+		for (std::size_t i = 0; i < count; ++i)
 		{
-			QuadTreeTileKey key = key = createAncestorKey(highestLodKey, lod);
-			tile = loadTile(key);
-			if (tile)
+			QuadTreeTileKey highestLodKey = getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(positions[i]));
+			if (const TileIndexEntry* entry = findTile(index, highestLodKey); entry)
 			{
-				// Add tile at highest LOD key so we can find it quickly next time from highestLodKey
-				addTileToCache(*tile, highestLodKey);
-				break;
+				results[i] = AltitudeResult::finalValue(entry->getAltitude(positions[i]));
+			}
+			else
+			{
+				results[i] = AltitudeResult::provisionalValue(0.0);
+				anyMissing = true;
 			}
 		}
-	}
+	});
 
-	if (!tile)
+	if (!anyMissing)
 	{
-		return AltitudeResult::provisionalValue(0.0);
+		return;
 	}
 
-	HeightMapElevationRerange rerange = getRequiredHeightMapElevationRerange(*tile->image);
-	vis::HeightMapElevationProvider provider(tile->image, rerange, toBox2f(getKeyLatLonBounds<LatLonVec2Adapter>(tile->key)));
-	return AltitudeResult::finalValue(provider.get(position.lat, position.lon));
+	// Load missing tiles outside of the index read so that the index can be modified
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (results[i].provisional)
+		{
+			results[i] = getAltitude(positions[i]);
+		}
+	}
 }
 
-std::optional<BlockingTilePlanetAltitudeProvider::TileImage> BlockingTilePlanetAltitudeProvider::findTile(const QuadTreeTileKey& key) const
+const BlockingTilePlanetAltitudeProvider::TileIndexEntry* BlockingTilePlanetAltitudeProvider::findTile(const TileIndex& index, const QuadTreeTileKey& key) const
 {
-	TileImage result;
-	std::scoped_lock<std::mutex> lock(mTileImageCacheMutex);
-	if (mTileImageCache.get(key, result))
+	auto i = index.find(key);
+	if (i == index.end())
 	{
-		return result;
+		return nullptr;
 	}
-	return std::nullopt;
+
+	// Only store if changed to avoid writing to memory shared between reader threads
+	std::uint32_t time = mTileIndexTime.load(std::memory_order_relaxed);
+	if (i->second->lastUsedTime.load(std::memory_order_relaxed) != time)
+	{
+		i->second->lastUsedTime.store(time, std::memory_order_relaxed);
+	}
+	return i->second.get();
 }
 
 std::optional<BlockingTilePlanetAltitudeProvider::TileImage> BlockingTilePlanetAltitudeProvider::loadTile(const QuadTreeTileKey& key) const
 {
-	int level = key.level;
 	osg::ref_ptr<osg::Image> image = mTileSource->createImage(key, [] {return false;});
 	if (image)
 	{
@@ -85,65 +133,231 @@ std::optional<BlockingTilePlanetAltitudeProvider::TileImage> BlockingTilePlanetA
 	return std::nullopt;
 }
 
+std::optional<BlockingTilePlanetAltitudeProvider::TileImage> BlockingTilePlanetAltitudeProvider::loadBestTileAndAddToIndex(const QuadTreeTileKey& highestLodKey) const
+{
+	// Load tile at highest available LOD level
+	for (int lod = highestLodKey.level; lod >= 0; lod--)
+	{
+		QuadTreeTileKey key = createAncestorKey(highestLodKey, lod);
+		if (std::optional<TileImage> tile = loadTile(key); tile)
+		{
+			// Add tile at highest LOD key so we can find it quickly next time from highestLodKey
+			addTileToIndex(*tile, highestLodKey);
+			return tile;
+		}
+	}
+	return std::nullopt;
+}
 
-void BlockingTilePlanetAltitudeProvider::addTileToCache(const TileImage& image, const QuadTreeTileKey& key) const
+void BlockingTilePlanetAltitudeProvider::addTileToIndex(const TileImage& image, const QuadTreeTileKey& key) const
 {
-	std::scoped_lock<std::mutex> lock(mTileImageCacheMutex);
-	mTileImageCache.putSafe(key, image);
+	auto entry = std::make_shared<TileIndexEntry>(image);
+	entry->lastUsedTime = ++mTileIndexTime;
+
+	// The writer is called once for each copy of the index, so choose entries to evict on the first call and reuse the choice on the second
+	std::optional<std::vector<QuadTreeTileKey>> evictedKeys;
+	mTileIndex.modify([&] (TileIndex& index) {
+		if (!index.emplace(key, entry).second)
+		{
+			return;
+		}
+
+		if (!evictedKeys)
+		{
+			evictedKeys.emplace();
+			if (index.size() > maxTileIndexSize)
+			{
+				// Evict the least recently used eighth of the index at once so that eviction is infrequent
+				std::vector<std::pair<std::uint32_t, QuadTreeTileKey>> entries;
+				entries.reserve(index.size());
+				for (const auto& [indexKey, indexEntry] : index)
+				{
+					entries.emplace_back(indexEntry->lastUsedTime.load(std::memory_order_relaxed), indexKey);
+				}
+
+				std::size_t evictionCount = index.size() - maxTileIndexSize * 7 / 8;
+				std::nth_element(entries.begin(), entries.begin() + evictionCount, entries.end());
+				for (std::size_t i = 0; i < evictionCount; ++i)
+				{
+					evictedKeys->push_back(entries[i].second);
+				}
+			}
+		}
+
+		for (const QuadTreeTileKey& evictedKey : *evictedKeys)
+		{
+			index.erase(evictedKey);
+		}
+	});
 }
 
-NonBlockingTilePlanetAltitudeProvider::NonBlockingTilePlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod) :
+NonBlockingTilePlanetAltitudeProvider::NonBlockingTilePlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod, int maxConcurrentLoads) :
 	BlockingTilePlanetAltitudeProvider(tileSource, maxLod),
-	mScheduler(scheduler)
+	mScheduler(scheduler),
+	mMaxConcurrentLoads(maxConcurrentLoads)
 {
 	assert(mScheduler);
 	assert(mTileSource);
+	assert(mMaxConcurrentLoads > 0);
+}
+
+NonBlockingTilePlanetAltitudeProvider::~NonBlockingTilePlanetAltitudeProvider()
+{
+	std::scoped_lock<std::mutex> lock(mLoadingTaskSyncMutex);
+	mScheduler->waitFor(mLoadingTaskSync);
 }
 
 BlockingTilePlanetAltitudeProvider::AltitudeResult NonBlockingTilePlanetAltitudeProvider::getAltitude(const sim::LatLon& position) const
 {
-	std::optional<TileImage> highestLodTile;
-	for (int lod = 0; lod <= mMaxLod; lod++)
+	std::optional<QuadTreeTileKey> keyToLoad;
+	AltitudeResult result = mTileIndex.read([&] (const TileIndex& index) {
+		return getAltitudeFromIndex(index, position, keyToLoad);
+	});
+
+	if (keyToLoad)
+	{
+		requestLoadTileAndAddToIndex(*keyToLoad, LoadType::ExactLevel);
+	}
+	return result;
+}
+
+void NonBlockingTilePlanetAltitudeProvider::getAltitudes(const sim::LatLon* positions, AltitudeResult* results, std::size_t count) const
+{
+	std::vector<QuadTreeTileKey> keysToLoad;
+	mTileIndex.read([&] (const TileIndex& index) {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			std::optional<QuadTreeTileKey> keyToLoad;
+			results[i] = getAltitudeFromIndex(index, positions[i], keyToLoad);
+			if (keyToLoad)
+			{
+				keysToLoad.push_back(*keyToLoad);
+			}
+		}
+	});
+
+	for (const QuadTreeTileKey& key : keysToLoad)
+	{
+		if (!requestLoadTileAndAddToIndex(key, LoadType::ExactLevel))
+		{
+			break;
+		}
+	}
+}
+
+void NonBlockingTilePlanetAltitudeProvider::prefetchAltitudes(const sim::LatLon& start, const sim::LatLon& end) const
+{
+	// Sample the track at half the highest LOD tile size so that no tiles along the track are skipped
+	constexpr int maxSampleCount = 256;
+	double sampleSpacing = 0.5 * math::piD() / double(1 << mMaxLod);
+	double deltaLat = end.lat - start.lat;
+	double deltaLon = math::calcSmallestAngleFromTo(start.lon, end.lon);
+	int sampleCount = std::min(maxSampleCount, int(std::ceil(std::max(std::abs(deltaLat), std::abs(deltaLon)) / sampleSpacing)) + 1);
+
+	std::vector<QuadTreeTileKey> keys;
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		double t = (sampleCount > 1) ? double(i) / double(sampleCount - 1) : 0.0;
+		sim::LatLon position(start.lat + deltaLat * t, math::fmodNeg(start.lon + deltaLon * t + math::piD(), math::twoPiD()) - math::piD());
+		QuadTreeTileKey key = getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(position));
+		if (keys.empty() || !(keys.back() == key))
+		{
+			keys.push_back(key);
+		}
+	}
+
+	// Skip tiles which are already loaded
+	mTileIndex.read([&] (const TileIndex& index) {
+		keys.erase(std::remove_if(keys.begin(), keys.end(), [&] (const QuadTreeTileKey& key) {
+			return findTile(index, key) != nullptr;
+		}), keys.end());
+	});
+
+	// Keys are ordered from start to end, so the nearest tiles are requested first
+	for (const QuadTreeTileKey& key : keys)
+	{
+		if (!requestLoadTileAndAddToIndex(key, LoadType::BestAvailable))
+		{
+			break;
+		}
+	}
+}
+
+int NonBlockingTilePlanetAltitudeProvider::getLoadingTileCount() const
+{
+	std::scoped_lock<std::mutex> lock(mLoadingKeysMutex);
+	return int(mLoadingKeys.size());
+}
+
+BlockingTilePlanetAltitudeProvider::AltitudeResult NonBlockingTilePlanetAltitudeProvider::getAltitudeFromIndex(const TileIndex& index, const sim::LatLon& position, std::optional<QuadTreeTileKey>& keyToLoad) const
+{
+	// Fast path for when the best available tile has already been loaded
+	QuadTreeTileKey highestLodKey = getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(position));
+	if (const TileIndexEntry* tile = findTile(index, highestLodKey); tile)
+	{
+		return AltitudeResult::finalValue(tile->getAltitude(position));
+	}
+
+	const TileIndexEntry* highestLodTile = nullptr;
+	for (int lod = 0; lod < mMaxLod; lod++)
 	{
 		QuadTreeTileKey key = getKeyAtLevelIntersectingLonLatPoint(lod, LatLonVec2Adapter(position));
-		std::optional<TileImage> tile = findTile(key);
-		if (tile)
+		if (const TileIndexEntry* tile = findTile(index, key); tile)
 		{
 			highestLodTile = tile;
 		}
 		else
 		{
-			requestLoadTileAndAddToCache(key);
+			keyToLoad = key;
 			break;
 		}
 	}
 
+	if (!keyToLoad)
+	{
+		// All lower LOD tiles are loaded, so load the highest LOD tile next
+		keyToLoad = highestLodKey;
+	}
+
 	if (!highestLodTile)
 	{
 		return AltitudeResult::provisionalValue(0.0);
 	}
 
-	HeightMapElevationRerange rerange = getRequiredHeightMapElevationRerange(*highestLodTile->image);
-	vis::HeightMapElevationProvider provider(highestLodTile->image, rerange, toBox2f(getKeyLatLonBounds<LatLonVec2Adapter>(highestLodTile->key)));
-
-	AltitudeResult result;
-	result.altitude = provider.get(position.lat, position.lon);
-	result.provisional = (highestLodTile->key.level < mMaxLod);
-	return result;
+	return AltitudeResult::provisionalValue(highestLodTile->getAltitude(position));
 }
 
-void NonBlockingTilePlanetAltitudeProvider::requestLoadTileAndAddToCache(const QuadTreeTileKey& key) const
+bool NonBlockingTilePlanetAltitudeProvider::requestLoadTileAndAddToIndex(const QuadTreeTileKey& key, LoadType type) const
 {
-	if (mScheduler->hasFinished(mLoadingTaskSync))
 	{
-		mScheduler->run([=]() {
-			if (std::optional<TileImage> image = loadTile(key); image)
-			{
-				addTileToCache(*image, key);
-			}
-		}, &mLoadingTaskSync);
+		std::scoped_lock<std::mutex> lock(mLoadingKeysMutex);
+		if (mLoadingKeys.find(key) != mLoadingKeys.end())
+		{
+			return true;
+		}
+		if (int(mLoadingKeys.size()) >= mMaxConcurrentLoads)
+		{
+			return false;
+		}
+		mLoadingKeys.insert(key);
 	}
+
+	std::scoped_lock<std::mutex> lock(mLoadingTaskSyncMutex);
+	mScheduler->run([=]() {
+		if (type == LoadType::BestAvailable)
+		{
+			loadBestTileAndAddToIndex(key);
+		}
+		else if (std::optional<TileImage> image = loadTile(key); image)
+		{
+			addTileToIndex(*image, key);
+		}
+
+		std::scoped_lock<std::mutex> lock(mLoadingKeysMutex);
+		mLoadingKeys.erase(key);
+	}, &mLoadingTaskSync);
+	return true;
 }
 
 } // namespace vis
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
@@ -6,15 +6,20 @@
 
 #pragma once
 
+#include "HeightMapElevationProvider.h"
 #include "SkyboltVis/SkyboltVisFwd.h"
 #include <SkyboltSim/PlanetAltitudeProvider.h>
-#include <SkyboltCommon/LruCacheMap.h>
-#include <SkyboltCommon/LruCacheSet.h>
+#include <SkyboltCommon/LeftRight.h>
 #include <SkyboltCommon/Math/QuadTree.h>
 
 #include <osg/Image>
 #include <px_sched/px_sched.h>
+#include <atomic>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace skybolt {
 namespace vis {
@@ -73,7 +78,8 @@ struct LatLonVec2Adapter : public sim::LatLon
 	}
 };
 
-//! Blocks until tile at maxLod is is loaded, then returns result
+//! Blocks until tile at maxLod is is loaded, then returns result.
+//! Loaded tiles are kept in an index which is read without locking, so concurrent queries of loaded tiles do not contend.
 class BlockingTilePlanetAltitudeProvider : public sim::PlanetAltitudeProvider
 {
 public:
@@ -82,6 +88,9 @@ public:
 	//! @ThreadSafe
 	AltitudeResult getAltitude(const sim::LatLon& position) const override;
 
+	//! @ThreadSafe
+	void getAltitudes(const sim::LatLon* positions, AltitudeResult* results, std::size_t count) const override;
+
 	typedef skybolt::Box2T<LatLonVec2Adapter> LatLonBounds;
 
 protected:
@@ -91,35 +100,86 @@ protected:
 		osg::ref_ptr<osg::Image> image;
 	};
 
-	std::optional<TileImage> findTile(const QuadTreeTileKey& key) const;
+	struct TileIndexEntry
+	{
+		TileIndexEntry(const TileImage& tile);
+
+		double getAltitude(const sim::LatLon& position) const;
+
+		const TileImage tile;
+		const HeightMapElevationProvider elevationProvider;
+		mutable std::atomic<std::uint32_t> lastUsedTime; //!< Value of mTileIndexTime when the entry was last used
+	};
+
+	//! Maps a tile key to the tile image, which may be at a lower LOD than the key if no higher LOD image is available
+	using TileIndex = std::unordered_map<QuadTreeTileKey, std::shared_ptr<const TileIndexEntry>>;
+
+	//! Must only be called from within a mTileIndex read
+	//! @returns null if not found
+	const TileIndexEntry* findTile(const TileIndex& index, const QuadTreeTileKey& key) const;
 
 	std::optional<TileImage> loadTile(const QuadTreeTileKey& key) const;
 
-	void addTileToCache(const TileImage& image, const QuadTreeTileKey& key) const;
+	//! Loads the tile at the highest available LOD in the given key's ancestral hierarchy, and adds it to the index under the given key
+	std::optional<TileImage> loadBestTileAndAddToIndex(const QuadTreeTileKey& highestLodKey) const;
+
+	void addTileToIndex(const TileImage& image, const QuadTreeTileKey& key) const;
 
 protected:
 	const TileSourcePtr mTileSource;
 	const int mMaxLod;
 
-	mutable LruCacheMap<QuadTreeTileKey, TileImage> mTileImageCache;
-	mutable std::mutex mTileImageCacheMutex;
+	static constexpr std::size_t maxTileIndexSize = 1024;
+	mutable LeftRight<TileIndex> mTileIndex;
+	mutable std::atomic<std::uint32_t> mTileIndexTime = 0; //!< Incremented each time a tile is added to the index
 };
 
-//! Immediately returns result from an already loaded tile at the highest available LOD, and schedules a background task to load higher LOD levels if requred
+//! Immediately returns result from an already loaded tile at the highest available LOD, and schedules a background task to load higher LOD levels if requred.
+//! Multiple tiles may be loaded concurrently, and each tile is only loaded once at a time.
 class NonBlockingTilePlanetAltitudeProvider : public BlockingTilePlanetAltitudeProvider
 {
 public:
-	NonBlockingTilePlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod);
+	//! @param maxConcurrentLoads is the maximum number of tiles loading at once. Further load requests are ignored until loads finish.
+	NonBlockingTilePlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod, int maxConcurrentLoads = 8);
+
+	//! Waits for in progress loads to finish
+	~NonBlockingTilePlanetAltitudeProvider() override;
 
 	//! @ThreadSafe
 	AltitudeResult getAltitude(const sim::LatLon& position) const override;
 
+	//! @ThreadSafe
+	void getAltitudes(const sim::LatLon* positions, AltitudeResult* results, std::size_t count) const override;
+
+	//! Loads highest LOD tiles along the track, so that final altitudes are available when the track is later queried.
+	//! @ThreadSafe
+	void prefetchAltitudes(const sim::LatLon& start, const sim::LatLon& end) const override;
+
+	//! @returns number of tile loads in progress
+	int getLoadingTileCount() const;
+
 protected:
-	void requestLoadTileAndAddToCache(const QuadTreeTileKey& key) const;
+	//! Must only be called from within a mTileIndex read
+	//! @param keyToLoad is set to the key of the next tile to load if a higher LOD tile is required
+	AltitudeResult getAltitudeFromIndex(const TileIndex& index, const sim::LatLon& position, std::optional<QuadTreeTileKey>& keyToLoad) const;
+
+	enum class LoadType
+	{
+		ExactLevel, //!< Load the tile at the key's level
+		BestAvailable //!< Load the tile at the highest available level in the key's ancestral hierarchy
+	};
+
+	//! @returns false if the load was not requested because the maximum number of loads are already in progress
+	bool requestLoadTileAndAddToIndex(const QuadTreeTileKey& key, LoadType type) const;
 
 protected:
+	mutable std::mutex mLoadingTaskSyncMutex; //!< Serializes use of mLoadingTaskSync, which is not thread safe
 	mutable px_sched::Sync mLoadingTaskSync;
 	px_sched::Scheduler* mScheduler;
+	const int mMaxConcurrentLoads;
+
+	mutable std::mutex mLoadingKeysMutex;
+	mutable std::unordered_set<QuadTreeTileKey> mLoadingKeys;
 };
 
 } // namespace vis
@@ -6,11 +6,23 @@
 
 #include "CloudNoiseTextureGenerator.h"
 #include "SkyboltVis/Renderable/Clouds/ThirdParty/TileableVolumeNoise.h"
+#include <SkyboltCommon/ParallelFor.h>
+#include <SkyboltCommon/ShaUtility.h>
 
+#include <boost/log/trivial.hpp>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <memory>
+#include <sstream>
+#include <vector>
 #include <glm/glm.hpp>
 
+namespace fs = std::filesystem;
+
 namespace skybolt {
 namespace vis {
 
@@ -44,29 +56,6 @@ static void fillTexture2d(osg::Image& image, ColorAtPositionGetter2d getter, int
 	}
 }
 
-typedef std::function<glm::vec4(const glm::vec3&)> ColorAtPositionGetter3d;
-static void fillTexture3d(osg::Image& image, ColorAtPositionGetter3d getter, int channelCount = 1)
-{
-	unsigned char* p = image.data();
-
-	for (int z = 0; z < image.r(); ++z)
-	{
-		for (int y = 0; y < image.t(); ++y)
-		{
-			for (int x = 0; x < image.s(); ++x)
-			{
-				glm::vec3 pos = glm::vec3(x, y, z) / float(image.s());
-
-				glm::vec4 c = getter(pos);
-				for (int i = 0; i < channelCount; ++i)
-				{
-					*p++ = luminanceToUnsignedByte(c[i]);
-				}
-			}
-		}
-	}
-}
-
 float createWorleyFbm(const glm::vec3& pos, const FbmConfig& config)
 {
 	float worleyNoise = 0;
@@ -114,19 +103,279 @@ osg::ref_ptr<osg::Image> createPerlinWorleyTexture2d(const PerlinWorleyConfig& c
 	return image;
 }
 
-osg::ref_ptr<osg::Image> createPerlinWorleyTexture3d(const PerlinWorleyConfig& config)
+namespace {
+
+//! Worley noise with an integer number of cells, which evaluates the same values as Tileable3dNoise::WorleyNoise.
+//! Tileable3dNoise evaluates value noise at each cell's wrapped integer coordinate to find the cell's feature point offset.
+//! Value noise at integer coordinates is just the hash of the cell, so the offsets are precalculated in a table,
+//! and the kernel processes a row of voxels at a time with flat loops that the compiler can vectorize.
+class WorleyCellTable
+{
+public:
+	WorleyCellTable(int cellCount) :
+		mCellCount(cellCount),
+		mOffsets(std::size_t(cellCount) * cellCount * cellCount)
+	{
+		for (int z = 0; z < cellCount; ++z)
+		{
+			for (int y = 0; y < cellCount; ++y)
+			{
+				for (int x = 0; x < cellCount; ++x)
+				{
+					float n = float(x) + float(y) * 57.0f + 113.0f * float(z);
+					mOffsets[(z * cellCount + y) * cellCount + x] = glm::fract(std::sin(n + 1.951f) * 43758.5453f);
+				}
+			}
+		}
+	}
+
+	//! Calculates noise for voxels (x, y, z) / width, for x in range [0, width)
+	//! @param result receives the noise for each voxel in the row
+	//! @param cellX and positionX are scratch buffers of the row width
+	void calcRow(int width, int y, int z, float* __restrict result, int* __restrict cellX, float* __restrict positionX) const
+	{
+		const float cellCount = float(mCellCount);
+		const float widthF = float(width);
+
+		for (int x = 0; x < width; ++x)
+		{
+			positionX[x] = (float(x) / widthF) * cellCount;
+			cellX[x] = int(std::floor(positionX[x]));
+			result[x] = 1.0e10f;
+		}
+
+		const float positionY = (float(y) / widthF) * cellCount;
+		const float positionZ = (float(z) / widthF) * cellCount;
+		const float cellY = std::floor(positionY);
+		const float cellZ = std::floor(positionZ);
+
+		for (int zo = -1; zo <= 1; ++zo)
+		{
+			const float tz = cellZ + float(zo);
+			const int wrappedZ = wrap(int(tz));
+			for (int yo = -1; yo <= 1; ++yo)
+			{
+				const float ty = cellY + float(yo);
+				const float* offsetsRow = mOffsets.data() + (wrappedZ * mCellCount + wrap(int(ty))) * mCellCount;
+				const float dy = positionY - ty;
+				const float dz = positionZ - tz;
+
+				for (int xo = -1; xo <= 1; ++xo)
+				{
+					for (int x = 0; x < width; ++x)
+					{
+						int tx = cellX[x] + xo;
+						float offset = offsetsRow[wrap(tx)];
+						float ox = positionX[x] - float(tx) - offset;
+						float oy = dy - offset;
+						float oz = dz - offset;
+						result[x] = std::min(result[x], ox * ox + oy * oy + oz * oz);
+					}
+				}
+			}
+		}
+
+		for (int x = 0; x < width; ++x)
+		{
+			result[x] = std::max(std::min(result[x], 1.0f), 0.0f);
+		}
+	}
+
+private:
+	//! Wraps cell coordinate in range [-1, cellCount] to range [0, cellCount)
+	int wrap(int i) const
+	{
+		return (i < 0) ? i + mCellCount : ((i >= mCellCount) ? i - mCellCount : i);
+	}
+
+private:
+	const int mCellCount;
+	std::vector<float> mOffsets;
+};
+
+bool isInteger(float v)
+{
+	return v == std::floor(v);
+}
+
+} // namespace
+
+osg::ref_ptr<osg::Image> createPerlinWorleyTexture3d(const PerlinWorleyConfig& config, px_sched::Scheduler* scheduler)
 {
 	osg::Image* image = new osg::Image;
 	image->allocateImage(config.width, config.width, config.width, GL_LUMINANCE, GL_UNSIGNED_BYTE);
 
-	fillTexture3d(*image, [=](const glm::vec3& pos) {
-		float c = 1.0 - createWorleyFbm(pos, config.worley);
-		//float c = createPerlinWorley(pos, config); // Use to modulate output by perlin
-		return glm::vec4(c, c, c, 1.0);
+	const int width = config.width;
+	const FbmConfig& fbm = config.worley;
+
+	// Create a cell table for each octave. Octaves with a fractional cell count use the reference implementation.
+	std::vector<std::unique_ptr<WorleyCellTable>> cellTables;
+	{
+		float frequency = fbm.frequency;
+		for (int i = 0; i < fbm.octaveCount; ++i)
+		{
+			cellTables.push_back(isInteger(frequency) ? std::make_unique<WorleyCellTable>(int(frequency)) : nullptr);
+			frequency *= fbm.lacunarity;
+		}
+	}
+
+	// Generate slabs of z slices in parallel
+	parallelFor(scheduler, width, 1, [&] (std::size_t beginZ, std::size_t endZ) {
+		std::vector<float> worleyNoise(width);
+		std::vector<float> octaveNoise(width);
+		std::vector<int> cellX(width);
+		std::vector<float> positionX(width);
+
+		for (int z = int(beginZ); z < int(endZ); ++z)
+		{
+			for (int y = 0; y < width; ++y)
+			{
+				std::fill(worleyNoise.begin(), worleyNoise.end(), 0.0f);
+
+				float frequency = fbm.frequency;
+				float amplitude = fbm.amplitude;
+				for (int i = 0; i < fbm.octaveCount; ++i)
+				{
+					if (cellTables[i])
+					{
+						cellTables[i]->calcRow(width, y, z, octaveNoise.data(), cellX.data(), positionX.data());
+					}
+					else
+					{
+						for (int x = 0; x < width; ++x)
+						{
+							octaveNoise[x] = Tileable3dNoise::WorleyNoise(glm::vec3(x, y, z) / float(width), frequency);
+						}
+					}
+
+					for (int x = 0; x < width; ++x)
+					{
+						worleyNoise[x] += amplitude * (1.0 - octaveNoise[x]);
+					}
+					frequency *= fbm.lacunarity;
+					amplitude *= fbm.gain;
+				}
+
+				unsigned char* p = image->data(0, y, z);
+				for (int x = 0; x < width; ++x)
+				{
+					float noise = worleyNoise[x] - 0.2f;
+					if (fbm.invert)
+					{
+						noise = 1.0f - noise;
+					}
+					float c = 1.0 - glm::clamp(noise, 0.0f, 1.0f);
+					p[x] = luminanceToUnsignedByte(c);
+				}
+			}
+		}
 	});
 
 	return image;
 }
 
+std::string calcPerlinWorleyConfigHash(const PerlinWorleyConfig& config)
+{
+	std::ostringstream ss;
+	ss.precision(9);
+	ss << "PerlinWorley3d"
+		<< " " << config.width
+		<< " " << config.perlinOctaves
+		<< " " << config.perlinFrequency
+		<< " " << config.worley.frequency
+		<< " " << config.worley.amplitude
+		<< " " << config.worley.octaveCount
+		<< " " << config.worley.lacunarity
+		<< " " << config.worley.gain
+		<< " " << config.worley.invert;
+	return calcSha1(ss.str());
+}
+
+struct CachedNoiseTextureHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t depth;
+};
+
+static const std::uint32_t cachedNoiseTextureMagic = 0x53494f4e; // "NOIS"
+static const std::uint32_t cachedNoiseTextureVersion = 1;
+
+static osg::ref_ptr<osg::Image> readCachedNoiseTexture(const std::string& filename, int expectedWidth)
+{
+	std::ifstream f(filename, std::ios::binary);
+	if (!f)
+	{
+		return nullptr;
+	}
+
+	CachedNoiseTextureHeader header;
+	f.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!f || header.magic != cachedNoiseTextureMagic || header.version != cachedNoiseTextureVersion
+		|| header.width != std::uint32_t(expectedWidth) || header.height != header.width || header.depth != header.width)
+	{
+		return nullptr;
+	}
+
+	osg::ref_ptr<osg::Image> image = new osg::Image;
+	image->allocateImage(header.width, header.height, header.depth, GL_LUMINANCE, GL_UNSIGNED_BYTE);
+	f.read(reinterpret_cast<char*>(image->data()), image->getTotalSizeInBytes());
+	if (!f)
+	{
+		return nullptr;
+	}
+	return image;
+}
+
+static void writeCachedNoiseTexture(const std::string& filename, const osg::Image& image)
+{
+	CachedNoiseTextureHeader header;
+	header.magic = cachedNoiseTextureMagic;
+	header.version = cachedNoiseTextureVersion;
+	header.width = image.s();
+	header.height = image.t();
+	header.depth = image.r();
+
+	// Write to a temporary file and then rename, so that other processes never read a partially written file
+	std::string temporaryFilename = filename + ".tmp";
+	{
+		std::ofstream f(temporaryFilename, std::ios::binary | std::ios::trunc);
+		f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		f.write(reinterpret_cast<const char*>(image.data()), image.getTotalSizeInBytes());
+		if (!f)
+		{
+			throw std::runtime_error("Could not write noise texture: " + temporaryFilename);
+		}
+	}
+	fs::rename(temporaryFilename, filename);
+}
+
+osg::ref_ptr<osg::Image> readOrCreatePerlinWorleyTexture3d(const PerlinWorleyConfig& config, const std::string& cacheDirectory, px_sched::Scheduler* scheduler)
+{
+	fs::path directory = fs::path(cacheDirectory) / "NoiseTextures";
+	std::string filename = (directory / (calcPerlinWorleyConfigHash(config) + ".bin")).string();
+
+	if (osg::ref_ptr<osg::Image> image = readCachedNoiseTexture(filename, config.width); image)
+	{
+		return image;
+	}
+
+	osg::ref_ptr<osg::Image> image = createPerlinWorleyTexture3d(config, scheduler);
+
+	// Failing to cache the texture is not fatal, as it can be generated again next time
+	try
+	{
+		fs::create_directories(directory);
+		writeCachedNoiseTexture(filename, *image);
+	}
+	catch (const std::exception& e)
+	{
+		BOOST_LOG_TRIVIAL(warning) << "Could not cache cloud noise texture: " << e.what();
+	}
+	return image;
+}
+
 } // namespace vis
 } // namespace skybolt
\ No newline at end of file
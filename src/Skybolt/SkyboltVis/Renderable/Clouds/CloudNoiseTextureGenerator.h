@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include "SkyboltVis/SkyboltVisFwd.h"
 #include <osg/Image>
 
+#include <string>
+
 namespace skybolt {
 namespace vis {
 
@@ -32,7 +35,18 @@ struct PerlinWorleyConfig
 };
 
 osg::ref_ptr<osg::Image> createPerlinWorleyTexture2d(const PerlinWorleyConfig& config);
-osg::ref_ptr<osg::Image> createPerlinWorleyTexture3d(const PerlinWorleyConfig& config);
+
+//! @param scheduler if not null, slabs of the texture are generated in parallel on the scheduler
+osg::ref_ptr<osg::Image> createPerlinWorleyTexture3d(const PerlinWorleyConfig& config, px_sched::Scheduler* scheduler = nullptr);
+
+//! @returns a string which uniquely identifies the texture generated from the config
+std::string calcPerlinWorleyConfigHash(const PerlinWorleyConfig& config);
+
+//! Loads a 3d texture generated from the config from the cache directory.
+//! If the texture is not in the cache, the texture is generated and written to the cache.
+//! @param cacheDirectory is the Skybolt cache directory. The texture is stored in a subdirectory.
+//! @param scheduler if not null, the texture is generated in parallel on the scheduler
+osg::ref_ptr<osg::Image> readOrCreatePerlinWorleyTexture3d(const PerlinWorleyConfig& config, const std::string& cacheDirectory, px_sched::Scheduler* scheduler = nullptr);
 
 } // namespace vis
 } // namespace skybolt
\ No newline at end of file
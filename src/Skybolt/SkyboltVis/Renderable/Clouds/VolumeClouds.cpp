@@ -39,8 +39,10 @@ static osg::Texture3D* createTexture3D(const osg::ref_ptr<osg::Image> image)
 	return texture;
 }
 
-static osg::StateSet* createStateSet(const osg::ref_ptr<osg::Program>& program, const VolumeClouds::Uniforms& uniforms, const osg::ref_ptr<osg::Texture2D>& cloudsTexture)
+static osg::StateSet* createStateSet(const VolumeCloudsConfig& config, const VolumeClouds::Uniforms& uniforms)
 {
+	const osg::ref_ptr<osg::Program>& program = config.program;
+	const osg::ref_ptr<osg::Texture2D>& cloudsTexture = config.cloudsTexture;
 	assert(program);
 	assert(cloudsTexture);
 
@@ -81,16 +83,15 @@ static osg::StateSet* createStateSet(const osg::ref_ptr<osg::Program>& program,
 //#define GENERATE_VOLUME_TEXTURE
 //#define CONVERT_VOLUME_TEXTURE_FROM_LAYER_IMAGES
 #ifdef GENERATE_VOLUME_TEXTURE
-		{
-			PerlinWorleyConfig config;
-			config.width = 128;
-			config.perlinOctaves = 6;
-			config.perlinFrequency = 8.0f;
-			config.worley.invert = true;
-
-			osg::ref_ptr<osg::Image> image = createPerlinWorleyTexture3d(config);
-			writeTexture3d(*image, "Assets/Core/Environment/Cloud/CloudVolumeBase.png");
-		}
+		// Generated on first use and then read from the cache directory
+		osg::ref_ptr<osg::Image> image = [&] {
+			PerlinWorleyConfig noiseConfig;
+			noiseConfig.width = 128;
+			noiseConfig.perlinOctaves = 6;
+			noiseConfig.perlinFrequency = 8.0f;
+			noiseConfig.worley.invert = true;
+			return readOrCreatePerlinWorleyTexture3d(noiseConfig, config.cacheDirectory, config.scheduler);
+		}();
 #else
 #ifdef CONVERT_VOLUME_TEXTURE_FROM_LAYER_IMAGES
 	osg::ref_ptr<osg::Image> image = readTexture3dFromSeparateFiles("D:/Programming/MyProjects/Skybolt/AssetsSource/Clouds/my3DTextureArray.", ".tga", 128);
@@ -148,7 +149,7 @@ VolumeClouds::VolumeClouds(const VolumeCloudsConfig& config) :
 
 	mUniforms.jitterOffset = new osg::Uniform("jitterOffset", osg::Vec2f(0.f, 0.f));
 
-	osg::StateSet* stateSet = createStateSet(config.program, mUniforms, config.cloudsTexture);
+	osg::StateSet* stateSet = createStateSet(config, mUniforms);
 
 	osg::Vec2f pos(0,0);
 	osg::Vec2f size(1,1);
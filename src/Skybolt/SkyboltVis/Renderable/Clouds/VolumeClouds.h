@@ -7,9 +7,12 @@
 #pragma once
 
 #include "SkyboltVis/DefaultRootNode.h"
+#include "SkyboltVis/SkyboltVisFwd.h"
 #include <osg/PrimitiveSet>
 #include <osg/Texture2D>
 
+#include <string>
+
 namespace skybolt {
 namespace vis {
 
@@ -20,6 +23,8 @@ struct VolumeCloudsConfig
 	float outerCloudLayerRadius;
 	osg::ref_ptr<osg::Texture2D> cloudsTexture;
 	bool applyTemporalUpscalingJitter = false;
+	px_sched::Scheduler* scheduler = nullptr; //!< Optional. Used to generate noise textures in parallel.
+	std::string cacheDirectory; //!< Skybolt cache directory in which generated noise textures are stored
 };
 
 class VolumeClouds : public DefaultRootNode
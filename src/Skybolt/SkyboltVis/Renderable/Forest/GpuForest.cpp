@@ -91,49 +91,63 @@ GpuForest::~GpuForest()
 	}
 }
 
-void removeTilesBelowLodLevel(TileKeyImagesMap& images, int minLodLevel)
+void GpuForest::updateFromLeafTileChanges(const LeafTileChanges& changes, const QuadTreeTileLoader::LoadedTileTree& tree)
 {
-	for (auto i = images.begin(); i != images.end(); )
+	if (changes.reset)
 	{
-		if (i->first.level < minLodLevel)
+		for (const auto& [key, tile] : mForestTiles)
 		{
-			i = images.erase(i);
-		}
-		else {
-			++i;
+			mParentGroup->removeChild(tile.tile->_getNode());
 		}
+		mForestTiles.clear();
+		mForestTileLeafCounts.clear();
 	}
-}
-
-void GpuForest::updateFromTree(const QuadTreeTileLoader::LoadedTileTree& tree)
-{
-	// Get required tile images
-	TileKeyImagesMap requiredTileImages;
-	findLeafTiles(tree, requiredTileImages, mForestParams.maxTileLodLevelToDisplayForest);
-	removeTilesBelowLodLevel(requiredTileImages, mForestParams.minTileLodLevelToDisplayForest);
 
-	// Removed current unreqiured forest tiles
-	for (auto i = mForestTiles.begin(); i != mForestTiles.end();)
-	{
-		if (requiredTileImages.find(i->first) == requiredTileImages.end())
-		{
-			auto itToRemove = i;
-			++i;
-			mParentGroup->removeChild(itToRemove->second.tile->_getNode());
-			mForestTiles.erase(itToRemove);
-		}
-		else
+	// Forest tiles are displayed for leaf tiles, or for the ancestors at the max forest LOD of leaf tiles beyond the max forest LOD.
+	// Count the leaves covered by each forest tile, so that forest tiles are only recreated when their coverage starts or ends,
+	// and not when the terrain beneath them subdivides or merges.
+	std::map<QuadTreeTileKey, int> previousCounts;
+	auto addToCount = [&] (const QuadTreeTileKey& leafKey, int delta) {
+		QuadTreeTileKey key = createAncestorKey(leafKey, std::min(leafKey.level, mForestParams.maxTileLodLevelToDisplayForest));
+		if (key.level < mForestParams.minTileLodLevelToDisplayForest)
 		{
-			++i;
+			return;
 		}
+		int& count = mForestTileLeafCounts[key];
+		previousCounts.emplace(key, count);
+		count += delta;
+	};
+
+	for (const QuadTreeTileKey& key : changes.removedTiles)
+	{
+		addToCount(key, -1);
+	}
+	for (const auto& [key, images] : changes.addedTiles)
+	{
+		addToCount(key, 1);
 	}
 
-	// Add new required forest tiles
-	for (const auto& [key, images] : requiredTileImages)
+	for (const auto& [key, previousCount] : previousCounts)
 	{
-		if (mForestTiles.find(key) == mForestTiles.end())
+		auto countIt = mForestTileLeafCounts.find(key);
+		int count = countIt->second;
+		assert(count >= 0);
+		if (count == 0)
+		{
+			mForestTileLeafCounts.erase(countIt);
+			if (auto i = mForestTiles.find(key); i != mForestTiles.end())
+			{
+				mParentGroup->removeChild(i->second.tile->_getNode());
+				mForestTiles.erase(i);
+			}
+		}
+		else if (previousCount == 0)
 		{
-			mForestTiles[key] = createForestTile(key, mTileTexturesProvider(*images));
+			const QuadTreeTileLoader::LoadedTile* tile = findTile(tree, key);
+			if (tile && tile->images)
+			{
+				mForestTiles[key] = createForestTile(key, mTileTexturesProvider(*tile->images));
+			}
 		}
 	}
 }
@@ -46,7 +46,9 @@ public:
 	GpuForest(const GpuForestConfig& config);
 	~GpuForest();
 
-	void updateFromTree(const QuadTreeTileLoader::LoadedTileTree& tree);
+	//! Updates forest tiles from changes to the leaf tiles of the terrain tree.
+	//! @param tree is the terrain tree after the changes were applied
+	void updateFromLeafTileChanges(const LeafTileChanges& changes, const QuadTreeTileLoader::LoadedTileTree& tree);
 
 	void updatePreRender(const CameraRenderContext& context);
 
@@ -76,6 +78,9 @@ private:
 	std::vector<std::shared_ptr<BillboardForest>> mForestGeometries;
 
 	std::map<QuadTreeTileKey, ForestTile> mForestTiles;
+
+	//! Number of terrain leaf tiles covered by each forest tile key. A forest tile exists while its count is non-zero.
+	std::map<QuadTreeTileKey, int> mForestTileLeafCounts;
 };
 
 } // namespace vis
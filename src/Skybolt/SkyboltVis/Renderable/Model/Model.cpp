@@ -9,14 +9,21 @@
 #include "SkyboltVis/Camera.h"
 #include "SkyboltVis/RenderContext.h"
 #include "SkyboltVis/VisibilityCategory.h"
+#include <boost/log/trivial.hpp>
 #include <assert.h>
 
 using namespace skybolt::vis;
 
 Model::Model(const ModelConfig &config) :
-	mNode(config.node)
+	mNode(config.node),
+	mPendingNode(config.pendingNode)
 {
-	assert(mNode);
+	if (!mNode)
+	{
+		assert(mPendingNode.valid());
+		mNode = new osg::Group;
+	}
+	mNodeRef = mNode;
 
 	mTransform->setNodeMask(vis::VisibilityCategory::defaultCategories | vis::VisibilityCategory::shadowCaster);
 	mTransform->addChild(mNode);
@@ -26,6 +33,9 @@ Model::Model(const ModelConfig &config) :
 
 	mModelViewMatrix = new osg::Uniform("modelViewMatrix", osg::Matrixf());
 	mTransform->getOrCreateStateSet()->addUniform(mModelViewMatrix);
+
+	// Avoid showing the placeholder for a frame if the node has already loaded
+	updatePendingNode();
 }
 
 Model::~Model()
@@ -59,8 +69,40 @@ void Model::setVisible(bool visible)
 	}
 }
 
+void Model::updatePendingNode()
+{
+	if (!mPendingNode.valid() || mPendingNode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	try
+	{
+		setNode(mPendingNode.get());
+	}
+	catch (const std::exception& e)
+	{
+		BOOST_LOG_TRIVIAL(error) << e.what();
+	}
+	mPendingNode = NodeFuture();
+}
+
+void Model::setNode(osg::Node* node)
+{
+	assert(node);
+	if (mVisible)
+	{
+		mTransform->removeChild(mNode);
+		mTransform->addChild(node);
+	}
+	mNode = node;
+	mNodeRef = node;
+}
+
 void Model::updatePreRender(const CameraRenderContext& context)
 {
+	updatePendingNode();
+
 	// Disable atmospheric shading if atmospheric density is too low because it causes rendering artifacts,
 	// and atmospheric scattering is not very visible at high altitude.
 	bool inAtmosphere = context.atmosphericDensity > 0.3;
@@ -9,13 +9,21 @@
 
 #include "SkyboltVis/DefaultRootNode.h"
 #include <osg/Program>
+#include <future>
 
 namespace skybolt {
 namespace vis {
 
+//! Node which may still be loading on another thread. Holds an exception if loading failed.
+typedef std::shared_future<osg::ref_ptr<osg::Node>> NodeFuture;
+
 struct ModelConfig
 {
-	osg::ref_ptr<osg::Node> node;
+	osg::ref_ptr<osg::Node> node; //!< Node to display. May be null if pendingNode is set.
+
+	//! Optional. If set, replaces node when it is ready. An empty placeholder is displayed
+	//! until then if node is null.
+	NodeFuture pendingNode;
 
 	static ModelConfig ofNode(const osg::ref_ptr<osg::Node>& node)
 	{
@@ -42,6 +50,10 @@ public:
 private:
 	void updatePreRender(const CameraRenderContext& context) override;
 
+	//! Replaces the displayed node with the pending node if it is ready
+	void updatePendingNode();
+	void setNode(osg::Node* node);
+
 protected:
 	osg::Node* mNode;
 
@@ -49,6 +61,8 @@ private:
 	osg::Uniform* mModelMatrix;
 	osg::Uniform* mModelViewMatrix;
 	bool mVisible = true;
+	osg::ref_ptr<osg::Node> mNodeRef; //!< Keeps mNode alive while it is hidden, as the factory's cache may not
+	NodeFuture mPendingNode;
 };
 
 } // namespace vis
@@ -9,15 +9,25 @@
 #include "ModelPreparer.h"
 #include "OsgImageHelpers.h"
 #include "OsgStateSetHelpers.h"
+#include <SkyboltCommon/Exception.h>
 #include <SkyboltCommon/MapUtility.h>
+#include <SkyboltCommon/ShaUtility.h>
 
 #include <osg/Image>
+#include <osgDB/FileUtils>
 #include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+#include <boost/log/trivial.hpp>
 
 #include <assert.h>
+#include <filesystem>
+#include <optional>
+#include <sstream>
 
 using namespace skybolt::vis;
 
+namespace fs = std::filesystem;
+
 // Traverses node hierarchy and sets internal format of textures to an equivalent sRGB format
 class StateSetVisitor : public osg::NodeVisitor
 {
@@ -174,47 +184,204 @@ private:
 	NamedStateSetModifiers mModifiers;
 };
 
+static void prepareModel(osg::Node& model, const std::vector<ModelFactory::TextureRole>& textureRoles)
+{
+	TexturePreparer modifier(textureRoles);
+	model.accept(modifier);
+
+	ModelPreparerConfig config;
+	config.generateTangents = modifier.hasNormalMap;
+	ModelPreparer preparer(config);
+	model.accept(preparer);
+}
+
+//! Increment when the output of prepareModel() changes, to invalidate previously cached models
+static const int preparedModelCacheVersion = 1;
+
+//! @returns the filename of the cached prepared model, or empty if the model cannot be cached.
+//! The source model's size and modification time are part of the key, so edited models are prepared again.
+static std::optional<std::string> getPreparedModelCacheFilename(const std::string& cacheDirectory, const std::string& filename, const std::vector<ModelFactory::TextureRole>& textureRoles)
+{
+	if (cacheDirectory.empty())
+	{
+		return std::nullopt;
+	}
+
+	std::string resolvedFilename = osgDB::findDataFile(filename);
+	if (resolvedFilename.empty())
+	{
+		return std::nullopt;
+	}
+
+	std::error_code error;
+	std::uintmax_t size = fs::file_size(resolvedFilename, error);
+	if (error)
+	{
+		return std::nullopt;
+	}
+	fs::file_time_type modifiedTime = fs::last_write_time(resolvedFilename, error);
+	if (error)
+	{
+		return std::nullopt;
+	}
+
+	std::ostringstream ss;
+	ss << "PreparedModel " << preparedModelCacheVersion
+		<< " " << fs::absolute(resolvedFilename).string()
+		<< " " << size
+		<< " " << modifiedTime.time_since_epoch().count();
+	for (ModelFactory::TextureRole role : textureRoles)
+	{
+		ss << " " << int(role);
+	}
+	return (fs::path(cacheDirectory) / "Models" / (skybolt::calcSha1(ss.str()) + ".osgb")).string();
+}
+
+static void writePreparedModel(const std::string& filename, const osg::Node& model)
+{
+	fs::create_directories(fs::path(filename).parent_path());
+
+	// Write to a temporary file and then rename, so that other processes never read a partially written file.
+	// The temporary file keeps the extension which selects the writer.
+	std::string temporaryFilename = filename + ".tmp.osgb";
+
+	// Include decoded images so that textures do not need to be located and decoded again
+	osg::ref_ptr<osgDB::Options> options = new osgDB::Options("WriteImageHint=IncludeData");
+	if (!osgDB::writeNodeFile(model, temporaryFilename, options))
+	{
+		throw std::runtime_error("Could not write file: " + temporaryFilename);
+	}
+	fs::rename(temporaryFilename, filename);
+}
+
+static std::string getModelCacheKey(const std::string& filename, const std::vector<ModelFactory::TextureRole>& textureRoles)
+{
+	std::string key = filename;
+	for (ModelFactory::TextureRole role : textureRoles)
+	{
+		key += "|" + std::to_string(int(role));
+	}
+	return key;
+}
+
 ModelFactory::ModelFactory(const ModelFactoryConfig &config) :
 	mStateSetModifiers(config.stateSetModifiers),
-	mDefaultProgram(config.defaultProgram)
+	mDefaultProgram(config.defaultProgram),
+	mScheduler(config.scheduler),
+	mCacheDirectory(config.cacheDirectory),
+	mModelCache(config.maxCachedModels)
 {
 	assert(mDefaultProgram);
 }
 
+ModelFactory::~ModelFactory()
+{
+	if (mScheduler)
+	{
+		std::scoped_lock<std::mutex> lock(mLoadingTaskSyncMutex);
+		mScheduler->waitFor(mLoadingTaskSync);
+	}
+}
+
 osg::ref_ptr<osg::Node> ModelFactory::createModel(const std::string& filename, const std::vector<TextureRole>& textureRoles)
 {
-	static std::map<std::string, osg::ref_ptr<osg::Node>> modelCache;
-	auto it = modelCache.find(filename);
-	if (it == modelCache.end())
+	return getOrLoadModel(filename, textureRoles, /* async */ false).get();
+}
+
+NodeFuture ModelFactory::createModelAsync(const std::string& filename, const std::vector<TextureRole>& textureRoles)
+{
+	return getOrLoadModel(filename, textureRoles, /* async */ true);
+}
+
+NodeFuture ModelFactory::getOrLoadModel(const std::string& filename, const std::vector<TextureRole>& textureRoles, bool async)
+{
+	// Models are added to the cache when loading starts, so that concurrent requests share one load
+	auto promise = std::make_shared<std::promise<osg::ref_ptr<osg::Node>>>();
+	std::string key = getModelCacheKey(filename, textureRoles);
+	CachedModel cachedModel;
 	{
-		osg::ref_ptr<osg::Node> model = osgDB::readNodeFile(filename);
-		if (!model)
+		std::scoped_lock<std::mutex> lock(mModelCacheMutex);
+		if (mModelCache.get(key, cachedModel))
 		{
-			throw skybolt::Exception("Could not load OSG model: " + filename);
+			return cachedModel.node;
 		}
+		cachedModel.node = promise->get_future().share();
+		cachedModel.loadId = mNextLoadId++;
+		mModelCache.put(key, cachedModel);
+	}
 
-		TexturePreparer modifier(textureRoles);
-		model->accept(modifier);
-
+	auto load = [this, filename, textureRoles, promise, key, loadId = cachedModel.loadId] {
+		try
 		{
-			ModelPreparerConfig config;
-			config.generateTangents = modifier.hasNormalMap;
-			ModelPreparer preparer(config);
-			model->accept(preparer);
+			promise->set_value(loadModel(filename, textureRoles));
 		}
+		catch (...)
+		{
+			{
+				// Remove the failed load from the cache before reporting the failure, so that the next request retries.
+				// The entry may have been evicted and replaced by a later load, which is kept.
+				std::scoped_lock<std::mutex> lock(mModelCacheMutex);
+				if (CachedModel entry; mModelCache.get(key, entry) && entry.loadId == loadId)
+				{
+					mModelCache.erase(key);
+				}
+			}
+			promise->set_exception(std::current_exception());
+		}
+	};
 
+	if (async && mScheduler)
+	{
+		std::scoped_lock<std::mutex> lock(mLoadingTaskSyncMutex);
+		mScheduler->run(load, &mLoadingTaskSync);
+	}
+	else
+	{
+		load();
+	}
+	return cachedModel.node;
+}
+
+osg::ref_ptr<osg::Node> ModelFactory::loadModel(const std::string& filename, const std::vector<TextureRole>& textureRoles) const
+{
+	std::optional<std::string> cacheFilename = getPreparedModelCacheFilename(mCacheDirectory, filename, textureRoles);
+
+	osg::ref_ptr<osg::Node> model;
+	if (cacheFilename && fs::exists(*cacheFilename))
+	{
+		model = osgDB::readNodeFile(*cacheFilename);
+	}
+
+	if (!model)
+	{
+		model = osgDB::readNodeFile(filename);
+		if (!model)
 		{
-			MaterialShaderAssignmentsModifier modifier(mStateSetModifiers);
-			model->accept(modifier);
+			throw skybolt::Exception("Could not load OSG model: " + filename);
 		}
 
-		model->getOrCreateStateSet()->setAttribute(mDefaultProgram); // set default program at top level
+		prepareModel(*model, textureRoles);
 
-		modelCache[filename] = model;
-		return model;
+		if (cacheFilename)
+		{
+			// Failing to cache the model is not fatal, as it can be prepared again next time
+			try
+			{
+				writePreparedModel(*cacheFilename, *model);
+			}
+			catch (const std::exception& e)
+			{
+				BOOST_LOG_TRIVIAL(warning) << "Could not cache prepared model '" << filename << "': " << e.what();
+			}
+		}
 	}
-	else
+
+	// Programs are shared with the rest of the scene, so are assigned after caching rather than stored in the cache
 	{
-		return it->second;
+		MaterialShaderAssignmentsModifier modifier(mStateSetModifiers);
+		model->accept(modifier);
 	}
-}
\ No newline at end of file
+
+	model->getOrCreateStateSet()->setAttribute(mDefaultProgram); // set default program at top level
+	return model;
+}
@@ -7,10 +7,15 @@
 
 #pragma once
 
+#include "Model.h"
 #include "SkyboltVis/DefaultRootNode.h"
+#include <SkyboltCommon/LruCacheMap.h>
 #include <osg/Material>
 #include <osg/Program>
+#include <px_sched/px_sched.h>
+#include <cstdint>
 #include <functional>
+#include <mutex>
 
 namespace skybolt {
 namespace vis {
@@ -22,12 +27,16 @@ struct ModelFactoryConfig
 {
 	NamedStateSetModifiers stateSetModifiers;
 	osg::ref_ptr<osg::Program> defaultProgram;
+	px_sched::Scheduler* scheduler = nullptr; //!< Optional. If null, createModelAsync() loads on the calling thread.
+	std::string cacheDirectory; //!< Optional Skybolt cache directory. If set, prepared models are cached in a subdirectory.
+	std::size_t maxCachedModels = 64; //!< Maximum number of prepared models kept in memory
 };
 
 class ModelFactory : public DefaultRootNode
 {
 public:
 	ModelFactory(const ModelFactoryConfig &config);
+	~ModelFactory();
 	
 	enum class TextureRole
 {
@@ -36,11 +45,42 @@ public:
 	OcclusionRoughnessMetalness
 };
 
+	//! Loads and prepares a model on the calling thread, or returns the model from the cache.
+	//! Waits for the model if it is already being loaded asynchronously.
+	//! @throws skybolt::Exception if the model could not be loaded
 	osg::ref_ptr<osg::Node> createModel(const std::string& filename, const std::vector<TextureRole>& textureRoles);
 
+	//! Loads and prepares a model on the scheduler, or returns the model from the cache.
+	//! The model is shared between all callers, and must not be modified.
+	//! Failed loads are not cached, so the model is loaded again when next requested.
+	//! @returns a future which holds the model, or a skybolt::Exception if the model could not be loaded
+	//! @ThreadSafe
+	NodeFuture createModelAsync(const std::string& filename, const std::vector<TextureRole>& textureRoles);
+
+private:
+	NodeFuture getOrLoadModel(const std::string& filename, const std::vector<TextureRole>& textureRoles, bool async);
+
+	//! @ThreadSafe
+	osg::ref_ptr<osg::Node> loadModel(const std::string& filename, const std::vector<TextureRole>& textureRoles) const;
+
 private:
 	NamedStateSetModifiers mStateSetModifiers;
 	osg::ref_ptr<osg::Program> mDefaultProgram;
+	px_sched::Scheduler* mScheduler;
+	std::string mCacheDirectory;
+
+	struct CachedModel
+	{
+		NodeFuture node;
+		std::uint64_t loadId; //!< Identifies the load which produces the node
+	};
+
+	std::mutex mModelCacheMutex;
+	LruCacheMap<std::string, CachedModel> mModelCache; //!< Guarded by mModelCacheMutex
+	std::uint64_t mNextLoadId = 0; //!< Guarded by mModelCacheMutex
+
+	std::mutex mLoadingTaskSyncMutex; //!< Serializes use of mLoadingTaskSync, which is not thread safe
+	px_sched::Sync mLoadingTaskSync;
 };
 
 } // namespace vis
@@ -9,21 +9,78 @@
 #include "SkyboltVis/OsgGeometryHelpers.h"
 #include "SkyboltVis/OsgStateSetHelpers.h"
 #include <SkyboltSim/Particles/ParticleSystem.h>
-#include <SkyboltCommon/Math/MathUtility.h>
 
-#include <glm/glm.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#ifndef GL_MAX_TEXTURE_BUFFER_SIZE
+#define GL_MAX_TEXTURE_BUFFER_SIZE 0x8C2B
+#endif
 
 using namespace skybolt;
 using namespace skybolt::vis;
 
+//! Number of RGBA32F texels used to store each particle in the instance buffer
+constexpr size_t texelsPerParticle = 2;
+constexpr size_t floatsPerParticle = texelsPerParticle * 4;
+
+constexpr size_t minInstanceCapacity = 1024;
+
+//! Minimum GL_MAX_TEXTURE_BUFFER_SIZE guaranteed by the OpenGL specification
+constexpr GLint guaranteedMaxTextureBufferTexels = 65536;
+
+//! GL_MAX_TEXTURE_BUFFER_SIZE queried from the GL implementation, or zero if not yet queried.
+//! If there are multiple graphics contexts, this is the smallest value among them.
+static std::atomic<GLint> queriedMaxTextureBufferTexels{0};
+
+//! Queries GL_MAX_TEXTURE_BUFFER_SIZE the first time the drawable is drawn in each graphics context
+class MaxTextureBufferSizeQueryCallback : public osg::Drawable::DrawCallback
+{
+public:
+	void drawImplementation(osg::RenderInfo& renderInfo, const osg::Drawable* drawable) const override
+	{
+		unsigned int contextId = renderInfo.getContextID();
+		if (contextId >= mQueried.size() || !mQueried[contextId])
+		{
+			GLint texels = 0;
+			glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &texels);
+			if (texels > 0)
+			{
+				GLint current = queriedMaxTextureBufferTexels.load();
+				while ((current == 0 || texels < current) && !queriedMaxTextureBufferTexels.compare_exchange_weak(current, texels)) {}
+			}
+
+			if (contextId >= mQueried.size())
+			{
+				mQueried.resize(contextId + 1, false);
+			}
+			mQueried[contextId] = true;
+		}
+		drawable->drawImplementation(renderInfo);
+	}
+
+private:
+	mutable std::vector<bool> mQueried; //!< Indexed by context ID. Each context is drawn by a single thread.
+};
+
 Particles::Particles(const osg::ref_ptr<osg::Program>& program, const osg::ref_ptr<osg::Texture2D>& albedoTexture) :
 	mGeometry(new osg::Geometry()),
-	mDrawArrays(new osg::DrawArrays()),
-	mParticleVertices(new osg::Vec3Array()),
-	mParticleUvs(new osg::Vec4Array())
+	mDrawArrays(new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0, 0)),
+	mInstanceTexture(new osg::TextureBuffer())
 {
+	// The quad corners are generated in the vertex shader from gl_VertexID.
+	// A vertex array is still provided because OSG does not draw geometry without one.
+	osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(4);
+	mGeometry->setVertexArray(vertices);
 	mGeometry->addPrimitiveSet(mDrawArrays);
 	configureDrawable(*mGeometry);
+	mGeometry->setDrawCallback(new MaxTextureBufferSizeQueryCallback());
+
+	mInstanceTexture->setInternalFormat(GL_RGBA32F_ARB);
+	updateInstanceCapacity(0);
 
 	auto stateSet = mGeometry->getOrCreateStateSet();
 	stateSet->setAttribute(program);
@@ -34,42 +91,123 @@ Particles::Particles(const osg::ref_ptr<osg::Program>& program, const osg::ref_p
 	stateSet->setTextureAttributeAndModes(unit, albedoTexture);
 	stateSet->addUniform(createUniformSampler2d("albedoSampler", unit++));
 
+	stateSet->setTextureAttribute(unit, mInstanceTexture);
+	stateSet->addUniform(createUniformSamplerTbo("particleSampler", unit++));
+
 	mTransform->addChild(mGeometry);
 }
 
-static float randomFast(float n) { return glm::fract(sin(n) * 43758.5453123); }
-
-void Particles::setParticles(const std::vector<sim::Particle>& particles, const osg::ref_ptr<osg::Vec3Array>& visParticlePositions)
+size_t Particles::getMaxParticleCount()
 {
-	assert(visParticlePositions->size() == particles.size());
-	mParticleVertices->reserve(particles.size() * 4);
-	mParticleVertices->clear();
-	mParticleUvs->reserve(particles.size() * 4);
-	mParticleUvs->clear();
+	GLint texels = queriedMaxTextureBufferTexels.load();
+	return size_t(texels > 0 ? texels : guaranteedMaxTextureBufferTexels) / texelsPerParticle;
+}
 
-	osg::BoundingBox bounds;
-	int i = 0;
-	for (const auto& pos : *visParticlePositions)
+void Particles::updateInstanceCapacity(size_t particleCount)
+{
+	size_t capacity;
+	if (particleCount > mInstanceCapacity)
 	{
-		const auto& particle = particles[i];
-		float radius = particle.radius;
-		osg::Vec3f corner(radius, radius, radius);
-		osg::BoundingBox box(pos - corner, pos + corner);
-		bounds.expandBy(box);
+		// Grow geometrically so that the buffer is rarely reallocated as particle count increases
+		capacity = std::max(particleCount, mInstanceCapacity * 2);
+	}
+	else if (particleCount < mInstanceCapacity / 4 && mInstanceCapacity > minInstanceCapacity)
+	{
+		// Shrink with hysteresis so that fluctuating particle counts do not cause repeated reallocation
+		capacity = particleCount * 2;
+	}
+	else
+	{
+		return;
+	}
+	mInstanceCapacity = std::clamp(capacity, minInstanceCapacity, std::max(minInstanceCapacity, getMaxParticleCount()));
 
-		const float rotation = randomFast(particle.guid % 100000) * math::twoPiF();
+	// Use a new image, and therefore a new GPU buffer object, sized to the new capacity
+	mInstanceData = std::vector<float>(mInstanceCapacity * floatsPerParticle, 0.0f);
+	mInstanceImage = new osg::Image();
+	mInstanceImage->setImage(int(mInstanceCapacity * texelsPerParticle), 1, 1, GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT,
+		reinterpret_cast<unsigned char*>(mInstanceData.data()), osg::Image::NO_DELETE);
+	mInstanceTexture->setImage(mInstanceImage);
+	mInstanceBufferAllocationPending = true;
+}
 
-		for (int j = 0; j < 4; ++j)
+void Particles::setParticles(const sim::ParticleStore& particles, const sim::Matrix4& worldToLocalTransform)
+{
+	size_t count = particles.size();
+	size_t maxCount = getMaxParticleCount();
+	if (count > maxCount)
+	{
+		if (!mParticleLimitWarningLogged)
 		{
-			mParticleVertices->push_back(pos);
-			mParticleUvs->push_back(osg::Vec4(radius, particle.alpha, rotation, particle.temperatureDegreesCelcius));
+			BOOST_LOG_TRIVIAL(warning) << "Particle count " << count << " exceeds the GL texture buffer limit of " << maxCount << " particles. Excess particles will not be drawn.";
+			mParticleLimitWarningLogged = true;
 		}
+		count = maxCount;
+	}
+	updateInstanceCapacity(count);
+
+	const double* px = particles.positionX.data();
+	const double* py = particles.positionY.data();
+	const double* pz = particles.positionZ.data();
+	const float* radius = particles.radius.data();
+	const float* alpha = particles.alpha.data();
+	const float* temperature = particles.temperatureDegreesCelcius.data();
+	const int* guid = particles.guid.data();
+	const sim::Matrix4& m = worldToLocalTransform;
 
-		++i;
+	float minX = std::numeric_limits<float>::max();
+	float minY = minX;
+	float minZ = minX;
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxY = maxX;
+	float maxZ = maxX;
+	float maxRadius = 0;
+
+	// Transform positions and write instance records in a single pass over the particle arrays
+	float* instance = mInstanceData.data();
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = float(m[0][0] * px[i] + m[1][0] * py[i] + m[2][0] * pz[i] + m[3][0]);
+		float y = float(m[0][1] * px[i] + m[1][1] * py[i] + m[2][1] * pz[i] + m[3][1]);
+		float z = float(m[0][2] * px[i] + m[1][2] * py[i] + m[2][2] * pz[i] + m[3][2]);
+
+		minX = std::min(minX, x);
+		minY = std::min(minY, y);
+		minZ = std::min(minZ, z);
+		maxX = std::max(maxX, x);
+		maxY = std::max(maxY, y);
+		maxZ = std::max(maxZ, z);
+		maxRadius = std::max(maxRadius, radius[i]);
+
+		float* record = instance + i * floatsPerParticle;
+		record[0] = x;
+		record[1] = y;
+		record[2] = z;
+		record[3] = radius[i];
+		record[4] = alpha[i];
+		record[5] = float(guid[i] % 100000); // seed for the particle's random rotation, calculated in the shader
+		record[6] = temperature[i];
+		record[7] = 0.0f;
+	}
+
+	// Resize the image to the particles in use, so that only those are uploaded. The image keeps referring to
+	// mInstanceData, and OSG updates the existing GPU buffer in place while the upload fits within it.
+	// The first upload after reallocation covers the whole capacity so that the GPU buffer is allocated at full size.
+	size_t uploadCount = mInstanceBufferAllocationPending ? mInstanceCapacity : std::max(count, size_t(1));
+	mInstanceBufferAllocationPending = false;
+	mInstanceImage->setImage(int(uploadCount * texelsPerParticle), 1, 1, GL_RGBA32F_ARB, GL_RGBA, GL_FLOAT,
+		reinterpret_cast<unsigned char*>(mInstanceData.data()), osg::Image::NO_DELETE); // also marks the image dirty
+
+	osg::BoundingBox bounds;
+	if (count > 0)
+	{
+		osg::Vec3f corner(maxRadius, maxRadius, maxRadius);
+		bounds.set(osg::Vec3f(minX, minY, minZ) - corner, osg::Vec3f(maxX, maxY, maxZ) + corner);
 	}
 	mGeometry->setComputeBoundingBoxCallback(createFixedBoundingBoxCallback(bounds));
+	mGeometry->dirtyBound();
 
-	mGeometry->setVertexArray(mParticleVertices);
-	mGeometry->setTexCoordArray(0, mParticleUvs);
-	mDrawArrays->set(osg::PrimitiveSet::QUADS, 0, mParticleVertices->size());
+	// Draw nothing if there are no particles, since a draw with zero instances is not instanced in OSG
+	mDrawArrays->setCount(count > 0 ? 4 : 0);
+	mDrawArrays->setNumInstances(int(count));
 }
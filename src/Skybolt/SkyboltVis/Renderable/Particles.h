@@ -8,27 +8,49 @@
 #pragma once
 
 #include "SkyboltVis/DefaultRootNode.h"
+#include <SkyboltSim/SimMath.h>
 #include <SkyboltSim/SkyboltSimFwd.h>
 #include <osg/Geometry>
 #include <osg/Program>
 #include <osg/Texture2D>
+#include <osg/TextureBuffer>
+
+#include <vector>
 
 namespace skybolt {
 namespace vis {
 
+//! Renders particles as camera facing quads.
+//! Each particle is uploaded to the GPU as a single instance record in a persistent texture buffer,
+//! and the vertex shader expands each instance into a quad.
+//! The number of particles drawn is limited by the GL implementation's maximum texture buffer size.
 class Particles : public DefaultRootNode
 {
 public:
 	Particles(const osg::ref_ptr<osg::Program>& program, const osg::ref_ptr<osg::Texture2D>& albedoTexture);
 	~Particles() override = default;
 
-	void setParticles(const std::vector<sim::Particle>& particles, const osg::ref_ptr<osg::Vec3Array>& visParticlePositions);
+	//! @param worldToLocalTransform transforms particle positions from sim world space into this node's space
+	void setParticles(const sim::ParticleStore& particles, const sim::Matrix4& worldToLocalTransform);
+
+private:
+	//! Resizes the instance buffer if required to hold particleCount particles.
+	//! The buffer grows geometrically, and shrinks when the particle count falls well below capacity.
+	void updateInstanceCapacity(size_t particleCount);
+
+	//! @returns the maximum number of particles which fit in a texture buffer.
+	//! This is the guaranteed minimum until the GL implementation's limit has been queried at draw time.
+	static size_t getMaxParticleCount();
 
 private:
 	osg::ref_ptr<osg::Geometry> mGeometry;
 	osg::ref_ptr<osg::DrawArrays> mDrawArrays;
-	osg::ref_ptr<osg::Vec3Array> mParticleVertices;
-	osg::ref_ptr<osg::Vec4Array> mParticleUvs;
+	osg::ref_ptr<osg::TextureBuffer> mInstanceTexture;
+	osg::ref_ptr<osg::Image> mInstanceImage; //!< Refers to mInstanceData. Sized to the particles in use, so that only those are uploaded.
+	std::vector<float> mInstanceData; //!< Two RGBA32F texels per particle
+	size_t mInstanceCapacity = 0;
+	bool mInstanceBufferAllocationPending = false; //!< If true, the next upload covers the whole capacity so that the GPU buffer is allocated at full size
+	bool mParticleLimitWarningLogged = false;
 };
 
 } // namespace vis
@@ -0,0 +1,444 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "PackedFeatureTile.h"
+#include <SkyboltCommon/Exception.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace bip = boost::interprocess;
+
+namespace skybolt {
+namespace mapfeatures {
+
+static const char packedFileMagic[4] = {'S', 'B', 'F', 'T'};
+static const std::uint32_t packedFileVersion = 2;
+
+//! Sections are aligned so that records can be read in place
+static const std::size_t packedSectionAlignment = 8;
+
+static constexpr int sectionCount = int(PackedFeatureSection::SectionCount);
+
+struct PackedFeatureTileHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	struct Section
+	{
+		std::uint64_t offset; //!< Bytes from start of file
+		std::uint64_t size; //!< Number of elements
+	};
+	Section sections[sectionCount];
+};
+
+static_assert(sizeof(PackedRange) == 8, "PackedRange must be tightly packed");
+static_assert(sizeof(PackedRoad) == 72, "PackedRoad must be tightly packed");
+static_assert(sizeof(PackedBuilding) == 16, "PackedBuilding must be tightly packed");
+static_assert(sizeof(PackedWater) == 8, "PackedWater must be tightly packed");
+static_assert(sizeof(PackedRunway) == 48, "PackedRunway must be tightly packed");
+static_assert(sizeof(PackedAirport) == 24, "PackedAirport must be tightly packed");
+static_assert(sizeof(sim::LatLon) == 16, "LatLon must be tightly packed");
+static_assert(sizeof(sim::LatLonAlt) == 24, "LatLonAlt must be tightly packed");
+static_assert(sizeof(PackedFeatureTileHeader) % packedSectionAlignment == 0, "Header size must preserve section alignment");
+
+static const std::size_t sectionElementSizes[sectionCount] = {
+	sizeof(PackedRoad),
+	sizeof(PackedBuilding),
+	sizeof(PackedWater),
+	sizeof(PackedAirport),
+	sizeof(PackedRunway),
+	sizeof(PackedRange),
+	sizeof(sim::LatLonAlt),
+	sizeof(sim::LatLon),
+	sizeof(char)
+};
+
+PackedFeatureTile::PackedFeatureTile(const std::string& filename)
+{
+	std::error_code error;
+	std::uintmax_t fileSize = std::filesystem::file_size(filename, error);
+	if (error)
+	{
+		throw skybolt::Exception("Could not open file: " + filename);
+	}
+	if (fileSize < sizeof(PackedFeatureTileHeader))
+	{
+		throw skybolt::Exception("File is not a packed feature tile: " + filename);
+	}
+
+	try
+	{
+		bip::file_mapping fileMapping(filename.c_str(), bip::read_only);
+		mMapping = std::make_unique<bip::mapped_region>(fileMapping, bip::read_only, 0, std::size_t(fileSize));
+	}
+	catch (const bip::interprocess_exception& e)
+	{
+		throw skybolt::Exception("Could not map file '" + filename + "': " + e.what());
+	}
+
+	mData = static_cast<const char*>(mMapping->get_address());
+	mDataSize = std::size_t(fileSize);
+	validate();
+}
+
+PackedFeatureTile::PackedFeatureTile(std::vector<char> buffer) :
+	mBuffer(std::move(buffer))
+{
+	mData = mBuffer.data();
+	mDataSize = mBuffer.size();
+	validate();
+}
+
+PackedFeatureTile::~PackedFeatureTile() = default;
+
+void PackedFeatureTile::validate()
+{
+	if (mDataSize < sizeof(PackedFeatureTileHeader))
+	{
+		throw skybolt::Exception("Packed feature tile is truncated");
+	}
+
+	const PackedFeatureTileHeader& header = *reinterpret_cast<const PackedFeatureTileHeader*>(mData);
+	if (std::memcmp(header.magic, packedFileMagic, sizeof(packedFileMagic)) != 0)
+	{
+		throw skybolt::Exception("Data is not a packed feature tile");
+	}
+	if (header.version != packedFileVersion)
+	{
+		throw skybolt::Exception("Invalid packed feature tile version: " + std::to_string(header.version) + ". Expected: " + std::to_string(packedFileVersion));
+	}
+
+	// Sections are only validated once here, so that accessors can return pointers into the data without further checks
+	for (int i = 0; i < sectionCount; ++i)
+	{
+		const PackedFeatureTileHeader::Section& section = header.sections[i];
+		if (section.offset % packedSectionAlignment != 0
+			|| section.offset > mDataSize
+			|| section.size > (mDataSize - section.offset) / sectionElementSizes[i]
+			|| section.size > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw skybolt::Exception("Packed feature tile section " + std::to_string(i) + " is out of bounds");
+		}
+		mSectionData[i] = mData + section.offset;
+		mSectionSizes[i] = std::uint32_t(section.size);
+	}
+}
+
+void PackedFeatureTile::checkRange(PackedFeatureSection section, const PackedRange& range) const
+{
+	std::uint32_t size = mSectionSizes[int(section)];
+	if (range.first > size || range.count > size - range.first)
+	{
+		throw skybolt::Exception("Packed feature tile range is out of bounds of section " + std::to_string(int(section)));
+	}
+}
+
+std::string_view PackedFeatureTile::getString(const PackedRange& range) const
+{
+	PackedArray<char> characters = getRange<char>(PackedFeatureSection::StringCharacters, range);
+	return std::string_view(characters.begin(), characters.size());
+}
+
+std::size_t PackedFeatureTile::getFeatureCount() const
+{
+	return std::size_t(getRoads().size()) + getBuildings().size() + getWaters().size() + getAirports().size();
+}
+
+namespace {
+
+class PackedFeatureTileWriter
+{
+public:
+	void add(const Feature& feature)
+	{
+		switch (feature.type())
+		{
+		case FeatureRoad:
+		{
+			const Road& road = static_cast<const Road&>(feature);
+			PackedRoad record = {};
+			record.points = addPoints(road.points);
+			record.width = road.width;
+			record.laneCount = road.laneCount;
+			for (int i = 0; i < 2; ++i)
+			{
+				record.endControlPoints[i] = road.endControlPoints[i];
+				record.endLaneCounts[i] = road.endLaneCounts[i];
+			}
+			mRoads.push_back(record);
+			break;
+		}
+		case FeatureBuilding:
+		{
+			const Building& building = static_cast<const Building&>(feature);
+			PackedBuilding record = {};
+			record.points = addPoints(building.points);
+			record.height = building.height;
+			mBuildings.push_back(record);
+			break;
+		}
+		case FeatureWater:
+		{
+			PackedWater record = {};
+			record.points = addPoints(static_cast<const Water&>(feature).points);
+			mWaters.push_back(record);
+			break;
+		}
+		case FeatureAirport:
+		{
+			const Airport& airport = static_cast<const Airport&>(feature);
+			PackedAirport record = {};
+			record.runways = PackedRange{toIndex(mRunways.size()), toIndex(airport.runways.size())};
+			for (const Airport::Runway& runway : airport.runways)
+			{
+				PackedRunway runwayRecord = {};
+				runwayRecord.name = PackedRange{toIndex(mStringCharacters.size()), toIndex(runway.name.size())};
+				mStringCharacters.insert(mStringCharacters.end(), runway.name.begin(), runway.name.end());
+				runwayRecord.start = runway.start;
+				runwayRecord.end = runway.end;
+				runwayRecord.width = runway.width;
+				mRunways.push_back(runwayRecord);
+			}
+
+			record.areaPolygons = PackedRange{toIndex(mPolygons.size()), toIndex(airport.areaPolygons.size())};
+			for (const LatLonPoints& polygon : airport.areaPolygons)
+			{
+				mPolygons.push_back(PackedRange{toIndex(mLatLonPoints.size()), toIndex(polygon.size())});
+				mLatLonPoints.insert(mLatLonPoints.end(), polygon.begin(), polygon.end());
+			}
+			record.altitude = airport.altitude;
+			mAirports.push_back(record);
+			break;
+		}
+		default:
+			assert(!"Not implemented");
+		}
+	}
+
+	std::vector<char> createBuffer() const
+	{
+		PackedFeatureTileHeader header = {};
+		std::memcpy(header.magic, packedFileMagic, sizeof(packedFileMagic));
+		header.version = packedFileVersion;
+
+		const void* sectionData[sectionCount] = {
+			mRoads.data(),
+			mBuildings.data(),
+			mWaters.data(),
+			mAirports.data(),
+			mRunways.data(),
+			mPolygons.data(),
+			mLatLonAltPoints.data(),
+			mLatLonPoints.data(),
+			mStringCharacters.data()
+		};
+		const std::size_t sectionSizes[sectionCount] = {
+			mRoads.size(),
+			mBuildings.size(),
+			mWaters.size(),
+			mAirports.size(),
+			mRunways.size(),
+			mPolygons.size(),
+			mLatLonAltPoints.size(),
+			mLatLonPoints.size(),
+			mStringCharacters.size()
+		};
+
+		std::size_t offset = sizeof(PackedFeatureTileHeader);
+		for (int i = 0; i < sectionCount; ++i)
+		{
+			header.sections[i].offset = offset;
+			header.sections[i].size = sectionSizes[i];
+			offset += sectionSizes[i] * sectionElementSizes[i];
+			offset = (offset + packedSectionAlignment - 1) / packedSectionAlignment * packedSectionAlignment;
+		}
+
+		std::vector<char> buffer(offset, 0);
+		std::memcpy(buffer.data(), &header, sizeof(header));
+		for (int i = 0; i < sectionCount; ++i)
+		{
+			if (sectionSizes[i] > 0)
+			{
+				std::memcpy(buffer.data() + header.sections[i].offset, sectionData[i], sectionSizes[i] * sectionElementSizes[i]);
+			}
+		}
+		return buffer;
+	}
+
+private:
+	static std::uint32_t toIndex(std::size_t i)
+	{
+		if (i > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw skybolt::Exception("Feature tile is too large to pack");
+		}
+		return std::uint32_t(i);
+	}
+
+	PackedRange addPoints(const LatLonAltPoints& points)
+	{
+		PackedRange range{toIndex(mLatLonAltPoints.size()), toIndex(points.size())};
+		mLatLonAltPoints.insert(mLatLonAltPoints.end(), points.begin(), points.end());
+		return range;
+	}
+
+private:
+	std::vector<PackedRoad> mRoads;
+	std::vector<PackedBuilding> mBuildings;
+	std::vector<PackedWater> mWaters;
+	std::vector<PackedAirport> mAirports;
+	std::vector<PackedRunway> mRunways;
+	std::vector<PackedRange> mPolygons;
+	std::vector<sim::LatLonAlt> mLatLonAltPoints;
+	std::vector<sim::LatLon> mLatLonPoints;
+	std::vector<char> mStringCharacters;
+};
+
+} // namespace
+
+std::vector<char> packFeatureTile(const std::vector<FeaturePtr>& features)
+{
+	PackedFeatureTileWriter writer;
+	for (const FeaturePtr& feature : features)
+	{
+		writer.add(*feature);
+	}
+	return writer.createBuffer();
+}
+
+static LatLonAltPoints toPoints(const PackedArray<sim::LatLonAlt>& points)
+{
+	return LatLonAltPoints(points.begin(), points.end());
+}
+
+void unpackFeatureTile(const PackedFeatureTile& tile, std::vector<FeaturePtr>& features)
+{
+	features.reserve(features.size() + tile.getFeatureCount());
+
+	for (const PackedRoad& record : tile.getRoads())
+	{
+		auto road = std::make_shared<Road>();
+		road->points = toPoints(tile.getLatLonAltPoints(record.points));
+		road->width = record.width;
+		road->laneCount = record.laneCount;
+		for (int i = 0; i < 2; ++i)
+		{
+			road->endControlPoints[i] = record.endControlPoints[i];
+			road->endLaneCounts[i] = record.endLaneCounts[i];
+		}
+		features.push_back(road);
+	}
+
+	for (const PackedBuilding& record : tile.getBuildings())
+	{
+		auto building = std::make_shared<Building>();
+		building->points = toPoints(tile.getLatLonAltPoints(record.points));
+		building->height = record.height;
+		features.push_back(building);
+	}
+
+	for (const PackedWater& record : tile.getWaters())
+	{
+		auto water = std::make_shared<Water>();
+		water->points = toPoints(tile.getLatLonAltPoints(record.points));
+		features.push_back(water);
+	}
+
+	for (const PackedAirport& record : tile.getAirports())
+	{
+		auto airport = std::make_shared<Airport>();
+		for (const PackedRunway& runwayRecord : tile.getRunways(record.runways))
+		{
+			Airport::Runway runway;
+			runway.name = std::string(tile.getString(runwayRecord.name));
+			runway.start = runwayRecord.start;
+			runway.end = runwayRecord.end;
+			runway.width = runwayRecord.width;
+			airport->runways.push_back(runway);
+		}
+		for (const PackedRange& polygon : tile.getPolygons(record.areaPolygons))
+		{
+			PackedArray<sim::LatLon> points = tile.getLatLonPoints(polygon);
+			airport->areaPolygons.emplace_back(points.begin(), points.end());
+		}
+		airport->altitude = record.altitude;
+		features.push_back(airport);
+	}
+}
+
+bool isPackedFeatureTileFile(const std::string& filename)
+{
+	std::ifstream f(filename, std::ios::binary);
+	if (!f.is_open())
+	{
+		throw skybolt::Exception("Could not open file: " + filename);
+	}
+
+	char magic[sizeof(packedFileMagic)];
+	f.read(magic, sizeof(magic));
+	return f && std::memcmp(magic, packedFileMagic, sizeof(packedFileMagic)) == 0;
+}
+
+std::unique_ptr<PackedFeatureTile> openFeatureTile(const std::string& filename)
+{
+	if (isPackedFeatureTileFile(filename))
+	{
+		return std::make_unique<PackedFeatureTile>(filename);
+	}
+
+	std::vector<FeaturePtr> features;
+	loadTile(filename, features);
+	return std::make_unique<PackedFeatureTile>(packFeatureTile(features));
+}
+
+bool convertTileToPackedFormat(const std::string& filename)
+{
+	if (isPackedFeatureTileFile(filename))
+	{
+		return false;
+	}
+
+	FeatureTile tile;
+	loadTile(filename, tile.features);
+
+	// Write to a temporary file first so that the original is not lost if writing fails
+	std::string tempFilename = filename + ".tmp";
+	saveTile(tile, tempFilename, FeatureTileFormat::Packed);
+	std::filesystem::rename(tempFilename, filename);
+	return true;
+}
+
+std::size_t convertTilesToPackedFormat(const std::string& directory)
+{
+	// Find tiles before converting, because converting modifies the directory
+	std::vector<std::string> filenames;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".ftr")
+		{
+			filenames.push_back(entry.path().string());
+		}
+	}
+
+	std::size_t convertedCount = 0;
+	for (const std::string& filename : filenames)
+	{
+		if (convertTileToPackedFormat(filename))
+		{
+			++convertedCount;
+		}
+	}
+	return convertedCount;
+}
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -0,0 +1,195 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "PlanetFeaturesSource.h"
+#include <SkyboltSim/Spatial/LatLon.h>
+#include <SkyboltSim/Spatial/LatLonAlt.h>
+
+#include <assert.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace boost::interprocess {
+class mapped_region;
+}
+
+namespace skybolt {
+namespace mapfeatures {
+
+//! Range of elements in one of the arrays of a packed feature tile
+struct PackedRange
+{
+	std::uint32_t first;
+	std::uint32_t count;
+};
+
+struct PackedRoad
+{
+	PackedRange points; //!< Range in LatLonAlt points
+	float width;
+	std::int32_t laneCount;
+	sim::LatLonAlt endControlPoints[2]; //!< See Road::endControlPoints
+	std::int32_t endLaneCounts[2]; //!< See Road::endLaneCounts
+};
+
+struct PackedBuilding
+{
+	PackedRange points; //!< Range in LatLonAlt points
+	float height;
+	std::uint32_t padding;
+};
+
+struct PackedWater
+{
+	PackedRange points; //!< Range in LatLonAlt points
+};
+
+struct PackedRunway
+{
+	PackedRange name; //!< Range in string characters
+	sim::LatLon start;
+	sim::LatLon end;
+	float width;
+	std::uint32_t padding;
+};
+
+struct PackedAirport
+{
+	PackedRange runways; //!< Range in runways
+	PackedRange areaPolygons; //!< Range in polygons
+	double altitude;
+};
+
+//! Arrays stored in a packed feature tile, in file order
+enum class PackedFeatureSection
+{
+	Roads,
+	Buildings,
+	Waters,
+	Airports,
+	Runways,
+	Polygons, //!< PackedRange of each polygon in LatLon points
+	LatLonAltPoints,
+	LatLonPoints,
+	StringCharacters,
+	SectionCount
+};
+
+//! Read only view of a contiguous array in a packed feature tile
+template <typename T>
+class PackedArray
+{
+public:
+	PackedArray(const T* data, std::uint32_t size) : mData(data), mSize(size) {}
+
+	const T* begin() const { return mData; }
+	const T* end() const { return mData + mSize; }
+	std::uint32_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+
+	const T& operator[](std::uint32_t i) const
+	{
+		assert(i < mSize);
+		return mData[i];
+	}
+
+private:
+	const T* mData;
+	std::uint32_t mSize;
+};
+
+//! Feature tile stored in a flat binary layout which is used in place without parsing.
+//! The file consists of a header containing the offset and size of each section, followed by
+//! the sections. Each feature type is stored as an array of fixed size records, which refer to
+//! ranges in shared arrays of points and strings.
+//! Files are memory mapped, so only the pages which are read are loaded from storage.
+class PackedFeatureTile
+{
+public:
+	//! Memory maps a packed tile file
+	//! @throws skybolt::Exception if the file could not be opened or is not a valid packed tile
+	explicit PackedFeatureTile(const std::string& filename);
+
+	//! Creates a tile which uses a buffer in memory, e.g. one created by packFeatureTile()
+	//! @throws skybolt::Exception if the buffer is not a valid packed tile
+	explicit PackedFeatureTile(std::vector<char> buffer);
+
+	~PackedFeatureTile();
+
+	PackedArray<PackedRoad> getRoads() const { return getSection<PackedRoad>(PackedFeatureSection::Roads); }
+	PackedArray<PackedBuilding> getBuildings() const { return getSection<PackedBuilding>(PackedFeatureSection::Buildings); }
+	PackedArray<PackedWater> getWaters() const { return getSection<PackedWater>(PackedFeatureSection::Waters); }
+	PackedArray<PackedAirport> getAirports() const { return getSection<PackedAirport>(PackedFeatureSection::Airports); }
+
+	PackedArray<sim::LatLonAlt> getLatLonAltPoints(const PackedRange& range) const { return getRange<sim::LatLonAlt>(PackedFeatureSection::LatLonAltPoints, range); }
+	PackedArray<sim::LatLon> getLatLonPoints(const PackedRange& range) const { return getRange<sim::LatLon>(PackedFeatureSection::LatLonPoints, range); }
+	PackedArray<PackedRunway> getRunways(const PackedRange& range) const { return getRange<PackedRunway>(PackedFeatureSection::Runways, range); }
+	PackedArray<PackedRange> getPolygons(const PackedRange& range) const { return getRange<PackedRange>(PackedFeatureSection::Polygons, range); }
+	std::string_view getString(const PackedRange& range) const;
+
+	//! @returns total number of features of all types
+	std::size_t getFeatureCount() const;
+
+private:
+	void validate();
+
+	template <typename T>
+	PackedArray<T> getSection(PackedFeatureSection section) const
+	{
+		return PackedArray<T>(reinterpret_cast<const T*>(mSectionData[int(section)]), mSectionSizes[int(section)]);
+	}
+
+	//! @throws skybolt::Exception if the range lies outside of the section
+	template <typename T>
+	PackedArray<T> getRange(PackedFeatureSection section, const PackedRange& range) const
+	{
+		checkRange(section, range);
+		return PackedArray<T>(reinterpret_cast<const T*>(mSectionData[int(section)]) + range.first, range.count);
+	}
+
+	void checkRange(PackedFeatureSection section, const PackedRange& range) const;
+
+private:
+	std::unique_ptr<boost::interprocess::mapped_region> mMapping; //!< Null if the tile is in a memory buffer
+	std::vector<char> mBuffer;
+	const char* mData = nullptr;
+	std::size_t mDataSize = 0;
+
+	static constexpr int sectionCount = int(PackedFeatureSection::SectionCount);
+	const char* mSectionData[sectionCount] = {};
+	std::uint32_t mSectionSizes[sectionCount] = {}; //!< Number of elements in each section
+};
+
+//! @returns a buffer containing the features in the packed tile format
+std::vector<char> packFeatureTile(const std::vector<FeaturePtr>& features);
+
+//! Appends features in the packed tile to a feature list
+void unpackFeatureTile(const PackedFeatureTile& tile, std::vector<FeaturePtr>& features);
+
+//! @returns true if the file is a packed feature tile. Files in the legacy format return false.
+//! @throws skybolt::Exception if the file could not be opened
+bool isPackedFeatureTileFile(const std::string& filename);
+
+//! Opens a feature tile in either format. Packed tiles are memory mapped,
+//! and tiles in the legacy format are loaded and packed in memory.
+//! @throws skybolt::Exception if the file could not be loaded
+std::unique_ptr<PackedFeatureTile> openFeatureTile(const std::string& filename);
+
+//! Converts a tile in the legacy format to the packed format in place.
+//! @returns false if the tile is already packed
+bool convertTileToPackedFormat(const std::string& filename);
+
+//! Converts all legacy format tiles in a tile directory written by save() to the packed format in place
+//! @returns the number of tiles converted
+std::size_t convertTilesToPackedFormat(const std::string& directory);
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -5,6 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PlanetFeatures.h"
+#include "PackedFeatureTile.h"
 #include "SkyboltSim/Spatial/GreatCircle.h"
 #include "SkyboltVis/LlaToNedConverter.h"
 #include "SkyboltVis/OsgGeocentric.h"
@@ -21,6 +22,8 @@
 
 #include <cxxtimer/cxxtimer.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/log/trivial.hpp>
+#include <limits>
 #include <mutex>
 
 using namespace skybolt;
@@ -48,7 +51,7 @@ public:
 	}
 
 	//! May be called on multiple threads concurrently
-	std::unique_ptr<LoadedVisObjects> loadVisObjects(const std::vector<mapfeatures::FeaturePtr>& features, const sim::LatLon& latLonOrigin, double planetRadius) const
+	std::unique_ptr<LoadedVisObjects> loadVisObjects(const mapfeatures::PackedFeatureTile& tile, const sim::LatLon& latLonOrigin, double planetRadius) const
 	{
 		std::unique_ptr<LoadedVisObjects> objectsPtr = std::make_unique<LoadedVisObjects>();
 		LoadedVisObjects& objects = *objectsPtr;
@@ -63,96 +66,88 @@ public:
 		Lakes lakes;
 		PolyRegions polyRegions;
 
-		for (const mapfeatures::FeaturePtr& feature : features)
+		// Features are read in place from the packed tile, so the only allocations are for the vis objects
+		for (const mapfeatures::PackedRoad& srcRoad : tile.getRoads())
 		{
-			switch (feature->type())
+			Road road;
+			mapfeatures::PackedArray<sim::LatLonAlt> points = tile.getLatLonAltPoints(srcRoad.points);
+			road.points.reserve(points.size());
+			for (const sim::LatLonAlt& point : points)
 			{
-			case mapfeatures::FeatureRoad:
-			{
-				const mapfeatures::Road& srcRoad = static_cast<const mapfeatures::Road&>(*feature);
+				road.points.push_back(converter.latLonAltToCartesianNed(point));
+			}
+			road.width = srcRoad.width;
+			road.laneCount = srcRoad.laneCount;
 
-				Road road;
-				for (int j = 0; j < srcRoad.points.size(); ++j)
+			for (int i = 0; i < 2; ++i)
+			{
+				road.endLaneCounts[i] = srcRoad.endLaneCounts[i];
+				if (road.endLaneCounts[i] != -1)
 				{
-					osg::Vec3f pos = converter.latLonAltToCartesianNed(srcRoad.points[j]);
-					road.points.push_back(pos);
+					road.endControlPoints[i] = converter.latLonAltToCartesianNed(srcRoad.endControlPoints[i]);
 				}
-				road.width = srcRoad.width;
-				road.laneCount = srcRoad.laneCount;
-				
-				for (int i = 0; i < 2; ++i)
-				{
-					road.endLaneCounts[i] = srcRoad.endLaneCounts[i];
-					if (road.endLaneCounts[i] != -1)
-					{
-						road.endControlPoints[i] = converter.latLonAltToCartesianNed(srcRoad.endControlPoints[i]);
-					}
-				}
-				roads.push_back(road);
 			}
-			break;
-			case mapfeatures::FeatureBuilding:
+			roads.push_back(std::move(road));
+		}
+
+		buildings.reserve(tile.getBuildings().size());
+		for (const mapfeatures::PackedBuilding& srcBuilding : tile.getBuildings())
+		{
+			Building building;
+			mapfeatures::PackedArray<sim::LatLonAlt> points = tile.getLatLonAltPoints(srcBuilding.points);
+			building.points.reserve(points.size());
+			for (const sim::LatLonAlt& point : points)
 			{
-				Building building;
-				const mapfeatures::Building& srcBuilding = static_cast<const mapfeatures::Building&>(*feature);
-				for (int j = 0; j < srcBuilding.points.size(); ++j)
-				{
-					osg::Vec3f pos = converter.latLonAltToCartesianNed(srcBuilding.points[j]);
-					building.points.push_back(pos);
-				}
-				building.height = srcBuilding.height;
-				buildings.push_back(building);
+				building.points.push_back(converter.latLonAltToCartesianNed(point));
+			}
+			building.height = srcBuilding.height;
+			buildings.push_back(std::move(building));
+		}
+
+		for (const mapfeatures::PackedWater& srcWater : tile.getWaters())
+		{
+			Lake lake;
+			mapfeatures::PackedArray<sim::LatLonAlt> points = tile.getLatLonAltPoints(srcWater.points);
+			lake.points.reserve(points.size());
+			for (const sim::LatLonAlt& point : points)
+			{
+				lake.points.push_back(converter.latLonAltToCartesianNed(point));
 			}
-			break;
-			case mapfeatures::FeatureWater:
+			lakes.push_back(std::move(lake));
+		}
+
+		for (const mapfeatures::PackedAirport& srcAirport : tile.getAirports())
+		{
+			for (const mapfeatures::PackedRunway& srcRunway : tile.getRunways(srcAirport.runways))
 			{
-				Lake lake;
-				const mapfeatures::Water& srcWater = static_cast<const mapfeatures::Water&>(*feature);
-				for (int j = 0; j < srcWater.points.size(); ++j)
+				Runway runway;
+				runway.startPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.start, srcAirport.altitude));
+				runway.endPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.end, srcAirport.altitude));
+
+				std::vector<std::string> strs;
+				std::string_view name = tile.getString(srcRunway.name);
+				boost::split(strs, name, boost::is_any_of("\\/"));
+				if (strs.size() == 2)
 				{
-					osg::Vec3f pos = converter.latLonAltToCartesianNed(srcWater.points[j]);
-					lake.points.push_back(pos);
+					runway.startMarking = strs.front();
+					runway.endMarking = strs.back();
 				}
 
-				lakes.push_back(lake);
+				runway.width = srcRunway.width;
+				runways.push_back(runway);
 			}
-			break;
-			case mapfeatures::FeatureAirport:
+			if (0)
 			{
-				const mapfeatures::Airport& srcAirport = static_cast<const mapfeatures::Airport&>(*feature);
-				for (const mapfeatures::Airport::Runway& srcRunway : srcAirport.runways)
-				{
-					Runway runway;
-					runway.startPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.start, srcAirport.altitude));
-					runway.endPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.end, srcAirport.altitude));
-
-					std::vector<std::string> strs;
-					boost::split(strs, srcRunway.name, boost::is_any_of("\\/"));
-					if (strs.size() == 2)
-					{
-						runway.startMarking = strs.front();
-						runway.endMarking = strs.back();
-					}
-
-					runway.width = srcRunway.width;
-					runways.push_back(runway);
-				}
-				if (0)
+				for (const mapfeatures::PackedRange& polygon : tile.getPolygons(srcAirport.areaPolygons))
 				{
-					for (const LatLonPoints& polygon : srcAirport.areaPolygons)
+					PolyRegion region;
+					for (const sim::LatLon& point : tile.getLatLonPoints(polygon))
 					{
-						PolyRegion region;
-						for (int j = 0; j < polygon.size(); ++j)
-						{
-							region.points.push_back(converter.latLonAltToCartesianNed(toLatLonAlt(polygon[j], srcAirport.altitude)));
-						}
-						polyRegions.push_back(region);
+						region.points.push_back(converter.latLonAltToCartesianNed(toLatLonAlt(point, srcAirport.altitude)));
 					}
+					polyRegions.push_back(region);
 				}
 			}
-			break;
-			assert(!"Not implemented");
-			}
 		}
 
 		osg::ref_ptr<osg::Program> modelProgram = mPrograms->getRequiredProgram("model");
@@ -243,7 +238,7 @@ bool shouldKeep(const VisFeatureTile& tile) { return false; }
 PlanetFeatures::~PlanetFeatures()
 {
 	// Cancel all loading tasks and wait for them to finish
-	for (const LoadingItemPtr& item : mLoadingQueue)
+	for (const auto& [tile, item] : mPendingLoads)
 	{
 		item->cancel = true;
 		CALL_LISTENERS(featureLoadDequeued());
@@ -292,16 +287,18 @@ void PlanetFeatures::onSurfaceTileAdded(const QuadTreeTileKey& key)
 
 void PlanetFeatures::updatePreRender(const CameraRenderContext& context)
 {
-	processLoadingQueue();
-
 	if (context.loadTimingPolicy == LoadTimingPolicy::LoadBeforeRender)
 	{
-		while (!mLoadingQueue.empty())
-		{
-			processLoadingQueue();
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		}
+		// Workers push loads to the completed queue before their tasks finish,
+		// so once the sync is released every pending load can be integrated.
+		mScheduler->waitFor(mLoadingTaskSync);
+		integrateCompletedLoads(std::numeric_limits<double>::infinity());
 	}
+	else
+	{
+		integrateCompletedLoads(mIntegrationTimeBudgetMilliseconds);
+	}
+	CALL_LISTENERS(featureLoaderStatsUpdated(mStats));
 
 	auto& tree = (skybolt::DiQuadTree<VisFeatureTile>&)(mFeatures.tree);
 
@@ -323,17 +320,26 @@ void PlanetFeatures::loadTile(VisFeatureTile& tile)
 
 			LoadingItemPtr loadingItem(new LoadingItem);
 			loadingItem->tile = &tile;
-			mLoadingQueue.push_back(loadingItem);
+			loadingItem->requestTime = std::chrono::steady_clock::now();
+			mPendingLoads[&tile] = loadingItem;
 			CALL_LISTENERS(featureLoadEnqueued());
 
 			mScheduler->run([=]()
 			{
 				if (!loadingItem->cancel) // if Tile hasn't been canceled by the time the scheduled task runs
 				{
-					std::vector<mapfeatures::FeaturePtr> features;
-					mapfeatures::loadTile(filename, features);
+					try
+					{
+						std::unique_ptr<mapfeatures::PackedFeatureTile> features = mapfeatures::openFeatureTile(filename);
+						loadingItem->objects = mVisObjectsLoadTask->loadVisObjects(*features, origin, mPlanetRadius);
+					}
+					catch (const std::exception& e)
+					{
+						// Complete the load without objects, so that the tile is dequeued and the load queue drains
+						BOOST_LOG_TRIVIAL(error) << "Could not load feature tile '" << filename << "': " << e.what();
+					}
 
-					loadingItem->objects = mVisObjectsLoadTask->loadVisObjects(features, origin, mPlanetRadius);
+					mCompletedLoads.push(loadingItem);
 				}
 			}, &mLoadingTaskSync);
 		}
@@ -345,6 +351,15 @@ void PlanetFeatures::unloadTile(VisFeatureTile& tile)
 	assert(tile.loaded);
 	tile.loaded = false;
 
+	auto pendingLoad = mPendingLoads.find(&tile);
+	if (pendingLoad != mPendingLoads.end())
+	{
+		// The load may still complete, in which case it is discarded by integrateCompletedLoads()
+		pendingLoad->second->cancel = true;
+		mPendingLoads.erase(pendingLoad);
+		CALL_LISTENERS(featureLoadDequeued());
+	}
+
 	LoadedVisObjects* objects = tile.visObjects.get();
 	if (objects)
 	{
@@ -359,64 +374,65 @@ void PlanetFeatures::unloadTile(VisFeatureTile& tile)
 	}
 }
 
-void PlanetFeatures::processLoadingQueue()
+void PlanetFeatures::integrateCompletedLoads(double timeBudgetMilliseconds)
 {
-	static const int maxItemsPerUpdate = 1;
-	int loadedItems = 0;
-	for (size_t i = 0; i < mLoadingQueue.size();)
-	{
-		LoadingItem& item = *mLoadingQueue[i];
+	auto startTime = std::chrono::steady_clock::now();
+	double totalLatencyMilliseconds = 0;
 
-		bool erase = !item.tile->loaded;
-		if (erase)
+	std::size_t integratedCount = mCompletedLoads.process(timeBudgetMilliseconds, [&] (const LoadingItemPtr& item) {
+		// Items are only canceled on this thread, after being removed from the pending loads
+		if (item->cancel)
 		{
-			item.cancel = true;
+			return false;
 		}
-		else if (loadedItems < maxItemsPerUpdate)
-		{
-			std::unique_ptr<LoadedVisObjects>& objects = item.objects;
-			if (objects)
-			{
-#ifdef DEBUG_PLANET_FREATURES_LOAD_TIMES
-				cxxtimer::Timer timer;
-				timer.start();
-#endif
-
-				for (int i = 0; i < PlanetFeaturesParams::featureGroupsSize; ++i)
-				{
-					for (const RootNodePtr& node : objects->nodes[i])
-					{
-						osg::Vec3d pos = llaToGeocentric(osg::Vec2d(objects->latLonOrigin.lat, objects->latLonOrigin.lon), 0, mPlanetRadius);
-						osg::Matrixd mat = osg::Matrixd::translate(pos);
-						mat.setRotate(latLonToGeocentricLtpOrientation(osg::Vec2d(objects->latLonOrigin.lat, objects->latLonOrigin.lon)));
 
-						node->setTransform(mat);
-						mGroups[i]->addChild(node->_getNode());
-					}
-				}
+		integrate(*item);
+		totalLatencyMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - item->requestTime).count();
+		return true;
+	});
 
-				item.tile->visObjects = std::move(objects);
-				mLoadedVisObjects.push_back(item.tile->visObjects.get());
-				erase = true;
-				++loadedItems;
+	mStats.integrationMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	if (integratedCount > 0)
+	{
+		mStats.totalLoadLatencyMilliseconds = totalLatencyMilliseconds;
+		mStats.loadLatencySampleCount = integratedCount;
+	}
+	mStats.completedLoadsAwaitingIntegration = mCompletedLoads.size();
+}
 
+void PlanetFeatures::integrate(LoadingItem& item)
+{
 #ifdef DEBUG_PLANET_FREATURES_LOAD_TIMES
-				printf("Feature %lli\n", timer.count());
-				timer.reset();
+	cxxtimer::Timer timer;
+	timer.start();
 #endif
-			}
-		}
 
-		if (erase)
-		{
-			mLoadingQueue.erase(mLoadingQueue.begin() + i);
-			CALL_LISTENERS(featureLoadDequeued());
-		}
-		else
+	std::unique_ptr<LoadedVisObjects>& objects = item.objects;
+	if (objects) // null if the load failed
+	{
+		for (int i = 0; i < PlanetFeaturesParams::featureGroupsSize; ++i)
 		{
-			++i;
+			for (const RootNodePtr& node : objects->nodes[i])
+			{
+				osg::Vec3d pos = llaToGeocentric(osg::Vec2d(objects->latLonOrigin.lat, objects->latLonOrigin.lon), 0, mPlanetRadius);
+				osg::Matrixd mat = osg::Matrixd::translate(pos);
+				mat.setRotate(latLonToGeocentricLtpOrientation(osg::Vec2d(objects->latLonOrigin.lat, objects->latLonOrigin.lon)));
+
+				node->setTransform(mat);
+				mGroups[i]->addChild(node->_getNode());
+			}
 		}
+
+		item.tile->visObjects = std::move(objects);
+		mLoadedVisObjects.push_back(item.tile->visObjects.get());
 	}
+
+	mPendingLoads.erase(item.tile);
+	CALL_LISTENERS(featureLoadDequeued());
+
+#ifdef DEBUG_PLANET_FREATURES_LOAD_TIMES
+	printf("Feature %lli\n", timer.count());
+#endif
 }
 
 void PlanetFeatures::updatePreRender(LoadedVisObjects& objects, const CameraRenderContext& context) const
@@ -14,9 +14,14 @@
 #include <SkyboltCommon/Listenable.h>
 #include <SkyboltCommon/File/FileLocator.h>
 #include <SkyboltCommon/Math/QuadTree.h>
+#include <SkyboltCommon/TimeBudgetedQueue.h>
 #include <px_sched/px_sched.h>
 #include <osg/MatrixTransform>
 
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
 namespace skybolt {
 namespace vis {
 
@@ -43,11 +48,23 @@ struct PlanetFeaturesParams
 	osg::Group* groups[featureGroupsSize];
 };
 
+struct PlanetFeaturesStats
+{
+	std::size_t completedLoadsAwaitingIntegration = 0; //!< Loads finished on worker threads which are waiting to be added to the scene
+	double integrationMilliseconds = 0; //!< Main thread time spent adding loaded tiles to the scene in the last update
+
+	// Time from request until being added to the scene, for tiles added in the most recent update which added any.
+	// The total and count are reported rather than the mean, so that stats from several planets can be combined.
+	double totalLoadLatencyMilliseconds = 0;
+	std::size_t loadLatencySampleCount = 0;
+};
+
 struct PlanetFeaturesListener
 {
 	virtual ~PlanetFeaturesListener() = default;
 	virtual void featureLoadEnqueued() {}
 	virtual void featureLoadDequeued() {}
+	virtual void featureLoaderStatsUpdated(const PlanetFeaturesStats& stats) {}
 };
 
 class PlanetFeatures : public skybolt::Listenable<PlanetFeaturesListener>
@@ -60,14 +77,31 @@ public:
 
 	void updatePreRender(const CameraRenderContext& context);
 
-	std::size_t getLoadQueueSize() const { return mLoadingQueue.size(); }
+	std::size_t getLoadQueueSize() const { return mPendingLoads.size(); }
+
+	//! Sets the time budget for adding loaded tiles to the scene in each updatePreRender().
+	//! At least one loaded tile is added per update regardless of the budget.
+	void setIntegrationTimeBudgetMilliseconds(double milliseconds) { mIntegrationTimeBudgetMilliseconds = milliseconds; }
+
+	const PlanetFeaturesStats& getStats() const { return mStats; }
 
 private:
+	struct LoadingItem
+	{
+		VisFeatureTile* tile;
+		std::unique_ptr<LoadedVisObjects> objects; //!< Null if the load failed
+		std::atomic<bool> cancel = false;
+		std::chrono::steady_clock::time_point requestTime;
+	};
+	typedef std::shared_ptr<LoadingItem> LoadingItemPtr;
+
 	void loadTile(VisFeatureTile& tile);
 	void unloadTile(VisFeatureTile& tile);
 
-private:
-	void processLoadingQueue();
+	//! Adds completed loads to the scene, in order of completion, until the time budget is spent.
+	//! See TimeBudgetedQueue::process() for the ordering and budget rules.
+	void integrateCompletedLoads(double timeBudgetMilliseconds);
+	void integrate(LoadingItem& item);
 
 	void updatePreRender(LoadedVisObjects& objects, const CameraRenderContext& context) const;
 	void unload(LoadedVisObjects& objects) const;
@@ -84,16 +118,13 @@ private:
 	const std::string mTilesDirectoryRelAssetPackage;
 	std::vector<LoadedVisObjects*> mLoadedVisObjects;
 
-	struct LoadingItem
-	{
-		VisFeatureTile* tile;
-		std::unique_ptr<LoadedVisObjects> objects;
-		std::atomic<bool> cancel = false;
-	};
-	typedef std::shared_ptr<LoadingItem> LoadingItemPtr;
+	std::unordered_map<VisFeatureTile*, LoadingItemPtr> mPendingLoads; //!< Loads which have been requested but not yet added to the scene
 
-	std::vector<LoadingItemPtr> mLoadingQueue;
+	TimeBudgetedQueue<LoadingItemPtr> mCompletedLoads; //!< Pushed by worker threads when loads finish
 	px_sched::Sync mLoadingTaskSync;
+
+	double mIntegrationTimeBudgetMilliseconds = 2.0;
+	PlanetFeaturesStats mStats;
 };
 
 } // namespace vis
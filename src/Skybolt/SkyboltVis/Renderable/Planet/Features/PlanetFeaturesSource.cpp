@@ -5,6 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PlanetFeaturesSource.h"
+#include "PackedFeatureTile.h"
 #include <SkyboltCommon/Exception.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <nlohmann/json.hpp>
@@ -363,6 +364,12 @@ static const uint32_t fileVersion = 1;
 
 void loadTile(const std::string& filename, std::vector<FeaturePtr>& features)
 {
+	if (isPackedFeatureTileFile(filename))
+	{
+		unpackFeatureTile(PackedFeatureTile(filename), features);
+		return;
+	}
+
 	std::ifstream f(filename, std::ios::binary);
 
 	if (!f.is_open())
@@ -381,9 +388,21 @@ void loadTile(const std::string& filename, std::vector<FeaturePtr>& features)
 	load(f, features);
 }
 
-void saveTile(const FeatureTile& tile, const std::string& filename)
+void saveTile(const FeatureTile& tile, const std::string& filename, FeatureTileFormat format)
 {
 	std::ofstream f(filename, std::ios::binary);
+	if (!f.is_open())
+	{
+		throw Exception("Could not create file: " + filename);
+	}
+
+	if (format == FeatureTileFormat::Packed)
+	{
+		std::vector<char> buffer = packFeatureTile(tile.features);
+		f.write(buffer.data(), buffer.size());
+		f.close();
+		return;
+	}
 
 	// Write file version
 	int version = fileVersion;
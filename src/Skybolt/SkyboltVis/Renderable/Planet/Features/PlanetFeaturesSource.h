@@ -150,7 +150,15 @@ struct TreeCreatorParams
 
 WorldFeatures createWorldFeatures(const TreeCreatorParams& params, const std::vector<FeaturePtr>& features);
 
-void saveTile(const FeatureTile& tile, const std::string& filename);
+enum class FeatureTileFormat
+{
+	Legacy, //!< Stream of serialized features, which must be parsed
+	Packed //!< Flat layout which can be memory mapped and used in place. See PackedFeatureTile.
+};
+
+void saveTile(const FeatureTile& tile, const std::string& filename, FeatureTileFormat format = FeatureTileFormat::Packed);
+
+//! Loads a tile in either format
 void loadTile(const std::string& filename, std::vector<FeaturePtr>& features);
 
 void save(const WorldFeatures::DiQuadTree& tree, const std::string& directory);
@@ -236,6 +236,7 @@ Planet::Planet(const PlanetConfig& config) :
 		surfaceConfig.parentTransform = mTransform;
 		surfaceConfig.gpuForest = forest;
 		surfaceConfig.planetTileSources = *config.planetTileSources;
+		surfaceConfig.tileImageCache = config.tileImageCache;
 		surfaceConfig.oceanEnabled = config.waterEnabled;
 		surfaceConfig.cloudsTexture = config.cloudsTexture;
 		surfaceConfig.tileTexturesProvider = createSurfaceTileTexturesProvider(textureCache);
@@ -317,6 +318,8 @@ Planet::Planet(const PlanetConfig& config) :
 			cloudsConfig.outerCloudLayerRadius = config.innerRadius + 8000;
 			cloudsConfig.cloudsTexture = config.cloudsTexture;
 			cloudsConfig.applyTemporalUpscalingJitter = config.cloudRenderingParams.enableTemporalUpscaling;
+			cloudsConfig.scheduler = config.scheduler;
+			cloudsConfig.cacheDirectory = config.cacheDirectory;
 			mVolumeClouds = std::make_unique<VolumeClouds>(cloudsConfig);
 		}
 
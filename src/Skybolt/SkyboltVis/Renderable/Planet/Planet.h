@@ -33,6 +33,7 @@ namespace vis {
 struct PlanetConfig
 {
 	px_sched::Scheduler* scheduler;
+	std::string cacheDirectory; //!< Skybolt cache directory
 	const ShaderPrograms* programs;
 	Scene* scene;
 	float innerRadius;
@@ -43,6 +44,7 @@ struct PlanetConfig
 	//! If true, height map edge texels are assumed to run along tile edges.
 	//! If false, height map edge texels are assumed to be be offset half a texel inside the tile.
 	bool heightMapTexelsOnTileEdge = false;
+	TileImageCachePtr tileImageCache; //!< Caches images derived from tile source images. May be null.
 
 	// Atmosphere
 	std::optional<BruentonAtmosphereConfig> atmosphereConfig;
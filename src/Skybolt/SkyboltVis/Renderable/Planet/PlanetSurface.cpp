@@ -93,7 +93,7 @@ PlanetSurface::PlanetSurface(const PlanetSurfaceConfig& config) :
 	mPredicate->observerLatLon = osg::Vec2(0, 0);
 	mPredicate->planetRadius = config.radius;
 
-	auto imageLoader = std::make_shared<PlanetTileImagesLoader>(config.radius);
+	auto imageLoader = std::make_shared<PlanetTileImagesLoader>(config.radius, config.tileImageCache);
 	imageLoader->elevationLayer = planetTileSources.elevation;
 	imageLoader->landMaskLayer = planetTileSources.landMask;
 	imageLoader->attributeLayer = planetTileSources.attribute;
@@ -113,16 +113,21 @@ bool PlanetSurface::updateGeometry()
 {
 	mTileSource->update();
 
-	// Get added and removed tile images
-	TileKeyImagesMap addedTiles;
-	std::set<QuadTreeTileKey> removedTiles;
-	QuadTreeTileLoader::LoadedTileTreePtr tree = mTileSource->getLoadedTree();
+	// Get tiles added and removed since the last update
+	LeafTileChanges changes;
+	mTileSource->getLeafTileChanges(mLeafTileChangeVersion, changes);
+	const TileKeyImagesMap& addedTiles = changes.addedTiles;
+	const std::set<QuadTreeTileKey>& removedTiles = changes.removedTiles;
 
+	// If the change history was lost, remove all tiles and recreate them from the full leaf set
+	if (changes.reset)
 	{
-		TileKeyImagesMap currentLeafTileImages;
-		findLeafTiles(*tree, currentLeafTileImages);
-		findAddedAndRemovedTiles(mLeafTileImages, currentLeafTileImages, addedTiles, removedTiles);
-		std::swap(mLeafTileImages, currentLeafTileImages);
+		for (const auto& [key, tile] : mTileNodes)
+		{
+			mGroup->removeChild(tile.transform);
+			CALL_LISTENERS(tileRemovedFromSceneGraph(key));
+		}
+		mTileNodes.clear();
 	}
 
 	// Remove OSG nodes for removed tiles
@@ -147,7 +152,7 @@ bool PlanetSurface::updateGeometry()
 		auto textureTiles = mTileTexturesProvider(images);
 		auto bounds = getKeyLonLatBounds<osg::Vec2d>(key);
 		Box2d latLonBounds(math::vec2SwapComponents(bounds.minimum), math::vec2SwapComponents(bounds.maximum));
-		OsgTile osgTile = mOsgTileFactory->createOsgTile(key, latLonBounds, textureTiles);
+		OsgTile osgTile = mOsgTileFactory->createOsgTile(key, latLonBounds, textureTiles, images.vertices);
 
 		mGroup->addChild(osgTile.transform);
 		mTileNodes[key] = osgTile;
@@ -157,7 +162,7 @@ bool PlanetSurface::updateGeometry()
 
 	if (mGpuForest)
 	{
-		mGpuForest->updateFromTree(*tree);
+		mGpuForest->updateFromLeafTileChanges(changes, *mTileSource->getLoadedTree());
 	}
 
 	// Iif tiles were added this update, we might need to load their children next update.
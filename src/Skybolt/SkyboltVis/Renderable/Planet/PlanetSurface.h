@@ -40,6 +40,7 @@ struct PlanetSurfaceConfig
 	const ShaderPrograms* programs;
 	osg::ref_ptr<osg::MatrixTransform> parentTransform; //!< Planet transform
 	PlanetTileSources planetTileSources;
+	TileImageCachePtr tileImageCache; //!< Caches images derived from tile source images. May be null.
 	float radius; //!< Radius of planet surface
 	osg::ref_ptr<osg::Texture2D> cloudsTexture; //!< Set to null to disable clouds
 
@@ -84,7 +85,7 @@ private:
 	osg::ref_ptr<osg::MatrixTransform> mParentTransform;
 	osg::ref_ptr<osg::Group> mGroup;
 
-	TileKeyImagesMap mLeafTileImages;
+	std::uint64_t mLeafTileChangeVersion = 0; //!< Version of mTileSource's leaf tile change log which has been consumed
 	typedef std::map<skybolt::QuadTreeTileKey, OsgTile> TileNodeMap;
 	TileNodeMap mTileNodes;
 };
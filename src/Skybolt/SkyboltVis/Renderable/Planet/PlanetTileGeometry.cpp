@@ -8,9 +8,11 @@
 #include "OsgGeometryHelpers.h"
 #include "SkyboltVis/OsgGeocentric.h"
 #include "SkyboltVis/OsgMathHelpers.h"
+#include <SkyboltCommon/LruCacheMap.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <osg/Geode>
 #include <assert.h>
+#include <mutex>
 
 using namespace skybolt;
 
@@ -31,68 +33,202 @@ osg::PrimitiveSet::Mode toOsgPrimitiveType(PrimitiveType type)
 	}
 }
 
-osg::Geometry* createPlanetTileGeometry(const osg::Vec3d& tileCenter, const Box2d& latLonBounds,
-	double radius, float skirtLength, PrimitiveType type)
-{
-	osg::Vec3Array* posBuffer = new osg::Vec3Array();
-	osg::UIntArray* indexBuffer = new osg::UIntArray();
-	int segmentCountX = 64;
-	int segmentCountY = 64;
+//! Number of grid segments along each tile edge, including the skirt segments
+constexpr int segmentCount = 64;
 
-	createPlaneBuffers(*posBuffer, *indexBuffer, osg::Vec2f(0,0), osg::Vec2f(1,1), segmentCountX, segmentCountY, type);
+//! Maximum number of latitude band templates to keep in memory
+constexpr size_t latitudeBandCacheCapacity = 256;
 
-	osg::Vec2Array* uvBuffer = new osg::Vec2Array();
-	uvBuffer->resize(posBuffer->size());
+static osg::ref_ptr<osg::DrawElementsUInt> createSharedPrimitiveSet(PrimitiveType type)
+{
+	osg::ref_ptr<osg::Vec3Array> posBuffer = new osg::Vec3Array();
+	osg::ref_ptr<osg::UIntArray> indexBuffer = new osg::UIntArray();
+	createPlaneBuffers(*posBuffer, *indexBuffer, osg::Vec2f(0,0), osg::Vec2f(1,1), segmentCount, segmentCount, type);
 
-	int countX = segmentCountX + 1;
-	int countY = segmentCountY + 1;
-	int innerMaxX = segmentCountX - 2;
-	int innerMaxY = segmentCountY - 2;
+	osg::ref_ptr<osg::DrawElementsUInt> primitiveSet = new osg::DrawElementsUInt(toOsgPrimitiveType(type), indexBuffer->size(), (GLuint*)indexBuffer->getDataPointer());
+	primitiveSet->setElementBufferObject(new osg::ElementBufferObject);
+	return primitiveSet;
+}
 
-	osg::BoundingBoxf bounds;
+//! @returns index buffer shared by all tiles with the given primitive type
+static osg::DrawElementsUInt* getSharedPrimitiveSet(PrimitiveType type)
+{
+	static osg::ref_ptr<osg::DrawElementsUInt> triangles = createSharedPrimitiveSet(Triangles);
+	static osg::ref_ptr<osg::DrawElementsUInt> quads = createSharedPrimitiveSet(Quads);
+	return (type == Triangles) ? triangles.get() : quads.get();
+}
 
-	size_t i = 0;
-	for (int y = 0; y < countY; ++y)
+static osg::ref_ptr<osg::Vec2Array> createSharedUvs()
+{
+	int innerMaxX = segmentCount - 2;
+	int innerMaxY = segmentCount - 2;
+
+	osg::ref_ptr<osg::Vec2Array> uvBuffer = new osg::Vec2Array();
+	uvBuffer->reserve((segmentCount + 1) * (segmentCount + 1));
+	for (int y = 0; y <= segmentCount; ++y)
 	{
-		for (int x = 0; x < countX; ++x)
+		for (int x = 0; x <= segmentCount; ++x)
 		{
-			bool skirt = (x == 0 || x == segmentCountX || y == 0 || y == segmentCountY);
+			// Clamp so that skirt vertices have the same uvs as the tile edge vertices
 			osg::Vec2f uv;
 			uv.x() = (float)math::clamp(x - 1, 0, innerMaxX) / (float)innerMaxX;
 			uv.y() = (float)math::clamp(y - 1, 0, innerMaxY) / (float)innerMaxY;
+			uvBuffer->push_back(uv);
+		}
+	}
+	uvBuffer->setBufferObject(new osg::VertexBufferObject);
+	return uvBuffer;
+}
+
+//! @returns texture coordinates shared by all tiles
+static osg::Vec2Array* getSharedUvs()
+{
+	static osg::ref_ptr<osg::Vec2Array> uvs = createSharedUvs();
+	return uvs.get();
+}
+
+//! Identifies a row of tiles which have the same latitude bounds and longitude extent.
+//! All tiles in the band have the same shape, differing only by a rotation about the planet axis.
+struct LatitudeBandKey
+{
+	double minLatitude;
+	double maxLatitude;
+	double longitudeSize;
 
-			osg::Vec2d latLon = latLonBounds.getPointFromNormalizedCoord(math::vec2SwapComponents(uv));
+	bool operator==(const LatitudeBandKey& other) const
+	{
+		return minLatitude == other.minLatitude && maxLatitude == other.maxLatitude && longitudeSize == other.longitudeSize;
+	}
+};
+
+} // namespace vis
+} // namespace skybolt
+
+namespace std {
+
+template <>
+struct hash<skybolt::vis::LatitudeBandKey>
+{
+	size_t operator()(const skybolt::vis::LatitudeBandKey& key) const
+	{
+		size_t h = std::hash<double>()(key.minLatitude);
+		h = h * 31 + std::hash<double>()(key.maxLatitude);
+		h = h * 31 + std::hash<double>()(key.longitudeSize);
+		return h;
+	}
+};
+
+} // namespace std
+
+namespace skybolt {
+namespace vis {
 
+//! Unit vectors from the planet center to each grid vertex of a tile centered on zero longitude
+using LatitudeBandTemplate = std::vector<osg::Vec3d>;
+using LatitudeBandTemplatePtr = std::shared_ptr<const LatitudeBandTemplate>;
+
+static LatitudeBandTemplatePtr createLatitudeBandTemplate(const LatitudeBandKey& key)
+{
+	const osg::Vec2Array& uvs = *getSharedUvs();
+	auto result = std::make_shared<LatitudeBandTemplate>(uvs.size());
+	for (size_t i = 0; i < uvs.size(); ++i)
+	{
+		const osg::Vec2f& uv = uvs[i];
+		osg::Vec2d latLon(
+			key.minLatitude + double(uv.y()) * (key.maxLatitude - key.minLatitude),
+			(double(uv.x()) - 0.5) * key.longitudeSize);
+		(*result)[i] = llaToGeocentric(latLon, 0, 1);
+	}
+	return result;
+}
+
+static LatitudeBandTemplatePtr getLatitudeBandTemplate(const Box2d& latLonBounds)
+{
+	static std::mutex mutex;
+	static LruCacheMap<LatitudeBandKey, LatitudeBandTemplatePtr> cache(latitudeBandCacheCapacity);
+
+	LatitudeBandKey key{latLonBounds.minimum.x(), latLonBounds.maximum.x(), latLonBounds.size().y()};
+	LatitudeBandTemplatePtr result;
+	{
+		std::scoped_lock<std::mutex> lock(mutex);
+		if (cache.get(key, result))
+		{
+			return result;
+		}
+	}
+
+	// Create the template outside of the lock so that other threads are not blocked
+	result = createLatitudeBandTemplate(key);
+
+	std::scoped_lock<std::mutex> lock(mutex);
+	cache.putSafe(key, result);
+	return result;
+}
+
+float calcPlanetTileSkirtLength(const Box2d& latLonBounds, double planetRadius)
+{
+	return 0.005 * latLonBounds.size().length() * planetRadius; // TODO: tweak
+}
+
+PlanetTileVerticesPtr createPlanetTileVertices(const osg::Vec3d& tileCenter, const Box2d& latLonBounds,
+	double radius, float skirtLength, const HeightMapElevationBounds& elevationBounds)
+{
+	LatitudeBandTemplatePtr bandTemplate = getLatitudeBandTemplate(latLonBounds);
+
+	// Rotate template from zero longitude to the tile's longitude
+	double centerLongitude = latLonBounds.center().y();
+	double cosLon = std::cos(centerLongitude);
+	double sinLon = std::sin(centerLongitude);
+
+	auto result = std::make_shared<PlanetTileVertices>();
+	result->positions = new osg::Vec3Array(bandTemplate->size());
+	result->positions->setBufferObject(new osg::VertexBufferObject);
+
+	size_t i = 0;
+	for (int y = 0; y <= segmentCount; ++y)
+	{
+		for (int x = 0; x <= segmentCount; ++x)
+		{
+			const osg::Vec3d& d = (*bandTemplate)[i];
+			osg::Vec3d direction(cosLon * d.x() - sinLon * d.y(), sinLon * d.x() + cosLon * d.y(), d.z());
+
+			bool skirt = (x == 0 || x == segmentCount || y == 0 || y == segmentCount);
 			double effectiveRadius = skirt ? (radius - double(skirtLength)) : radius;
-			osg::Vec3f pos = llaToGeocentric(latLon, 0, effectiveRadius) - tileCenter;
-			posBuffer->at(i) = pos;
-			uvBuffer->at(i) = uv;
+			(*result->positions)[i] = direction * effectiveRadius - tileCenter;
 			++i;
 
-			// Add point to bounding box, with some vertical padding to ensure vertical bounds are large enough to account for height in heightmap.
-			// TODO: use actual tile vertical bounds.
-			pos = llaToGeocentric(latLon, 0, radius - 9000) - tileCenter; // lowest point
-			bounds.expandBy(pos);
-			pos = llaToGeocentric(latLon, 0, radius + 9000) - tileCenter; // highest point
-			bounds.expandBy(pos);
+			// Expand bounds by lowest and highest points the vertex can be displaced to by the height map
+			result->bounds.expandBy(direction * (effectiveRadius + elevationBounds.x()) - tileCenter);
+			result->bounds.expandBy(direction * (effectiveRadius + elevationBounds.y()) - tileCenter);
 		}
 	}
+	return result;
+}
 
+osg::Geometry* createPlanetTileGeometry(const PlanetTileVertices& vertices, PrimitiveType type)
+{
 	osg::Geometry *geometry = new osg::Geometry();
 
-	geometry->setVertexArray(posBuffer);
-	geometry->setTexCoordArray(0, uvBuffer);
+	// Arrays are assigned their own buffer objects in advance, so shared arrays do not end up in the same buffer object as per-tile arrays
+	geometry->setVertexArray(vertices.positions);
+	geometry->setTexCoordArray(0, getSharedUvs());
 	vis::configureDrawable(*geometry);
-	geometry->setComputeBoundingBoxCallback(createFixedBoundingBoxCallback(bounds));
+	geometry->setComputeBoundingBoxCallback(createFixedBoundingBoxCallback(vertices.bounds));
 
-	geometry->addPrimitiveSet(new osg::DrawElementsUInt(toOsgPrimitiveType(type), indexBuffer->size(), (GLuint*)indexBuffer->getDataPointer()));
+	geometry->addPrimitiveSet(getSharedPrimitiveSet(type));
 	return geometry;
 }
 
-osg::Geode* createPlanetTileGeode(const osg::Vec3d& tileCenter, const Box2d& latLonBounds, double planetRadius, PrimitiveType type)
+osg::Geometry* createPlanetTileGeometry(const osg::Vec3d& tileCenter, const Box2d& latLonBounds,
+	double radius, float skirtLength, PrimitiveType type)
+{
+	PlanetTileVerticesPtr vertices = createPlanetTileVertices(tileCenter, latLonBounds, radius, skirtLength, getDefaultPlanetTileElevationBounds());
+	return createPlanetTileGeometry(*vertices, type);
+}
+
+osg::Geode* createPlanetTileGeode(const PlanetTileVertices& vertices, PrimitiveType type)
 {
-	float skirtLength = 0.005 * latLonBounds.size().length() * planetRadius; // TODO: tweak
-	osg::ref_ptr<osg::Geometry> geometry = createPlanetTileGeometry(tileCenter, latLonBounds, planetRadius, skirtLength, type);
+	osg::ref_ptr<osg::Geometry> geometry = createPlanetTileGeometry(vertices, type);
 
 	osg::Geode* geode = new osg::Geode;
 	geode->addDrawable(geometry);
@@ -100,5 +236,12 @@ osg::Geode* createPlanetTileGeode(const osg::Vec3d& tileCenter, const Box2d& lat
 	return geode;
 }
 
+osg::Geode* createPlanetTileGeode(const osg::Vec3d& tileCenter, const Box2d& latLonBounds, double planetRadius, PrimitiveType type)
+{
+	float skirtLength = calcPlanetTileSkirtLength(latLonBounds, planetRadius);
+	PlanetTileVerticesPtr vertices = createPlanetTileVertices(tileCenter, latLonBounds, planetRadius, skirtLength, getDefaultPlanetTileElevationBounds());
+	return createPlanetTileGeode(*vertices, type);
+}
+
 } // namespace vis
 } // namespace skybolt
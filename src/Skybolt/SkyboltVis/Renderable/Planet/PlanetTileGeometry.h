@@ -8,6 +8,9 @@
 
 #include "SkyboltVis/OsgGeometryFactory.h"
 #include "SkyboltVis/OsgBox2.h"
+#include "SkyboltVis/SkyboltVisFwd.h"
+#include "SkyboltVis/Renderable/Planet/Tile/HeightMapElevationBounds.h"
+#include <osg/BoundingBox>
 #include <osg/Geometry>
 #include <osg/Vec2>
 #include <osg/Vec3>
@@ -15,9 +18,37 @@
 namespace skybolt {
 namespace vis {
 
+//! Per-tile vertex data for planet tile geometry.
+//! Index and texture coordinate buffers are the same for all tiles, and are shared between tile geometries.
+struct PlanetTileVertices
+{
+	osg::ref_ptr<osg::Vec3Array> positions; //!< Relative to tile center
+	osg::BoundingBoxf bounds; //!< Bounds of the displaced tile surface relative to tile center
+};
+
+//! Elevation bounds used when the elevation range of a tile is unknown
+inline HeightMapElevationBounds getDefaultPlanetTileElevationBounds()
+{
+	return HeightMapElevationBounds(-9000, 9000);
+}
+
+float calcPlanetTileSkirtLength(const Box2d& latLonBounds, double planetRadius);
+
+//! Vertices are generated from a cached template grid shared by all tiles in the same latitude band,
+//! so no trigonometric functions are evaluated per vertex.
+//! @param elevationBounds is the range of terrain elevations in the tile, used to calculate the tile bounds
+//! @ThreadSafe
+PlanetTileVerticesPtr createPlanetTileVertices(const osg::Vec3d& tileCenter, const Box2d& latLonBounds,
+	double radius, float skirtLength, const HeightMapElevationBounds& elevationBounds);
+
+//! Creates geometry from vertices which may have been generated on another thread
+osg::Geometry* createPlanetTileGeometry(const PlanetTileVertices& vertices, PrimitiveType type);
+
 osg::Geometry* createPlanetTileGeometry(const osg::Vec3d& tileCenter, const Box2d& latLonBounds,
 	double radius, float skirtLength, PrimitiveType type);
 
+osg::Geode* createPlanetTileGeode(const PlanetTileVertices& vertices, PrimitiveType type);
+
 osg::Geode* createPlanetTileGeode(const osg::Vec3d& tileCenter, const Box2d& latLonBounds, double radius, PrimitiveType type);
 
 } // namespace vis
@@ -185,8 +185,15 @@ Terrain::Terrain(const TerrainConfig& config)
 	}
 	else if (planetTile)
 	{
-		osg::Vec3d tilePosition = llaToGeocentric(planetTile->latLonBounds.center(), 0, planetTile->planetRadius);
-		mNode = createPlanetTileGeode(tilePosition, planetTile->latLonBounds, planetTile->planetRadius, Quads);
+		if (planetTile->vertices)
+		{
+			mNode = createPlanetTileGeode(*planetTile->vertices, Quads);
+		}
+		else
+		{
+			osg::Vec3d tilePosition = llaToGeocentric(planetTile->latLonBounds.center(), 0, planetTile->planetRadius);
+			mNode = createPlanetTileGeode(tilePosition, planetTile->latLonBounds, planetTile->planetRadius, Quads);
+		}
 	}
 	else
 	{
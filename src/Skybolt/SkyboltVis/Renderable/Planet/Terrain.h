@@ -56,6 +56,7 @@ struct TerrainConfig
 	{
 		Box2d latLonBounds;
 		float planetRadius;
+		PlanetTileVerticesPtr vertices; //!< If null, vertices are generated when the terrain is created
 	};
 
 	std::shared_ptr<Tile> tile;
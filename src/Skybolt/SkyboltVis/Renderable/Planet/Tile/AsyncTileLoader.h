@@ -25,6 +25,9 @@ struct TileProgressCallback
 
 	std::atomic<State> state = State::Loading;
 
+	//! Loads with higher priority are started first. May be changed while the load is queued.
+	std::atomic<double> priority = 0.0;
+
 	bool isCancelRequested() const { return canceledRequested; }
 	void requestCancel() { canceledRequested = true; }
 
@@ -32,6 +35,14 @@ private:
 	std::atomic<bool> canceledRequested = false;
 };
 
+struct AsyncTileLoaderStats
+{
+	std::size_t queuedLoads = 0; //!< Number of loads waiting to be started
+	std::size_t activeLoads = 0; //!< Number of loads in progress on worker threads
+	std::size_t loadsCanceledBeforeStart = 0; //!< Total number of loads dropped from the queue because they were canceled before starting
+	double updateMilliseconds = 0; //!< Time spent in the last call to update()
+};
+
 class AsyncTileLoader
 {
 public:
@@ -44,6 +55,8 @@ public:
 	virtual void waitForLoads() = 0;
 
 	virtual void update() = 0;
+
+	virtual AsyncTileLoaderStats getStats() const { return {}; }
 };
 
 } // namespace vis
@@ -7,23 +7,35 @@
 #include "ConcurrentAsyncTileLoader.h"
 #include "TileImagesLoader.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 using namespace skybolt;
 
 namespace skybolt {
 namespace vis {
 
 ConcurrentAsyncTileLoader::ConcurrentAsyncTileLoader(const TileImagesLoaderPtr& tileImageLoader, px_sched::Scheduler* scheduler) :
-	mTileImageLoader(tileImageLoader), mScheduler(scheduler)
+	mTileImageLoader(tileImageLoader), mScheduler(scheduler),
+	// Allow enough loads in progress to keep workers busy between updates, without committing workers to requests which may soon be canceled.
+	mMaxActiveLoads(std::max(1, int(scheduler->params().num_threads) * 2))
 {
 }
 
 ConcurrentAsyncTileLoader::~ConcurrentAsyncTileLoader()
 {
-	for (const Request& request : mRequests)
+	for (const QueuedRequest& queued : mQueuedRequests)
+	{
+		queued.request.progressCallback->state = TileProgressCallback::State::FailedOrCanceled;
+	}
+	mQueuedRequests.clear();
+
+	for (const ActiveLoadPtr& load : mActiveLoads)
 	{
-		request.progressCallback->requestCancel();
+		load->request.progressCallback->requestCancel();
 	}
-	waitForLoads();
+	mScheduler->waitFor(mLoadingTaskSync);
 }
 
 void ConcurrentAsyncTileLoader::load(const QuadTreeTileKey& key, const TileImagesPtrPtr& result, const ProgressCallbackPtr& progress)
@@ -32,47 +44,125 @@ void ConcurrentAsyncTileLoader::load(const QuadTreeTileKey& key, const TileImage
 	request.key = key;
 	request.result = result;
 	request.progressCallback = progress;
-
-	typedef std::shared_ptr<TileProgressCallback> TileProgressCallbackPtr;
 	request.progressCallback->state = TileProgressCallback::State::Loading;
 
-	mRequests.push_back(request);
-
-	mScheduler->run([=]() {
-		*request.result = mTileImageLoader->load(key, [=] {return progress->isCancelRequested(); });
-		request.progressCallback->state = *request.result ? TileProgressCallback::State::Loaded : TileProgressCallback::State::FailedOrCanceled;
-	}, &mLoadingTaskSync);
+	mQueuedRequests.push_back({request, progress->priority.load()});
 }
 
 void ConcurrentAsyncTileLoader::waitForLoads()
 {
+	dropCanceledRequests();
+	startQueuedLoads(std::numeric_limits<std::size_t>::max());
 	mScheduler->waitFor(mLoadingTaskSync);
 }
 
 void ConcurrentAsyncTileLoader::update()
 {
-	// Update requests
-	static const int maxTileLoadsPerUpdate = 16; // tweek to give best performance. Smaller numbers give less frame stutters but potentially longer load delays.
-	int tileLoads = 0;
+	auto startTime = std::chrono::steady_clock::now();
+
+	publishCompletedLoads();
+	dropCanceledRequests();
+	startQueuedLoads(std::size_t(mMaxActiveLoads));
 
-	for (int i = 0; i < (int)mRequests.size(); ++i)
+	mStats.queuedLoads = mQueuedRequests.size();
+	mStats.activeLoads = mActiveLoads.size();
+	mStats.updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void ConcurrentAsyncTileLoader::publishCompletedLoads()
+{
+	auto startTime = std::chrono::steady_clock::now();
+	auto budget = std::chrono::duration<double, std::milli>(mCompletionTimeBudgetMilliseconds);
+	bool publishedAny = false;
+
+	for (std::size_t i = 0; i < mActiveLoads.size();)
 	{
-		const Request& request = mRequests[i];
-		auto state = request.progressCallback->state.load();
-		if (state == TileProgressCallback::State::FailedOrCanceled)
+		ActiveLoadPtr& load = mActiveLoads[i];
+		if (!load->finished)
 		{
-			mRequests.erase(mRequests.begin() + i);
-			--i;
+			++i;
+			continue;
 		}
-		else if (request.result->get() && tileLoads < maxTileLoadsPerUpdate)
+
+		if (publishedAny && std::chrono::steady_clock::now() - startTime > budget)
 		{
-			mRequests.erase(mRequests.begin() + i);
+			break;
+		}
 
-			++tileLoads;
-			--i;
+		const Request& request = load->request;
+		if (load->images && !request.progressCallback->isCancelRequested())
+		{
+			*request.result = std::move(load->images);
+			request.progressCallback->state = TileProgressCallback::State::Loaded;
+		}
+		else
+		{
+			request.progressCallback->state = TileProgressCallback::State::FailedOrCanceled;
 		}
+		publishedAny = true;
+
+		// Order of active loads does not matter, so swap and pop
+		load = std::move(mActiveLoads.back());
+		mActiveLoads.pop_back();
 	}
 }
 
+void ConcurrentAsyncTileLoader::dropCanceledRequests()
+{
+	for (std::size_t i = 0; i < mQueuedRequests.size();)
+	{
+		const Request& request = mQueuedRequests[i].request;
+		if (request.progressCallback->isCancelRequested())
+		{
+			request.progressCallback->state = TileProgressCallback::State::FailedOrCanceled;
+			++mStats.loadsCanceledBeforeStart;
+
+			mQueuedRequests[i] = std::move(mQueuedRequests.back());
+			mQueuedRequests.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void ConcurrentAsyncTileLoader::startQueuedLoads(std::size_t maxActiveLoads)
+{
+	if (mQueuedRequests.empty() || mActiveLoads.size() >= maxActiveLoads)
+	{
+		return;
+	}
+
+	// Sort by ascending priority so that the highest priority requests can be popped from the back
+	for (QueuedRequest& queued : mQueuedRequests)
+	{
+		queued.priority = queued.request.progressCallback->priority.load();
+	}
+	std::sort(mQueuedRequests.begin(), mQueuedRequests.end(), [] (const QueuedRequest& a, const QueuedRequest& b) {
+		return a.priority < b.priority;
+	});
+
+	while (!mQueuedRequests.empty() && mActiveLoads.size() < maxActiveLoads)
+	{
+		startLoad(mQueuedRequests.back().request);
+		mQueuedRequests.pop_back();
+	}
+}
+
+void ConcurrentAsyncTileLoader::startLoad(const Request& request)
+{
+	auto load = std::make_shared<ActiveLoad>();
+	load->request = request;
+	mActiveLoads.push_back(load);
+
+	ProgressCallbackPtr progress = request.progressCallback;
+	QuadTreeTileKey key = request.key;
+	mScheduler->run([this, load, progress, key]() {
+		load->images = mTileImageLoader->load(key, [progress] {return progress->isCancelRequested(); });
+		load->finished = true;
+	}, &mLoadingTaskSync);
+}
+
 } // namespace vis
 } // namespace skybolt
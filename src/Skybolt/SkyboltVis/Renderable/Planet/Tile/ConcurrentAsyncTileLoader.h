@@ -10,9 +10,15 @@
 
 #include <px_sched/px_sched.h>
 
+#include <vector>
+
 namespace skybolt {
 namespace vis {
 
+//! Loads tiles on the scheduler's worker threads.
+//! Requests are queued and started in order of TileProgressCallback::priority, which is re-evaluated every update().
+//! Requests canceled while queued are dropped without being started.
+//! Loaded tiles are published to the requester on the calling thread in update(), subject to a time budget.
 class ConcurrentAsyncTileLoader : public AsyncTileLoader
 {
 public:
@@ -24,23 +30,59 @@ public:
 
 	void load(const skybolt::QuadTreeTileKey& key, const TileImagesPtrPtr& result, const ProgressCallbackPtr& progress) override;
 
+	//! Starts all queued loads and waits for them to complete
 	void waitForLoads() override;
 
 	void update() override;
 
-private:
-	TileImagesLoaderPtr mTileImageLoader;
-	px_sched::Scheduler* mScheduler;
-	px_sched::Sync mLoadingTaskSync;
+	AsyncTileLoaderStats getStats() const override { return mStats; }
+
+	//! Sets the maximum number of loads which may be in progress at once.
+	//! Keeping this small keeps most requests in the queue, where they can be reprioritized or canceled cheaply.
+	void setMaxActiveLoads(int count) { mMaxActiveLoads = count; }
 
+	//! Sets the time budget for publishing completed loads in each update().
+	//! At least one completed load is published per update regardless of the budget.
+	void setCompletionTimeBudgetMilliseconds(double milliseconds) { mCompletionTimeBudgetMilliseconds = milliseconds; }
+
+private:
 	struct Request
 	{
 		skybolt::QuadTreeTileKey key;
-		TileImagesPtrPtr result; //!< The outer pointer is used to share the lifetime of the inner pointer between producer and consumer. The inner pointer is changed from nullptr to containing a valid object by producer.
+		TileImagesPtrPtr result; //!< The outer pointer is used to share the lifetime of the inner pointer between producer and consumer. The inner pointer is changed from nullptr to containing a valid object when the load is published.
 		ProgressCallbackPtr progressCallback;
 	};
 
-	std::vector<Request> mRequests;
+	struct QueuedRequest
+	{
+		Request request;
+		double priority; //!< Snapshot of progressCallback->priority, taken when the queue is sorted
+	};
+
+	struct ActiveLoad
+	{
+		Request request;
+		TileImagesPtr images; //!< Written by worker thread before finished is set
+		std::atomic<bool> finished = false;
+	};
+	typedef std::shared_ptr<ActiveLoad> ActiveLoadPtr;
+
+	void publishCompletedLoads();
+	void dropCanceledRequests();
+	void startQueuedLoads(std::size_t maxActiveLoads);
+	void startLoad(const Request& request);
+
+private:
+	TileImagesLoaderPtr mTileImageLoader;
+	px_sched::Scheduler* mScheduler;
+	px_sched::Sync mLoadingTaskSync;
+
+	std::vector<QueuedRequest> mQueuedRequests;
+	std::vector<ActiveLoadPtr> mActiveLoads;
+
+	int mMaxActiveLoads;
+	double mCompletionTimeBudgetMilliseconds = 2.0;
+	AsyncTileLoaderStats mStats;
 };
 
 } // namespace vis
@@ -5,14 +5,134 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "NormalMapHelpers.h"
+#include <SkyboltCommon/ParallelFor.h>
 #include <osg/Texture> // included for GL_R16
 #include <algorithm>
 #include <assert.h>
+#include <cmath>
+#include <vector>
 
 namespace skybolt {
 namespace vis {
 
-osg::ref_ptr<osg::Image> createNormalMapFromHeightMap(const osg::Image& heightmap, const HeightMapElevationRerange& rerange, const osg::Vec2f& texelWorldSize, int filterWidth)
+namespace {
+
+struct NormalMapParams
+{
+	int width;
+	int height;
+	int filterWidth;
+	int lowerOffset;
+	float gradientScale; //!< Converts sum of height differences to elevation difference
+	float texelWorldSizeX; //!< Size of the filter footprint in world units
+	float texelWorldSizeY;
+};
+
+//! Per-row scratch buffers. Kept as separate arrays so that the loops over them can be auto-vectorized.
+struct RowBuffers
+{
+	RowBuffers(int width) : dhx(width), dhy(width), nx(width), ny(width), nz(width) {}
+	std::vector<float> dhx, dhy;
+	std::vector<float> nx, ny, nz;
+};
+
+//! Calculates gradients for columns which need clamping to the image bounds
+void calcBorderGradients(const NormalMapParams& params, const uint16_t* row0, const uint16_t* row1, int xBegin, int xEnd, float* dhx, float* dhy)
+{
+	const int upperOffset = params.lowerOffset + params.filterWidth;
+	for (int x = xBegin; x < xEnd; ++x)
+	{
+		int x0 = std::clamp(x + params.lowerOffset, 0, params.width - 1 - params.filterWidth);
+		int x1 = std::clamp(x + upperOffset, params.filterWidth, params.width - 1);
+
+		int h00 = row0[x0];
+		int h10 = row0[x1];
+		int h01 = row1[x0];
+		int h11 = row1[x1];
+
+		dhx[x] = params.gradientScale * float((h10 + h11) - (h00 + h01));
+		dhy[x] = params.gradientScale * float((h01 + h11) - (h00 + h10));
+	}
+}
+
+//! Calculates gradients for columns whose filter footprint lies within the image, without clamping
+void calcInteriorGradients(const NormalMapParams& params, const uint16_t* row0, const uint16_t* row1, int xBegin, int xEnd, float* __restrict dhx, float* __restrict dhy)
+{
+	const uint16_t* r00 = row0 + params.lowerOffset;
+	const uint16_t* r01 = row1 + params.lowerOffset;
+	const uint16_t* r10 = r00 + params.filterWidth;
+	const uint16_t* r11 = r01 + params.filterWidth;
+	const float gradientScale = params.gradientScale;
+
+	for (int x = xBegin; x < xEnd; ++x)
+	{
+		int h00 = r00[x];
+		int h10 = r10[x];
+		int h01 = r01[x];
+		int h11 = r11[x];
+
+		dhx[x] = gradientScale * float((h10 + h11) - (h00 + h01));
+		dhy[x] = gradientScale * float((h01 + h11) - (h00 + h10));
+	}
+}
+
+void createNormalMapRows(const NormalMapParams& params, const uint16_t* src, unsigned char* dst, int yBegin, int yEnd)
+{
+	const int width = params.width;
+	const int filterWidth = params.filterWidth;
+	const int upperOffset = params.lowerOffset + filterWidth;
+
+	// Columns in [interiorBegin, interiorEnd) sample within the image without clamping
+	const int interiorBegin = std::min(width, -params.lowerOffset);
+	const int interiorEnd = std::max(interiorBegin, width - 1 - filterWidth - params.lowerOffset + 1);
+
+	// The normal is the normalized cross product of the surface tangents (sx, 0, dhx) and (0, sy, dhy),
+	// which is (-sy * dhx, -sx * dhy, sx * sy).
+	const float sx = params.texelWorldSizeX;
+	const float sy = params.texelWorldSizeY;
+	const float sxsy = sx * sy;
+
+	RowBuffers buffers(width);
+	float* __restrict dhx = buffers.dhx.data();
+	float* __restrict dhy = buffers.dhy.data();
+	float* __restrict nx = buffers.nx.data();
+	float* __restrict ny = buffers.ny.data();
+	float* __restrict nz = buffers.nz.data();
+
+	for (int y = yBegin; y < yEnd; ++y)
+	{
+		int y0 = std::clamp(y + params.lowerOffset, 0, params.height - 1 - filterWidth);
+		int y1 = std::clamp(y + upperOffset, filterWidth, params.height - 1);
+		const uint16_t* row0 = src + width * y0;
+		const uint16_t* row1 = src + width * y1;
+
+		calcBorderGradients(params, row0, row1, 0, interiorBegin, dhx, dhy);
+		calcInteriorGradients(params, row0, row1, interiorBegin, interiorEnd, dhx, dhy);
+		calcBorderGradients(params, row0, row1, interiorEnd, width, dhx, dhy);
+
+		for (int x = 0; x < width; ++x)
+		{
+			float cx = -sy * dhx[x];
+			float cy = -sx * dhy[x];
+			float scale = 128.0f / std::sqrt(cx * cx + cy * cy + sxsy * sxsy);
+			nx[x] = cx * scale + 128.0f;
+			ny[x] = cy * scale + 128.0f;
+			nz[x] = sxsy * scale + 128.0f;
+		}
+
+		unsigned char* p = dst + 3 * width * y;
+		for (int x = 0; x < width; ++x)
+		{
+			p[3 * x] = std::clamp(int(nx[x]), 0, 255);
+			p[3 * x + 1] = std::clamp(int(ny[x]), 0, 255);
+			p[3 * x + 2] = std::clamp(int(nz[x]), 0, 255);
+		}
+	}
+}
+
+} // namespace
+
+osg::ref_ptr<osg::Image> createNormalMapFromHeightMap(const osg::Image& heightmap, const HeightMapElevationRerange& rerange, const osg::Vec2f& texelWorldSize, int filterWidth, px_sched::Scheduler* scheduler)
 {
 	assert(heightmap.getInternalTextureFormat() == GL_R16);
 	const int width = heightmap.s();
@@ -22,39 +142,22 @@ osg::ref_ptr<osg::Image> createNormalMapFromHeightMap(const osg::Image& heightma
 	image->allocateImage(width, height, 1, GL_RGB, GL_UNSIGNED_BYTE);
 	image->setInternalTextureFormat(GL_RGB8);
 
-	unsigned char* p = image->data();
-	const uint16_t* src = reinterpret_cast<const uint16_t*>(heightmap.data());
+	NormalMapParams params;
+	params.width = width;
+	params.height = height;
+	params.filterWidth = filterWidth;
+	params.lowerOffset = -(filterWidth / 2);
+	params.gradientScale = rerange.x() * 0.5f;
+	params.texelWorldSizeX = texelWorldSize.x() * float(filterWidth);
+	params.texelWorldSizeY = texelWorldSize.y() * float(filterWidth);
 
-	float filterWidthF = filterWidth;
-	int lowerOffset = -(filterWidth / 2);
-	int upperOffset = lowerOffset + filterWidth;
+	const uint16_t* src = reinterpret_cast<const uint16_t*>(heightmap.data());
+	unsigned char* dst = image->data();
 
-	for (int y = 0; y < height; ++y)
-	{
-		for (int x = 0; x < width; ++x)
-		{
-			int x0 = std::clamp(x + lowerOffset, 0, width-1-filterWidth);
-			int y0 = std::clamp(y + lowerOffset, 0, height-1-filterWidth);
-			int x1 = std::clamp(x + upperOffset, filterWidth, width-1);
-			int y1 = std::clamp(y + upperOffset, filterWidth, height-1);
-
-			uint16_t h00 = src[x0 + width * y0];
-			uint16_t h10 = src[x1 + width * y0];
-			uint16_t h01 = src[x0 + width * y1];
-			uint16_t h11 = src[x1 + width * y1];
-
-			const float elevationScale = rerange.x();
-			float dhx = elevationScale * 0.5f * float((h10 + h11) - (h00 + h01));
-			float dhy = elevationScale * 0.5f * float((h01 + h11) - (h00 + h10));
-
-			osg::Vec3f normal = osg::Vec3f(texelWorldSize.x() * filterWidthF, 0, dhx) ^ osg::Vec3f(0, texelWorldSize.y() * filterWidthF, dhy);
-			normal.normalize();
-
-			*p++ = std::clamp(int(normal.x() * 128.0f + 128.0f), 0, 255);
-			*p++ = std::clamp(int(normal.y() * 128.0f + 128.0f), 0, 255);
-			*p++ = std::clamp(int(normal.z() * 128.0f + 128.0f), 0, 255);
-		}
-	}
+	constexpr std::size_t minRowsPerBatch = 32;
+	parallelFor(scheduler, height, minRowsPerBatch, [&] (std::size_t begin, std::size_t end) {
+		createNormalMapRows(params, src, dst, int(begin), int(end));
+	});
 	return image;
 }
 
@@ -7,12 +7,16 @@
 #pragma once
 
 #include "HeightMapElevationRerange.h"
+#include "SkyboltVis/SkyboltVisFwd.h"
 #include <osg/Image>
 
 namespace skybolt {
 namespace vis {
 
-osg::ref_ptr<osg::Image> createNormalMapFromHeightMap(const osg::Image& heightmap, const HeightMapElevationRerange& rerange, const osg::Vec2f& texelWorldSize, int filterWidth = 1);
+//! Creates an RGB8 tangent space normal map from a GL_R16 height map.
+//! @param scheduler if not null, rows are split into batches which are processed in parallel on the scheduler.
+osg::ref_ptr<osg::Image> createNormalMapFromHeightMap(const osg::Image& heightmap, const HeightMapElevationRerange& rerange, const osg::Vec2f& texelWorldSize, int filterWidth = 1,
+	px_sched::Scheduler* scheduler = nullptr);
 
 } // namespace vis
 } // namespace skybolt
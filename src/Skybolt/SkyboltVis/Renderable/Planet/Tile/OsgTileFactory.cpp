@@ -34,7 +34,7 @@ OsgTileFactory::OsgTileFactory(const OsgTileFactoryConfig& config) :
 
 OsgTileFactory::~OsgTileFactory() = default;
 
-OsgTile OsgTileFactory::createOsgTile(const QuadTreeTileKey& key, const Box2d& latLonBounds, const TileTextures& textures) const
+OsgTile OsgTileFactory::createOsgTile(const QuadTreeTileKey& key, const Box2d& latLonBounds, const TileTextures& textures, const PlanetTileVerticesPtr& vertices) const
 {
 	// Get heightmap for tile, and its scale and offset relative to the tile
 	osg::Vec2f heightImageScale, heightImageOffset;
@@ -63,6 +63,13 @@ OsgTile OsgTileFactory::createOsgTile(const QuadTreeTileKey& key, const Box2d& l
 	result.modelMatrixUniform = new osg::Uniform("modelMatrix", osg::Matrixf());
 	result.transform->getOrCreateStateSet()->addUniform(result.modelMatrixUniform);
 
+	PlanetTileVerticesPtr tileVertices = vertices;
+	if (!tileVertices)
+	{
+		float skirtLength = calcPlanetTileSkirtLength(latLonBounds, mPlanetRadius);
+		tileVertices = createPlanetTileVertices(tilePosition, latLonBounds, mPlanetRadius, skirtLength, getDefaultPlanetTileElevationBounds());
+	}
+
 	osg::Vec2f albedoImageScale, albedoImageOffset;
 	getTileTransformInParentSpace(key, textures.albedo.key.level, albedoImageScale, albedoImageOffset);
 
@@ -77,6 +84,7 @@ OsgTile OsgTileFactory::createOsgTile(const QuadTreeTileKey& key, const Box2d& l
 		std::shared_ptr<TerrainConfig::PlanetTile> planetTile(new TerrainConfig::PlanetTile);
 		planetTile->latLonBounds = latLonBounds;
 		planetTile->planetRadius = mPlanetRadius;
+		planetTile->vertices = tileVertices;
 
 		osg::Vec2f attributeImageScale, attributeImageOffset;
 		if (textures.attribute)
@@ -107,7 +115,7 @@ OsgTile OsgTileFactory::createOsgTile(const QuadTreeTileKey& key, const Box2d& l
 	else if (textures.albedo.texture)
 	{
 		// Low LOD terrain
-		osg::Geode* geode = createPlanetTileGeode(tilePosition, latLonBounds, mPlanetRadius, Triangles);
+		osg::Geode* geode = createPlanetTileGeode(*tileVertices, Triangles);
 		result.transform->addChild(geode);
 
 		int unit = 0;
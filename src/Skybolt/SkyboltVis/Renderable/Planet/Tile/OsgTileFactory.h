@@ -46,7 +46,8 @@ public:
 		std::optional<TileTexture> attribute;
 	};
 
-	OsgTile createOsgTile(const skybolt::QuadTreeTileKey& key, const Box2d& latLonBounds, const TileTextures& textures) const;
+	//! @param vertices are the tile's vertices, which may be generated in advance on a worker thread. If null, vertices are generated by this function.
+	OsgTile createOsgTile(const skybolt::QuadTreeTileKey& key, const Box2d& latLonBounds, const TileTextures& textures, const PlanetTileVerticesPtr& vertices = nullptr) const;
 
 private:
 	double mPlanetRadius;
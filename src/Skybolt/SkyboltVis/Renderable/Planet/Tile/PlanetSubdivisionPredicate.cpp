@@ -69,6 +69,26 @@ bool PlanetSubdivisionPredicate::operator()(const Box2d& bounds, const QuadTreeT
 	return false;
 }
 
+double PlanetSubdivisionPredicate::calcLoadPriority(const Box2d& bounds, const QuadTreeTileKey& key)
+{
+	// Tile elevation bounds are not known until the tile is loaded, so measure distance to the tile at sea level
+	Box2d latLonBounds(math::vec2SwapComponents(bounds.minimum), math::vec2SwapComponents(bounds.maximum));
+	osg::Vec2d latLon = nearestPointInSolidBox(observerLatLon, latLonBounds);
+
+	osg::Vec3d observerPosition = llaToGeocentric(observerLatLon, std::max(1.0, observerAltitude), planetRadius);
+	osg::Vec3d tileNearestPoint = llaToGeocentric(latLon, 0, planetRadius);
+	double distanceToTileNearestPoint = (tileNearestPoint - observerPosition).length();
+
+	double tileSize = planetRadius / std::pow(2, key.level);
+	double projectedSize = tileSize / std::max(0.01, distanceToTileNearestPoint);
+
+	// Deprioritize tiles below the horizon
+	osg::Vec3d up = tileNearestPoint;
+	up.normalize();
+	bool visible = (observerPosition - tileNearestPoint) * up > 0.0;
+	return visible ? projectedSize : projectedSize * 0.1;
+}
+
 osg::Vec2d PlanetSubdivisionPredicate::nearestPointInSolidBox(const osg::Vec2d& point, const Box2d& bounds) const
 {
 	// Handle longitude wrap around
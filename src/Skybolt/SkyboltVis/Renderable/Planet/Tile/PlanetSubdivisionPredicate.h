@@ -21,6 +21,9 @@ struct PlanetSubdivisionPredicate : public QuadTreeSubdivisionPredicate
 
 	bool operator()(const Box2d& bounds, const skybolt::QuadTreeTileKey& key, const TileImages& images) override;
 
+	//! Prioritizes tiles by their approximate projected size, so that tiles with the largest screen-space error load first
+	double calcLoadPriority(const Box2d& bounds, const skybolt::QuadTreeTileKey& key) override;
+
 	std::vector<TileSourcePtr> tileSources; //!< tileSources are queried to see if children exist at each level
 	osg::Vec2d observerLatLon;
 	double observerAltitude;
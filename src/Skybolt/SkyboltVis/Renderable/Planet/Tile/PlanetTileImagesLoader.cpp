@@ -5,10 +5,13 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PlanetTileImagesLoader.h"
+#include "TileSource/MemoryCachedTileSource.h"
 #include "TileSource/TileSource.h"
 #include "SkyboltVis/Renderable/Planet/AttributeMapHelpers.h"
+#include "SkyboltVis/Renderable/Planet/PlanetTileGeometry.h"
 #include "SkyboltVis/Renderable/Planet/Tile/HeightMapElevationBounds.h"
 #include "SkyboltVis/Renderable/Planet/Tile/NormalMapHelpers.h"
+#include "SkyboltVis/OsgGeocentric.h"
 #include "SkyboltVis/OsgImageHelpers.h"
 #include "SkyboltVis/OsgTextureHelpers.h"
 #include <algorithm>
@@ -96,7 +99,7 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 		std::optional<QuadTreeTileKey> elevationKey = elevationLayer->getHighestAvailableLevel(key);
 		if (elevationKey)
 		{
-			images->heightMapImage = getOrCreateImage(*elevationKey, size_t(CacheIndex::Elevation), [this, cancelSupplier](const QuadTreeTileKey& key) {
+			images->heightMapImage = createImageOrAncestor(*elevationKey, [this, cancelSupplier](const QuadTreeTileKey& key) {
 				return elevationLayer->createImage(key, cancelSupplier);
 			});
 		}
@@ -126,24 +129,40 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 #endif
 	}
 
+	// Vertices
+	{
+		auto bounds = getKeyLonLatBounds<osg::Vec2d>(key);
+		Box2d latLonBounds(math::vec2SwapComponents(bounds.minimum), math::vec2SwapComponents(bounds.maximum));
+		osg::Vec3d tilePosition = llaToGeocentric(latLonBounds.center(), 0, mPlanetRadius);
+
+		// Bounds of the height map cover the tile, but may be loose if the height map is from an ancestor tile
+		HeightMapElevationBounds elevationBounds = getHeightMapElevationBounds(*images->heightMapImage.image).value_or(getDefaultPlanetTileElevationBounds());
+
+		float skirtLength = calcPlanetTileSkirtLength(latLonBounds, mPlanetRadius);
+		images->vertices = createPlanetTileVertices(tilePosition, latLonBounds, mPlanetRadius, skirtLength, elevationBounds);
+
+#ifdef ENABLE_TILE_IMAGE_LOADER_PROFILING
+		std::cout << "Vertices@" << key.level << ": " << timer.count() << std::endl;
+		timer.reset();
+		timer.start();
+#endif
+	}
+
 	// Land mask
 	{
 		osg::ref_ptr<osg::Image> heightImage = images->heightMapImage.image;
-		images->landMaskImage = getOrCreateImage(images->heightMapImage.key, size_t(CacheIndex::LandMask), [this, heightImage, cancelSupplier](const QuadTreeTileKey& key) {
-			if (landMaskLayer)
-			{
+		if (landMaskLayer)
+		{
+			images->landMaskImage = createImageOrAncestor(images->heightMapImage.key, [this, cancelSupplier](const QuadTreeTileKey& key) {
 				return landMaskLayer->createImage(key, cancelSupplier);
-			}
-			else
-			{
-				if (heightImage == defaultHeightImage)
-				{
-					return defaultLandMask;
-				}
-				osg::ref_ptr<osg::Image> image = convertHeightmapToLandMask(*heightImage, getRequiredHeightMapElevationRerange(*heightImage));
-				return image;
-			}
-		}).image;
+			}).image;
+		}
+		else if (heightImage != defaultHeightImage)
+		{
+			images->landMaskImage = getOrCreateDerivedImage(elevationLayer->getCacheSha() + "/landMask", images->heightMapImage.key, [heightImage] {
+				return osg::ref_ptr<osg::Image>(convertHeightmapToLandMask(*heightImage, getRequiredHeightMapElevationRerange(*heightImage)));
+			});
+		}
 
 		if (!images->landMaskImage)
 		{
@@ -164,7 +183,7 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 		std::optional<QuadTreeTileKey> albedoKey = albedoLayer->getHighestAvailableLevel(key);
 		if (albedoKey)
 		{
-			images->albedoMapImage = getOrCreateImage(*albedoKey, size_t(CacheIndex::Albedo), [this, cancelSupplier](const QuadTreeTileKey& key) {
+			images->albedoMapImage = createImageOrAncestor(*albedoKey, [this, cancelSupplier](const QuadTreeTileKey& key) {
 				osg::ref_ptr<osg::Image> image = albedoLayer->createImage(key, cancelSupplier);
 				return image;
 			});
@@ -189,13 +208,17 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 			std::optional<QuadTreeTileKey> attributeKey = attributeLayer->getHighestAvailableLevel(key);
 			if (attributeKey)
 			{
-				images->attributeMapImage = getOrCreateImage(*attributeKey, size_t(CacheIndex::Attribute), [this, cancelSupplier](const QuadTreeTileKey& key) {
-					osg::ref_ptr<osg::Image> image = attributeLayer->createImage(key, cancelSupplier);
-					if (image)
-					{
-						image = convertAttributeMap(*image, getNlcdAttributeColors());
-					}
-					return image;
+				// Only the converted image is cached, so read the source image without caching it in memory
+				TileSourcePtr attributeSource = getMemoryUncachedTileSource(attributeLayer);
+				images->attributeMapImage = createImageOrAncestor(*attributeKey, [this, &attributeSource, cancelSupplier](const QuadTreeTileKey& key) {
+					return getOrCreateDerivedImage(attributeLayer->getCacheSha() + "/nlcdAttributes", key, [&] {
+						osg::ref_ptr<osg::Image> image = attributeSource->createImage(key, cancelSupplier);
+						if (image)
+						{
+							image = convertAttributeMap(*image, getNlcdAttributeColors());
+						}
+						return image;
+					});
 				});
 				if (!images->attributeMapImage->image)
 				{
@@ -205,7 +228,7 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 		}
 		else if (!images->attributeMapImage && false) // Experimental. If enabled, attribute map will be generated from the albedo map, otherwise no attributes will be used.
 		{
-			images->attributeMapImage = getOrCreateImage(key, size_t(CacheIndex::Attribute), [this, cancelSupplier, albedo = images->albedoMapImage.image](const QuadTreeTileKey& key) {
+			images->attributeMapImage = createImageOrAncestor(key, [albedo = images->albedoMapImage.image](const QuadTreeTileKey& key) {
 				return convertToAttributeMap(*albedo);
 			});
 		}
@@ -21,6 +21,8 @@ struct PlanetTileImages : TileImages
 
 	TileImage albedoMapImage;
 	std::optional<TileImage> attributeMapImage;
+
+	PlanetTileVerticesPtr vertices; //!< Generated by the loader so that the main thread only needs to assemble the geometry
 };
 
 class PlanetTileImagesLoader : public TileImagesLoader
@@ -31,15 +33,8 @@ public:
 	TileSourcePtr albedoLayer; //!< never null
 	TileSourcePtr attributeLayer; //!< if null, attributes are not used
 
-	enum class CacheIndex
-	{
-		Elevation,
-		LandMask,
-		Albedo,
-		Attribute
-	};
-
-	PlanetTileImagesLoader(double planetRadius) : TileImagesLoader(4), mPlanetRadius(planetRadius) {}
+	//! @param imageCache caches land mask and attribute images derived from layer images. May be null.
+	PlanetTileImagesLoader(double planetRadius, const TileImageCachePtr& imageCache = nullptr) : TileImagesLoader(imageCache), mPlanetRadius(planetRadius) {}
 
 	//! May be called from multiple threads
 	TileImagesPtr load(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override;
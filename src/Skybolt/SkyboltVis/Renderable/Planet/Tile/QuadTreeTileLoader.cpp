@@ -11,6 +11,7 @@
 
 #include <SkyboltCommon/Listenable.h>
 #include <SkyboltCommon/Math/MathUtility.h>
+#include <SkyboltCommon/Math/QuadTreeUtility.h>
 
 #include <ostream>
 
@@ -27,6 +28,10 @@ std::ostream& operator<<(std::ostream& s, const osg::Vec3f& v)
 
 int maxHeightMapTileLevel = 10;
 
+//! Maximum number of leaf tile changes to retain for consumers which have not yet read them.
+//! Consumers which fall further behind than this must resynchronize from the full leaf set.
+constexpr size_t maxRetainedLeafTileChanges = 65536;
+
 struct AsyncQuadTreeTile : public skybolt::QuadTreeTile<osg::Vec2d, AsyncQuadTreeTile>
 {
 	AsyncQuadTreeTile();
@@ -161,6 +166,7 @@ void QuadTreeTileLoader::update()
 
 	// Tick the async loader
 	mAsyncTileLoader->update();
+	CALL_LISTENERS(tileLoaderStatsUpdated(mAsyncTileLoader->getStats()));
 
 	// Copy loaded tiles from the async tree to the loaded tree
 	{
@@ -176,6 +182,10 @@ void QuadTreeTileLoader::traveseToLoadAndUnload(QuadTree<AsyncQuadTreeTile>& tre
 	{
 		loadTile(tile);
 	}
+	else if (state == AsyncQuadTreeTile::State::Loading)
+	{
+		tile.progressCallback->priority = mSubdivisionPredicate->calcLoadPriority(tile.bounds, tile.key);
+	}
 	if (state != AsyncQuadTreeTile::State::Loaded)
 	{
 		return;
@@ -214,8 +224,16 @@ void QuadTreeTileLoader::traveseToLoadAndUnload(QuadTree<AsyncQuadTreeTile>& tre
 	}
 }
 
-void QuadTreeTileLoader::populateLoadedTree(AsyncQuadTreeTile& srcTile, skybolt::QuadTree<LoadedTile>& dstTree, LoadedTile& dstTile) const
+static bool isLeafWithImages(const QuadTreeTileLoader::LoadedTile& tile)
 {
+	return !tile.hasChildren() && tile.images;
+}
+
+void QuadTreeTileLoader::populateLoadedTree(AsyncQuadTreeTile& srcTile, skybolt::QuadTree<LoadedTile>& dstTree, LoadedTile& dstTile)
+{
+	bool wasLeaf = isLeafWithImages(dstTile);
+	TileImagesPtr previousImages = dstTile.images;
+
 	if (srcTile.getData())
 	{
 		dstTile.images = *srcTile.dataPtr;
@@ -247,6 +265,7 @@ void QuadTreeTileLoader::populateLoadedTree(AsyncQuadTreeTile& srcTile, skybolt:
 		}
 		else if (dstTile.hasChildren())
 		{
+			recordLeafTilesRemoved(dstTile);
 			dstTree.merge(dstTile);
 		}
 	}
@@ -254,6 +273,86 @@ void QuadTreeTileLoader::populateLoadedTree(AsyncQuadTreeTile& srcTile, skybolt:
 	{
 		dstTile.images = nullptr;
 	}
+
+	bool isLeaf = isLeafWithImages(dstTile);
+	bool imagesChanged = (dstTile.images != previousImages);
+	if (wasLeaf && (!isLeaf || imagesChanged))
+	{
+		recordLeafTileRemoved(dstTile.key);
+	}
+	if (isLeaf && (!wasLeaf || imagesChanged))
+	{
+		recordLeafTileAdded(dstTile.key, dstTile.images);
+	}
+}
+
+void QuadTreeTileLoader::recordLeafTileAdded(const QuadTreeTileKey& key, const TileImagesPtr& images)
+{
+	assert(images);
+	mLeafTiles[key] = images;
+	mLeafTileChangeLog.push_back({key, images});
+	++mLeafTileChangeVersion;
+
+	if (mLeafTileChangeLog.size() > maxRetainedLeafTileChanges)
+	{
+		mLeafTileChangeLog.pop_front();
+	}
+}
+
+void QuadTreeTileLoader::recordLeafTileRemoved(const QuadTreeTileKey& key)
+{
+	mLeafTiles.erase(key);
+	mLeafTileChangeLog.push_back({key, nullptr});
+	++mLeafTileChangeVersion;
+
+	if (mLeafTileChangeLog.size() > maxRetainedLeafTileChanges)
+	{
+		mLeafTileChangeLog.pop_front();
+	}
+}
+
+void QuadTreeTileLoader::recordLeafTilesRemoved(const LoadedTile& tile)
+{
+	if (tile.hasChildren())
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			recordLeafTilesRemoved(*tile.children[i]);
+		}
+	}
+	else if (tile.images)
+	{
+		recordLeafTileRemoved(tile.key);
+	}
+}
+
+void QuadTreeTileLoader::getLeafTileChanges(std::uint64_t& version, LeafTileChanges& changes) const
+{
+	assert(version <= mLeafTileChangeVersion);
+	changes = LeafTileChanges();
+
+	std::uint64_t firstRetainedVersion = mLeafTileChangeVersion - mLeafTileChangeLog.size();
+	if (version < firstRetainedVersion)
+	{
+		changes.reset = true;
+		changes.addedTiles = mLeafTiles;
+	}
+	else
+	{
+		// Merge changes so that a tile added and then removed within the range is not reported
+		for (auto i = mLeafTileChangeLog.begin() + (version - firstRetainedVersion); i != mLeafTileChangeLog.end(); ++i)
+		{
+			if (i->images)
+			{
+				changes.addedTiles[i->key] = i->images;
+			}
+			else if (changes.addedTiles.erase(i->key) == 0)
+			{
+				changes.removedTiles.insert(i->key);
+			}
+		}
+	}
+	version = mLeafTileChangeVersion;
 }
 
 void QuadTreeTileLoader::loadTile(AsyncQuadTreeTile& tile)
@@ -264,6 +363,7 @@ void QuadTreeTileLoader::loadTile(AsyncQuadTreeTile& tile)
 		return;
 
 	tile.progressCallback = std::make_shared<TileProgressCallback>();
+	tile.progressCallback->priority = mSubdivisionPredicate->calcLoadPriority(tile.bounds, tile.key);
 	mAsyncTileLoader->load(tile.key, tile.dataPtr, tile.progressCallback);
 	CALL_LISTENERS(tileLoadRequested());
 	mLoadQueue.push_back({ tile.progressCallback });
@@ -293,6 +393,15 @@ void findLeafTiles(const QuadTreeTileLoader::LoadedTileTree& tree, TileKeyImages
 	findLeafTiles(tree.rightTree.getRoot(), result, maxLevel);
 }
 
+const QuadTreeTileLoader::LoadedTile* findTile(const QuadTreeTileLoader::LoadedTileTree& tree, const QuadTreeTileKey& key)
+{
+	const QuadTreeTileKey rootKey = createAncestorKey(key, 0);
+	const QuadTreeTileLoader::LoadedTile& root = (rootKey == tree.leftTree.getRoot().key) ? tree.leftTree.getRoot() : tree.rightTree.getRoot();
+
+	const QuadTreeTileLoader::LoadedTile& tile = visitHierarchyToKey<const QuadTreeTileLoader::LoadedTile>(root, key, [] (const QuadTreeTileLoader::LoadedTile&) {});
+	return (tile.key == key) ? &tile : nullptr;
+}
+
 void findAddedAndRemovedTiles(const TileKeyImagesMap& previousTiles, const TileKeyImagesMap& currentTiles,
 	TileKeyImagesMap& addedTiles, std::set<QuadTreeTileKey>& removedTiles)
 {
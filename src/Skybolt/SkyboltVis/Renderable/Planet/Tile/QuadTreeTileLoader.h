@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "AsyncTileLoader.h"
 #include "SkyboltVis/OsgBox2.h"
 #include "SkyboltVis/SkyboltVisFwd.h"
 #include <SkyboltCommon/Listenable.h>
@@ -14,6 +15,9 @@
 #include <osg/Vec2d>
 
 #include <assert.h>
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -26,6 +30,7 @@ struct QuadTreeTileLoaderListener
 	virtual void tileLoadRequested() {}
 	virtual void tileLoaded() {}
 	virtual void tileLoadCanceled() {}
+	virtual void tileLoaderStatsUpdated(const AsyncTileLoaderStats& stats) {}
 };
 
 struct QuadTreeSubdivisionPredicate
@@ -36,12 +41,29 @@ struct QuadTreeSubdivisionPredicate
 	//! @param images specifies the tile's images, which are useful if the subdivision decision is based on image content,
 	//!        for example how close the camera is to elevations stored in a height map image.
 	virtual bool operator()(const Box2d& bounds, const QuadTreeTileKey& key, const TileImages& images) = 0;
+
+	//! Returns the priority with which the tile should be loaded. Tiles with higher priority are loaded first.
+	//! Called every update for tiles which are waiting to load, so that loads can be reprioritized as the observer moves.
+	virtual double calcLoadPriority(const Box2d& bounds, const QuadTreeTileKey& key) { return -double(key.level); }
 };
 
 using QuadTreeSubdivisionPredicatePtr = std::shared_ptr<QuadTreeSubdivisionPredicate>;
 
 struct AsyncQuadTreeTile;
 
+using TileKeyImagesMap = std::map<QuadTreeTileKey, TileImagesPtr>;
+
+//! Changes to the set of leaf tiles of a QuadTreeTileLoader's loaded tree
+struct LeafTileChanges
+{
+	//! If true, the changes since the requested version are no longer available.
+	//! Consumers must discard all of their tiles and treat addedTiles as the complete set of leaf tiles.
+	bool reset = false;
+
+	std::set<QuadTreeTileKey> removedTiles; //!< Should be processed before addedTiles
+	TileKeyImagesMap addedTiles; //!< May contain keys in removedTiles if a tile's images changed
+};
+
 //! QuadTreeTileLoader loads a quadtree of tiles to satisfy a predicate governing whether a given tile is of sufficient resolution.
 //! While a tile is of sufficient resolution, child tiles will not be loaded.
 //! If a tile is of insufficient resolution, its children will be loaded.
@@ -68,13 +90,28 @@ public:
 
 	LoadedTileTreePtr getLoadedTree() const { return mLoadedTree; }
 
+	//! @returns the version of the leaf tile change log, which increments for each change to the set of leaf tiles of the loaded tree
+	std::uint64_t getLeafTileChangeVersion() const { return mLeafTileChangeVersion; }
+
+	//! Gets the changes to the set of leaf tiles of the loaded tree since the given version, and sets version to the current version.
+	//! Consumers should initialize their version to zero before the first call.
+	//! This allows consumers to update incrementally instead of diffing the whole leaf set every update.
+	void getLeafTileChanges(std::uint64_t& version, LeafTileChanges& changes) const;
+
+	//! @returns the leaf tiles of the loaded tree which have images. Maintained incrementally, so is cheap to call.
+	const TileKeyImagesMap& getLeafTiles() const { return mLeafTiles; }
+
 private:
 	void traveseToLoadAndUnload(skybolt::QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile);
 	
-	void populateLoadedTree(AsyncQuadTreeTile& srcTile, skybolt::QuadTree<LoadedTile>& destTree, LoadedTile& destTile) const;
+	void populateLoadedTree(AsyncQuadTreeTile& srcTile, skybolt::QuadTree<LoadedTile>& destTree, LoadedTile& destTile);
 
 	void loadTile(AsyncQuadTreeTile& tile);
 
+	void recordLeafTileAdded(const QuadTreeTileKey& key, const TileImagesPtr& images);
+	void recordLeafTileRemoved(const QuadTreeTileKey& key);
+	void recordLeafTilesRemoved(const LoadedTile& tile); //!< Records removal of all leaf tiles in the tile's subtree
+
 private:
 	typedef skybolt::DiQuadTree<struct AsyncQuadTreeTile> AsyncQuadTree;
 	typedef std::shared_ptr<AsyncQuadTree> AsyncTileTreePtr;
@@ -90,9 +127,20 @@ private:
 	};
 
 	std::vector<LoadRequest> mLoadQueue;
+
+	struct LeafTileChange
+	{
+		QuadTreeTileKey key;
+		TileImagesPtr images; //!< Null if the tile was removed
+	};
+
+	std::deque<LeafTileChange> mLeafTileChangeLog; //!< Most recent changes. The last change has version mLeafTileChangeVersion.
+	std::uint64_t mLeafTileChangeVersion = 0;
+	TileKeyImagesMap mLeafTiles;
 };
 
-using TileKeyImagesMap = std::map<QuadTreeTileKey, TileImagesPtr>;
+//! @returns the tile in the tree with the given key, or null if the tree does not contain the tile
+const QuadTreeTileLoader::LoadedTile* findTile(const QuadTreeTileLoader::LoadedTileTree& tree, const QuadTreeTileKey& key);
 
 void findLeafTiles(const QuadTreeTileLoader::LoadedTile& tile, TileKeyImagesMap& result, std::optional<int> maxLevel = std::nullopt);
 void findLeafTiles(const QuadTreeTileLoader::LoadedTileTree& tree, TileKeyImagesMap& result, std::optional<int> maxLevel = std::nullopt);
@@ -5,47 +5,50 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "TileImagesLoader.h"
+#include "TileSource/TileImageCache.h"
 
 namespace skybolt {
 namespace vis {
 
-TileImage TileImagesLoader::getOrCreateImage(const QuadTreeTileKey& requestedKey, size_t cacheIndex, Factory factory) const
+TileImage TileImagesLoader::createImageOrAncestor(const QuadTreeTileKey& requestedKey, const Factory& factory)
 {
-	TileCache& cache = mImageCache[cacheIndex];
+	TileImage result;
 
-	bool added = false;
-	CacheEntryPtr entry;
+	int level = requestedKey.level;
+	QuadTreeTileKey key = requestedKey;
+	while (level >= 0)
 	{
+		result.image = factory(key);
+		if (result.image)
 		{
-			std::lock_guard<std::mutex> lock(mCacheMutex[cacheIndex]);
-			entry = cache[requestedKey];
-		}
-		if (!entry)
-		{
-			entry = std::make_shared<CacheEntry>();
-			added = true;
+			result.key = key;
+			break;
 		}
+		--level;
+		key = createAncestorKey(requestedKey, level);
 	}
+	return result;
+}
 
-	if (added)
+osg::ref_ptr<osg::Image> TileImagesLoader::getOrCreateDerivedImage(const std::string& sourceSha, const QuadTreeTileKey& key, const std::function<osg::ref_ptr<osg::Image>()>& factory) const
+{
+	if (!mImageCache)
 	{
-		std::lock_guard<std::mutex> lock(entry->mImageMutex);
+		return factory();
+	}
 
-		int level = requestedKey.level;
-		QuadTreeTileKey key = requestedKey;
-		while (level >= 0)
-		{
-			entry->image.image = factory(key);
-			if (entry->image.image)
-			{
-				entry->image.key = key;
-				break;
-			}
-			--level;
-			key = createAncestorKey(requestedKey, level);
-		}
+	TileImageCacheKey cacheKey{sourceSha, key};
+	if (osg::ref_ptr<osg::Image> image = mImageCache->get(cacheKey); image)
+	{
+		return image;
+	}
+
+	osg::ref_ptr<osg::Image> image = factory();
+	if (image)
+	{
+		mImageCache->put(cacheKey, image);
 	}
-	return entry->image;
+	return image;
 }
 
 } // namespace vis
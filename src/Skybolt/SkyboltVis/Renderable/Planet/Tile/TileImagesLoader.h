@@ -9,6 +9,9 @@
 #include "TileImage.h"
 #include <SkyboltVis/SkyboltVisFwd.h>
 
+#include <functional>
+#include <string>
+
 namespace skybolt {
 namespace vis {
 
@@ -22,9 +25,9 @@ using TileImagesPtr = std::shared_ptr<TileImages>;
 class TileImagesLoader
 {
 public:
-	TileImagesLoader(size_t imageCount) :
-		mImageCache(imageCount),
-		mCacheMutex(imageCount)
+	//! @param imageCache caches images derived from tile source images. May be null.
+	explicit TileImagesLoader(const TileImageCachePtr& imageCache) :
+		mImageCache(imageCache)
 	{
 	}
 
@@ -37,22 +40,19 @@ public:
 	virtual TileImagesPtr load(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const = 0;
 
 protected:
-	struct CacheEntry
-	{
-		TileImage image;
-		std::mutex mImageMutex;
-	};
-
-	typedef std::shared_ptr<CacheEntry> CacheEntryPtr;
-	typedef std::map<skybolt::QuadTreeTileKey, CacheEntryPtr> TileCache; //!< Maps a requested tile key to an image. The image may be at a lower key level than the request e.g if no high res image is available.
 	typedef std::function<osg::ref_ptr<osg::Image>(const skybolt::QuadTreeTileKey& key)> Factory;
 
-	TileImage getOrCreateImage(const skybolt::QuadTreeTileKey& requestedKey, size_t cacheIndex, Factory factory) const;
+	//! @returns the image created by the factory for the requested key.
+	//! If the factory returns null, the requested key's ancestors are tried in turn, and the first image found is returned.
+	//! Images are not cached here. Tile source images should be cached by the TileSource, e.g with a MemoryCachedTileSource.
+	static TileImage createImageOrAncestor(const skybolt::QuadTreeTileKey& requestedKey, const Factory& factory);
 
+	//! Returns a cached image derived from a tile source image, or creates and caches a new one.
+	//! @param sourceSha identifies the source image and the derivation, so must be unique for each kind of derived image
+	osg::ref_ptr<osg::Image> getOrCreateDerivedImage(const std::string& sourceSha, const skybolt::QuadTreeTileKey& key, const std::function<osg::ref_ptr<osg::Image>()>& factory) const;
 
 private:
-	mutable std::vector<TileCache> mImageCache;
-	mutable std::vector<std::mutex> mCacheMutex;
+	TileImageCachePtr mImageCache;
 };
 
 } // namespace vis
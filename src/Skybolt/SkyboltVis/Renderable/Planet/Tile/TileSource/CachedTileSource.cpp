@@ -5,75 +5,265 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "CachedTileSource.h"
+#include "PackedTileCache.h"
 #include "SkyboltVis/OsgImageHelpers.h"
 #include "SkyboltVis/OsgTextureHelpers.h"
 
-#include <osgDB/WriteFile>
+#include <osgDB/Registry>
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+
+namespace fs = std::filesystem;
 
 namespace skybolt {
 namespace vis {
 
-CachedTileSource::CachedTileSource(const TileSourcePtr& tileSource, const std::string& cacheDirectory) :
+CachedTileSource::CachedTileSource(const TileSourcePtr& tileSource, const PackedTileCachePtr& cache) :
 	mTileSource(tileSource),
-	mCacheDirectory(cacheDirectory)
+	mCache(cache)
 {
 	assert(mTileSource);
+	assert(mCache);
 }
 
 osg::ref_ptr<osg::Image> CachedTileSource::createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const
 {
-	std::string imageDirectory = mCacheDirectory + "/" + std::to_string(key.level) + "/" + std::to_string(key.x) + "/";
-	std::string filename = imageDirectory + std::to_string(key.y) + "." + mTileSource->getCacheFileFormat();
+	std::vector<std::uint8_t> data;
+	if (mCache->read(key, data))
+	{
+		if (osg::ref_ptr<osg::Image> image = readPackedTileImage(data.data(), data.size()); image)
+		{
+			return image;
+		}
+	}
+
+	osg::ref_ptr<osg::Image> image = mTileSource->createImage(key, cancelSupplier);
+	if (image)
+	{
+		writePackedTileImage(*image, data);
+		mCache->write(key, data.data(), data.size());
+	}
+	return image;
+}
+
+constexpr std::uint32_t packedTileImageVersion = 1;
 
-	const bool supportUserData = (mTileSource->getCacheFileFormat() == "pngx");
+struct PackedTileImageHeader
+{
+	std::uint32_t version;
+	std::int32_t s;
+	std::int32_t t;
+	std::int32_t r;
+	std::int32_t internalTextureFormat;
+	std::uint32_t pixelFormat;
+	std::uint32_t dataType;
+	std::uint32_t packing;
+	std::uint32_t origin;
+	std::uint32_t imageDataSize;
+	std::uint32_t userDataSize;
+};
 
-	if (std::filesystem::exists(filename))
+void writePackedTileImage(const osg::Image& image, std::vector<std::uint8_t>& data)
+{
+	std::string userData;
+	if (image.getUserDataContainer())
 	{
-		osg::ref_ptr<osg::Image> image;
-		if (supportUserData)
+		auto writer = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+		if (!writer)
+		{
+			throw std::runtime_error("Could not find osgb writer for tile user data");
+		}
+
+		std::ostringstream ss(std::ios::binary);
+		osgDB::ReaderWriter::WriteResult result = writer->writeObject(*image.getUserDataContainer(), ss);
+		if (result.error())
 		{
-			std::ifstream f(filename.c_str(), std::ios::binary);
-			image = readImageWithUserData(f, "png");
-			f.close();
+			throw std::runtime_error("Could not write tile user data: " + result.message());
 		}
-		else
+		userData = ss.str();
+	}
+
+	PackedTileImageHeader header = {};
+	header.version = packedTileImageVersion;
+	header.s = image.s();
+	header.t = image.t();
+	header.r = image.r();
+	header.internalTextureFormat = image.getInternalTextureFormat();
+	header.pixelFormat = image.getPixelFormat();
+	header.dataType = image.getDataType();
+	header.packing = image.getPacking();
+	header.origin = image.getOrigin();
+	header.imageDataSize = image.getTotalSizeInBytes();
+	header.userDataSize = std::uint32_t(userData.size());
+
+	data.resize(sizeof(header) + header.imageDataSize + header.userDataSize);
+	std::uint8_t* p = data.data();
+	std::memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	std::memcpy(p, image.data(), header.imageDataSize);
+	p += header.imageDataSize;
+	std::memcpy(p, userData.data(), header.userDataSize);
+}
+
+osg::ref_ptr<osg::Image> readPackedTileImage(const std::uint8_t* data, std::size_t size)
+{
+	if (size < sizeof(PackedTileImageHeader))
+	{
+		return nullptr;
+	}
+
+	PackedTileImageHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (header.version != packedTileImageVersion || sizeof(header) + header.imageDataSize + header.userDataSize != size)
+	{
+		return nullptr;
+	}
+
+	osg::ref_ptr<osg::Image> image = new osg::Image;
+	image->allocateImage(header.s, header.t, header.r, GLenum(header.pixelFormat), GLenum(header.dataType), int(header.packing));
+	if (image->getTotalSizeInBytes() != header.imageDataSize)
+	{
+		return nullptr;
+	}
+	image->setInternalTextureFormat(header.internalTextureFormat);
+	image->setOrigin(osg::Image::Origin(header.origin));
+
+	const std::uint8_t* p = data + sizeof(header);
+	std::memcpy(image->data(), p, header.imageDataSize);
+	p += header.imageDataSize;
+
+	if (header.userDataSize > 0)
+	{
+		auto reader = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+		if (!reader)
 		{
-			image = readImageWithoutWarnings(filename);
+			return nullptr;
 		}
-		if (image && isHeightMapDataFormat(*image))
+
+		std::istringstream ss(std::string(reinterpret_cast<const char*>(p), header.userDataSize), std::ios::binary);
+		osg::ref_ptr<osg::Object> object = reader->readObject(ss).takeObject();
+		if (!object || !object->asUserDataContainer())
 		{
-			image->setInternalTextureFormat(getHeightMapInternalTextureFormat());
+			return nullptr;
 		}
-		return image;
+		image->setUserDataContainer(object->asUserDataContainer());
+	}
+	return image;
+}
+
+static std::optional<int> parseNonNegativeInt(const std::string& str)
+{
+	if (str.empty() || !std::all_of(str.begin(), str.end(), [] (char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+	{
+		return std::nullopt;
+	}
+	return std::stoi(str);
+}
+
+static osg::ref_ptr<osg::Image> readLegacyCachedImage(const fs::path& path)
+{
+	osg::ref_ptr<osg::Image> image;
+	if (path.extension() == ".pngx")
+	{
+		std::ifstream f(path, std::ios::binary);
+		image = readImageWithUserData(f, "png");
 	}
 	else
 	{
-		osg::ref_ptr<osg::Image> image = mTileSource->createImage(key, cancelSupplier);
-		if (image)
+		image = readImageWithoutWarnings(path.string());
+	}
+
+	if (image && isHeightMapDataFormat(*image))
+	{
+		image->setInternalTextureFormat(getHeightMapInternalTextureFormat());
+	}
+	return image;
+}
+
+//! @returns true if the directory was empty and removed
+static bool removeEmptyDirectories(const fs::path& directory)
+{
+	bool empty = true;
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory))
+	{
+		if (!entry.is_directory() || !removeEmptyDirectories(entry.path()))
+		{
+			empty = false;
+		}
+	}
+
+	if (empty)
+	{
+		fs::remove(directory);
+	}
+	return empty;
+}
+
+std::size_t migrateTileCacheDirectory(const std::string& directory, PackedTileCache& cache, bool removeMigratedFiles)
+{
+	std::size_t migratedCount = 0;
+	std::vector<std::uint8_t> data;
+
+	// Legacy tiles are stored at <level>/<x>/<y>.<extension>.
+	// Find level directories up front because they may be removed during migration.
+	std::vector<std::pair<int, fs::path>> levelDirectories;
+	for (const fs::directory_entry& levelEntry : fs::directory_iterator(directory))
+	{
+		if (std::optional<int> level = parseNonNegativeInt(levelEntry.path().filename().string()); level && levelEntry.is_directory())
 		{
-			std::filesystem::create_directories(imageDirectory);
+			levelDirectories.emplace_back(*level, levelEntry.path());
+		}
+	}
 
-			if (supportUserData)
+	for (const auto& [level, levelDirectory] : levelDirectories)
+	{
+		for (const fs::directory_entry& xEntry : fs::directory_iterator(levelDirectory))
+		{
+			std::optional<int> x = parseNonNegativeInt(xEntry.path().filename().string());
+			if (!xEntry.is_directory() || !x)
 			{
-				std::ofstream f(filename.c_str(), std::ios::binary);
-				if (!writeImageWithUserData(*image, f, "png"))
-				{
-					throw std::runtime_error("Could not write cached tile image to: " + filename);
-				}
-				f.close();
+				continue;
 			}
-			else
+
+			for (const fs::directory_entry& yEntry : fs::directory_iterator(xEntry.path()))
 			{
-				if (!osgDB::writeImageFile(*image, filename))
+				std::optional<int> y = parseNonNegativeInt(yEntry.path().stem().string());
+				if (!yEntry.is_regular_file() || !y)
+				{
+					continue;
+				}
+
+				osg::ref_ptr<osg::Image> image = readLegacyCachedImage(yEntry.path());
+				if (!image)
+				{
+					continue;
+				}
+
+				writePackedTileImage(*image, data);
+				cache.write(QuadTreeTileKey(level, *x, *y), data.data(), data.size());
+				++migratedCount;
+
+				if (removeMigratedFiles)
 				{
-					throw std::runtime_error("Could not write cached tile image to: " + filename);
+					fs::remove(yEntry.path());
 				}
 			}
 		}
-		return image;
+
+		if (removeMigratedFiles)
+		{
+			removeEmptyDirectories(levelDirectory);
+		}
 	}
+
+	cache.flush();
+	return migratedCount;
 }
 
 } // namespace vis
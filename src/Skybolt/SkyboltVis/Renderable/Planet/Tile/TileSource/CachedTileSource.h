@@ -9,13 +9,17 @@
 #include "TileSource.h"
 #include <SkyboltVis/SkyboltVisFwd.h>
 
+#include <cstdint>
+#include <vector>
+
 namespace skybolt {
 namespace vis {
 
+//! Caches images from a TileSource in a PackedTileCache
 class CachedTileSource : public TileSource
 {
 public:
-	CachedTileSource(const TileSourcePtr& tileSource, const std::string& cacheDirectory);
+	CachedTileSource(const TileSourcePtr& tileSource, const PackedTileCachePtr& cache);
 
 	osg::ref_ptr<osg::Image> createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override;
 
@@ -29,12 +33,25 @@ public:
 		return mTileSource->getHighestAvailableLevel(key);
 	}
 
-	const std::string& getCacheSha() const override { throw std::runtime_error("Cached tile source cann't be cached"); }
+	const std::string& getCacheSha() const override { return mTileSource->getCacheSha(); }
 
 private:
 	TileSourcePtr mTileSource;
-	std::string mCacheDirectory;
+	PackedTileCachePtr mCache;
 };
 
+//! Serializes an image, including pixel format and user data, to the form stored in a PackedTileCache.
+//! Pixels are stored uncompressed so that reading a cached tile does not require decoding.
+void writePackedTileImage(const osg::Image& image, std::vector<std::uint8_t>& data);
+
+//! @returns nullptr if the data is not a valid packed tile image
+osg::ref_ptr<osg::Image> readPackedTileImage(const std::uint8_t* data, std::size_t size);
+
+//! Migrates tiles from the legacy cache layout, which stored one image file per tile at <directory>/<level>/<x>/<y>.<extension>,
+//! into a PackedTileCache.
+//! @param removeMigratedFiles if true, migrated tile files and their emptied directories are deleted
+//! @returns number of tiles migrated
+std::size_t migrateTileCacheDirectory(const std::string& directory, PackedTileCache& cache, bool removeMigratedFiles);
+
 } // namespace vis
 } // namespace skybolt
@@ -9,7 +9,10 @@
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/BingTileSource.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/CachedTileSource.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/MapboxElevationTileSource.h"
+#include "SkyboltVis/Renderable/Planet/Tile/TileSource/MemoryCachedTileSource.h"
+#include "SkyboltVis/Renderable/Planet/Tile/TileSource/PackedTileCache.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/SphericalMercatorToPlateCarreeTileSource.h"
+#include "SkyboltVis/Renderable/Planet/Tile/TileSource/TileImageCache.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/XyzTileSource.h"
 #include <SkyboltCommon/Json/JsonHelpers.h>
 
@@ -20,6 +23,10 @@ JsonTileSourceFactoryRegistry::JsonTileSourceFactoryRegistry(const JsonTileSourc
 	mCacheDirectory(config.cacheDirectory),
 	mApiKeys(config.apiKeys)
 {
+	if (config.tileImageCacheSizeBytes > 0)
+	{
+		mTileImageCache = std::make_shared<TileImageCache>(config.tileImageCacheSizeBytes);
+	}
 }
 
 void JsonTileSourceFactoryRegistry::addFactory(const std::string& name, JsonTileSourceFactory factory)
@@ -49,13 +56,32 @@ JsonTileSourceFactory JsonTileSourceFactoryRegistry::wrapWithCacheSupport(JsonTi
 			{
 				std::string url = json.at("url");
 				std::string directory = mCacheDirectory + "/" + tileSource->getCacheSha();
-				return std::make_shared<CachedTileSource>(tileSource, directory);
+				tileSource = std::make_shared<CachedTileSource>(tileSource, getOrCreatePackedTileCache(directory));
 			}
 		}
+
+		// Decoded images are cached in memory regardless of whether they are cached on disk
+		if (mTileImageCache)
+		{
+			tileSource = std::make_shared<MemoryCachedTileSource>(tileSource, mTileImageCache);
+		}
 		return tileSource;
 	};
 }
 
+PackedTileCachePtr JsonTileSourceFactoryRegistry::getOrCreatePackedTileCache(const std::string& directory) const
+{
+	std::scoped_lock<std::mutex> lock(mPackedTileCachesMutex);
+	PackedTileCachePtr& cache = mPackedTileCaches[directory];
+	if (!cache)
+	{
+		PackedTileCacheConfig config;
+		config.directory = directory;
+		cache = std::make_shared<PackedTileCache>(config);
+	}
+	return cache;
+}
+
 JsonTileSourceFactory JsonTileSourceFactoryRegistry::wrapWithProjectionSupport(JsonTileSourceFactory factory) const
 {
 	return[factory = std::move(factory), this] (const nlohmann::json& json) -> TileSourcePtr {
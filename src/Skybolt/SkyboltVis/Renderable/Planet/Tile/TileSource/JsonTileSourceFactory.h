@@ -9,6 +9,7 @@
 #include "SkyboltVis/SkyboltVisFwd.h"
 
 #include <nlohmann/json.hpp>
+#include <mutex>
 #include <string>
 
 namespace skybolt {
@@ -18,6 +19,7 @@ struct JsonTileSourceFactoryRegistryConfig
 {
 	std::string cacheDirectory;
 	std::map<std::string, std::string> apiKeys;
+	std::size_t tileImageCacheSizeBytes = 512 * 1024 * 1024; //!< Size of the in-memory decoded tile image cache shared by all tile sources. Set to zero to disable.
 };
 
 using JsonTileSourceFactory = std::function<TileSourcePtr(const nlohmann::json& json)>;
@@ -37,12 +39,24 @@ public:
 	JsonTileSourceFactory wrapWithProjectionSupport(JsonTileSourceFactory factory) const;
 
 	const std::string& getCacheDirectory() const { return mCacheDirectory; }
+
+	//! @returns the in-memory cache shared by all tile sources created by this registry. May be null if disabled.
+	const TileImageCachePtr& getTileImageCache() const { return mTileImageCache; }
 	ApiKeys getApiKeys() const { return mApiKeys; }
 
+	//! @returns the cache in the given directory, creating it if it is not already open.
+	//! Tile sources with the same cache directory share the same cache.
+	//! Caches remain open for the lifetime of the registry, so that a directory is never opened by two caches at once.
+	PackedTileCachePtr getOrCreatePackedTileCache(const std::string& directory) const;
+
 private:
 	const std::string mCacheDirectory;
 	ApiKeys mApiKeys;
 	std::map<std::string, JsonTileSourceFactory> mFactories;
+	TileImageCachePtr mTileImageCache;
+
+	mutable std::mutex mPackedTileCachesMutex;
+	mutable std::map<std::string, PackedTileCachePtr> mPackedTileCaches;
 };
 
 void addDefaultFactories(JsonTileSourceFactoryRegistry& registry);
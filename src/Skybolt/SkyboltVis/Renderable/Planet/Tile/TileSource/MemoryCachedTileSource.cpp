@@ -0,0 +1,49 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "MemoryCachedTileSource.h"
+#include "TileImageCache.h"
+
+namespace skybolt {
+namespace vis {
+
+MemoryCachedTileSource::MemoryCachedTileSource(const TileSourcePtr& tileSource, const TileImageCachePtr& cache) :
+	mTileSource(tileSource),
+	mCache(cache)
+{
+	assert(mTileSource);
+	assert(mCache);
+	mSourceSha = mTileSource->getCacheSha();
+}
+
+osg::ref_ptr<osg::Image> MemoryCachedTileSource::createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const
+{
+	TileImageCacheKey cacheKey{mSourceSha, key};
+	if (osg::ref_ptr<osg::Image> image = mCache->get(cacheKey); image)
+	{
+		return image;
+	}
+
+	// Null images are not cached because they may be the result of a canceled load
+	osg::ref_ptr<osg::Image> image = mTileSource->createImage(key, cancelSupplier);
+	if (image)
+	{
+		mCache->put(cacheKey, image);
+	}
+	return image;
+}
+
+TileSourcePtr getMemoryUncachedTileSource(const TileSourcePtr& tileSource)
+{
+	if (const auto* cachedTileSource = dynamic_cast<const MemoryCachedTileSource*>(tileSource.get()); cachedTileSource)
+	{
+		return cachedTileSource->getTileSource();
+	}
+	return tileSource;
+}
+
+} // namespace vis
+} // namespace skybolt
@@ -0,0 +1,50 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "TileSource.h"
+#include <SkyboltVis/SkyboltVisFwd.h>
+
+namespace skybolt {
+namespace vis {
+
+//! Caches decoded images from a TileSource in a TileImageCache, which may be shared with other tile sources.
+//! Images are keyed by the wrapped TileSource's cache SHA, so tile sources with equal SHAs share cached images.
+class MemoryCachedTileSource : public TileSource
+{
+public:
+	MemoryCachedTileSource(const TileSourcePtr& tileSource, const TileImageCachePtr& cache);
+
+	osg::ref_ptr<osg::Image> createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override;
+
+	bool hasAnyChildren(const skybolt::QuadTreeTileKey& key) const override
+	{
+		return mTileSource->hasAnyChildren(key);
+	}
+
+	std::optional<skybolt::QuadTreeTileKey> getHighestAvailableLevel(const skybolt::QuadTreeTileKey& key) const override
+	{
+		return mTileSource->getHighestAvailableLevel(key);
+	}
+
+	const std::string& getCacheSha() const override { return mTileSource->getCacheSha(); }
+	const std::string& getCacheFileFormat() const override { return mTileSource->getCacheFileFormat(); }
+
+	const TileSourcePtr& getTileSource() const { return mTileSource; }
+
+private:
+	TileSourcePtr mTileSource;
+	TileImageCachePtr mCache;
+	std::string mSourceSha;
+};
+
+//! @returns the tile source wrapped by tileSource if it is a MemoryCachedTileSource, otherwise returns tileSource.
+//! Useful for reading source images which are only used to derive other cached images, so that both are not cached.
+TileSourcePtr getMemoryUncachedTileSource(const TileSourcePtr& tileSource);
+
+} // namespace vis
+} // namespace skybolt
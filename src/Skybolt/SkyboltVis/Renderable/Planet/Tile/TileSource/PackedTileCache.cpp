@@ -0,0 +1,624 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "PackedTileCache.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <assert.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace fs = std::filesystem;
+namespace bip = boost::interprocess;
+
+namespace skybolt {
+namespace vis {
+
+constexpr std::uint32_t packRecordMagic = 0x52544B53; // "SKTR"
+constexpr std::uint32_t indexMagic = 0x49544B53; // "SKTI"
+constexpr std::uint32_t indexVersion = 1;
+
+static const std::string packFilenamePrefix = "tiles_";
+static const std::string packFilenameExtension = ".pack";
+
+//! Header preceding each tile's data in a pack file
+struct PackedTileRecordHeader
+{
+	std::uint32_t magic;
+	std::int32_t level;
+	std::int32_t x;
+	std::int32_t y;
+	std::uint32_t dataSize;
+	std::uint32_t padding;
+};
+
+// Index file layout: PackedTileIndexHeader, followed by packCount PackedTileIndexPackInfos,
+// followed by entryCount PackedTileIndexEntries sorted by key.
+struct PackedTileIndexHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t packCount;
+	std::uint32_t padding;
+	std::uint64_t entryCount;
+};
+
+struct PackedTileIndexPackInfo
+{
+	std::uint32_t packId;
+	std::uint32_t padding;
+	std::uint64_t size;
+	std::uint64_t lastAccessTime;
+};
+
+struct PackedTileIndexEntry
+{
+	std::int32_t level;
+	std::int32_t x;
+	std::int32_t y;
+	std::uint32_t packId;
+	std::uint64_t dataOffset;
+	std::uint32_t dataSize;
+	std::uint32_t padding;
+
+	QuadTreeTileKey getKey() const { return QuadTreeTileKey(level, x, y); }
+};
+
+static std::uint64_t getCurrentTime()
+{
+	return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::optional<std::uint32_t> parsePackId(const fs::path& path)
+{
+	std::string filename = path.filename().string();
+	if (filename.size() <= packFilenamePrefix.size() + packFilenameExtension.size()
+		|| filename.compare(0, packFilenamePrefix.size(), packFilenamePrefix) != 0
+		|| path.extension().string() != packFilenameExtension)
+	{
+		return std::nullopt;
+	}
+
+	std::string idString = filename.substr(packFilenamePrefix.size(), filename.size() - packFilenamePrefix.size() - packFilenameExtension.size());
+	if (idString.empty() || !std::all_of(idString.begin(), idString.end(), [] (char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+	{
+		return std::nullopt;
+	}
+	return std::uint32_t(std::stoul(idString));
+}
+
+PackedTileCache::PackedTileCache(const PackedTileCacheConfig& config) :
+	mConfig(config)
+{
+	assert(mConfig.maxPackFileSizeBytes > 0);
+	fs::create_directories(mConfig.directory);
+
+	mapIndex();
+	openPackFiles();
+	deleteFiles(evictPacks());
+}
+
+PackedTileCache::~PackedTileCache()
+{
+	try
+	{
+		flush();
+	}
+	catch (const std::exception&)
+	{
+		// Tiles written since the last flush will be recovered on next open
+	}
+
+	mActivePackStream.close();
+	unmapIndex();
+}
+
+bool PackedTileCache::read(const QuadTreeTileKey& key, std::vector<std::uint8_t>& data) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+
+	std::optional<Location> location = findLocation(key);
+	if (!location)
+	{
+		return false;
+	}
+
+	const Pack* pack = findPack(location->packId);
+	if (!pack || location->dataOffset + location->dataSize > pack->size)
+	{
+		return false;
+	}
+
+	pack->lastAccessTime.store(getCurrentTime(), std::memory_order_relaxed);
+	data.resize(location->dataSize);
+
+	if (pack->mapping)
+	{
+		const std::uint8_t* begin = static_cast<const std::uint8_t*>(pack->mapping->get_address()) + location->dataOffset;
+		std::memcpy(data.data(), begin, location->dataSize);
+	}
+	else
+	{
+		// Pack is still being appended to, so is not mapped
+		std::scoped_lock<std::mutex> streamLock(pack->activeReadStreamMutex);
+		std::ifstream& f = pack->activeReadStream;
+		f.clear();
+		f.seekg(location->dataOffset);
+		f.read(reinterpret_cast<char*>(data.data()), location->dataSize);
+		if (!f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PackedTileCache::contains(const QuadTreeTileKey& key) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	std::optional<Location> location = findLocation(key);
+	return location && findPack(location->packId);
+}
+
+void PackedTileCache::write(const QuadTreeTileKey& key, const std::uint8_t* data, std::size_t size)
+{
+	assert(size <= std::numeric_limits<std::uint32_t>::max());
+
+	std::scoped_lock<std::mutex> writeLock(mWriteMutex);
+
+	Pack& pack = getOrCreateActivePack();
+
+	PackedTileRecordHeader header = {};
+	header.magic = packRecordMagic;
+	header.level = key.level;
+	header.x = key.x;
+	header.y = key.y;
+	header.dataSize = std::uint32_t(size);
+
+	// Append the record without holding mMutex, so that reads are not blocked by file I/O.
+	// The active pack's size only changes while mWriteMutex is held, so it can be read here.
+	std::uint64_t recordOffset = pack.size;
+	mActivePackStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	mActivePackStream.write(reinterpret_cast<const char*>(data), size);
+	mActivePackStream.flush();
+	if (!mActivePackStream)
+	{
+		throw std::runtime_error("Could not write to tile cache file: " + pack.filename);
+	}
+
+	bool overSizeLimit;
+	{
+		std::unique_lock<std::shared_mutex> lock(mMutex);
+
+		Location location;
+		location.packId = pack.id;
+		location.dataSize = std::uint32_t(size);
+		location.dataOffset = recordOffset + sizeof(header);
+		mRecentLocations[key] = location;
+		mIndexDirty = true;
+
+		std::uint64_t recordSize = sizeof(header) + size;
+		pack.size += recordSize;
+		pack.lastAccessTime = getCurrentTime();
+		mTotalSize += recordSize;
+		overSizeLimit = mTotalSize > mConfig.maxSizeBytes;
+	}
+
+	if (pack.size >= mConfig.maxPackFileSizeBytes)
+	{
+		sealActivePack(pack);
+	}
+
+	if (overSizeLimit)
+	{
+		std::vector<std::string> evictedFilenames;
+		{
+			std::unique_lock<std::shared_mutex> lock(mMutex);
+			evictedFilenames = evictPacks();
+		}
+		deleteFiles(evictedFilenames);
+	}
+}
+
+void PackedTileCache::flush()
+{
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	if (!isIndexUpToDate())
+	{
+		writeIndex();
+	}
+}
+
+std::uint64_t PackedTileCache::getSizeBytes() const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mTotalSize;
+}
+
+std::size_t PackedTileCache::getPackFileCount() const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mPacks.size();
+}
+
+void PackedTileCache::mapIndex()
+{
+	std::string filename = getIndexFilename();
+	std::error_code ec;
+	std::uintmax_t fileSize = fs::file_size(filename, ec);
+	if (ec || fileSize < sizeof(PackedTileIndexHeader))
+	{
+		return;
+	}
+
+	bip::file_mapping fileMapping(filename.c_str(), bip::read_only);
+	auto mapping = std::make_unique<bip::mapped_region>(fileMapping, bip::read_only);
+
+	const auto* begin = static_cast<const std::uint8_t*>(mapping->get_address());
+	const auto& header = *reinterpret_cast<const PackedTileIndexHeader*>(begin);
+	std::uint64_t expectedSize = sizeof(PackedTileIndexHeader) + header.packCount * sizeof(PackedTileIndexPackInfo) + header.entryCount * sizeof(PackedTileIndexEntry);
+	if (header.magic != indexMagic || header.version != indexVersion || expectedSize != fileSize)
+	{
+		// Ignore the invalid index. All tiles will be recovered from pack files.
+		return;
+	}
+
+	const auto* packInfos = reinterpret_cast<const PackedTileIndexPackInfo*>(begin + sizeof(PackedTileIndexHeader));
+	for (std::uint32_t i = 0; i < header.packCount; ++i)
+	{
+		mIndexedPacks[packInfos[i].packId] = IndexedPack{packInfos[i].size, packInfos[i].lastAccessTime};
+	}
+
+	mIndexEntries = reinterpret_cast<const PackedTileIndexEntry*>(packInfos + header.packCount);
+	mIndexEntryCount = header.entryCount;
+	mIndexMapping = std::move(mapping);
+}
+
+void PackedTileCache::unmapIndex()
+{
+	mIndexMapping.reset();
+	mIndexEntries = nullptr;
+	mIndexEntryCount = 0;
+}
+
+bool PackedTileCache::isIndexUpToDate() const
+{
+	if (mIndexDirty || mIndexedPacks.size() != mPacks.size())
+	{
+		return false;
+	}
+
+	for (const auto& [id, pack] : mPacks)
+	{
+		auto i = mIndexedPacks.find(id);
+		if (i == mIndexedPacks.end() || i->second.size != pack->size || i->second.lastAccessTime != pack->lastAccessTime)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void PackedTileCache::writeIndex()
+{
+	std::vector<PackedTileIndexEntry> entries;
+	entries.reserve(mIndexEntryCount + mRecentLocations.size());
+
+	for (std::size_t i = 0; i < mIndexEntryCount; ++i)
+	{
+		const PackedTileIndexEntry& entry = mIndexEntries[i];
+		if (mPacks.find(entry.packId) != mPacks.end() && mRecentLocations.find(entry.getKey()) == mRecentLocations.end())
+		{
+			entries.push_back(entry);
+		}
+	}
+
+	for (const auto& [key, location] : mRecentLocations)
+	{
+		if (mPacks.find(location.packId) != mPacks.end())
+		{
+			PackedTileIndexEntry entry = {};
+			entry.level = key.level;
+			entry.x = key.x;
+			entry.y = key.y;
+			entry.packId = location.packId;
+			entry.dataOffset = location.dataOffset;
+			entry.dataSize = location.dataSize;
+			entries.push_back(entry);
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), [] (const PackedTileIndexEntry& a, const PackedTileIndexEntry& b) {
+		return a.getKey() < b.getKey();
+	});
+
+	std::vector<PackedTileIndexPackInfo> packInfos;
+	std::map<std::uint32_t, IndexedPack> indexedPacks;
+	for (const auto& [id, pack] : mPacks)
+	{
+		PackedTileIndexPackInfo info = {};
+		info.packId = id;
+		info.size = pack->size;
+		info.lastAccessTime = pack->lastAccessTime;
+		packInfos.push_back(info);
+		indexedPacks[id] = IndexedPack{info.size, info.lastAccessTime};
+	}
+
+	PackedTileIndexHeader header = {};
+	header.magic = indexMagic;
+	header.version = indexVersion;
+	header.packCount = std::uint32_t(packInfos.size());
+	header.entryCount = entries.size();
+
+	// Write to a temporary file and then replace the index, so that the index is never partially written
+	std::string filename = getIndexFilename();
+	std::string temporaryFilename = filename + ".tmp";
+	{
+		std::ofstream f(temporaryFilename, std::ios::binary | std::ios::trunc);
+		f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		f.write(reinterpret_cast<const char*>(packInfos.data()), packInfos.size() * sizeof(PackedTileIndexPackInfo));
+		f.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackedTileIndexEntry));
+		if (!f)
+		{
+			throw std::runtime_error("Could not write tile cache index: " + temporaryFilename);
+		}
+	}
+
+	unmapIndex(); // Mapped files cannot be replaced on some platforms
+	fs::rename(temporaryFilename, filename);
+
+	mIndexedPacks.clear();
+	mRecentLocations.clear();
+	mIndexDirty = false;
+	mapIndex();
+}
+
+void PackedTileCache::openPackFiles()
+{
+	for (const fs::directory_entry& entry : fs::directory_iterator(mConfig.directory))
+	{
+		std::optional<std::uint32_t> id = entry.is_regular_file() ? parsePackId(entry.path()) : std::nullopt;
+		if (!id)
+		{
+			continue;
+		}
+
+		auto pack = std::make_unique<Pack>();
+		pack->id = *id;
+		pack->filename = entry.path().string();
+		pack->size = fs::file_size(entry.path());
+
+		std::uint64_t indexedSize = 0;
+		if (auto i = mIndexedPacks.find(*id); i != mIndexedPacks.end())
+		{
+			indexedSize = i->second.size;
+			pack->lastAccessTime = i->second.lastAccessTime;
+		}
+		else
+		{
+			pack->lastAccessTime = getCurrentTime();
+		}
+
+		if (pack->size > indexedSize)
+		{
+			recoverRecords(*pack, indexedSize);
+		}
+
+		mTotalSize += pack->size;
+		mPacks[*id] = std::move(pack);
+	}
+
+	// Never reuse the ID of a pack which may still be referenced by the index
+	for (const auto& [id, indexedPack] : mIndexedPacks)
+	{
+		mNextPackId = std::max(mNextPackId, id + 1);
+	}
+	for (const auto& [id, pack] : mPacks)
+	{
+		mNextPackId = std::max(mNextPackId, id + 1);
+	}
+
+	// Continue appending to the last pack if it is not full. Map the others.
+	for (auto& [id, pack] : mPacks)
+	{
+		bool isLastPack = (id == mPacks.rbegin()->first);
+		if (isLastPack && pack->size < mConfig.maxPackFileSizeBytes)
+		{
+			openActivePackStreams(*pack, std::ios::app);
+			mActivePackId = id;
+		}
+		else
+		{
+			pack->mapping = mapPack(*pack);
+		}
+	}
+}
+
+void PackedTileCache::recoverRecords(Pack& pack, std::uint64_t offset)
+{
+	std::ifstream f(pack.filename, std::ios::binary);
+	f.seekg(offset);
+
+	while (offset < pack.size)
+	{
+		PackedTileRecordHeader header;
+		f.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!f || header.magic != packRecordMagic || offset + sizeof(header) + header.dataSize > pack.size)
+		{
+			// Remove partially written record
+			f.close();
+			fs::resize_file(pack.filename, offset);
+			pack.size = offset;
+			break;
+		}
+
+		Location location;
+		location.packId = pack.id;
+		location.dataSize = header.dataSize;
+		location.dataOffset = offset + sizeof(header);
+		mRecentLocations[QuadTreeTileKey(header.level, header.x, header.y)] = location;
+		mIndexDirty = true;
+
+		offset += sizeof(header) + header.dataSize;
+		f.seekg(offset);
+	}
+}
+
+std::optional<PackedTileCache::Location> PackedTileCache::findLocation(const QuadTreeTileKey& key) const
+{
+	if (auto i = mRecentLocations.find(key); i != mRecentLocations.end())
+	{
+		return i->second;
+	}
+
+	const PackedTileIndexEntry* end = mIndexEntries + mIndexEntryCount;
+	const PackedTileIndexEntry* i = std::lower_bound(mIndexEntries, end, key, [] (const PackedTileIndexEntry& entry, const QuadTreeTileKey& key) {
+		return entry.getKey() < key;
+	});
+
+	if (i != end && i->getKey() == key)
+	{
+		return Location{i->packId, i->dataSize, i->dataOffset};
+	}
+	return std::nullopt;
+}
+
+const PackedTileCache::Pack* PackedTileCache::findPack(std::uint32_t id) const
+{
+	auto i = mPacks.find(id);
+	return (i == mPacks.end()) ? nullptr : i->second.get();
+}
+
+PackedTileCache::Pack& PackedTileCache::getOrCreateActivePack()
+{
+	if (mActivePackId)
+	{
+		// The active pack is never evicted, so the reference remains valid after the lock is released
+		std::shared_lock<std::shared_mutex> lock(mMutex);
+		return *mPacks.at(*mActivePackId);
+	}
+
+	std::uint32_t id = mNextPackId++;
+
+	auto pack = std::make_unique<Pack>();
+	pack->id = id;
+	pack->filename = getPackFilename(id);
+	pack->lastAccessTime = getCurrentTime();
+
+	openActivePackStreams(*pack, std::ios::trunc);
+
+	Pack& result = *pack;
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	mActivePackId = id;
+	mPacks[id] = std::move(pack);
+	return result;
+}
+
+void PackedTileCache::openActivePackStreams(Pack& pack, std::ios::openmode writeMode)
+{
+	mActivePackStream.open(pack.filename, std::ios::binary | writeMode);
+	if (!mActivePackStream)
+	{
+		throw std::runtime_error("Could not open tile cache file: " + pack.filename);
+	}
+
+	pack.activeReadStream.open(pack.filename, std::ios::binary);
+	if (!pack.activeReadStream)
+	{
+		throw std::runtime_error("Could not open tile cache file: " + pack.filename);
+	}
+}
+
+void PackedTileCache::sealActivePack(Pack& pack)
+{
+	assert(mActivePackId == pack.id);
+	mActivePackStream.close();
+
+	// The pack is no longer appended to, so it can be mapped without holding mMutex
+	std::unique_ptr<bip::mapped_region> mapping = mapPack(pack);
+
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	pack.mapping = std::move(mapping);
+	pack.activeReadStream.close();
+	mActivePackId.reset();
+}
+
+std::unique_ptr<bip::mapped_region> PackedTileCache::mapPack(const Pack& pack) const
+{
+	if (pack.size == 0)
+	{
+		return nullptr;
+	}
+	bip::file_mapping fileMapping(pack.filename.c_str(), bip::read_only);
+	return std::make_unique<bip::mapped_region>(fileMapping, bip::read_only, 0, std::size_t(pack.size));
+}
+
+std::vector<std::string> PackedTileCache::evictPacks()
+{
+	std::vector<std::string> evictedFilenames;
+	while (mTotalSize > mConfig.maxSizeBytes)
+	{
+		// Find least recently used pack, excluding the pack being appended to
+		Pack* lruPack = nullptr;
+		for (const auto& [id, pack] : mPacks)
+		{
+			if (id != mActivePackId && (!lruPack || pack->lastAccessTime < lruPack->lastAccessTime))
+			{
+				lruPack = pack.get();
+			}
+		}
+
+		if (!lruPack)
+		{
+			break;
+		}
+
+		std::uint32_t id = lruPack->id;
+		mTotalSize -= lruPack->size;
+		lruPack->mapping.reset();
+		evictedFilenames.push_back(lruPack->filename);
+
+		for (auto i = mRecentLocations.begin(); i != mRecentLocations.end();)
+		{
+			i = (i->second.packId == id) ? mRecentLocations.erase(i) : std::next(i);
+		}
+		mPacks.erase(id);
+		mIndexDirty = true;
+	}
+	return evictedFilenames;
+}
+
+void PackedTileCache::deleteFiles(const std::vector<std::string>& filenames)
+{
+	for (const std::string& filename : filenames)
+	{
+		std::error_code ec;
+		fs::remove(filename, ec);
+	}
+}
+
+std::string PackedTileCache::getPackFilename(std::uint32_t id) const
+{
+	std::ostringstream ss;
+	ss << mConfig.directory << "/" << packFilenamePrefix << std::setw(6) << std::setfill('0') << id << packFilenameExtension;
+	return ss.str();
+}
+
+std::string PackedTileCache::getIndexFilename() const
+{
+	return mConfig.directory + "/tiles.index";
+}
+
+} // namespace vis
+} // namespace skybolt
@@ -0,0 +1,168 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltCommon/Math/QuadTree.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace boost::interprocess {
+class mapped_region;
+}
+
+namespace skybolt {
+namespace vis {
+
+struct PackedTileIndexEntry;
+
+struct PackedTileCacheConfig
+{
+	std::string directory;
+	std::uint64_t maxSizeBytes = 8ull * 1024 * 1024 * 1024; //!< Least recently used pack files are deleted when the cache exceeds this size
+	std::uint64_t maxPackFileSizeBytes = 256ull * 1024 * 1024; //!< A new pack file is started when the current one exceeds this size
+};
+
+//! Persistent on-disk cache of tile data blobs, keyed by QuadTreeTileKey.
+//! Tiles are appended to a small number of large pack files rather than stored one file per tile,
+//! and located through a sorted index file which is memory mapped on open.
+//! Full pack files are memory mapped so that tile reads do not need to open files.
+//! Eviction is least-recently-used at pack file granularity.
+//! Writes are serialized with each other, but file I/O is performed without blocking concurrent reads.
+//! If the process exits without flushing the index, tiles appended since the last flush are recovered by scanning pack files on the next open.
+//! Files are written in native byte order and are not intended to be portable between platforms.
+//! Only one PackedTileCache may use a given directory at a time.
+//! @ThreadSafe
+class PackedTileCache
+{
+public:
+	explicit PackedTileCache(const PackedTileCacheConfig& config);
+
+	//! Flushes the index
+	~PackedTileCache();
+
+	//! @param data is replaced with the tile's data if found
+	//! @returns true if the tile was found
+	bool read(const QuadTreeTileKey& key, std::vector<std::uint8_t>& data) const;
+
+	bool contains(const QuadTreeTileKey& key) const;
+
+	//! Appends a tile to the cache. If the tile already exists, the new data replaces the old.
+	//! The tile is readable once this function returns.
+	void write(const QuadTreeTileKey& key, const std::uint8_t* data, std::size_t size);
+
+	//! Writes the index to disk
+	void flush();
+
+	std::uint64_t getSizeBytes() const;
+
+	std::size_t getPackFileCount() const;
+
+private:
+	struct Location
+	{
+		std::uint32_t packId;
+		std::uint32_t dataSize;
+		std::uint64_t dataOffset;
+	};
+
+	struct Pack
+	{
+		std::uint32_t id;
+		std::string filename;
+		std::uint64_t size = 0;
+		std::unique_ptr<boost::interprocess::mapped_region> mapping; //!< Null for the pack currently being appended to, or if the pack is empty
+		mutable std::atomic<std::uint64_t> lastAccessTime = 0; //!< Seconds since epoch
+
+		//! Read handle for the pack currently being appended to, shared by all reads from the pack
+		mutable std::ifstream activeReadStream;
+		mutable std::mutex activeReadStreamMutex;
+	};
+	using PackPtr = std::unique_ptr<Pack>;
+
+	struct IndexedPack
+	{
+		std::uint64_t size; //!< Size of the pack file covered by the index
+		std::uint64_t lastAccessTime;
+	};
+
+	//! Maps the index file. The index is ignored if it is missing or invalid.
+	void mapIndex();
+	void unmapIndex();
+	bool isIndexUpToDate() const;
+	void writeIndex();
+	void openPackFiles();
+
+	//! Adds records from the given offset to the end of the pack file to mRecentLocations.
+	//! If the file ends with a partially written record, the file is truncated to remove it.
+	void recoverRecords(Pack& pack, std::uint64_t offset);
+
+	std::optional<Location> findLocation(const QuadTreeTileKey& key) const;
+	const Pack* findPack(std::uint32_t id) const;
+	//! Must be called with mWriteMutex locked
+	Pack& getOrCreateActivePack();
+
+	//! Opens the write and read streams of the pack which will become the active pack.
+	//! Must be called with mWriteMutex locked, or from the constructor.
+	void openActivePackStreams(Pack& pack, std::ios::openmode writeMode);
+
+	//! Must be called with mWriteMutex locked
+	void sealActivePack(Pack& pack);
+
+	//! @returns a mapping of the pack file, or null if the pack is empty
+	std::unique_ptr<boost::interprocess::mapped_region> mapPack(const Pack& pack) const;
+
+	//! Removes least recently used packs from the cache until it is within the size limit.
+	//! Must be called with mMutex exclusively locked.
+	//! @returns filenames of the removed packs, which the caller must delete
+	std::vector<std::string> evictPacks();
+	static void deleteFiles(const std::vector<std::string>& filenames);
+
+	std::string getPackFilename(std::uint32_t id) const;
+	std::string getIndexFilename() const;
+
+private:
+	const PackedTileCacheConfig mConfig;
+
+	//! Guards all members except those guarded by mWriteMutex. Held exclusively only to publish changes.
+	mutable std::shared_mutex mMutex;
+
+	//! Serializes writes. Guards mActivePackStream and mNextPackId.
+	//! Also guards changes to mActivePackId and the active pack's size, which additionally require mMutex to be held exclusively.
+	//! Must be locked before mMutex.
+	std::mutex mWriteMutex;
+
+	std::map<std::uint32_t, PackPtr> mPacks;
+	std::uint64_t mTotalSize = 0;
+
+	std::uint32_t mNextPackId = 0;
+	std::optional<std::uint32_t> mActivePackId;
+	std::ofstream mActivePackStream;
+
+	// Index loaded from disk
+	std::unique_ptr<boost::interprocess::mapped_region> mIndexMapping;
+	const PackedTileIndexEntry* mIndexEntries = nullptr;
+	std::size_t mIndexEntryCount = 0;
+	std::map<std::uint32_t, IndexedPack> mIndexedPacks;
+
+	//! Locations of tiles written or recovered since the index was last written to disk.
+	//! These take precedence over mIndexEntries.
+	std::unordered_map<QuadTreeTileKey, Location> mRecentLocations;
+	bool mIndexDirty = false;
+};
+
+} // namespace vis
+} // namespace skybolt
@@ -0,0 +1,118 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "TileImageCache.h"
+
+#include <assert.h>
+
+namespace skybolt {
+namespace vis {
+
+static std::size_t getImageSizeBytes(const osg::Image& image)
+{
+	return sizeof(osg::Image) + image.getTotalSizeInBytes();
+}
+
+TileImageCache::TileImageCache(std::size_t maxSizeBytes, std::size_t shardCount) :
+	mMaxSizeBytes(maxSizeBytes)
+{
+	assert(shardCount > 0);
+	mShardMaxSizeBytes = maxSizeBytes / shardCount;
+
+	mShards.reserve(shardCount);
+	for (std::size_t i = 0; i < shardCount; ++i)
+	{
+		mShards.push_back(std::make_unique<Shard>());
+	}
+}
+
+TileImageCache::~TileImageCache() = default;
+
+TileImageCache::Shard& TileImageCache::getShard(const TileImageCacheKey& key) const
+{
+	return *mShards[std::hash<TileImageCacheKey>()(key) % mShards.size()];
+}
+
+osg::ref_ptr<osg::Image> TileImageCache::get(const TileImageCacheKey& key) const
+{
+	Shard& shard = getShard(key);
+	{
+		std::scoped_lock<std::mutex> lock(shard.mutex);
+		auto i = shard.entries.find(key);
+		if (i != shard.entries.end())
+		{
+			shard.queue.splice(shard.queue.begin(), shard.queue, i->second); // move item to the beginning of the queue
+			++mHits;
+			return i->second->second;
+		}
+	}
+	++mMisses;
+	return nullptr;
+}
+
+void TileImageCache::put(const TileImageCacheKey& key, const osg::ref_ptr<osg::Image>& image)
+{
+	assert(image);
+	std::size_t imageSize = getImageSizeBytes(*image);
+	if (imageSize > mShardMaxSizeBytes)
+	{
+		return;
+	}
+
+	Shard& shard = getShard(key);
+	std::scoped_lock<std::mutex> lock(shard.mutex);
+	if (auto i = shard.entries.find(key); i != shard.entries.end())
+	{
+		removeEntry(shard, i->second);
+	}
+
+	shard.queue.emplace_front(key, image);
+	shard.entries[key] = shard.queue.begin();
+	shard.sizeBytes += imageSize;
+
+	while (shard.sizeBytes > mShardMaxSizeBytes)
+	{
+		removeEntry(shard, std::prev(shard.queue.end()));
+		++mEvictions;
+	}
+}
+
+void TileImageCache::removeEntry(Shard& shard, std::list<Shard::Entry>::iterator it)
+{
+	shard.sizeBytes -= getImageSizeBytes(*it->second);
+	shard.entries.erase(it->first);
+	shard.queue.erase(it);
+}
+
+void TileImageCache::clear()
+{
+	for (const auto& shard : mShards)
+	{
+		std::scoped_lock<std::mutex> lock(shard->mutex);
+		shard->entries.clear();
+		shard->queue.clear();
+		shard->sizeBytes = 0;
+	}
+}
+
+TileImageCacheStats TileImageCache::getStats() const
+{
+	TileImageCacheStats stats;
+	stats.hits = mHits;
+	stats.misses = mMisses;
+	stats.evictions = mEvictions;
+
+	for (const auto& shard : mShards)
+	{
+		std::scoped_lock<std::mutex> lock(shard->mutex);
+		stats.sizeBytes += shard->sizeBytes;
+		stats.imageCount += shard->entries.size();
+	}
+	return stats;
+}
+
+} // namespace vis
+} // namespace skybolt
@@ -0,0 +1,112 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltCommon/Math/QuadTree.h>
+
+#include <osg/Image>
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace skybolt {
+namespace vis {
+
+struct TileImageCacheKey
+{
+	std::string sourceSha; //!< Identifies the source of the image, e.g TileSource::getCacheSha()
+	QuadTreeTileKey tileKey;
+
+	bool operator==(const TileImageCacheKey& other) const
+	{
+		return tileKey == other.tileKey && sourceSha == other.sourceSha;
+	}
+};
+
+} // namespace vis
+} // namespace skybolt
+
+namespace std {
+template <>
+struct hash<skybolt::vis::TileImageCacheKey>
+{
+	size_t operator()(const skybolt::vis::TileImageCacheKey& key) const
+	{
+		size_t h = std::hash<std::string>()(key.sourceSha);
+		return h ^ (std::hash<skybolt::QuadTreeTileKey>()(key.tileKey) + 0x9e3779b9 + (h << 6) + (h >> 2));
+	}
+};
+}
+
+namespace skybolt {
+namespace vis {
+
+struct TileImageCacheStats
+{
+	std::uint64_t hits = 0;
+	std::uint64_t misses = 0;
+	std::uint64_t evictions = 0;
+	std::size_t sizeBytes = 0;
+	std::size_t imageCount = 0;
+};
+
+//! In-memory cache of decoded tile images, bounded by the total size of the cached images.
+//! The cache is split into independently locked shards so that concurrent loader threads rarely contend.
+//! Each shard evicts its least recently used images when it exceeds its share of the size budget.
+//! Cached images are shared between all users and must not be modified.
+//! @ThreadSafe
+class TileImageCache
+{
+public:
+	TileImageCache(std::size_t maxSizeBytes, std::size_t shardCount = 16);
+	~TileImageCache();
+
+	//! @returns the cached image, or null if the image is not in the cache
+	osg::ref_ptr<osg::Image> get(const TileImageCacheKey& key) const;
+
+	//! Adds an image to the cache, replacing any existing image with the same key.
+	//! Images larger than a shard's size budget are not cached.
+	void put(const TileImageCacheKey& key, const osg::ref_ptr<osg::Image>& image);
+
+	void clear();
+
+	TileImageCacheStats getStats() const;
+
+	std::size_t getMaxSizeBytes() const { return mMaxSizeBytes; }
+
+private:
+	struct Shard
+	{
+		using Entry = std::pair<TileImageCacheKey, osg::ref_ptr<osg::Image>>;
+
+		mutable std::mutex mutex;
+		mutable std::list<Entry> queue; //!< Most recently used first
+		std::unordered_map<TileImageCacheKey, std::list<Entry>::iterator> entries;
+		std::size_t sizeBytes = 0;
+	};
+
+	Shard& getShard(const TileImageCacheKey& key) const;
+	void removeEntry(Shard& shard, std::list<Shard::Entry>::iterator it);
+
+private:
+	const std::size_t mMaxSizeBytes;
+	std::size_t mShardMaxSizeBytes;
+	std::vector<std::unique_ptr<Shard>> mShards;
+
+	mutable std::atomic<std::uint64_t> mHits = 0;
+	mutable std::atomic<std::uint64_t> mMisses = 0;
+	std::atomic<std::uint64_t> mEvictions = 0;
+};
+
+} // namespace vis
+} // namespace skybolt
@@ -39,10 +39,12 @@ class Model;
 class ModelFactory;
 struct OsgTile;
 class OsgTileFactory;
+class PackedTileCache;
 class PagedForest;
 class PlanetFeatures;
 struct PlanetSubdivisionPredicate;
 struct PlanetTileSources;
+struct PlanetTileVertices;
 class QuadTreeTileLoader;
 class Ocean;
 class Particles;
@@ -70,6 +72,7 @@ class Terrain;
 class TextureCache;
 class TextureCompiler;
 struct TileImage;
+class TileImageCache;
 struct TileImages;
 class TileImagesLoader;
 struct TileProgressCallback;
@@ -105,9 +108,11 @@ typedef shared_ptr<ModelFactory> ModelFactoryPtr;
 typedef shared_ptr<Ocean> OceanPtr;
 typedef shared_ptr<OsgTile> OsgTilePtr;
 typedef shared_ptr<OsgTileFactory> OsgTileFactoryPtr;
+typedef shared_ptr<PackedTileCache> PackedTileCachePtr;
 typedef shared_ptr<PagedForest> PagedForestPtr;
 typedef shared_ptr<Particles> ParticlesPtr;
 typedef shared_ptr<Planet> PlanetPtr;
+typedef shared_ptr<PlanetTileVertices> PlanetTileVerticesPtr;
 typedef shared_ptr<Polyline> PolylinePtr;
 typedef shared_ptr<QuadTreeTileLoader> QuadTreeTileLoaderPtr;
 typedef shared_ptr<RenderOperationSequence> RenderOperationSequencePtr;
@@ -118,6 +123,7 @@ typedef shared_ptr<RootNode> RootNodePtr;
 typedef shared_ptr<Scene> ScenePtr;
 typedef shared_ptr<TextureCache> TextureCachePtr;
 typedef shared_ptr<Terrain> TerrainPtr;
+typedef shared_ptr<TileImageCache> TileImageCachePtr;
 typedef shared_ptr<TileImages> TileImagesPtr;
 typedef shared_ptr<TileImagesLoader> TileImagesLoaderPtr;
 typedef shared_ptr<TileProgressCallback> ProgressCallbackPtr;
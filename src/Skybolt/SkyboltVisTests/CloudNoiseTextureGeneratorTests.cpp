@@ -0,0 +1,152 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltVis/Renderable/Clouds/CloudNoiseTextureGenerator.h>
+#include <SkyboltVis/Renderable/Clouds/ThirdParty/TileableVolumeNoise.h>
+
+#include <px_sched/px_sched.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+//! Per-voxel implementation using Tileable3dNoise directly, used as a reference for the optimized implementation
+static osg::ref_ptr<osg::Image> createReferencePerlinWorleyTexture3d(const PerlinWorleyConfig& config)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image;
+	image->allocateImage(config.width, config.width, config.width, GL_LUMINANCE, GL_UNSIGNED_BYTE);
+
+	unsigned char* p = image->data();
+	for (int z = 0; z < config.width; ++z)
+	{
+		for (int y = 0; y < config.width; ++y)
+		{
+			for (int x = 0; x < config.width; ++x)
+			{
+				glm::vec3 pos = glm::vec3(x, y, z) / float(config.width);
+
+				float worleyNoise = 0;
+				float frequency = config.worley.frequency;
+				float amplitude = config.worley.amplitude;
+				for (int i = 0; i < config.worley.octaveCount; ++i)
+				{
+					worleyNoise += amplitude * (1.0 - Tileable3dNoise::WorleyNoise(pos, frequency));
+					frequency *= config.worley.lacunarity;
+					amplitude *= config.worley.gain;
+				}
+				worleyNoise -= 0.2f;
+				if (config.worley.invert)
+				{
+					worleyNoise = 1.0f - worleyNoise;
+				}
+
+				float c = 1.0 - glm::clamp(worleyNoise, 0.0f, 1.0f);
+				*p++ = std::min(255, int(c * 256.f));
+			}
+		}
+	}
+	return image;
+}
+
+static int getMaxDifference(const osg::Image& a, const osg::Image& b)
+{
+	REQUIRE(a.getTotalSizeInBytes() == b.getTotalSizeInBytes());
+	int maxDifference = 0;
+	for (unsigned int i = 0; i < a.getTotalSizeInBytes(); ++i)
+	{
+		maxDifference = std::max(maxDifference, std::abs(int(a.data()[i]) - int(b.data()[i])));
+	}
+	return maxDifference;
+}
+
+static PerlinWorleyConfig createTestConfig()
+{
+	PerlinWorleyConfig config;
+	config.width = 24;
+	config.worley.invert = true;
+	return config;
+}
+
+TEST_CASE("Perlin-Worley texture matches reference implementation")
+{
+	PerlinWorleyConfig config = createTestConfig();
+
+	SECTION("Integer cell counts")
+	{
+		CHECK(getMaxDifference(*createReferencePerlinWorleyTexture3d(config), *createPerlinWorleyTexture3d(config)) <= 1);
+	}
+
+	SECTION("Fractional cell counts")
+	{
+		config.worley.frequency = 5.5f;
+		config.worley.octaveCount = 2;
+		CHECK(getMaxDifference(*createReferencePerlinWorleyTexture3d(config), *createPerlinWorleyTexture3d(config)) <= 1);
+	}
+}
+
+TEST_CASE("Perlin-Worley texture created in parallel matches texture created serially")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	PerlinWorleyConfig config = createTestConfig();
+	CHECK(getMaxDifference(*createPerlinWorleyTexture3d(config), *createPerlinWorleyTexture3d(config, &scheduler)) == 0);
+}
+
+TEST_CASE("Perlin-Worley texture is read from cache")
+{
+	std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path() / "SkyboltVisTests_CloudNoiseCache";
+	std::filesystem::remove_all(cacheDirectory);
+
+	PerlinWorleyConfig config = createTestConfig();
+	osg::ref_ptr<osg::Image> created = readOrCreatePerlinWorleyTexture3d(config, cacheDirectory.string());
+	REQUIRE(created);
+	CHECK(!std::filesystem::is_empty(cacheDirectory));
+
+	osg::ref_ptr<osg::Image> cached = readOrCreatePerlinWorleyTexture3d(config, cacheDirectory.string());
+	REQUIRE(cached);
+	CHECK(cached != created);
+	CHECK(cached->r() == config.width);
+	CHECK(getMaxDifference(*created, *cached) == 0);
+
+	SECTION("Configs have different hashes")
+	{
+		PerlinWorleyConfig otherConfig = config;
+		otherConfig.worley.gain = 0.5f;
+		CHECK(calcPerlinWorleyConfigHash(config) != calcPerlinWorleyConfigHash(otherConfig));
+	}
+
+	std::filesystem::remove_all(cacheDirectory);
+}
+
+TEST_CASE("Benchmark Perlin-Worley texture generation", "[.benchmark]")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	PerlinWorleyConfig config;
+	config.width = 64;
+	config.worley.invert = true;
+
+	BENCHMARK("Reference 64^3")
+	{
+		return createReferencePerlinWorleyTexture3d(config);
+	};
+
+	BENCHMARK("Serial 64^3")
+	{
+		return createPerlinWorleyTexture3d(config);
+	};
+
+	BENCHMARK("Parallel 64^3")
+	{
+		return createPerlinWorleyTexture3d(config, &scheduler);
+	};
+}
@@ -9,6 +9,10 @@
 #include <SkyboltVis/Renderable/Planet/Tile/ConcurrentAsyncTileLoader.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileImagesLoader.h>
 
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
 using namespace skybolt;
 using namespace skybolt::vis;
 
@@ -21,7 +25,7 @@ struct DummyTileImages : public TileImages
 class DummyTileImagesLoader : public TileImagesLoader
 {
 public:
-	DummyTileImagesLoader() : TileImagesLoader(1) {}
+	DummyTileImagesLoader() : TileImagesLoader(nullptr) {}
 	~DummyTileImagesLoader() override = default;
 
 	TileImagesPtr load(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const
@@ -35,10 +39,18 @@ public:
 		{
 			return nullptr;
 		}
+
+		{
+			std::scoped_lock<std::mutex> lock(mutex);
+			loadedKeys.push_back(key);
+		}
 		return std::make_shared<DummyTileImages>(key);
 	}
 
 	std::atomic_bool doLoad = false;
+
+	mutable std::mutex mutex;
+	mutable std::vector<skybolt::QuadTreeTileKey> loadedKeys;
 };
 
 TEST_CASE("Test tile loads on background thread")
@@ -90,3 +102,85 @@ TEST_CASE("Test background loading tile cancels load when cancelled")
 	CHECK(progressCallback->state == TileProgressCallback::State::FailedOrCanceled);
 	CHECK(!result->get());
 }
+
+
+TEST_CASE("Test queued tiles load in priority order")
+{
+	auto imagesLoader = std::make_shared<DummyTileImagesLoader>();
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	ConcurrentAsyncTileLoader loader(imagesLoader, &scheduler);
+	loader.setMaxActiveLoads(1);
+
+	std::vector<QuadTreeTileKey> keys = { QuadTreeTileKey(1, 0, 0), QuadTreeTileKey(1, 1, 0), QuadTreeTileKey(1, 0, 1) };
+	std::vector<double> priorities = { 1.0, 3.0, 2.0 };
+	std::vector<ProgressCallbackPtr> progressCallbacks;
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		auto progressCallback = std::make_shared<TileProgressCallback>();
+		progressCallback->priority = priorities[i];
+		loader.load(keys[i], std::make_shared<TileImagesPtr>(), progressCallback);
+		progressCallbacks.push_back(progressCallback);
+	}
+
+	loader.update();
+	CHECK(loader.getStats().activeLoads == 1);
+	CHECK(loader.getStats().queuedLoads == 2);
+
+	// Reprioritize a queued tile
+	progressCallbacks[0]->priority = 4.0;
+
+	imagesLoader->doLoad = true;
+	auto allLoaded = [&] {
+		return std::all_of(progressCallbacks.begin(), progressCallbacks.end(), [] (const ProgressCallbackPtr& callback) {
+			return callback->state == TileProgressCallback::State::Loaded;
+		});
+	};
+	while (!allLoaded())
+	{
+		loader.update();
+		using namespace std::chrono_literals;
+		std::this_thread::sleep_for(1ms);
+	}
+
+	std::vector<QuadTreeTileKey> expectedOrder = { keys[1], keys[0], keys[2] };
+	CHECK(imagesLoader->loadedKeys == expectedOrder);
+}
+
+TEST_CASE("Test tile canceled while queued is dropped without loading")
+{
+	auto imagesLoader = std::make_shared<DummyTileImagesLoader>();
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	ConcurrentAsyncTileLoader loader(imagesLoader, &scheduler);
+	loader.setMaxActiveLoads(1);
+
+	auto activeProgressCallback = std::make_shared<TileProgressCallback>();
+	activeProgressCallback->priority = 1.0;
+	loader.load(QuadTreeTileKey(0, 0, 0), std::make_shared<TileImagesPtr>(), activeProgressCallback);
+
+	auto queuedProgressCallback = std::make_shared<TileProgressCallback>();
+	loader.load(QuadTreeTileKey(0, 1, 0), std::make_shared<TileImagesPtr>(), queuedProgressCallback);
+
+	loader.update();
+	CHECK(loader.getStats().queuedLoads == 1);
+
+	queuedProgressCallback->requestCancel();
+	loader.update();
+
+	CHECK(queuedProgressCallback->state == TileProgressCallback::State::FailedOrCanceled);
+	CHECK(loader.getStats().queuedLoads == 0);
+	CHECK(loader.getStats().loadsCanceledBeforeStart == 1);
+
+	imagesLoader->doLoad = true;
+	loader.waitForLoads();
+	loader.update();
+
+	CHECK(activeProgressCallback->state == TileProgressCallback::State::Loaded);
+	REQUIRE(imagesLoader->loadedKeys.size() == 1);
+	CHECK(imagesLoader->loadedKeys[0] == QuadTreeTileKey(0, 0, 0));
+}
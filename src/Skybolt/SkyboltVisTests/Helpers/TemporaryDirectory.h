@@ -0,0 +1,19 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+//! @returns an empty directory at <temp>/SkyboltTests/<suiteName>/<name>, removing any contents left by a previous run
+inline std::filesystem::path createEmptyTemporaryDirectory(const std::string& suiteName, const std::string& name)
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "SkyboltTests" / suiteName / name;
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+	return path;
+}
@@ -0,0 +1,129 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include "Helpers/TemporaryDirectory.h"
+#include <SkyboltVis/Renderable/Model/ModelFactory.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osgDB/WriteFile>
+#include <px_sched/px_sched.h>
+#include <filesystem>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+namespace fs = std::filesystem;
+
+static std::string writeTestModel(const fs::path& directory)
+{
+	osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+	osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array({{0, 0, 0}, {1, 0, 0}, {0, 1, 0}});
+	geometry->setVertexArray(vertices);
+	geometry->setTexCoordArray(0, new osg::Vec2Array({{0, 0}, {1, 0}, {0, 1}}));
+	geometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, 3));
+
+	osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+	geode->addDrawable(geometry);
+
+	std::string filename = (directory / "model.osgt").string();
+	REQUIRE(osgDB::writeNodeFile(*geode, filename));
+	return filename;
+}
+
+static ModelFactoryConfig createTestConfig(px_sched::Scheduler* scheduler, const std::string& cacheDirectory)
+{
+	ModelFactoryConfig config;
+	config.defaultProgram = new osg::Program;
+	config.scheduler = scheduler;
+	config.cacheDirectory = cacheDirectory;
+	return config;
+}
+
+static std::size_t countFiles(const fs::path& directory)
+{
+	if (!fs::exists(directory))
+	{
+		return 0;
+	}
+	return std::distance(fs::directory_iterator(directory), fs::directory_iterator());
+}
+
+TEST_CASE("ModelFactory loads models asynchronously and shares loaded models")
+{
+	fs::path directory = createEmptyTemporaryDirectory("ModelFactory", "Async");
+	std::string filename = writeTestModel(directory);
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+	ModelFactory factory(createTestConfig(&scheduler, ""));
+
+	NodeFuture future = factory.createModelAsync(filename, {});
+	osg::ref_ptr<osg::Node> model = future.get();
+	REQUIRE(model);
+	CHECK(model->getStateSet()->getAttribute(osg::StateAttribute::PROGRAM));
+
+	CHECK(factory.createModel(filename, {}) == model);
+	CHECK(factory.createModel(filename, {ModelFactory::TextureRole::Albedo}) != model);
+}
+
+TEST_CASE("ModelFactory reports models which fail to load")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+	ModelFactory factory(createTestConfig(&scheduler, ""));
+
+	NodeFuture future = factory.createModelAsync("missingModel.osgt", {});
+	CHECK_THROWS_AS(future.get(), skybolt::Exception);
+	CHECK_THROWS_AS(factory.createModel("missingModel.osgt", {}), skybolt::Exception);
+}
+
+TEST_CASE("ModelFactory retries models which failed to load")
+{
+	fs::path directory = createEmptyTemporaryDirectory("ModelFactory", "Retry");
+	std::string filename = (directory / "model.osgt").string();
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+	ModelFactory factory(createTestConfig(&scheduler, ""));
+
+	CHECK_THROWS_AS(factory.createModelAsync(filename, {}).get(), skybolt::Exception);
+
+	// The failure is not cached, so the model loads once the file exists
+	REQUIRE(writeTestModel(directory) == filename);
+	CHECK(factory.createModelAsync(filename, {}).get());
+}
+
+TEST_CASE("ModelFactory reads prepared models from disk cache")
+{
+	fs::path directory = createEmptyTemporaryDirectory("ModelFactory", "DiskCache");
+	std::string filename = writeTestModel(directory);
+	fs::path cacheDirectory = directory / "Cache";
+
+	{
+		ModelFactory factory(createTestConfig(nullptr, cacheDirectory.string()));
+		REQUIRE(factory.createModel(filename, {}));
+	}
+	CHECK(countFiles(cacheDirectory / "Models") == 1);
+
+	// Overwrite the source model with zeros, keeping the size and modification time which the cache key depends on,
+	// so that loading only succeeds if the cached model is used
+	auto modifiedTime = fs::last_write_time(filename);
+	auto size = fs::file_size(filename);
+	fs::resize_file(filename, 0);
+	fs::resize_file(filename, size);
+	fs::last_write_time(filename, modifiedTime);
+
+	{
+		ModelFactory factory(createTestConfig(nullptr, cacheDirectory.string()));
+		osg::ref_ptr<osg::Node> model = factory.createModel(filename, {});
+		REQUIRE(model);
+		CHECK(model->getStateSet()->getAttribute(osg::StateAttribute::PROGRAM));
+	}
+	CHECK(countFiles(cacheDirectory / "Models") == 1);
+}
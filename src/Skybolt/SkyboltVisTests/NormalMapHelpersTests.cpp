@@ -10,18 +10,93 @@
 
 #include <osg/Image>
 #include <osg/Texture>
+#include <px_sched/px_sched.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
 
 using namespace skybolt;
 using namespace skybolt::vis;
 
-static osg::ref_ptr<osg::Image> create4x4TestHeightImage()
+static osg::ref_ptr<osg::Image> createTestHeightImage(int width, int height)
 {
 	osg::Image* image = new osg::Image();
-	image->allocateImage(4, 4, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
+	image->allocateImage(width, height, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
 	image->setInternalTextureFormat(GL_R16);
 	return image;
 }
 
+static osg::ref_ptr<osg::Image> create4x4TestHeightImage()
+{
+	return createTestHeightImage(4, 4);
+}
+
+static osg::ref_ptr<osg::Image> createRandomTestHeightImage(int width, int height)
+{
+	osg::ref_ptr<osg::Image> image = createTestHeightImage(width, height);
+	uint16_t* data = reinterpret_cast<uint16_t*>(image->data());
+
+	std::mt19937 generator(0);
+	std::uniform_int_distribution<int> distribution(0, 65535);
+	std::generate(data, data + width * height, [&] { return uint16_t(distribution(generator)); });
+	return image;
+}
+
+//! Straightforward per-pixel implementation used as a reference for the optimized implementation
+static osg::ref_ptr<osg::Image> createReferenceNormalMap(const osg::Image& heightmap, const HeightMapElevationRerange& rerange, const osg::Vec2f& texelWorldSize, int filterWidth)
+{
+	const int width = heightmap.s();
+	const int height = heightmap.t();
+
+	osg::Image* image = new osg::Image;
+	image->allocateImage(width, height, 1, GL_RGB, GL_UNSIGNED_BYTE);
+
+	unsigned char* p = image->data();
+	const uint16_t* src = reinterpret_cast<const uint16_t*>(heightmap.data());
+
+	int lowerOffset = -(filterWidth / 2);
+	int upperOffset = lowerOffset + filterWidth;
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			int x0 = std::clamp(x + lowerOffset, 0, width-1-filterWidth);
+			int y0 = std::clamp(y + lowerOffset, 0, height-1-filterWidth);
+			int x1 = std::clamp(x + upperOffset, filterWidth, width-1);
+			int y1 = std::clamp(y + upperOffset, filterWidth, height-1);
+
+			uint16_t h00 = src[x0 + width * y0];
+			uint16_t h10 = src[x1 + width * y0];
+			uint16_t h01 = src[x0 + width * y1];
+			uint16_t h11 = src[x1 + width * y1];
+
+			float dhx = rerange.x() * 0.5f * float((h10 + h11) - (h00 + h01));
+			float dhy = rerange.x() * 0.5f * float((h01 + h11) - (h00 + h10));
+
+			osg::Vec3f normal = osg::Vec3f(texelWorldSize.x() * filterWidth, 0, dhx) ^ osg::Vec3f(0, texelWorldSize.y() * filterWidth, dhy);
+			normal.normalize();
+
+			*p++ = std::clamp(int(normal.x() * 128.0f + 128.0f), 0, 255);
+			*p++ = std::clamp(int(normal.y() * 128.0f + 128.0f), 0, 255);
+			*p++ = std::clamp(int(normal.z() * 128.0f + 128.0f), 0, 255);
+		}
+	}
+	return image;
+}
+
+static int getMaxChannelDifference(const osg::Image& a, const osg::Image& b)
+{
+	REQUIRE(a.getTotalSizeInBytes() == b.getTotalSizeInBytes());
+	int maxDifference = 0;
+	for (unsigned int i = 0; i < a.getTotalSizeInBytes(); ++i)
+	{
+		maxDifference = std::max(maxDifference, std::abs(int(a.data()[i]) - int(b.data()[i])));
+	}
+	return maxDifference;
+}
+
 static osg::Vec3f readNormal(const osg::Image& image, int x, int y)
 {
 	osg::Vec4f c = image.getColor(x, y);
@@ -72,3 +147,79 @@ TEST_CASE("Test normal map created from height map")
 		CHECK(almostEqual(expectedNormal, actualNormal, 0.01f));
 	}
 }
+
+TEST_CASE("Normal map matches reference implementation")
+{
+	HeightMapElevationRerange rerange = {0.01f, -100};
+	osg::Vec2f texelWorldSize(3, 4);
+
+	for (int size : {8, 33, 64})
+	{
+		osg::ref_ptr<osg::Image> heightMap = createRandomTestHeightImage(size, size + 3);
+		for (int filterWidth : {1, 2, 5})
+		{
+			osg::ref_ptr<osg::Image> expected = createReferenceNormalMap(*heightMap, rerange, texelWorldSize, filterWidth);
+			osg::ref_ptr<osg::Image> actual = createNormalMapFromHeightMap(*heightMap, rerange, texelWorldSize, filterWidth);
+
+			// Allow for differences in float rounding
+			CHECK(getMaxChannelDifference(*expected, *actual) <= 1);
+		}
+	}
+}
+
+TEST_CASE("Normal map created in parallel matches normal map created serially")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	osg::ref_ptr<osg::Image> heightMap = createRandomTestHeightImage(256, 256);
+	HeightMapElevationRerange rerange = {0.01f, -100};
+	osg::Vec2f texelWorldSize(3, 4);
+
+	osg::ref_ptr<osg::Image> serial = createNormalMapFromHeightMap(*heightMap, rerange, texelWorldSize, 5);
+	osg::ref_ptr<osg::Image> parallel = createNormalMapFromHeightMap(*heightMap, rerange, texelWorldSize, 5, &scheduler);
+	CHECK(getMaxChannelDifference(*serial, *parallel) == 0);
+}
+
+TEST_CASE("Benchmark normal map creation", "[.benchmark]")
+{
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	HeightMapElevationRerange rerange = {0.01f, -100};
+	osg::Vec2f texelWorldSize(3, 4);
+	constexpr int filterWidth = 5;
+
+	osg::ref_ptr<osg::Image> heightMap256 = createRandomTestHeightImage(256, 256);
+	osg::ref_ptr<osg::Image> heightMap512 = createRandomTestHeightImage(512, 512);
+
+	BENCHMARK("Reference 256x256")
+	{
+		return createReferenceNormalMap(*heightMap256, rerange, texelWorldSize, filterWidth);
+	};
+
+	BENCHMARK("Serial 256x256")
+	{
+		return createNormalMapFromHeightMap(*heightMap256, rerange, texelWorldSize, filterWidth);
+	};
+
+	BENCHMARK("Parallel 256x256")
+	{
+		return createNormalMapFromHeightMap(*heightMap256, rerange, texelWorldSize, filterWidth, &scheduler);
+	};
+
+	BENCHMARK("Reference 512x512")
+	{
+		return createReferenceNormalMap(*heightMap512, rerange, texelWorldSize, filterWidth);
+	};
+
+	BENCHMARK("Serial 512x512")
+	{
+		return createNormalMapFromHeightMap(*heightMap512, rerange, texelWorldSize, filterWidth);
+	};
+
+	BENCHMARK("Parallel 512x512")
+	{
+		return createNormalMapFromHeightMap(*heightMap512, rerange, texelWorldSize, filterWidth, &scheduler);
+	};
+}
@@ -0,0 +1,295 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include "Helpers/TemporaryDirectory.h"
+#include <SkyboltVis/Renderable/Planet/Features/PackedFeatureTile.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace skybolt;
+using namespace skybolt::mapfeatures;
+
+namespace fs = std::filesystem;
+
+static sim::LatLonAlt createPoint(int i)
+{
+	return sim::LatLonAlt(0.8 + i * 1e-5, -2.1 - i * 1e-5, 10.0 + i);
+}
+
+static LatLonAltPoints createPoints(int first, int count)
+{
+	LatLonAltPoints points;
+	for (int i = 0; i < count; ++i)
+	{
+		points.push_back(createPoint(first + i));
+	}
+	return points;
+}
+
+static std::vector<FeaturePtr> createTestFeatures()
+{
+	std::vector<FeaturePtr> features;
+
+	auto road = std::make_shared<Road>();
+	road->points = createPoints(0, 3);
+	road->width = 7.5f;
+	road->laneCount = 2;
+	road->endControlPoints[1] = createPoint(100);
+	road->endLaneCounts[1] = 4;
+	features.push_back(road);
+
+	auto building = std::make_shared<Building>();
+	building->points = createPoints(10, 4);
+	building->height = 12.0f;
+	features.push_back(building);
+
+	auto water = std::make_shared<Water>();
+	water->points = createPoints(20, 5);
+	features.push_back(water);
+
+	auto airport = std::make_shared<Airport>();
+	Airport::Runway runway;
+	runway.name = "16L/34R";
+	runway.start = sim::LatLon(0.8, -2.1);
+	runway.end = sim::LatLon(0.81, -2.1);
+	runway.width = 45.0f;
+	airport->runways.push_back(runway);
+	airport->areaPolygons.push_back({sim::LatLon(0.8, -2.1), sim::LatLon(0.81, -2.1), sim::LatLon(0.81, -2.11)});
+	airport->areaPolygons.push_back({});
+	airport->altitude = 130.0;
+	features.push_back(airport);
+
+	return features;
+}
+
+static void checkFeaturesEqual(const std::vector<FeaturePtr>& expected, const std::vector<FeaturePtr>& actual)
+{
+	REQUIRE(actual.size() == expected.size());
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		REQUIRE(actual[i]->type() == expected[i]->type());
+		switch (expected[i]->type())
+		{
+		case FeatureRoad:
+		{
+			const Road& e = static_cast<const Road&>(*expected[i]);
+			const Road& a = static_cast<const Road&>(*actual[i]);
+			CHECK(a.points == e.points);
+			CHECK(a.width == e.width);
+			CHECK(a.laneCount == e.laneCount);
+			CHECK(a.endLaneCounts[0] == e.endLaneCounts[0]);
+			CHECK(a.endLaneCounts[1] == e.endLaneCounts[1]);
+			CHECK(a.endControlPoints[1] == e.endControlPoints[1]);
+			break;
+		}
+		case FeatureBuilding:
+		{
+			const Building& e = static_cast<const Building&>(*expected[i]);
+			const Building& a = static_cast<const Building&>(*actual[i]);
+			CHECK(a.points == e.points);
+			CHECK(a.height == e.height);
+			break;
+		}
+		case FeatureWater:
+			CHECK(static_cast<const Water&>(*actual[i]).points == static_cast<const Water&>(*expected[i]).points);
+			break;
+		case FeatureAirport:
+		{
+			const Airport& e = static_cast<const Airport&>(*expected[i]);
+			const Airport& a = static_cast<const Airport&>(*actual[i]);
+			REQUIRE(a.runways.size() == e.runways.size());
+			for (size_t j = 0; j < e.runways.size(); ++j)
+			{
+				CHECK(a.runways[j].name == e.runways[j].name);
+				CHECK(a.runways[j].start == e.runways[j].start);
+				CHECK(a.runways[j].end == e.runways[j].end);
+				CHECK(a.runways[j].width == e.runways[j].width);
+			}
+			CHECK(a.areaPolygons == e.areaPolygons);
+			CHECK(a.altitude == e.altitude);
+			break;
+		}
+		default:
+			FAIL("Unexpected feature type");
+		}
+	}
+}
+
+static void saveTestTile(const std::vector<FeaturePtr>& features, const fs::path& filename, FeatureTileFormat format)
+{
+	FeatureTile tile;
+	tile.features = features;
+	saveTile(tile, filename.string(), format);
+}
+
+TEST_CASE("Packed feature tile records are read in place")
+{
+	std::vector<FeaturePtr> features = createTestFeatures();
+	PackedFeatureTile tile(packFeatureTile(features));
+
+	CHECK(tile.getFeatureCount() == features.size());
+
+	REQUIRE(tile.getBuildings().size() == 1);
+	const PackedBuilding& building = tile.getBuildings()[0];
+	CHECK(building.height == 12.0f);
+	PackedArray<sim::LatLonAlt> points = tile.getLatLonAltPoints(building.points);
+	REQUIRE(points.size() == 4);
+	CHECK(points[3] == createPoint(13));
+
+	REQUIRE(tile.getAirports().size() == 1);
+	PackedArray<PackedRunway> runways = tile.getRunways(tile.getAirports()[0].runways);
+	REQUIRE(runways.size() == 1);
+	CHECK(tile.getString(runways[0].name) == "16L/34R");
+}
+
+TEST_CASE("Feature tile round trips through both formats")
+{
+	fs::path directory = createEmptyTemporaryDirectory("PackedFeatureTile", "RoundTrip");
+	std::vector<FeaturePtr> features = createTestFeatures();
+
+	for (FeatureTileFormat format : {FeatureTileFormat::Legacy, FeatureTileFormat::Packed})
+	{
+		fs::path filename = directory / "tile.ftr";
+		saveTestTile(features, filename, format);
+		CHECK(isPackedFeatureTileFile(filename.string()) == (format == FeatureTileFormat::Packed));
+
+		std::vector<FeaturePtr> loadedFeatures;
+		loadTile(filename.string(), loadedFeatures);
+		checkFeaturesEqual(features, loadedFeatures);
+
+		std::unique_ptr<PackedFeatureTile> tile = openFeatureTile(filename.string());
+		std::vector<FeaturePtr> unpackedFeatures;
+		unpackFeatureTile(*tile, unpackedFeatures);
+		checkFeaturesEqual(features, unpackedFeatures);
+	}
+}
+
+TEST_CASE("Convert legacy feature tiles to packed format")
+{
+	fs::path directory = createEmptyTemporaryDirectory("PackedFeatureTile", "Convert");
+	fs::create_directories(directory / "1" / "0");
+	std::vector<FeaturePtr> features = createTestFeatures();
+	saveTestTile(features, directory / "1" / "0" / "0.ftr", FeatureTileFormat::Legacy);
+	saveTestTile(features, directory / "1" / "0" / "1.ftr", FeatureTileFormat::Packed);
+
+	CHECK(convertTilesToPackedFormat(directory.string()) == 1);
+	CHECK(convertTilesToPackedFormat(directory.string()) == 0);
+
+	std::string filename = (directory / "1" / "0" / "0.ftr").string();
+	CHECK(isPackedFeatureTileFile(filename));
+	CHECK(!fs::exists(filename + ".tmp"));
+
+	std::vector<FeaturePtr> loadedFeatures;
+	unpackFeatureTile(PackedFeatureTile(filename), loadedFeatures);
+	checkFeaturesEqual(features, loadedFeatures);
+}
+
+TEST_CASE("Invalid packed feature tiles are rejected")
+{
+	std::vector<char> buffer = packFeatureTile(createTestFeatures());
+
+	SECTION("Truncated")
+	{
+		buffer.resize(buffer.size() / 2);
+		CHECK_THROWS_AS(PackedFeatureTile(buffer), skybolt::Exception);
+	}
+
+	SECTION("Wrong magic")
+	{
+		buffer[0] = 'X';
+		CHECK_THROWS_AS(PackedFeatureTile(buffer), skybolt::Exception);
+	}
+
+	SECTION("Range out of bounds")
+	{
+		PackedFeatureTile tile(buffer);
+		PackedRange range = tile.getBuildings()[0].points;
+		range.count = 1000;
+		CHECK_THROWS_AS(tile.getLatLonAltPoints(range), skybolt::Exception);
+	}
+}
+
+//! Creates a tile similar to a dense city tile
+static std::vector<FeaturePtr> createDenseTestFeatures()
+{
+	std::vector<FeaturePtr> features;
+	for (int i = 0; i < 20000; ++i)
+	{
+		auto building = std::make_shared<Building>();
+		building->points = createPoints(i, 6);
+		building->height = 10.0f;
+		features.push_back(building);
+	}
+	for (int i = 0; i < 4000; ++i)
+	{
+		auto road = std::make_shared<Road>();
+		road->points = createPoints(i, 12);
+		road->width = 7.0f;
+		road->laneCount = 2;
+		features.push_back(road);
+	}
+	return features;
+}
+
+static double sumPointAltitudes(const PackedFeatureTile& tile)
+{
+	double sum = 0;
+	for (const PackedBuilding& building : tile.getBuildings())
+	{
+		for (const sim::LatLonAlt& point : tile.getLatLonAltPoints(building.points))
+		{
+			sum += point.alt;
+		}
+	}
+	for (const PackedRoad& road : tile.getRoads())
+	{
+		for (const sim::LatLonAlt& point : tile.getLatLonAltPoints(road.points))
+		{
+			sum += point.alt;
+		}
+	}
+	return sum;
+}
+
+static double sumPointAltitudes(const std::vector<FeaturePtr>& features)
+{
+	double sum = 0;
+	for (const FeaturePtr& feature : features)
+	{
+		for (const sim::LatLonAlt& point : static_cast<const PolyFeature&>(*feature).points)
+		{
+			sum += point.alt;
+		}
+	}
+	return sum;
+}
+
+TEST_CASE("Benchmark feature tile loading", "[.benchmark]")
+{
+	fs::path directory = createEmptyTemporaryDirectory("PackedFeatureTile", "Benchmark");
+	std::vector<FeaturePtr> features = createDenseTestFeatures();
+	std::string legacyFilename = (directory / "legacy.ftr").string();
+	std::string packedFilename = (directory / "packed.ftr").string();
+	saveTestTile(features, legacyFilename, FeatureTileFormat::Legacy);
+	saveTestTile(features, packedFilename, FeatureTileFormat::Packed);
+
+	// Both benchmarks read every point, as VisObjectsLoadTask does
+	BENCHMARK("Load legacy tile")
+	{
+		std::vector<FeaturePtr> loadedFeatures;
+		loadTile(legacyFilename, loadedFeatures);
+		return sumPointAltitudes(loadedFeatures);
+	};
+
+	BENCHMARK("Load packed tile")
+	{
+		PackedFeatureTile tile(packedFilename);
+		return sumPointAltitudes(tile);
+	};
+}
@@ -10,13 +10,24 @@
 #include <px_sched/px_sched.h>
 
 #include <SkyboltCommon/MapUtility.h>
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/Motion.h>
+#include <SkyboltSim/Components/Node.h>
+#include <SkyboltSim/Components/PlanetComponent.h>
+#include <SkyboltSim/Spatial/Geocentric.h>
+#include <SkyboltSim/System/TerrainPrefetchSystem.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/TileSource.h>
 #include <SkyboltVis/ElevationProvider/HeightMapElevationProvider.h>
 #include <SkyboltVis/ElevationProvider/TilePlanetAltitudeProvider.h>
 #include <SkyboltCommon/Eventually.h>
 #include <SkyboltCommon/NumericComparison.h>
+#include <SkyboltCommon/Math/MathUtility.h>
 
+#include <atomic>
+#include <chrono>
 #include <optional>
+#include <thread>
 
 using namespace skybolt;
 using namespace skybolt::vis;
@@ -129,4 +140,230 @@ TEST_CASE("Test NonBlockingPlanetAltitudeProvider background loads tile")
 	CHECK(eventually([&]{
 		return provider.getAltitude(sim::LatLon(1.4, -3.0)) == NonBlockingTilePlanetAltitudeProvider::AltitudeResult::finalValue(altitude);
 	}));
-}
\ No newline at end of file
+}
+TEST_CASE("Test BlockingTilePlanetAltitudeProvider getAltitudes returns same results as getAltitude")
+{
+	auto source = std::make_shared<DummyTileSource>();
+	source->images[QuadTreeTileKey(1, 0, 0)] = createDummyImage();
+
+	BlockingTilePlanetAltitudeProvider provider(source, 1);
+
+	std::vector<sim::LatLon> positions = {sim::LatLon(1.4, -3.0), sim::LatLon(1.2, -2.5), sim::LatLon(-1.0, 1.0)};
+	std::vector<BlockingTilePlanetAltitudeProvider::AltitudeResult> results(positions.size());
+	provider.getAltitudes(positions.data(), results.data(), positions.size());
+
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		CHECK(results[i] == provider.getAltitude(positions[i]));
+	}
+}
+
+TEST_CASE("Test BlockingTilePlanetAltitudeProvider supports concurrent queries while tiles are added and evicted")
+{
+	constexpr int level = 6;
+	constexpr int tileCountX = 1 << (level + 1);
+	constexpr int tileCountY = 1 << level;
+
+	// Create more tiles than the provider's tile index can hold, so that tiles are evicted during the test
+	auto source = std::make_shared<DummyTileSource>();
+	osg::ref_ptr<osg::Image> image = createDummyImage();
+	for (int x = 0; x < tileCountX; ++x)
+	{
+		for (int y = 0; y < tileCountY; ++y)
+		{
+			source->images[QuadTreeTileKey(level, x, y)] = image;
+		}
+	}
+
+	BlockingTilePlanetAltitudeProvider provider(source, level);
+
+	std::atomic<int> failureCount = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < 3000; ++i)
+			{
+				int tile = (i * 7 + t * 1000) % (tileCountX * tileCountY);
+				double lon = -skybolt::math::piD() + (tile % tileCountX + 0.5) * skybolt::math::twoPiD() / tileCountX;
+				double lat = -skybolt::math::halfPiD() + (tile / tileCountX + 0.5) * skybolt::math::piD() / tileCountY;
+				if (!almostEqual(provider.getAltitude(sim::LatLon(lat, lon)).altitude, altitude, 1e-3))
+				{
+					++failureCount;
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(failureCount == 0);
+}
+
+TEST_CASE("Test NonBlockingPlanetAltitudeProvider prefetches highest LOD tiles along track")
+{
+	constexpr int level = 3;
+	auto source = std::make_shared<DummyTileSource>();
+	osg::ref_ptr<osg::Image> image = createDummyImage();
+	for (int x = 0; x < (2 << level); ++x)
+	{
+		for (int y = 0; y < (1 << level); ++y)
+		{
+			source->images[QuadTreeTileKey(level, x, y)] = image;
+		}
+	}
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	NonBlockingTilePlanetAltitudeProvider provider(&scheduler, source, level, /* maxConcurrentLoads */ 16);
+
+	// Track crosses several tiles
+	sim::LatLon start(0.1, 0.1);
+	sim::LatLon end(0.1, 1.5);
+	provider.prefetchAltitudes(start, end);
+
+	CHECK(eventually([&] {
+		return provider.getLoadingTileCount() == 0;
+	}));
+
+	{
+		std::scoped_lock<std::mutex> lock(source->requestsMutex);
+		CHECK(source->requests.size() > 1);
+		for (const QuadTreeTileKey& key : source->requests)
+		{
+			CHECK(key.level == level);
+		}
+	}
+
+	// Altitudes along the track are final without needing to wait for further loads
+	for (double lon = start.lon; lon <= end.lon; lon += 0.1)
+	{
+		CHECK(provider.getAltitude(sim::LatLon(start.lat, lon)) == NonBlockingTilePlanetAltitudeProvider::AltitudeResult::finalValue(altitude));
+	}
+}
+
+TEST_CASE("Test TerrainPrefetchSystem loads tiles ahead of a moving body before the body reaches them")
+{
+	constexpr int level = 3;
+	auto source = std::make_shared<DummyTileSource>();
+	osg::ref_ptr<osg::Image> image = createDummyImage();
+	for (int x = 0; x < (2 << level); ++x)
+	{
+		for (int y = 0; y < (1 << level); ++y)
+		{
+			source->images[QuadTreeTileKey(level, x, y)] = image;
+		}
+	}
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	auto provider = std::make_shared<NonBlockingTilePlanetAltitudeProvider>(&scheduler, source, level, /* maxConcurrentLoads */ 16);
+
+	constexpr double planetRadius = 1000;
+	sim::World world;
+	auto planet = std::make_shared<sim::Entity>(sim::EntityId({1, 1}));
+	planet->addComponent(std::make_shared<sim::Node>());
+	auto planetComponent = std::make_shared<sim::PlanetComponent>(planetRadius);
+	planetComponent->altitudeProvider = provider;
+	planet->addComponent(planetComponent);
+	world.addEntity(planet);
+
+	// Body moves east and will reach a tile several tiles away within the lookahead time
+	constexpr double lookaheadSeconds = 10;
+	sim::LatLon bodyLatLon(0.1, 0.1);
+	sim::LatLon aheadLatLon(0.1, 0.9);
+	sim::Vector3 bodyPosition = sim::llaToGeocentric(sim::toLatLonAlt(bodyLatLon, 0), planetRadius);
+	sim::Vector3 aheadPosition = sim::llaToGeocentric(sim::toLatLonAlt(aheadLatLon, 0), planetRadius);
+
+	auto body = std::make_shared<sim::Entity>(sim::EntityId({1, 2}));
+	body->addComponent(std::make_shared<sim::Node>(bodyPosition));
+	auto motion = std::make_shared<sim::Motion>();
+	motion->linearVelocity = (aheadPosition - bodyPosition) / lookaheadSeconds;
+	body->addComponent(motion);
+	world.addEntity(body);
+
+	sim::TerrainPrefetchSystem system(&world, lookaheadSeconds);
+	system.prefetch();
+
+	CHECK(eventually([&] {
+		return provider->getLoadingTileCount() == 0;
+	}));
+
+	// The first query at the tile ahead of the body returns a final value without needing to wait for a load
+	CHECK(provider->getAltitude(aheadLatLon) == NonBlockingTilePlanetAltitudeProvider::AltitudeResult::finalValue(altitude));
+
+	// A stationary body does not trigger any prefetching
+	{
+		std::scoped_lock<std::mutex> lock(source->requestsMutex);
+		source->requests.clear();
+	}
+	motion->linearVelocity = sim::Vector3(0, 0, 0);
+	system.prefetch();
+	CHECK(provider->getLoadingTileCount() == 0);
+	{
+		std::scoped_lock<std::mutex> lock(source->requestsMutex);
+		CHECK(source->requests.empty());
+	}
+}
+
+//! Counts createImage() calls in progress, which take long enough for requests from other threads to overlap
+class SlowTileSource : public DummyTileSource
+{
+public:
+	osg::ref_ptr<osg::Image> createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override
+	{
+		++activeRequestCount;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		osg::ref_ptr<osg::Image> image = DummyTileSource::createImage(key, cancelSupplier);
+		--activeRequestCount;
+		return image;
+	}
+
+	mutable std::atomic<int> activeRequestCount = 0;
+};
+
+TEST_CASE("Test NonBlockingPlanetAltitudeProvider waits for loads requested concurrently from multiple threads")
+{
+	constexpr int level = 4;
+	auto source = std::make_shared<SlowTileSource>();
+	osg::ref_ptr<osg::Image> image = createDummyImage();
+	for (int x = 0; x < (2 << level); ++x)
+	{
+		for (int y = 0; y < (1 << level); ++y)
+		{
+			source->images[QuadTreeTileKey(level, x, y)] = image;
+		}
+	}
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	{
+		NonBlockingTilePlanetAltitudeProvider provider(&scheduler, source, level, /* maxConcurrentLoads */ 64);
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&, t] {
+				for (int i = 0; i < 200; ++i)
+				{
+					double lon = -3.0 + 0.03 * i;
+					double lat = -1.5 + 0.7 * t;
+					provider.getAltitude(sim::LatLon(lat, lon));
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// The provider's destructor must wait for every load, including those requested concurrently
+	CHECK(source->activeRequestCount == 0);
+}
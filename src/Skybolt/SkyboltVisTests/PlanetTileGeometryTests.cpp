@@ -0,0 +1,78 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltVis/OsgGeocentric.h>
+#include <SkyboltVis/Renderable/Planet/PlanetTileGeometry.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+#include <SkyboltCommon/Math/QuadTree.h>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+constexpr double planetRadius = 6371000;
+
+static Box2d getLatLonBounds(const QuadTreeTileKey& key)
+{
+	auto bounds = getKeyLonLatBounds<osg::Vec2d>(key);
+	return Box2d(math::vec2SwapComponents(bounds.minimum), math::vec2SwapComponents(bounds.maximum));
+}
+
+static osg::ref_ptr<osg::Geometry> createTestGeometry(const QuadTreeTileKey& key, const HeightMapElevationBounds& elevationBounds, PlanetTileVertices& verticesOut)
+{
+	Box2d latLonBounds = getLatLonBounds(key);
+	osg::Vec3d tileCenter = llaToGeocentric(latLonBounds.center(), 0, planetRadius);
+	verticesOut = *createPlanetTileVertices(tileCenter, latLonBounds, planetRadius, calcPlanetTileSkirtLength(latLonBounds, planetRadius), elevationBounds);
+	return createPlanetTileGeometry(verticesOut, Triangles);
+}
+
+TEST_CASE("Planet tile vertices lie on planet surface at their texture coordinates")
+{
+	// Tiles in the same latitude band share a vertex template, so test more than one
+	for (const QuadTreeTileKey& key : {QuadTreeTileKey(5, 3, 9), QuadTreeTileKey(5, 40, 9)})
+	{
+		Box2d latLonBounds = getLatLonBounds(key);
+		osg::Vec3d tileCenter = llaToGeocentric(latLonBounds.center(), 0, planetRadius);
+
+		PlanetTileVertices vertices;
+		osg::ref_ptr<osg::Geometry> geometry = createTestGeometry(key, {0, 0}, vertices);
+
+		auto uvs = static_cast<const osg::Vec2Array*>(geometry->getTexCoordArray(0));
+		REQUIRE(uvs->size() == vertices.positions->size());
+
+		// Center vertex is not a skirt vertex
+		size_t i = vertices.positions->size() / 2;
+		osg::Vec2d latLon = latLonBounds.getPointFromNormalizedCoord(math::vec2SwapComponents(osg::Vec2d((*uvs)[i])));
+		osg::Vec3d expectedPosition = llaToGeocentric(latLon, 0, planetRadius) - tileCenter;
+		CHECK((osg::Vec3d((*vertices.positions)[i]) - expectedPosition).length() < 0.1);
+	}
+}
+
+TEST_CASE("Planet tiles share index and texture coordinate buffers")
+{
+	PlanetTileVertices vertices1, vertices2;
+	osg::ref_ptr<osg::Geometry> geometry1 = createTestGeometry(QuadTreeTileKey(3, 1, 2), {0, 0}, vertices1);
+	osg::ref_ptr<osg::Geometry> geometry2 = createTestGeometry(QuadTreeTileKey(3, 5, 6), {0, 0}, vertices2);
+
+	CHECK(geometry1->getPrimitiveSet(0) == geometry2->getPrimitiveSet(0));
+	CHECK(geometry1->getTexCoordArray(0) == geometry2->getTexCoordArray(0));
+	CHECK(geometry1->getVertexArray() != geometry2->getVertexArray());
+}
+
+TEST_CASE("Planet tile bounds account for elevation bounds")
+{
+	QuadTreeTileKey key(8, 10, 60);
+	Box2d latLonBounds = getLatLonBounds(key);
+	osg::Vec3d tileCenter = llaToGeocentric(latLonBounds.center(), 0, planetRadius);
+
+	PlanetTileVertices mountainVertices;
+	createTestGeometry(key, {100, 3000}, mountainVertices);
+	CHECK(mountainVertices.bounds.contains(llaToGeocentric(latLonBounds.center(), 2999, planetRadius) - tileCenter));
+
+	PlanetTileVertices defaultVertices;
+	createTestGeometry(key, getDefaultPlanetTileElevationBounds(), defaultVertices);
+	CHECK(mountainVertices.bounds.radius() < defaultVertices.bounds.radius());
+}
@@ -229,4 +229,182 @@ TEST_CASE("Find tiles added and removed from tree")
 		CHECK(addedTiles.empty());
 		CHECK(removedTiles == std::set<QuadTreeTileKey>({ QuadTreeTileKey(0, 0, 0) }));
 	}
-}
\ No newline at end of file
+}
+
+static std::set<QuadTreeTileKey> getKeys(const TileKeyImagesMap& tiles)
+{
+	std::set<QuadTreeTileKey> result;
+	for (const auto& [key, images] : tiles)
+	{
+		result.insert(key);
+	}
+	return result;
+}
+
+static void applyChanges(const LeafTileChanges& changes, TileKeyImagesMap& tiles)
+{
+	if (changes.reset)
+	{
+		tiles.clear();
+	}
+	for (const QuadTreeTileKey& key : changes.removedTiles)
+	{
+		REQUIRE(tiles.erase(key) == 1);
+	}
+	for (const auto& [key, images] : changes.addedTiles)
+	{
+		REQUIRE(tiles.find(key) == tiles.end());
+		tiles[key] = images;
+	}
+}
+
+static void updateAndLoadAll(QuadTreeTileLoader& loader, DummyAsyncTileLoader& asyncTileLoader)
+{
+	// Loads are throttled, so update until no more tiles are requested
+	do
+	{
+		asyncTileLoader.requests.clear();
+		loader.update();
+		loadAllTiles(asyncTileLoader.requests);
+	} while (!asyncTileLoader.requests.empty() || loader.isLoading());
+	loader.update();
+}
+
+TEST_CASE("QuadTreeTileLoader publishes changes to leaf tiles")
+{
+	auto asyncTileLoader = std::make_shared<DummyAsyncTileLoader>();
+	auto predicate = std::make_shared<DummyQuadTreeSubdivisionPredicate>();
+	QuadTreeTileLoader loader(asyncTileLoader, predicate);
+
+	std::uint64_t version = 0;
+	TileKeyImagesMap consumerTiles;
+	LeafTileChanges changes;
+
+	auto checkConsumerMatchesTree = [&] {
+		TileKeyImagesMap expectedTiles;
+		findLeafTiles(*loader.getLoadedTree(), expectedTiles);
+		CHECK(consumerTiles == expectedTiles);
+		CHECK(loader.getLeafTiles() == expectedTiles);
+		CHECK(version == loader.getLeafTileChangeVersion());
+	};
+
+	// Load roots
+	updateAndLoadAll(loader, *asyncTileLoader);
+	loader.getLeafTileChanges(version, changes);
+	CHECK(changes.addedTiles.size() == 2);
+	CHECK(changes.removedTiles.empty());
+	applyChanges(changes, consumerTiles);
+	checkConsumerMatchesTree();
+
+	// No changes if tree is unchanged
+	loader.update();
+	loader.getLeafTileChanges(version, changes);
+	CHECK(changes.addedTiles.empty());
+	CHECK(changes.removedTiles.empty());
+
+	// Subdivide
+	predicate->maxSubdivisionLevel = 2;
+	updateAndLoadAll(loader, *asyncTileLoader);
+	loader.getLeafTileChanges(version, changes);
+	CHECK(changes.addedTiles.size() == 32);
+	CHECK(changes.removedTiles == std::set<QuadTreeTileKey>({QuadTreeTileKey(0, 0, 0), QuadTreeTileKey(0, 1, 0)}));
+	applyChanges(changes, consumerTiles);
+	checkConsumerMatchesTree();
+
+	// Merge
+	predicate->maxSubdivisionLevel = 1;
+	updateAndLoadAll(loader, *asyncTileLoader);
+	loader.getLeafTileChanges(version, changes);
+	CHECK(changes.addedTiles.size() == 8);
+	CHECK(changes.removedTiles.size() == 32);
+	applyChanges(changes, consumerTiles);
+	checkConsumerMatchesTree();
+}
+
+TEST_CASE("QuadTreeTileLoader leaf tile changes are merged for consumers which skip updates")
+{
+	auto asyncTileLoader = std::make_shared<DummyAsyncTileLoader>();
+	auto predicate = std::make_shared<DummyQuadTreeSubdivisionPredicate>();
+	QuadTreeTileLoader loader(asyncTileLoader, predicate);
+
+	updateAndLoadAll(loader, *asyncTileLoader);
+
+	std::uint64_t version = 0;
+	TileKeyImagesMap consumerTiles;
+	LeafTileChanges changes;
+	loader.getLeafTileChanges(version, changes);
+	applyChanges(changes, consumerTiles);
+
+	// Subdivide and merge without consuming changes in between
+	predicate->maxSubdivisionLevel = 1;
+	updateAndLoadAll(loader, *asyncTileLoader);
+	predicate->maxSubdivisionLevel = 0;
+	updateAndLoadAll(loader, *asyncTileLoader);
+
+	loader.getLeafTileChanges(version, changes);
+	CHECK(!changes.reset);
+	CHECK(getKeys(changes.addedTiles) == changes.removedTiles); // roots were removed by the subdivision and re-added by the merge
+	CHECK(changes.addedTiles.size() == 2);
+	applyChanges(changes, consumerTiles);
+	CHECK(consumerTiles == loader.getLeafTiles());
+}
+
+TEST_CASE("Find tile in loaded tree")
+{
+	auto tree = createTree();
+	tree->rightTree.subdivide(tree->rightTree.getRoot());
+	tree->rightTree.subdivide(*tree->rightTree.getRoot().children[2]);
+
+	const QuadTreeTileLoader::LoadedTile* tile = findTile(*tree, QuadTreeTileKey(2, 5, 3));
+	REQUIRE(tile);
+	CHECK(tile->key == QuadTreeTileKey(2, 5, 3));
+
+	CHECK(findTile(*tree, QuadTreeTileKey(0, 0, 0)) == &tree->leftTree.getRoot());
+	CHECK(!findTile(*tree, QuadTreeTileKey(1, 0, 0)));
+	CHECK(!findTile(*tree, QuadTreeTileKey(3, 10, 6)));
+}
+
+//! Subdivides all tiles to level 5, and half of the level 5 tiles to level 6, giving 5120 leaf tiles
+class BenchmarkQuadTreeSubdivisionPredicate : public QuadTreeSubdivisionPredicate
+{
+public:
+	~BenchmarkQuadTreeSubdivisionPredicate() override = default;
+
+	bool operator()(const Box2d& bounds, const QuadTreeTileKey& key, const TileImages& images) override
+	{
+		return key.level < 5 || (key.level == 5 && key.x < 32);
+	}
+};
+
+TEST_CASE("Benchmark finding changes to leaf tiles with 5k leaf tiles", "[.benchmark]")
+{
+	auto asyncTileLoader = std::make_shared<DummyAsyncTileLoader>();
+	QuadTreeTileLoader loader(asyncTileLoader, std::make_shared<BenchmarkQuadTreeSubdivisionPredicate>());
+	updateAndLoadAll(loader, *asyncTileLoader);
+	REQUIRE(loader.getLeafTiles().size() == 5120);
+
+	TileKeyImagesMap previousTiles;
+	findLeafTiles(*loader.getLoadedTree(), previousTiles);
+
+	std::uint64_t version = 0;
+	LeafTileChanges changes;
+	loader.getLeafTileChanges(version, changes);
+
+	// Measure the steady state case where the tree is unchanged, which is the common case each frame
+	BENCHMARK("Full leaf set rebuild and diff")
+	{
+		TileKeyImagesMap currentTiles;
+		findLeafTiles(*loader.getLoadedTree(), currentTiles);
+
+		TileKeyImagesMap addedTiles;
+		std::set<QuadTreeTileKey> removedTiles;
+		findAddedAndRemovedTiles(previousTiles, currentTiles, addedTiles, removedTiles);
+		return addedTiles.size() + removedTiles.size();
+	};
+
+	BENCHMARK("Leaf tile change log")
+	{
+		loader.getLeafTileChanges(version, changes);
+		return changes.addedTiles.size() + changes.removedTiles.size();
+	};
+}
@@ -0,0 +1,368 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include "../Helpers/TemporaryDirectory.h"
+#include <SkyboltVis/OsgImageHelpers.h>
+#include <SkyboltVis/Renderable/Planet/Tile/HeightMapElevationBounds.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/CachedTileSource.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/PackedTileCache.h>
+
+#include <osg/Image>
+#include <osgDB/WriteFile>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+namespace fs = std::filesystem;
+
+static std::vector<std::uint8_t> createTestData(const QuadTreeTileKey& key, std::size_t size)
+{
+	std::vector<std::uint8_t> data(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		data[i] = std::uint8_t(key.level + key.x * 3 + key.y * 7 + i);
+	}
+	return data;
+}
+
+static void writeTestData(PackedTileCache& cache, const QuadTreeTileKey& key, std::size_t size = 100)
+{
+	std::vector<std::uint8_t> data = createTestData(key, size);
+	cache.write(key, data.data(), data.size());
+}
+
+static bool hasTestData(const PackedTileCache& cache, const QuadTreeTileKey& key, std::size_t size = 100)
+{
+	std::vector<std::uint8_t> data;
+	return cache.read(key, data) && data == createTestData(key, size);
+}
+
+TEST_CASE("Read tile from PackedTileCache")
+{
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "ReadWrite").string();
+	PackedTileCache cache(config);
+
+	QuadTreeTileKey key(3, 2, 1);
+	CHECK(!cache.contains(key));
+
+	writeTestData(cache, key);
+	CHECK(cache.contains(key));
+	CHECK(hasTestData(cache, key));
+	CHECK(!cache.contains(QuadTreeTileKey(3, 2, 2)));
+}
+
+TEST_CASE("PackedTileCache persists tiles after reopening")
+{
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "Persist").string();
+	config.maxPackFileSizeBytes = 500;
+
+	std::vector<QuadTreeTileKey> keys;
+	for (int i = 0; i < 20; ++i)
+	{
+		keys.emplace_back(5, i, 2 * i);
+	}
+
+	{
+		PackedTileCache cache(config);
+		for (const QuadTreeTileKey& key : keys)
+		{
+			writeTestData(cache, key);
+		}
+		CHECK(cache.getPackFileCount() > 1);
+	}
+
+	SECTION("Tiles are read from index")
+	{
+		PackedTileCache cache(config);
+		for (const QuadTreeTileKey& key : keys)
+		{
+			CHECK(hasTestData(cache, key));
+		}
+	}
+
+	SECTION("Tiles are recovered from pack files if index is missing")
+	{
+		fs::remove(fs::path(config.directory) / "tiles.index");
+
+		PackedTileCache cache(config);
+		for (const QuadTreeTileKey& key : keys)
+		{
+			CHECK(hasTestData(cache, key));
+		}
+	}
+}
+
+TEST_CASE("PackedTileCache discards partially written tile")
+{
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "PartialWrite").string();
+
+	QuadTreeTileKey key(1, 1, 1);
+	{
+		PackedTileCache cache(config);
+		writeTestData(cache, key);
+	}
+
+	// Simulate a crash while appending a tile
+	fs::path packFilename;
+	for (const fs::directory_entry& entry : fs::directory_iterator(config.directory))
+	{
+		if (entry.path().extension() == ".pack")
+		{
+			packFilename = entry.path();
+		}
+	}
+	REQUIRE(!packFilename.empty());
+	std::uintmax_t validSize = fs::file_size(packFilename);
+	{
+		std::ofstream f(packFilename, std::ios::binary | std::ios::app);
+		f << "partial";
+	}
+
+	PackedTileCache cache(config);
+	CHECK(hasTestData(cache, key));
+	CHECK(fs::file_size(packFilename) == validSize);
+
+	QuadTreeTileKey newKey(1, 0, 1);
+	writeTestData(cache, newKey);
+	CHECK(hasTestData(cache, newKey));
+}
+
+TEST_CASE("PackedTileCache evicts least recently used packs when over size limit")
+{
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "Evict").string();
+	config.maxPackFileSizeBytes = 250;
+	config.maxSizeBytes = 1000;
+
+	PackedTileCache cache(config);
+	for (int i = 0; i < 50; ++i)
+	{
+		writeTestData(cache, QuadTreeTileKey(10, i, 0));
+	}
+
+	CHECK(cache.getSizeBytes() <= config.maxSizeBytes);
+	CHECK(!cache.contains(QuadTreeTileKey(10, 0, 0)));
+	CHECK(hasTestData(cache, QuadTreeTileKey(10, 49, 0)));
+}
+
+TEST_CASE("PackedTileCache supports concurrent reads")
+{
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "Concurrent").string();
+	config.maxPackFileSizeBytes = 4096;
+
+	PackedTileCache cache(config);
+	for (int i = 0; i < 100; ++i)
+	{
+		writeTestData(cache, QuadTreeTileKey(8, i, i));
+	}
+
+	std::atomic<int> failureCount = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&] {
+			for (int i = 0; i < 100; ++i)
+			{
+				if (!hasTestData(cache, QuadTreeTileKey(8, i, i)))
+				{
+					++failureCount;
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(failureCount == 0);
+}
+
+TEST_CASE("PackedTileCache supports reads concurrent with writes")
+{
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "ConcurrentReadWrite").string();
+	config.maxPackFileSizeBytes = 4096;
+
+	PackedTileCache cache(config);
+
+	// Readers repeatedly read the most recently written tiles, from both the active pack and sealed packs
+	constexpr int tileCount = 500;
+	std::atomic<int> lastWrittenIndex = -1;
+	std::atomic<bool> writing = true;
+	std::atomic<int> failureCount = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&] {
+			while (writing)
+			{
+				int last = lastWrittenIndex;
+				for (int i = std::max(0, last - 50); i <= last; ++i)
+				{
+					if (!hasTestData(cache, QuadTreeTileKey(8, i, 0)))
+					{
+						++failureCount;
+					}
+				}
+			}
+		});
+	}
+
+	for (int i = 0; i < tileCount; ++i)
+	{
+		writeTestData(cache, QuadTreeTileKey(8, i, 0));
+		lastWrittenIndex = i;
+	}
+	writing = false;
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(failureCount == 0);
+	CHECK(cache.getPackFileCount() > 1);
+}
+
+static osg::ref_ptr<osg::Image> createTestHeightMapImage(int size)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image();
+	image->allocateImage(size, size, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
+	auto data = reinterpret_cast<std::uint16_t*>(image->data());
+	for (int i = 0; i < size * size; ++i)
+	{
+		data[i] = std::uint16_t(i);
+	}
+	return image;
+}
+
+TEST_CASE("Packed tile image preserves pixels, format and user data")
+{
+	osg::ref_ptr<osg::Image> image = createTestHeightMapImage(4);
+	image->setInternalTextureFormat(GL_R16);
+	setHeightMapElevationBounds(*image, HeightMapElevationBounds(-10, 20));
+
+	std::vector<std::uint8_t> data;
+	writePackedTileImage(*image, data);
+	osg::ref_ptr<osg::Image> result = readPackedTileImage(data.data(), data.size());
+
+	REQUIRE(result);
+	CHECK(result->s() == image->s());
+	CHECK(result->t() == image->t());
+	CHECK(result->getPixelFormat() == image->getPixelFormat());
+	CHECK(result->getDataType() == image->getDataType());
+	CHECK(result->getInternalTextureFormat() == image->getInternalTextureFormat());
+	CHECK(std::memcmp(result->data(), image->data(), image->getTotalSizeInBytes()) == 0);
+	CHECK(getHeightMapElevationBounds(*result) == HeightMapElevationBounds(-10, 20));
+}
+
+TEST_CASE("Migrate legacy tile cache directory to PackedTileCache")
+{
+	fs::path directory = createEmptyTemporaryDirectory("PackedTileCache", "Migrate");
+	fs::create_directories(directory / "2" / "1");
+	osgDB::writeImageFile(*createTestHeightMapImage(4), (directory / "2" / "1" / "3.png").string());
+
+	PackedTileCacheConfig config;
+	config.directory = directory.string();
+	PackedTileCache cache(config);
+
+	CHECK(migrateTileCacheDirectory(directory.string(), cache, /* removeMigratedFiles */ true) == 1);
+	CHECK(!fs::exists(directory / "2"));
+
+	std::vector<std::uint8_t> data;
+	REQUIRE(cache.read(QuadTreeTileKey(2, 1, 3), data));
+	osg::ref_ptr<osg::Image> image = readPackedTileImage(data.data(), data.size());
+	REQUIRE(image);
+	CHECK(std::memcmp(image->data(), createTestHeightMapImage(4)->data(), image->getTotalSizeInBytes()) == 0);
+}
+
+//! Reads tiles from the legacy one-file-per-tile cache layout
+static osg::ref_ptr<osg::Image> readLegacyTile(const fs::path& directory, const QuadTreeTileKey& key)
+{
+	fs::path filename = directory / std::to_string(key.level) / std::to_string(key.x) / (std::to_string(key.y) + ".png");
+	if (fs::exists(filename))
+	{
+		return readImageWithoutWarnings(filename.string());
+	}
+	return nullptr;
+}
+
+TEST_CASE("Benchmark PackedTileCache read throughput against one file per tile", "[.benchmark]")
+{
+	constexpr int tileCount = 1000;
+	std::vector<QuadTreeTileKey> keys;
+	for (int i = 0; i < tileCount; ++i)
+	{
+		keys.emplace_back(12, i % 40, i / 40);
+	}
+
+	osg::ref_ptr<osg::Image> image = createTestHeightMapImage(256);
+
+	fs::path legacyDirectory = createEmptyTemporaryDirectory("PackedTileCache", "BenchmarkLegacy");
+	for (const QuadTreeTileKey& key : keys)
+	{
+		fs::path directory = legacyDirectory / std::to_string(key.level) / std::to_string(key.x);
+		fs::create_directories(directory);
+		osgDB::writeImageFile(*image, (directory / (std::to_string(key.y) + ".png")).string());
+	}
+
+	PackedTileCacheConfig config;
+	config.directory = createEmptyTemporaryDirectory("PackedTileCache", "BenchmarkPacked").string();
+	{
+		PackedTileCache cache(config);
+		std::vector<std::uint8_t> data;
+		writePackedTileImage(*image, data);
+		for (const QuadTreeTileKey& key : keys)
+		{
+			cache.write(key, data.data(), data.size());
+		}
+	}
+
+	BENCHMARK("One file per tile")
+	{
+		int loadedCount = 0;
+		for (const QuadTreeTileKey& key : keys)
+		{
+			loadedCount += readLegacyTile(legacyDirectory, key) ? 1 : 0;
+		}
+		return loadedCount;
+	};
+
+	BENCHMARK("Packed cold (including open)")
+	{
+		PackedTileCache cache(config);
+		std::vector<std::uint8_t> data;
+		int loadedCount = 0;
+		for (const QuadTreeTileKey& key : keys)
+		{
+			loadedCount += (cache.read(key, data) && readPackedTileImage(data.data(), data.size())) ? 1 : 0;
+		}
+		return loadedCount;
+	};
+
+	PackedTileCache cache(config);
+	BENCHMARK("Packed warm")
+	{
+		std::vector<std::uint8_t> data;
+		int loadedCount = 0;
+		for (const QuadTreeTileKey& key : keys)
+		{
+			loadedCount += (cache.read(key, data) && readPackedTileImage(data.data(), data.size())) ? 1 : 0;
+		}
+		return loadedCount;
+	};
+}
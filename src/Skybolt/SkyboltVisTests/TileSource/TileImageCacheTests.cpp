@@ -0,0 +1,186 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/MemoryCachedTileSource.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/TileImageCache.h>
+
+#include <osg/Image>
+#include <atomic>
+#include <thread>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+static osg::ref_ptr<osg::Image> createTestImage(int size = 16)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image();
+	image->allocateImage(size, size, 1, GL_LUMINANCE, GL_UNSIGNED_BYTE);
+	return image;
+}
+
+static std::size_t getTestImageSizeBytes(int size = 16)
+{
+	return sizeof(osg::Image) + size * size;
+}
+
+TEST_CASE("TileImageCache returns cached images by source and key")
+{
+	TileImageCache cache(1024 * 1024);
+
+	TileImageCacheKey key{"a", QuadTreeTileKey(1, 0, 1)};
+	CHECK(!cache.get(key));
+
+	osg::ref_ptr<osg::Image> image = createTestImage();
+	cache.put(key, image);
+	CHECK(cache.get(key) == image);
+	CHECK(!cache.get(TileImageCacheKey{"b", key.tileKey}));
+	CHECK(!cache.get(TileImageCacheKey{"a", QuadTreeTileKey(1, 1, 1)}));
+
+	TileImageCacheStats stats = cache.getStats();
+	CHECK(stats.hits == 1);
+	CHECK(stats.misses == 3);
+	CHECK(stats.imageCount == 1);
+	CHECK(stats.sizeBytes == getTestImageSizeBytes());
+}
+
+TEST_CASE("TileImageCache evicts least recently used images when over size budget")
+{
+	// Use one shard so that eviction order is deterministic
+	TileImageCache cache(getTestImageSizeBytes() * 3, /* shardCount */ 1);
+
+	auto key = [] (int x) { return TileImageCacheKey{"a", QuadTreeTileKey(5, x, 0)}; };
+	cache.put(key(0), createTestImage());
+	cache.put(key(1), createTestImage());
+	cache.put(key(2), createTestImage());
+
+	// Use image 0 so that image 1 becomes the least recently used
+	CHECK(cache.get(key(0)));
+
+	cache.put(key(3), createTestImage());
+	CHECK(cache.get(key(0)));
+	CHECK(!cache.get(key(1)));
+	CHECK(cache.get(key(2)));
+	CHECK(cache.get(key(3)));
+
+	TileImageCacheStats stats = cache.getStats();
+	CHECK(stats.evictions == 1);
+	CHECK(stats.imageCount == 3);
+	CHECK(stats.sizeBytes <= cache.getMaxSizeBytes());
+}
+
+TEST_CASE("TileImageCache does not cache images larger than budget")
+{
+	TileImageCache cache(getTestImageSizeBytes(), /* shardCount */ 1);
+	TileImageCacheKey key{"a", QuadTreeTileKey(0, 0, 0)};
+	cache.put(key, createTestImage(64));
+	CHECK(!cache.get(key));
+	CHECK(cache.getStats().sizeBytes == 0);
+}
+
+class CountingTileSource : public TileSource
+{
+public:
+	osg::ref_ptr<osg::Image> createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override
+	{
+		++createCount;
+		return (key.level <= maxLevel) ? createTestImage() : nullptr;
+	}
+
+	bool hasAnyChildren(const skybolt::QuadTreeTileKey& key) const override { return key.level < maxLevel; }
+
+	std::optional<skybolt::QuadTreeTileKey> getHighestAvailableLevel(const skybolt::QuadTreeTileKey& key) const override { return key; }
+
+	const std::string& getCacheSha() const override { return sha; }
+
+	std::string sha = "counting";
+	int maxLevel = 3;
+	mutable std::atomic<int> createCount = 0;
+};
+
+TEST_CASE("MemoryCachedTileSource only creates each image once")
+{
+	auto cache = std::make_shared<TileImageCache>(1024 * 1024);
+	auto source = std::make_shared<CountingTileSource>();
+	MemoryCachedTileSource cachedSource(source, cache);
+
+	QuadTreeTileKey key(2, 1, 1);
+	osg::ref_ptr<osg::Image> image = cachedSource.createImage(key, [] { return false; });
+	REQUIRE(image);
+	CHECK(cachedSource.createImage(key, [] { return false; }) == image);
+	CHECK(source->createCount == 1);
+
+	SECTION("Tile sources with the same SHA share images")
+	{
+		auto otherSource = std::make_shared<CountingTileSource>();
+		MemoryCachedTileSource otherCachedSource(otherSource, cache);
+		CHECK(otherCachedSource.createImage(key, [] { return false; }) == image);
+		CHECK(otherSource->createCount == 0);
+	}
+
+	SECTION("Tile sources with different SHAs do not share images")
+	{
+		auto otherSource = std::make_shared<CountingTileSource>();
+		otherSource->sha = "other";
+		MemoryCachedTileSource otherCachedSource(otherSource, cache);
+		CHECK(otherCachedSource.createImage(key, [] { return false; }) != image);
+		CHECK(otherSource->createCount == 1);
+	}
+
+	SECTION("Missing images are not cached")
+	{
+		QuadTreeTileKey missingKey(5, 0, 0);
+		CHECK(!cachedSource.createImage(missingKey, [] { return false; }));
+		CHECK(!cachedSource.createImage(missingKey, [] { return false; }));
+		CHECK(source->createCount == 3);
+	}
+}
+
+TEST_CASE("Uncached tile source is found for memory cached tile source")
+{
+	auto cache = std::make_shared<TileImageCache>(1024 * 1024);
+	auto source = std::make_shared<CountingTileSource>();
+	auto cachedSource = std::make_shared<MemoryCachedTileSource>(source, cache);
+
+	CHECK(getMemoryUncachedTileSource(cachedSource) == source);
+	CHECK(getMemoryUncachedTileSource(source) == source);
+
+	// Images read from the uncached source are not added to the cache
+	QuadTreeTileKey key(2, 1, 1);
+	REQUIRE(getMemoryUncachedTileSource(cachedSource)->createImage(key, [] { return false; }));
+	CHECK(cachedSource->createImage(key, [] { return false; }));
+	CHECK(source->createCount == 2);
+}
+
+TEST_CASE("TileImageCache supports concurrent access")
+{
+	TileImageCache cache(getTestImageSizeBytes() * 100, /* shardCount */ 4);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&cache, t] {
+			for (int i = 0; i < 1000; ++i)
+			{
+				TileImageCacheKey key{"a", QuadTreeTileKey(10, i % 200, t)};
+				if (!cache.get(key))
+				{
+					cache.put(key, createTestImage());
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	TileImageCacheStats stats = cache.getStats();
+	CHECK(stats.hits + stats.misses == 4000);
+	CHECK(stats.sizeBytes <= cache.getMaxSizeBytes());
+	CHECK(stats.sizeBytes == stats.imageCount * getTestImageSizeBytes());
+}
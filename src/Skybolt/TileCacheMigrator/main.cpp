@@ -0,0 +1,54 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+//! Converts tile caches from the legacy one-file-per-tile layout to the packed tile cache format.
+//! Usage: TileCacheMigrator <cacheDirectory> [--remove-migrated]
+//! where cacheDirectory contains one subdirectory per tile source.
+
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/CachedTileSource.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/PackedTileCache.h>
+
+#include <filesystem>
+#include <iostream>
+
+using namespace skybolt::vis;
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: TileCacheMigrator <cacheDirectory> [--remove-migrated]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	fs::path cacheDirectory = argv[1];
+	bool removeMigratedFiles = (argc > 2 && std::string(argv[2]) == "--remove-migrated");
+
+	try
+	{
+		for (const fs::directory_entry& entry : fs::directory_iterator(cacheDirectory))
+		{
+			if (!entry.is_directory())
+			{
+				continue;
+			}
+
+			PackedTileCacheConfig config;
+			config.directory = entry.path().string();
+			PackedTileCache cache(config);
+
+			std::size_t count = migrateTileCacheDirectory(config.directory, cache, removeMigratedFiles);
+			std::cout << "Migrated " << count << " tiles in " << config.directory << std::endl;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
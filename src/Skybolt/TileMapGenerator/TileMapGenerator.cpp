@@ -7,12 +7,17 @@
 #include "TileMapGenerator.h"
 #include <SkyboltVis/OsgImageHelpers.h>
 #include <SkyboltVis/OsgMathHelpers.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/TileImageCache.h>
 #include <SkyboltCommon/Exception.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <SkyboltCommon/Math/QuadTree.h>
 
+#include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
+#include <condition_variable>
+#include <exception>
 #include <filesystem>
+#include <mutex>
 #include <boost/noncopyable.hpp>
 
 #define PX_SCHED_IMPLEMENTATION 1
@@ -37,6 +42,83 @@ static osg::Vec4f sampleImage(const osg::Image& image, const osg::Vec2d& point,
 	return osg::Vec4f();
 }
 
+static float calcLayerResolution(int width, int height, const Box2d& bounds)
+{
+	return std::max(width / bounds.size().x(), height / bounds.size().y());
+}
+
+//! @returns true if any layer intersecting the tile has a higher resolution than the tile
+static bool isSubdivisionRequired(const Box2d& tileBounds, const osg::Vec2i& tileDimensions, const std::vector<Box2d>& layerBounds, const std::vector<float>& layerResolutions)
+{
+	// Find find the highest resolution of the layers that interesect the tile
+	float maxSrcResolution = 0;
+	for (int i = layerBounds.size() - 1; i >= 0; --i)
+	{
+		if (layerBounds[i].intersects(tileBounds))
+		{
+			maxSrcResolution = std::max(maxSrcResolution, layerResolutions[i]);
+		}
+	}
+
+	// If resolution is higher than current tile resolution, return true to indicate that further subdivision is required
+	float outputResolution = std::max(tileDimensions.x() / tileBounds.size().x(), tileDimensions.y() / tileBounds.size().y());
+	return (maxSrcResolution > outputResolution);
+}
+
+//! @returns bounds of a tile pixel in (longitude, latitude)
+static Box2d calcDestPixelBounds(const Box2d& tileBounds, const osg::Vec2i& tileDimensions, int x, int y)
+{
+	Box2d destPixelBounds(osg::Vec2d(double(x) / double(tileDimensions.x()), double(y) / double(tileDimensions.y())),
+		osg::Vec2d(double(x+1) / double(tileDimensions.x()), double(y+1) / double(tileDimensions.y())));
+
+	osg::Vec2d size = tileBounds.size();
+	destPixelBounds.minimum = tileBounds.minimum + math::componentWiseMultiply(destPixelBounds.minimum, size);
+	destPixelBounds.maximum = tileBounds.minimum + math::componentWiseMultiply(destPixelBounds.maximum, size);
+	return destPixelBounds;
+}
+
+//! @returns path of the tile in the XYZ directory structure, creating the parent directories if necessary
+static std::string createTilePath(const std::string& outputDirectory, const QuadTreeTileKey& tileKey, const std::string& extension)
+{
+	std::string path = outputDirectory + "/" + std::to_string(tileKey.level);
+	std::filesystem::create_directory(path);
+	path += +"/" + std::to_string(tileKey.x);
+	std::filesystem::create_directory(path);
+
+	return path + "/" + std::to_string(tileKey.y) + "." + extension;
+}
+
+static void reportFileWritten(std::atomic_int& filesWrittenCount, const std::string& path)
+{
+	int count = filesWrittenCount++;
+	if ((count % 1000) == 0)
+	{
+		printf("%i files written so far. Most recent file written: '%s'\n", count, path.c_str());
+	}
+}
+
+static void createOutputDirectory(const std::string& outputDirectory)
+{
+	if (!std::filesystem::exists(outputDirectory))
+	{
+		if (!std::filesystem::create_directories(outputDirectory))
+		{
+			throw skybolt::Exception("Could not create output directory '" + outputDirectory + "'");
+		}
+	}
+}
+
+static std::unique_ptr<px_sched::Scheduler> createScheduler()
+{
+	auto scheduler = std::make_unique<px_sched::Scheduler>();
+	int coreCount = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+	px_sched::SchedulerParams schedulerParams;
+	schedulerParams.max_running_threads = coreCount;
+	schedulerParams.num_threads = coreCount;
+	scheduler->init(schedulerParams);
+	return scheduler;
+}
+
 struct TileGeneratorConfig
 {
 	std::unique_ptr<px_sched::Scheduler> scheduler;
@@ -62,7 +144,8 @@ struct TileGenerator : public boost::noncopyable
 		printf("Generating mipmaps...\n");
 		for (const TileMapGeneratorLayer& layer : mLayers)
 		{
-			mLayerResolutions.push_back(std::max(layer.image->s() / layer.bounds.size().x(), layer.image->t() / layer.bounds.size().y()));
+			mLayerBounds.push_back(layer.bounds);
+			mLayerResolutions.push_back(calcLayerResolution(layer.image->s(), layer.image->t(), layer.bounds));
 			mLayerImageMipmaps.push_back(generateMipmaps(layer.image));
 		}
 	}
@@ -85,20 +168,7 @@ struct TileGenerator : public boost::noncopyable
 			generateImage(tile.bounds, tile.key);
 		}
 
-		// Find find the highest resolution of the layers that interesect the tile
-		float maxSrcResolution = 0;
-		for (int i = mLayers.size() - 1; i >= 0; --i)
-		{
-			const TileMapGeneratorLayer& layer = mLayers[i];
-			if (layer.bounds.intersects(tile.bounds))
-			{
-				maxSrcResolution = std::max(maxSrcResolution, mLayerResolutions[i]);
-			}
-		}
-
-		// If resolution is higher than current tile resolution, return true to indicate that further subdivision is required
-		float outputResolution = std::max(mTileDimensions.x() / tile.bounds.size().x(), mTileDimensions.y() / tile.bounds.size().y());
-		return (maxSrcResolution > outputResolution);
+		return isSubdivisionRequired(tile.bounds, mTileDimensions, mLayerBounds, mLayerResolutions);
 	}
 
 	// @ThreadSafe
@@ -113,12 +183,7 @@ struct TileGenerator : public boost::noncopyable
 		{
 			for (int x = 0; x < mTileDimensions.x(); ++x)
 			{
-				Box2d destPixelBounds(osg::Vec2d(double(x) / double(mTileDimensions.x()), double(y) / double(mTileDimensions.y())),
-								  osg::Vec2d(double(x+1) / double(mTileDimensions.x()), double(y+1) / double(mTileDimensions.y())));
-
-				osg::Vec2d size = tileBounds.size();
-				destPixelBounds.minimum = tileBounds.minimum + math::componentWiseMultiply(destPixelBounds.minimum, size);
-				destPixelBounds.maximum = tileBounds.minimum + math::componentWiseMultiply(destPixelBounds.maximum, size);
+				Box2d destPixelBounds = calcDestPixelBounds(tileBounds, mTileDimensions, x, y);
 
 				bool pixelWritten = false;
 
@@ -147,12 +212,7 @@ struct TileGenerator : public boost::noncopyable
 			}
 		}
 
-		std::string path = mOutputDirectory + "/" + std::to_string(tileKey.level);
-		std::filesystem::create_directory(path);
-		path += +"/" + std::to_string(tileKey.x);
-		std::filesystem::create_directory(path);
-
-		path += "/" + std::to_string(tileKey.y) + "." + mExtension;
+		std::string path = createTilePath(mOutputDirectory, tileKey, mExtension);
 
 		bool verboseOutput = false;
 		if (verboseOutput)
@@ -162,13 +222,7 @@ struct TileGenerator : public boost::noncopyable
 
 		osgDB::writeImageFile(*image, path);
 
-		{
-			int filesWrittenCount = mFilesWrittenCount++;
-			if ((filesWrittenCount % 1000) == 0)
-			{
-				printf("%i files written so far. Most recent file written: '%s'\n", filesWrittenCount, path.c_str());
-			}
-		}
+		reportFileWritten(mFilesWrittenCount, path);
 	}
 
 	using ImageMipmaps = std::vector<osg::ref_ptr<osg::Image>>; // Base image, followed by mipmaps in decreasing resolution
@@ -189,6 +243,7 @@ private:
 	const std::string mExtension;
 	const double mMipmapBias;
 
+	std::vector<Box2d> mLayerBounds;
 	std::vector<float> mLayerResolutions;
 	
 	std::vector<ImageMipmaps> mLayerImageMipmaps; //!< Image mipmaps for each item in mLayers
@@ -204,13 +259,7 @@ void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileD
 		throw skybolt::Exception("No tile map generator input layers layers");
 	}
 
-	if (!std::filesystem::exists(outputDirectory))
-	{
-		if (!std::filesystem::create_directories(outputDirectory))
-		{
-			throw skybolt::Exception("Could not create output directory '" + outputDirectory + "'");
-		}
-	}
+	createOutputDirectory(outputDirectory);
 
 	Box2d bounds(osg::Vec2d(-math::piD(), -math::halfPiD()), osg::Vec2d(0, math::halfPiD()));
 	QuadTree<DefaultTile<osg::Vec2d>> treeLeft(createDefaultTile<osg::Vec2d>, QuadTreeTileKey(0, 0, 0), bounds);
@@ -218,12 +267,7 @@ void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileD
 	bounds = Box2d(osg::Vec2d(0, -math::halfPiD()), osg::Vec2d(math::piD(), math::halfPiD()));
 	QuadTree<DefaultTile<osg::Vec2d>> treeRight(createDefaultTile<osg::Vec2d>, QuadTreeTileKey(0, 1, 0), bounds);
 
-	auto scheduler = std::make_unique<px_sched::Scheduler>();
-	int coreCount = std::thread::hardware_concurrency() - 1;
-	px_sched::SchedulerParams schedulerParams;
-	schedulerParams.max_running_threads = coreCount;
-	schedulerParams.num_threads = coreCount;
-	scheduler->init(schedulerParams);
+	auto scheduler = createScheduler();
 
 	TileGenerator tileGenerator([&] {
 		TileGeneratorConfig c;
@@ -250,6 +294,407 @@ void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileD
 	//treeRight.subdivideRecursively(treeRight.getRoot(), predicate);
 }
 
+//! Sets a pixel color, rounding to the nearest representable value.
+//! osg::Image::setColor() truncates, which would darken tiles a little more at each level downsampled from children.
+static void setColorRounded(osg::Image& image, const osg::Vec4f& color, int x, int y)
+{
+	float halfStep = 0;
+	switch (image.getDataType())
+	{
+	case GL_UNSIGNED_BYTE:
+		halfStep = 0.5f / 255.0f;
+		break;
+	case GL_UNSIGNED_SHORT:
+		halfStep = 0.5f / 65535.0f;
+		break;
+	default:
+		break;
+	}
+	image.setColor(color + osg::Vec4f(halfStep, halfStep, halfStep, halfStep), x, y);
+}
+
+//! Window of a source raster read to generate a tile
+struct LayerWindow
+{
+	osg::ref_ptr<osg::Image> image; //!< Null if the layer does not intersect the tile
+	int x = 0; //!< Position of the window in the source raster, in pixels
+	int y = 0;
+};
+
+//! Calculates the range of source pixels [begin, end) needed to sample normalized coordinates in [minCoord, maxCoord]
+static void calcWindowRange(double minCoord, double maxCoord, int sourceSize, int& begin, int& end)
+{
+	// Add a pixel margin for bilinear neighbours and rounding
+	begin = int(std::clamp(std::floor(minCoord * sourceSize) - 1.0, 0.0, double(sourceSize - 1)));
+	end = int(std::clamp(std::floor(maxCoord * sourceSize) + 2.0, double(begin + 1), double(sourceSize)));
+}
+
+//! @param point is in normalized coordinates of the whole source raster
+static osg::Vec4f sampleWindow(const LayerWindow& window, const TileMapSourceRaster& source, const osg::Vec2d& point, Filtering filtering)
+{
+	// Coordinates are clamped to the whole raster before offsetting into the window,
+	// so that the result matches sampling the whole raster.
+	switch (filtering)
+	{
+	case Filtering::NearestNeighbor:
+	{
+		int x = std::clamp(int(point.x() * (source.getWidth() - 1)), 0, source.getWidth() - 1);
+		int y = std::clamp(int(point.y() * (source.getHeight() - 1)), 0, source.getHeight() - 1);
+		return window.image->getColor(x - window.x, y - window.y);
+	}
+	case Filtering::Bilinear:
+	{
+		float x = math::clamp(float(point.x() * source.getWidth()), 0.0f, float(source.getWidth() - 1));
+		float y = math::clamp(float(point.y() * source.getHeight()), 0.0f, float(source.getHeight() - 1));
+		return vis::getColorBilinear(*window.image, osg::Vec2f(x - window.x, y - window.y));
+	}
+	default:
+		assert(!"Not implemented");
+	}
+	return osg::Vec4f();
+}
+
+//! Parent tile waiting for all of its children to complete before it can be downsampled from them
+struct PendingParentTile
+{
+	std::string path;
+	std::shared_ptr<PendingParentTile> parent; //!< May be null
+	int indexInParent;
+	std::atomic_int remainingChildCount = 4;
+	osg::ref_ptr<osg::Image> children[4]; //!< In QuadTree child order: north west, north east, south west, south east
+};
+
+using PendingParentTilePtr = std::shared_ptr<PendingParentTile>;
+
+class StreamingTileGenerator : public boost::noncopyable
+{
+public:
+	StreamingTileGenerator(const StreamingTileMapGeneratorConfig& config, std::unique_ptr<px_sched::Scheduler> scheduler) :
+		mScheduler(std::move(scheduler)),
+		mConfig(config),
+		mSourceBlockCache(std::make_shared<TileImageCache>(config.memoryBudgetBytes / 2))
+	{
+		for (size_t i = 0; i < mConfig.layers.size(); ++i)
+		{
+			StreamingTileMapGeneratorLayer& layer = mConfig.layers[i];
+			if (layer.source->isStreamed())
+			{
+				layer.source = std::make_shared<BlockCachedSourceRaster>(layer.source, mSourceBlockCache, std::to_string(i), mConfig.sourceBlockSize);
+			}
+			mLayerBounds.push_back(layer.bounds);
+			mLayerResolutions.push_back(calcLayerResolution(layer.source->getWidth(), layer.source->getHeight(), layer.bounds));
+		}
+
+		const TileMapSourceRaster& topSource = *mConfig.layers.back().source;
+		mPixelFormat = topSource.getPixelFormat();
+		mDataType = topSource.getDataType();
+
+		// Each task holds roughly this many tile sized images, for source windows, the tile, and parents downsampled from it
+		constexpr std::size_t tileImagesPerTask = 4;
+		std::size_t tileSizeBytes = std::size_t(mConfig.tileDimensions.x()) * std::size_t(mConfig.tileDimensions.y())
+			* osg::Image::computePixelSizeInBits(mPixelFormat, mDataType) / 8;
+		std::size_t taskBudgetBytes = mConfig.memoryBudgetBytes - mSourceBlockCache->getMaxSizeBytes();
+		mMaxTasksInFlightCount = std::max(int(mScheduler->params().num_threads), int(taskBudgetBytes / (tileSizeBytes * tileImagesPerTask)));
+	}
+
+	~StreamingTileGenerator()
+	{
+		mScheduler->waitFor(mTaskSync);
+	}
+
+	void generate()
+	{
+		// The planet is covered by two level 0 tiles
+		for (int x = 0; x < 2; ++x)
+		{
+			QuadTreeTileKey key(0, x, 0);
+			visit(key, getKeyLonLatBounds<osg::Vec2d>(key), nullptr, 0);
+		}
+
+		mScheduler->waitFor(mTaskSync);
+		if (mError)
+		{
+			std::rethrow_exception(mError);
+		}
+	}
+
+private:
+	//! Visits tiles depth first, generating leaf tiles and registering parents to be downsampled once their children complete.
+	//! Depth first order means siblings complete close together, which limits the number of images waiting for their siblings.
+	void visit(const QuadTreeTileKey& key, const Box2d& bounds, const PendingParentTilePtr& parent, int indexInParent)
+	{
+		if (mFailed)
+		{
+			return;
+		}
+
+		std::string path = createTilePath(mConfig.outputDirectory, key, mConfig.extension);
+
+		if (mConfig.resume && std::filesystem::exists(path))
+		{
+			// Tiles are written after all of their children, so the tile's subtree is already complete
+			if (parent)
+			{
+				runTask([this, path, parent, indexInParent] {
+					completeTile(parent, indexInParent, readTile(path));
+				});
+			}
+			return;
+		}
+
+		if (isSubdivisionRequired(bounds, mConfig.tileDimensions, mLayerBounds, mLayerResolutions))
+		{
+			auto tile = std::make_shared<PendingParentTile>();
+			tile->path = path;
+			tile->parent = parent;
+			tile->indexInParent = indexInParent;
+
+			int level = key.level + 1;
+			int x = key.x * 2;
+			int y = key.y * 2;
+			const QuadTreeTileKey childKeys[4] = {
+				QuadTreeTileKey(level, x, y), // north west
+				QuadTreeTileKey(level, x + 1, y), // north east
+				QuadTreeTileKey(level, x, y + 1), // south west
+				QuadTreeTileKey(level, x + 1, y + 1) // south east
+			};
+
+			for (int i = 0; i < 4; ++i)
+			{
+				visit(childKeys[i], getKeyLonLatBounds<osg::Vec2d>(childKeys[i]), tile, i);
+			}
+		}
+		else
+		{
+			runTask([this, bounds, path, parent, indexInParent] {
+				osg::ref_ptr<osg::Image> image = generateLeafImage(bounds);
+				writeTile(*image, path);
+				completeTile(parent, indexInParent, image);
+			});
+		}
+	}
+
+	//! Runs the task on the scheduler, first waiting until the number of tasks in flight is within the memory budget
+	void runTask(std::function<void()> task)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mTasksInFlightMutex);
+			mTasksInFlightChanged.wait(lock, [this] { return mTasksInFlightCount < mMaxTasksInFlightCount; });
+			++mTasksInFlightCount;
+		}
+
+		mScheduler->run([this, task = std::move(task)] {
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				std::scoped_lock<std::mutex> lock(mErrorMutex);
+				if (!mError)
+				{
+					mError = std::current_exception();
+				}
+				mFailed = true;
+			}
+
+			{
+				std::scoped_lock<std::mutex> lock(mTasksInFlightMutex);
+				--mTasksInFlightCount;
+			}
+			mTasksInFlightChanged.notify_one();
+		}, &mTaskSync);
+	}
+
+	//! Passes a completed tile's image to its parent. If the parent then has all of its children,
+	//! the parent is downsampled and written, continuing up the tree on the calling thread.
+	// @ThreadSafe
+	void completeTile(PendingParentTilePtr parent, int indexInParent, osg::ref_ptr<osg::Image> image) const
+	{
+		while (parent)
+		{
+			parent->children[indexInParent] = image;
+			if (--parent->remainingChildCount > 0)
+			{
+				return;
+			}
+
+			image = downsampleChildren(parent->children);
+			writeTile(*image, parent->path);
+			for (osg::ref_ptr<osg::Image>& child : parent->children)
+			{
+				child = nullptr;
+			}
+
+			indexInParent = parent->indexInParent;
+			parent = parent->parent;
+		}
+	}
+
+	// @ThreadSafe
+	osg::ref_ptr<osg::Image> generateLeafImage(const Box2d& tileBounds) const
+	{
+		const std::vector<StreamingTileMapGeneratorLayer>& layers = mConfig.layers;
+
+		std::vector<LayerWindow> windows(layers.size());
+		for (size_t i = 0; i < layers.size(); ++i)
+		{
+			if (layers[i].bounds.intersects(tileBounds))
+			{
+				windows[i] = readLayerWindow(layers[i], tileBounds);
+			}
+		}
+
+		osg::ref_ptr<osg::Image> image = allocateTileImage();
+
+		for (int y = 0; y < mConfig.tileDimensions.y(); ++y)
+		{
+			for (int x = 0; x < mConfig.tileDimensions.x(); ++x)
+			{
+				Box2d destPixelBounds = calcDestPixelBounds(tileBounds, mConfig.tileDimensions, x, y);
+
+				osg::Vec4f c(0, 0, 0, 0);
+				for (int i = layers.size() - 1; i >= 0; --i)
+				{
+					const StreamingTileMapGeneratorLayer& layer = layers[i];
+					if (windows[i].image && layer.bounds.intersects(destPixelBounds))
+					{
+						osg::Vec2d point = math::componentWiseDivide(destPixelBounds.center() - layer.bounds.minimum, layer.bounds.size());
+						c = sampleWindow(windows[i], *layer.source, point, mConfig.filtering);
+						break;
+					}
+				}
+				setColorRounded(*image, c, x, y);
+			}
+		}
+		return image;
+	}
+
+	LayerWindow readLayerWindow(const StreamingTileMapGeneratorLayer& layer, const Box2d& tileBounds) const
+	{
+		osg::Vec2d minCoord = math::componentWiseDivide(tileBounds.minimum - layer.bounds.minimum, layer.bounds.size());
+		osg::Vec2d maxCoord = math::componentWiseDivide(tileBounds.maximum - layer.bounds.minimum, layer.bounds.size());
+
+		int x0, x1, y0, y1;
+		calcWindowRange(minCoord.x(), maxCoord.x(), layer.source->getWidth(), x0, x1);
+		calcWindowRange(minCoord.y(), maxCoord.y(), layer.source->getHeight(), y0, y1);
+
+		LayerWindow window;
+		window.image = layer.source->readWindow(x0, y0, x1 - x0, y1 - y0);
+		window.x = x0;
+		window.y = y0;
+		return window;
+	}
+
+	// @ThreadSafe
+	osg::ref_ptr<osg::Image> downsampleChildren(const osg::ref_ptr<osg::Image> (&children)[4]) const
+	{
+		osg::ref_ptr<osg::Image> image = allocateTileImage();
+
+		int halfWidth = mConfig.tileDimensions.x() / 2;
+		int halfHeight = mConfig.tileDimensions.y() / 2;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			const osg::Image& child = *children[i];
+			if (child.s() != mConfig.tileDimensions.x() || child.t() != mConfig.tileDimensions.y())
+			{
+				throw skybolt::Exception("Tile has unexpected dimensions. Delete the output directory if tile dimensions have changed.");
+			}
+
+			// Children are ordered north to south, and image rows increase northwards
+			int offsetX = (i % 2) * halfWidth;
+			int offsetY = (1 - i / 2) * halfHeight;
+
+			for (int y = 0; y < halfHeight; ++y)
+			{
+				for (int x = 0; x < halfWidth; ++x)
+				{
+					int cx = x * 2;
+					int cy = y * 2;
+					osg::Vec4f c = (mConfig.filtering == Filtering::NearestNeighbor) ? child.getColor(cx, cy) :
+						(child.getColor(cx, cy) + child.getColor(cx + 1, cy) + child.getColor(cx, cy + 1) + child.getColor(cx + 1, cy + 1)) * 0.25f;
+					setColorRounded(*image, c, offsetX + x, offsetY + y);
+				}
+			}
+		}
+		return image;
+	}
+
+	osg::ref_ptr<osg::Image> allocateTileImage() const
+	{
+		osg::ref_ptr<osg::Image> image = new osg::Image();
+		image->allocateImage(mConfig.tileDimensions.x(), mConfig.tileDimensions.y(), 1, mPixelFormat, mDataType);
+		return image;
+	}
+
+	// @ThreadSafe
+	void writeTile(const osg::Image& image, const std::string& path) const
+	{
+		// Write to a temporary file first so that an interrupted run never leaves a partially written tile
+		std::filesystem::path tmpPath(path);
+		tmpPath.replace_extension(".tmp." + mConfig.extension);
+		if (!osgDB::writeImageFile(image, tmpPath.string()))
+		{
+			throw skybolt::Exception("Could not write tile '" + path + "'");
+		}
+		std::filesystem::rename(tmpPath, path);
+
+		reportFileWritten(mFilesWrittenCount, path);
+	}
+
+	// @ThreadSafe
+	osg::ref_ptr<osg::Image> readTile(const std::string& path) const
+	{
+		osg::ref_ptr<osg::Image> image = osgDB::readImageFile(path);
+		if (!image)
+		{
+			throw skybolt::Exception("Could not read tile '" + path + "'");
+		}
+		return image;
+	}
+
+private:
+	std::unique_ptr<px_sched::Scheduler> mScheduler;
+	StreamingTileMapGeneratorConfig mConfig;
+	std::shared_ptr<TileImageCache> mSourceBlockCache;
+
+	std::vector<Box2d> mLayerBounds;
+	std::vector<float> mLayerResolutions;
+	GLenum mPixelFormat;
+	GLenum mDataType;
+
+	std::mutex mTasksInFlightMutex;
+	std::condition_variable mTasksInFlightChanged;
+	int mTasksInFlightCount = 0;
+	int mMaxTasksInFlightCount;
+
+	std::mutex mErrorMutex;
+	std::exception_ptr mError; //!< First error raised by a task
+	std::atomic_bool mFailed = false;
+
+	px_sched::Sync mTaskSync;
+	mutable std::atomic_int mFilesWrittenCount = 0;
+};
+
+void generateTileMapStreaming(const StreamingTileMapGeneratorConfig& config)
+{
+	if (config.layers.empty())
+	{
+		throw skybolt::Exception("No tile map generator input layers layers");
+	}
+
+	if (config.tileDimensions.x() % 2 != 0 || config.tileDimensions.y() % 2 != 0)
+	{
+		throw skybolt::Exception("Tile dimensions must be even");
+	}
+
+	createOutputDirectory(config.outputDirectory);
+
+	StreamingTileGenerator generator(config, createScheduler());
+	generator.generate();
+}
+
 static int nextPowerOfTwo(int v)
 {
 	// From https://stackoverflow.com/questions/4398711/round-to-the-nearest-power-of-two
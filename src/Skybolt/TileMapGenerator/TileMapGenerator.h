@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "TileMapSourceRaster.h"
 #include <SkyboltVis/OsgBox2.h>
 #include <osg/Image>
 #include <osg/Vec2i>
@@ -26,5 +27,31 @@ enum class Filtering
 //! @param layers are ordered from bottom to top. Upper layers appear on top of lower layers.
 void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering, const std::string& extension = "png");
 
+struct StreamingTileMapGeneratorLayer
+{
+	TileMapSourceRasterPtr source;
+	skybolt::vis::Box2d bounds; //!< Bounds are (longitude, latitude), in radians
+};
+
+struct StreamingTileMapGeneratorConfig
+{
+	std::string outputDirectory;
+	osg::Vec2i tileDimensions; //!< Must be even in both dimensions
+	std::vector<StreamingTileMapGeneratorLayer> layers; //!< Ordered from bottom to top. Upper layers appear on top of lower layers.
+	Filtering filtering = Filtering::Bilinear;
+	std::string extension = "png";
+	std::size_t memoryBudgetBytes = std::size_t(1) << 30; //!< Approximate limit on memory used by cached source blocks and tiles in flight
+	int sourceBlockSize = 512; //!< Width and height in pixels of blocks read from streamed source rasters
+	bool resume = true; //!< If true, tiles which already exist in the output directory are reused rather than generated again
+};
+
+//! Generates herichical tile map in XYZ format without holding whole source images in memory.
+//! Leaf tiles are resampled from windows of the source rasters, and each parent tile is downsampled from
+//! its four children once they have been written, so levels are built bottom-up instead of from whole-image mipmaps.
+//! Tiles are resampled, downsampled and encoded in parallel, with the number of tiles in flight limited by the memory budget.
+//! Each tile is written atomically after all of its children, so an interrupted run can be resumed by running it again.
+//! The run is complete when both level 0 tiles exist. Delete the output directory before running again with changed inputs.
+void generateTileMapStreaming(const StreamingTileMapGeneratorConfig& config);
+
 //! @returns base image and mipmaps in increasing LOD order (largest to smallest images)
 std::vector<osg::ref_ptr<osg::Image>> generateMipmaps(const osg::ref_ptr<osg::Image>& base);
\ No newline at end of file
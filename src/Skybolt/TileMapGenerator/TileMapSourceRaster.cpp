@@ -0,0 +1,153 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "TileMapSourceRaster.h"
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/TileImageCache.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace skybolt;
+
+static std::size_t getPixelSizeBytes(GLenum pixelFormat, GLenum dataType)
+{
+	return osg::Image::computePixelSizeInBits(pixelFormat, dataType) / 8;
+}
+
+static osg::ref_ptr<osg::Image> allocateWindowImage(const TileMapSourceRaster& raster, int width, int height)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image();
+	image->allocateImage(width, height, 1, raster.getPixelFormat(), raster.getDataType());
+	return image;
+}
+
+static void copyPixels(const osg::Image& src, int srcX, int srcY, osg::Image& dst, int dstX, int dstY, int width, int height)
+{
+	std::size_t rowSizeBytes = width * getPixelSizeBytes(src.getPixelFormat(), src.getDataType());
+	for (int y = 0; y < height; ++y)
+	{
+		std::memcpy(dst.data(dstX, dstY + y), src.data(srcX, srcY + y), rowSizeBytes);
+	}
+}
+
+ImageSourceRaster::ImageSourceRaster(const osg::ref_ptr<osg::Image>& image) :
+	mImage(image)
+{
+	assert(mImage);
+}
+
+osg::ref_ptr<osg::Image> ImageSourceRaster::readWindow(int x, int y, int width, int height) const
+{
+	osg::ref_ptr<osg::Image> image = allocateWindowImage(*this, width, height);
+	copyPixels(*mImage, x, y, *image, 0, 0, width, height);
+	return image;
+}
+
+RawFileSourceRaster::RawFileSourceRaster(const RawFileSourceRasterConfig& config) :
+	mConfig(config),
+	mPixelSizeBytes(getPixelSizeBytes(config.pixelFormat, config.dataType))
+{
+	std::error_code error;
+	std::uintmax_t fileSize = std::filesystem::file_size(mConfig.filename, error);
+	if (error)
+	{
+		throw skybolt::Exception("Unable to open file: " + mConfig.filename);
+	}
+
+	if (fileSize < std::uintmax_t(mConfig.width) * std::uintmax_t(mConfig.height) * mPixelSizeBytes)
+	{
+		throw skybolt::Exception("File is smaller than expected raster size: " + mConfig.filename);
+	}
+}
+
+osg::ref_ptr<osg::Image> RawFileSourceRaster::readWindow(int x, int y, int width, int height) const
+{
+	std::ifstream f(mConfig.filename, std::ios::in | std::ios::binary);
+	if (!f.is_open())
+	{
+		throw skybolt::Exception("Unable to open file: " + mConfig.filename);
+	}
+
+	osg::ref_ptr<osg::Image> image = allocateWindowImage(*this, width, height);
+
+	std::size_t rowSizeBytes = width * mPixelSizeBytes;
+	for (int row = 0; row < height; ++row)
+	{
+		int fileRow = mConfig.flipVertical ? (mConfig.height - 1 - (y + row)) : (y + row);
+		std::size_t offset = (std::size_t(fileRow) * std::size_t(mConfig.width) + std::size_t(x)) * mPixelSizeBytes;
+		f.seekg(offset);
+		f.read((char*)image->data(0, row), rowSizeBytes);
+		if (!f)
+		{
+			throw skybolt::Exception("Unable to read file: " + mConfig.filename);
+		}
+	}
+
+	if (mConfig.postProcess)
+	{
+		mConfig.postProcess(*image);
+	}
+	return image;
+}
+
+BlockCachedSourceRaster::BlockCachedSourceRaster(const TileMapSourceRasterPtr& source, const std::shared_ptr<vis::TileImageCache>& cache, const std::string& cacheId, int blockSize) :
+	mSource(source),
+	mCache(cache),
+	mCacheId(cacheId),
+	mBlockSize(blockSize)
+{
+	assert(mSource);
+	assert(mCache);
+	assert(mBlockSize > 0);
+}
+
+osg::ref_ptr<osg::Image> BlockCachedSourceRaster::readWindow(int x, int y, int width, int height) const
+{
+	osg::ref_ptr<osg::Image> image = allocateWindowImage(*this, width, height);
+
+	int blockXEnd = (x + width - 1) / mBlockSize;
+	int blockYEnd = (y + height - 1) / mBlockSize;
+	for (int blockY = y / mBlockSize; blockY <= blockYEnd; ++blockY)
+	{
+		for (int blockX = x / mBlockSize; blockX <= blockXEnd; ++blockX)
+		{
+			osg::ref_ptr<osg::Image> block = getBlock(blockX, blockY);
+
+			// Copy the intersection of the block and the window
+			int blockOriginX = blockX * mBlockSize;
+			int blockOriginY = blockY * mBlockSize;
+			int x0 = std::max(x, blockOriginX);
+			int y0 = std::max(y, blockOriginY);
+			int x1 = std::min(x + width, blockOriginX + block->s());
+			int y1 = std::min(y + height, blockOriginY + block->t());
+			copyPixels(*block, x0 - blockOriginX, y0 - blockOriginY, *image, x0 - x, y0 - y, x1 - x0, y1 - y0);
+		}
+	}
+	return image;
+}
+
+osg::ref_ptr<osg::Image> BlockCachedSourceRaster::getBlock(int blockX, int blockY) const
+{
+	// Blocks are keyed as tiles of a single level
+	vis::TileImageCacheKey key{mCacheId, QuadTreeTileKey(0, blockX, blockY)};
+	if (osg::ref_ptr<osg::Image> block = mCache->get(key); block)
+	{
+		return block;
+	}
+
+	int x = blockX * mBlockSize;
+	int y = blockY * mBlockSize;
+	osg::ref_ptr<osg::Image> block = mSource->readWindow(x, y,
+		std::min(mBlockSize, mSource->getWidth() - x),
+		std::min(mBlockSize, mSource->getHeight() - y));
+
+	mCache->put(key, block);
+	return block;
+}
@@ -0,0 +1,115 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <osg/Image>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace skybolt {
+namespace vis {
+class TileImageCache;
+} // namespace vis
+} // namespace skybolt
+
+//! Source raster for the tile map generator which is read in rectangular windows,
+//! so that the whole raster does not need to be held in memory at once.
+class TileMapSourceRaster
+{
+public:
+	virtual ~TileMapSourceRaster() = default;
+
+	virtual int getWidth() const = 0;
+	virtual int getHeight() const = 0;
+	virtual GLenum getPixelFormat() const = 0;
+	virtual GLenum getDataType() const = 0;
+
+	//! @returns true if windows are read from storage, in which case readers should cache them
+	virtual bool isStreamed() const = 0;
+
+	//! @returns a new image containing the pixels in the window. The window must lie within the raster.
+	//! @ThreadSafe
+	virtual osg::ref_ptr<osg::Image> readWindow(int x, int y, int width, int height) const = 0;
+};
+
+using TileMapSourceRasterPtr = std::shared_ptr<TileMapSourceRaster>;
+
+//! Source raster backed by an image which is already in memory
+class ImageSourceRaster : public TileMapSourceRaster
+{
+public:
+	ImageSourceRaster(const osg::ref_ptr<osg::Image>& image);
+
+	int getWidth() const override { return mImage->s(); }
+	int getHeight() const override { return mImage->t(); }
+	GLenum getPixelFormat() const override { return mImage->getPixelFormat(); }
+	GLenum getDataType() const override { return mImage->getDataType(); }
+	bool isStreamed() const override { return false; }
+
+	osg::ref_ptr<osg::Image> readWindow(int x, int y, int width, int height) const override;
+
+private:
+	osg::ref_ptr<osg::Image> mImage;
+};
+
+struct RawFileSourceRasterConfig
+{
+	std::string filename;
+	int width;
+	int height;
+	GLenum pixelFormat;
+	GLenum dataType;
+	bool flipVertical = false; //!< If true, the first row in the file is the last row of the raster
+	std::function<void(osg::Image&)> postProcess; //!< Optional. Applied to each window after it is read.
+};
+
+//! Source raster stored as rows of uncompressed pixels in a file with no header.
+//! Only the part of each row within a window is read from the file.
+class RawFileSourceRaster : public TileMapSourceRaster
+{
+public:
+	RawFileSourceRaster(const RawFileSourceRasterConfig& config);
+
+	int getWidth() const override { return mConfig.width; }
+	int getHeight() const override { return mConfig.height; }
+	GLenum getPixelFormat() const override { return mConfig.pixelFormat; }
+	GLenum getDataType() const override { return mConfig.dataType; }
+	bool isStreamed() const override { return true; }
+
+	osg::ref_ptr<osg::Image> readWindow(int x, int y, int width, int height) const override;
+
+private:
+	const RawFileSourceRasterConfig mConfig;
+	const std::size_t mPixelSizeBytes;
+};
+
+//! Reads windows from a source raster in fixed size blocks, and keeps recently used blocks in a cache
+//! so that neighbouring windows do not read the same pixels from storage again.
+class BlockCachedSourceRaster : public TileMapSourceRaster
+{
+public:
+	//! @param cacheId uniquely identifies the source raster within the cache
+	BlockCachedSourceRaster(const TileMapSourceRasterPtr& source, const std::shared_ptr<skybolt::vis::TileImageCache>& cache, const std::string& cacheId, int blockSize);
+
+	int getWidth() const override { return mSource->getWidth(); }
+	int getHeight() const override { return mSource->getHeight(); }
+	GLenum getPixelFormat() const override { return mSource->getPixelFormat(); }
+	GLenum getDataType() const override { return mSource->getDataType(); }
+	bool isStreamed() const override { return false; }
+
+	osg::ref_ptr<osg::Image> readWindow(int x, int y, int width, int height) const override;
+
+private:
+	osg::ref_ptr<osg::Image> getBlock(int blockX, int blockY) const;
+
+private:
+	const TileMapSourceRasterPtr mSource;
+	const std::shared_ptr<skybolt::vis::TileImageCache> mCache;
+	const std::string mCacheId;
+	const int mBlockSize;
+};
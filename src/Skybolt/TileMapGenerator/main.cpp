@@ -29,36 +29,30 @@ static Box2d getTileBounds(int x, int y, int numTilesX, int numTilesY)
 
 constexpr int defaultHeightmapSeaLevelValue = 32767;
 
-static osg::ref_ptr<osg::Image> loadRawImage16bit(const std::string& filename, int width, int height)
+//! Creates a source raster which streams a raw 16 bit heightmap from file
+static TileMapSourceRasterPtr createRawSourceRaster16bit(const std::string& filename, int width, int height)
 {
-	std::ifstream f(filename, std::ios::in | std::ios::binary);
-	if (!f.is_open())
-		throw skybolt::Exception("Unable to open file: " + filename);
-
-	osg::Image* image = new osg::Image;
-	image->allocateImage(width, height, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
-	image->setInternalTextureFormat(GL_R16);
-
-	size_t elementCount = width * height;
-	size_t sizeBytes = elementCount * 2;
-	f.read((char*)image->data(), sizeBytes);
-
-	// Post process
-	char* p = (char*)image->data();
-	for (int i = 0; i < elementCount; ++i)
-	{
-		// Convert from big to little endian
-		//std::swap(*p, *(p + 1));
-
-		// Offset sea level
-		uint16_t& value = *(uint16_t*)p;
-		value += defaultHeightmapSeaLevelValue;
+	RawFileSourceRasterConfig config;
+	config.filename = filename;
+	config.width = width;
+	config.height = height;
+	config.pixelFormat = GL_LUMINANCE;
+	config.dataType = GL_UNSIGNED_SHORT;
+	config.flipVertical = true;
+	config.postProcess = [] (osg::Image& image) {
+		size_t elementCount = image.s() * image.t();
+		for (size_t i = 0; i < elementCount; ++i)
+		{
+			uint16_t& value = ((uint16_t*)image.data())[i];
 
-		p += 2;
-	}
+			// Convert from big to little endian
+			//value = (value >> 8) | (value << 8);
 
-	f.close();
-	return image;
+			// Offset sea level
+			value += defaultHeightmapSeaLevelValue;
+		}
+	};
+	return std::make_shared<RawFileSourceRaster>(config);
 }
 
 static void postProcessStrm(osg::Image& image)
@@ -153,10 +147,11 @@ static int main_nlcd()
 
 static int main_dem()
 {
-	std::string outputDirectory = "DEM/CombinedElevation";
-	osg::Vec2i tileDimensions(256, 256);
-	
-	std::vector<TileMapGeneratorLayer> layers;
+	// Stream layers from disk because the combined DEM is too large to hold in memory
+	StreamingTileMapGeneratorConfig config;
+	config.outputDirectory = "DEM/CombinedElevation";
+	config.tileDimensions = osg::Vec2i(256, 256);
+	config.filtering = Filtering::Bilinear;
 
 	// Add GLOBE tiles
 	{
@@ -180,13 +175,12 @@ static int main_dem()
 				int width = 10800;
 				int height = (y == 1 || y == 2) ? 6000 : 4800;
 
-				TileMapGeneratorLayer layer;
-				layer.image = loadRawImage16bit(filename, width, height);
-				layer.image->flipVertical();
+				StreamingTileMapGeneratorLayer layer;
+				layer.source = createRawSourceRaster16bit(filename, width, height);
 				layer.bounds = getTileBounds(x, 3-y, 4, 4);
 				layer.bounds.minimum.y() = latitudes[3-y];
 				layer.bounds.maximum.y() = latitudes[(3-y)+1];
-				layers.push_back(layer);
+				config.layers.push_back(layer);
 				++i;
 			}
 		}
@@ -194,18 +188,22 @@ static int main_dem()
 
 	// Add STRM tiles
 	{
-		TileMapGeneratorLayer layer;
-		layer.image = osgDB::readImageFile("DEM/STRM_90m_DEM4/srtm_12_03.tif");
-		postProcessStrm(*layer.image);
+		osg::ref_ptr<osg::Image> image = osgDB::readImageFile("DEM/STRM_90m_DEM4/srtm_12_03.tif");
+		postProcessStrm(*image);
+
+		StreamingTileMapGeneratorLayer layer;
+		layer.source = std::make_shared<ImageSourceRaster>(image);
 		layer.bounds = Box2d(osg::Vec2d(osg::DegreesToRadians(-125.0), osg::DegreesToRadians(45.0)), osg::Vec2d(osg::DegreesToRadians(-120.0), osg::DegreesToRadians(50.0)));
-		layers.push_back(layer);
+		config.layers.push_back(layer);
 	}
 	{
-		TileMapGeneratorLayer layer;
-		layer.image = osgDB::readImageFile("DEM/STRM_90m_DEM4/srtm_14_06.tif");
-		postProcessStrm(*layer.image);
+		osg::ref_ptr<osg::Image> image = osgDB::readImageFile("DEM/STRM_90m_DEM4/srtm_14_06.tif");
+		postProcessStrm(*image);
+
+		StreamingTileMapGeneratorLayer layer;
+		layer.source = std::make_shared<ImageSourceRaster>(image);
 		layer.bounds = Box2d(osg::Vec2d(osg::DegreesToRadians(-115.0), osg::DegreesToRadians(30.0)), osg::Vec2d(osg::DegreesToRadians(-110.0), osg::DegreesToRadians(35.0)));
-		layers.push_back(layer);
+		config.layers.push_back(layer);
 	}
 
 
@@ -213,7 +211,7 @@ static int main_dem()
 
 	try
 	{
-		generateTileMap(outputDirectory, tileDimensions, layers, Filtering::Bilinear);
+		generateTileMapStreaming(config);
 	}
 	catch (const std::exception& e)
 	{
@@ -0,0 +1,358 @@
+/* Copyright Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <TileMapGenerator/TileMapGenerator.h>
+#include <TileMapGenerator/TileMapSourceRaster.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/TileImageCache.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <osgDB/ReadFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+using namespace skybolt;
+
+namespace fs = std::filesystem;
+
+static fs::path createEmptyTemporaryDirectory(const std::string& name)
+{
+	fs::path path = fs::temp_directory_path() / "SkyboltTests" / "TileMapGenerator" / name;
+	fs::remove_all(path);
+	fs::create_directories(path);
+	return path;
+}
+
+//! Creates an image where red increases with x and green increases with y,
+//! so that resampled images can be compared with a tolerance proportional to the resampling footprint.
+static osg::ref_ptr<osg::Image> createGradientImage(int width, int height)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image();
+	image->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			image->setColor(osg::Vec4f(float(x) / float(width - 1), float(y) / float(height - 1), 0.5f, 1.0f), x, y);
+		}
+	}
+	return image;
+}
+
+//! Writes the image as a headerless raw file readable by RawFileSourceRaster
+static std::string writeRawFile(const osg::Image& image, const fs::path& filename, bool flipVertical)
+{
+	std::ofstream f(filename, std::ios::out | std::ios::binary);
+	std::size_t rowSizeBytes = image.getRowSizeInBytes();
+	for (int row = 0; row < image.t(); ++row)
+	{
+		int y = flipVertical ? (image.t() - 1 - row) : row;
+		f.write(reinterpret_cast<const char*>(image.data(0, y)), rowSizeBytes);
+	}
+	REQUIRE(f.good());
+	return filename.string();
+}
+
+static TileMapSourceRasterPtr createRawFileSourceRaster(const osg::Image& image, const fs::path& filename, bool flipVertical = false)
+{
+	RawFileSourceRasterConfig config;
+	config.filename = writeRawFile(image, filename, flipVertical);
+	config.width = image.s();
+	config.height = image.t();
+	config.pixelFormat = image.getPixelFormat();
+	config.dataType = image.getDataType();
+	config.flipVertical = flipVertical;
+	return std::make_shared<RawFileSourceRaster>(config);
+}
+
+static bool imagesEqual(const osg::Image& a, const osg::Image& b)
+{
+	return a.s() == b.s() && a.t() == b.t() && a.getTotalSizeInBytes() == b.getTotalSizeInBytes()
+		&& std::memcmp(a.data(), b.data(), a.getTotalSizeInBytes()) == 0;
+}
+
+TEST_CASE("Source rasters read the same windows, including at raster boundaries")
+{
+	fs::path directory = createEmptyTemporaryDirectory("SourceRasters");
+
+	// Dimensions are not multiples of the block size, so blocks at the right and bottom edges are partial
+	constexpr int blockSize = 16;
+	osg::ref_ptr<osg::Image> image = createGradientImage(37, 29);
+
+	auto imageSource = std::make_shared<ImageSourceRaster>(image);
+	auto rawSource = createRawFileSourceRaster(*image, directory / "raster.raw");
+	auto flippedRawSource = createRawFileSourceRaster(*image, directory / "flippedRaster.raw", /* flipVertical */ true);
+	auto cache = std::make_shared<vis::TileImageCache>(std::size_t(1) << 20);
+	auto blockCachedSource = std::make_shared<BlockCachedSourceRaster>(rawSource, cache, "0", blockSize);
+
+	CHECK(rawSource->isStreamed());
+	CHECK(!blockCachedSource->isStreamed());
+	CHECK(blockCachedSource->getWidth() == image->s());
+	CHECK(blockCachedSource->getHeight() == image->t());
+
+	struct Window
+	{
+		int x, y, width, height;
+	};
+
+	const Window windows[] = {
+		{0, 0, 5, 5}, // Top left corner
+		{30, 20, 7, 9}, // Bottom right corner, within partial blocks
+		{0, 24, 37, 5}, // Full width along the bottom edge
+		{14, 14, 4, 4}, // Crosses block boundaries in both directions
+		{0, 0, 37, 29} // Whole raster
+	};
+
+	for (const Window& w : windows)
+	{
+		osg::ref_ptr<osg::Image> expected = imageSource->readWindow(w.x, w.y, w.width, w.height);
+		CHECK(imagesEqual(*expected, *rawSource->readWindow(w.x, w.y, w.width, w.height)));
+		CHECK(imagesEqual(*expected, *flippedRawSource->readWindow(w.x, w.y, w.width, w.height)));
+
+		// Read twice, so that the second read uses cached blocks
+		CHECK(imagesEqual(*expected, *blockCachedSource->readWindow(w.x, w.y, w.width, w.height)));
+		CHECK(imagesEqual(*expected, *blockCachedSource->readWindow(w.x, w.y, w.width, w.height)));
+	}
+}
+
+//! @returns paths of tiles in the output directory, relative to the directory
+static std::vector<fs::path> findTiles(const fs::path& directory)
+{
+	std::vector<fs::path> result;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".png")
+		{
+			result.push_back(fs::relative(entry.path(), directory));
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+static fs::path getTilePath(int level, int x, int y)
+{
+	return fs::path(std::to_string(level)) / std::to_string(x) / (std::to_string(y) + ".png");
+}
+
+//! @returns level of a tile path created by getTilePath()
+static int getTileLevel(const fs::path& tilePath)
+{
+	return std::stoi(tilePath.begin()->string());
+}
+
+static bool isLeafTile(const fs::path& directory, const fs::path& tilePath)
+{
+	int level = getTileLevel(tilePath);
+	int x = std::stoi(std::next(tilePath.begin())->string());
+	int y = std::stoi(tilePath.stem().string());
+	return !fs::exists(directory / getTilePath(level + 1, x * 2, y * 2));
+}
+
+static osg::ref_ptr<osg::Image> readTile(const fs::path& path)
+{
+	osg::ref_ptr<osg::Image> image = osgDB::readImageFile(path.string());
+	REQUIRE(image);
+	return image;
+}
+
+//! @returns maximum difference of any color component of any pixel
+static float calcMaxColorDifference(const osg::Image& a, const osg::Image& b)
+{
+	REQUIRE(a.s() == b.s());
+	REQUIRE(a.t() == b.t());
+	float result = 0;
+	for (int y = 0; y < a.t(); ++y)
+	{
+		for (int x = 0; x < a.s(); ++x)
+		{
+			osg::Vec4f d = a.getColor(x, y) - b.getColor(x, y);
+			for (int c = 0; c < 4; ++c)
+			{
+				result = std::max(result, std::abs(d[c]));
+			}
+		}
+	}
+	return result;
+}
+
+//! @returns mean color of each quadrant of the image, in row order
+static std::vector<osg::Vec4f> calcQuadrantMeanColors(const osg::Image& image)
+{
+	std::vector<osg::Vec4f> result(4, osg::Vec4f(0, 0, 0, 0));
+	int halfWidth = image.s() / 2;
+	int halfHeight = image.t() / 2;
+	for (int y = 0; y < image.t(); ++y)
+	{
+		for (int x = 0; x < image.s(); ++x)
+		{
+			result[(y / halfHeight) * 2 + (x / halfWidth)] += image.getColor(x, y) / float(halfWidth * halfHeight);
+		}
+	}
+	return result;
+}
+
+static float calcMaxQuadrantMeanColorDifference(const osg::Image& a, const osg::Image& b)
+{
+	std::vector<osg::Vec4f> meansA = calcQuadrantMeanColors(a);
+	std::vector<osg::Vec4f> meansB = calcQuadrantMeanColors(b);
+	float result = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			result = std::max(result, std::abs(meansA[i][c] - meansB[i][c]));
+		}
+	}
+	return result;
+}
+
+//! Checks that two tile map outputs contain the same tiles with identical pixels
+static void checkOutputsEqual(const fs::path& expectedDirectory, const fs::path& actualDirectory)
+{
+	std::vector<fs::path> expectedTiles = findTiles(expectedDirectory);
+	REQUIRE(!expectedTiles.empty());
+	REQUIRE(findTiles(actualDirectory) == expectedTiles);
+
+	for (const fs::path& tile : expectedTiles)
+	{
+		INFO(tile.string());
+		CHECK(imagesEqual(*readTile(expectedDirectory / tile), *readTile(actualDirectory / tile)));
+	}
+}
+
+static const osg::Vec2i tileDimensions(8, 8);
+
+//! The whole image generator only generates the western hemisphere, so the source raster covers it exactly
+static const vis::Box2d westernHemisphereBounds(osg::Vec2d(-math::piD(), -math::halfPiD()), osg::Vec2d(0, math::halfPiD()));
+
+//! Source raster resolution, chosen so that tiles are subdivided to level 3, with 0.75 source pixels per leaf tile pixel
+constexpr int sourceSize = 48;
+constexpr int leafLevel = 3;
+
+static StreamingTileMapGeneratorConfig createStreamingConfig(const fs::path& outputDirectory, const TileMapSourceRasterPtr& source)
+{
+	StreamingTileMapGeneratorConfig config;
+	config.outputDirectory = outputDirectory.string();
+	config.tileDimensions = tileDimensions;
+	config.layers = {{source, westernHemisphereBounds}};
+	config.filtering = Filtering::Bilinear;
+	config.memoryBudgetBytes = std::size_t(1) << 20;
+	config.sourceBlockSize = 20; // Not a divisor of the source size, so edge blocks are partial
+	return config;
+}
+
+TEST_CASE("Streaming tile map generation matches whole image generation")
+{
+	fs::path directory = createEmptyTemporaryDirectory("CompareWithWholeImage");
+	fs::path wholeImageOutput = directory / "WholeImage";
+	fs::path streamedImageOutput = directory / "StreamedImage";
+	fs::path streamedRawFileOutput = directory / "StreamedRawFile";
+
+	osg::ref_ptr<osg::Image> image = createGradientImage(sourceSize, sourceSize);
+
+	generateTileMap(wholeImageOutput.string(), tileDimensions, {{image, westernHemisphereBounds}}, Filtering::Bilinear);
+	generateTileMapStreaming(createStreamingConfig(streamedImageOutput, std::make_shared<ImageSourceRaster>(image)));
+	generateTileMapStreaming(createStreamingConfig(streamedRawFileOutput, createRawFileSourceRaster(*image, directory / "raster.raw")));
+
+	// Windowed reads from a file produce the same tiles as reads from an image in memory
+	checkOutputsEqual(streamedImageOutput, streamedRawFileOutput);
+
+	// Gradient increase per source pixel
+	const float gradientStep = 1.0f / float(sourceSize - 1);
+	const float quantizationTolerance = 2.0f / 255.0f;
+
+	std::vector<fs::path> wholeImageTiles = findTiles(wholeImageOutput);
+	REQUIRE(!wholeImageTiles.empty());
+	for (const fs::path& tile : wholeImageTiles)
+	{
+		INFO(tile.string());
+		REQUIRE(fs::exists(streamedImageOutput / tile));
+
+		osg::ref_ptr<osg::Image> expected = readTile(wholeImageOutput / tile);
+		osg::ref_ptr<osg::Image> actual = readTile(streamedImageOutput / tile);
+
+		if (isLeafTile(wholeImageOutput, tile))
+		{
+			// Leaf tiles are resampled from the source raster in the same way by both generators,
+			// except that the streaming generator rounds rather than truncates colors.
+			CHECK(getTileLevel(tile) == leafLevel);
+			CHECK(calcMaxColorDifference(*expected, *actual) <= quantizationTolerance);
+		}
+		else
+		{
+			// Parent tiles are downsampled from their children by the streaming generator, and sampled from
+			// whole-image mipmaps by the other, so they differ by up to the footprint of a tile pixel in the source.
+			double sourcePixelsPerTilePixel = double(sourceSize) / double(tileDimensions.x() << getTileLevel(tile));
+			float tolerance = 2.0f * gradientStep * float(sourcePixelsPerTilePixel) + quantizationTolerance;
+			CHECK(calcMaxQuadrantMeanColorDifference(*expected, *actual) <= tolerance);
+		}
+	}
+}
+
+//! Deletes a tile and its ancestors, because a partial run only writes a tile after all of its children
+static void deleteTileAndAncestors(const fs::path& directory, int level, int x, int y)
+{
+	for (; level >= 0; --level, x /= 2, y /= 2)
+	{
+		fs::remove(directory / getTilePath(level, x, y));
+	}
+}
+
+//! Deletes a tile and its descendants
+static void deleteSubtree(const fs::path& directory, int level, int x, int y)
+{
+	if (fs::remove(directory / getTilePath(level, x, y)))
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			deleteSubtree(directory, level + 1, x * 2 + i % 2, y * 2 + i / 2);
+		}
+	}
+}
+
+TEST_CASE("Streaming tile map generation resumes after a partial run")
+{
+	fs::path directory = createEmptyTemporaryDirectory("Resume");
+	fs::path completeOutput = directory / "Complete";
+	fs::path resumedOutput = directory / "Resumed";
+
+	osg::ref_ptr<osg::Image> image = createGradientImage(sourceSize, sourceSize);
+	TileMapSourceRasterPtr source = createRawFileSourceRaster(*image, directory / "raster.raw");
+
+	generateTileMapStreaming(createStreamingConfig(completeOutput, source));
+	generateTileMapStreaming(createStreamingConfig(resumedOutput, source));
+
+	// Recreate the state of a run interrupted part way through the tree. Tiles in subtree 2/1/0 are not written yet,
+	// leaf 3/0/1 is not written yet, and the ancestors of both are waiting for their children.
+	deleteSubtree(resumedOutput, 2, 1, 0);
+	deleteTileAndAncestors(resumedOutput, 2, 1, 0);
+	deleteTileAndAncestors(resumedOutput, leafLevel, 0, 1);
+	REQUIRE(!fs::exists(resumedOutput / getTilePath(0, 0, 0)));
+	REQUIRE(fs::exists(resumedOutput / getTilePath(leafLevel, 1, 1))); // Sibling of the deleted leaf
+
+	std::map<fs::path, fs::file_time_type> keptTileWriteTimes;
+	for (const fs::path& tile : findTiles(resumedOutput))
+	{
+		keptTileWriteTimes[tile] = fs::last_write_time(resumedOutput / tile);
+	}
+
+	generateTileMapStreaming(createStreamingConfig(resumedOutput, source));
+
+	checkOutputsEqual(completeOutput, resumedOutput);
+
+	// Tiles which already existed are reused rather than written again
+	for (const auto& [tile, writeTime] : keptTileWriteTimes)
+	{
+		INFO(tile.string());
+		CHECK(fs::last_write_time(resumedOutput / tile) == writeTime);
+	}
+}